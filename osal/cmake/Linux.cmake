@@ -19,6 +19,9 @@ option (USE_SCHED_FIFO
   "Use SCHED_FIFO policy. May require extra privileges to run"
   OFF)
 
+set (OSAL_TIMER_PRIO 30 CACHE STRING
+  "Priority of the thread running os_timer callbacks (if USE_SCHED_FIFO is set)")
+
 target_sources(osal PRIVATE
   src/linux/osal.c
   src/linux/osal_log.c
@@ -31,6 +34,7 @@ target_compile_options(osal
   -Werror
   -Wno-unused-parameter
   $<$<BOOL:${USE_SCHED_FIFO}>:-DUSE_SCHED_FIFO>
+  -DTIMER_PRIO=${OSAL_TIMER_PRIO}
   INTERFACE
   $<$<CONFIG:Coverage>:--coverage>
   )
@@ -89,6 +89,16 @@ os_thread_t * os_thread_create (
    void (*entry) (void * arg),
    void * arg);
 
+/**
+ * Restrict a thread to a set of CPUs.
+ *
+ * @param thread           In:    Thread, as returned by os_thread_create()
+ * @param cpu_mask         In:    Bit n set allows the thread to run on CPU n.
+ *                                0 leaves the affinity unchanged.
+ * @return  0 on success, -1 on error or if not supported by the port
+ */
+int os_thread_set_affinity (os_thread_t * thread, uint32_t cpu_mask);
+
 os_mutex_t * os_mutex_create (void);
 void os_mutex_lock (os_mutex_t * mutex);
 void os_mutex_unlock (os_mutex_t * mutex);
@@ -22,6 +22,8 @@ extern "C" {
 
 #include "osal.h"
 
+#include <stdarg.h>
+
 /* Log levels */
 #define LOG_LEVEL_DEBUG   0x00
 #define LOG_LEVEL_INFO    0x01
@@ -71,6 +73,26 @@ extern "C" {
 
 void os_log (uint8_t type, const char * fmt, ...) CC_FORMAT (2, 3);
 
+/**
+ * Function which receives all messages of os_log().
+ *
+ * @param type             In:    Log level and state, see LOG_LEVEL_*.
+ * @param fmt              In:    The printf format string.
+ * @param list             In:    The arguments of the format string.
+ */
+typedef void (*os_log_fn_t) (uint8_t type, const char * fmt, va_list list);
+
+/**
+ * Redirect os_log(), e.g. into an asynchronous logger.
+ *
+ * The function may be called from any thread which logs. By default,
+ * messages are printed to stdout.
+ *
+ * @param fn               In:    The function receiving all messages, or
+ *                                NULL to print to stdout again.
+ */
+void os_log_set_function (os_log_fn_t fn);
+
 #ifdef __cplusplus
 }
 #endif
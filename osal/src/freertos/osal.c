@@ -54,6 +54,12 @@ os_thread_t * os_thread_create (
    }
 }
 
+int os_thread_set_affinity (os_thread_t * thread, uint32_t cpu_mask)
+{
+   /* Not supported */
+   return (cpu_mask == 0) ? 0 : -1;
+}
+
 os_mutex_t * os_mutex_create (void)
 {
    SemaphoreHandle_t handle = xSemaphoreCreateRecursiveMutex();
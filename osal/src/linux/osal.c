@@ -22,7 +22,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <signal.h>
 #include <limits.h>
 
 #include <pthread.h>
@@ -31,10 +30,15 @@
 #include <errno.h>
 #include <unistd.h>
 
+#include <linux/futex.h>
+#include <sys/epoll.h>
 #include <sys/syscall.h>
+#include <sys/timerfd.h>
 
 /* Priority of timer callback thread (if USE_SCHED_FIFO is set) */
+#ifndef TIMER_PRIO
 #define TIMER_PRIO 30
+#endif
 
 #define USECS_PER_SEC (1 * 1000 * 1000)
 #define NSECS_PER_SEC (1 * 1000 * 1000 * 1000)
@@ -88,6 +92,32 @@ os_thread_t * os_thread_create (
    return thread;
 }
 
+int os_thread_set_affinity (os_thread_t * thread, uint32_t cpu_mask)
+{
+   cpu_set_t cpuset;
+   int cpu;
+
+   if (cpu_mask == 0)
+   {
+      return 0;
+   }
+
+   CPU_ZERO (&cpuset);
+   for (cpu = 0; cpu < 32; cpu++)
+   {
+      if (cpu_mask & (1u << cpu))
+      {
+         CPU_SET (cpu, &cpuset);
+      }
+   }
+
+   if (pthread_setaffinity_np (*thread, sizeof (cpuset), &cpuset) != 0)
+   {
+      return -1;
+   }
+   return 0;
+}
+
 os_mutex_t * os_mutex_create (void)
 {
    int result;
@@ -234,11 +264,55 @@ uint32_t os_get_current_time_us (void)
    return ts.tv_sec * 1000 * 1000 + ts.tv_nsec / 1000;
 }
 
+/* Absolute CLOCK_MONOTONIC time, time ms from now */
+static void os_abstime (struct timespec * ts, uint32_t time)
+{
+   uint64_t nsec = (uint64_t)time * 1000 * 1000;
+
+   clock_gettime (CLOCK_MONOTONIC, ts);
+   nsec += ts->tv_nsec;
+
+   ts->tv_sec += nsec / NSECS_PER_SEC;
+   ts->tv_nsec = nsec % NSECS_PER_SEC;
+}
+
+/* Sleep while *uaddr == val, until woken or until the absolute
+ * CLOCK_MONOTONIC time ts (NULL to wait forever). Returns 0 or errno. */
+static int os_futex_wait (
+   uint32_t * uaddr,
+   uint32_t val,
+   const struct timespec * ts)
+{
+   if (
+      syscall (
+         SYS_futex,
+         uaddr,
+         FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+         val,
+         ts,
+         NULL,
+         FUTEX_BITSET_MATCH_ANY) == -1)
+   {
+      return errno;
+   }
+   return 0;
+}
+
+static void os_futex_wake (uint32_t * uaddr)
+{
+   syscall (
+      SYS_futex,
+      uaddr,
+      FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+      INT_MAX,
+      NULL,
+      NULL,
+      0);
+}
+
 os_event_t * os_event_create (void)
 {
    os_event_t * event;
-   pthread_mutexattr_t mattr;
-   pthread_condattr_t cattr;
 
    event = (os_event_t *)malloc (sizeof (*event));
    if (event == NULL)
@@ -246,13 +320,8 @@ os_event_t * os_event_create (void)
       return NULL;
    }
 
-   pthread_condattr_init (&cattr);
-   pthread_condattr_setclock (&cattr, CLOCK_MONOTONIC);
-   pthread_cond_init (&event->cond, &cattr);
-   pthread_mutexattr_init (&mattr);
-   pthread_mutexattr_setprotocol (&mattr, PTHREAD_PRIO_INHERIT);
-   pthread_mutex_init (&event->mutex, &mattr);
-   event->flags = 0;
+   event->flags   = 0;
+   event->waiters = 0;
 
    return event;
 }
@@ -260,222 +329,360 @@ os_event_t * os_event_create (void)
 bool os_event_wait (os_event_t * event, uint32_t mask, uint32_t * value, uint32_t time)
 {
    struct timespec ts;
-   int error     = 0;
-   uint64_t nsec = (uint64_t)time * 1000 * 1000;
+   uint32_t flags;
+   int error = 0;
 
    if (time != OS_WAIT_FOREVER)
    {
-      clock_gettime (CLOCK_MONOTONIC, &ts);
-      nsec += ts.tv_nsec;
-
-      ts.tv_sec += nsec / NSECS_PER_SEC;
-      ts.tv_nsec = nsec % NSECS_PER_SEC;
+      os_abstime (&ts, time);
    }
 
-   pthread_mutex_lock (&event->mutex);
+   __atomic_add_fetch (&event->waiters, 1, __ATOMIC_SEQ_CST);
+   __atomic_thread_fence (__ATOMIC_SEQ_CST);
 
-   while ((event->flags & mask) == 0)
+   flags = __atomic_load_n (&event->flags, __ATOMIC_ACQUIRE);
+   while ((flags & mask) == 0)
    {
-      if (time != OS_WAIT_FOREVER)
+      error = os_futex_wait (
+         &event->flags,
+         flags,
+         (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      flags = __atomic_load_n (&event->flags, __ATOMIC_ACQUIRE);
+      if (error == ETIMEDOUT)
       {
-         error = pthread_cond_timedwait (&event->cond, &event->mutex, &ts);
-         assert (error != EINVAL);
-         if (error)
-         {
-            goto timeout;
-         }
-      }
-      else
-      {
-         error = pthread_cond_wait (&event->cond, &event->mutex);
-         assert (error != EINVAL);
+         break;
       }
    }
 
-timeout:
-   *value = event->flags & mask;
-   pthread_mutex_unlock (&event->mutex);
-   return (error != 0);
+   __atomic_sub_fetch (&event->waiters, 1, __ATOMIC_RELAXED);
+
+   *value = flags & mask;
+   return (*value == 0);
 }
 
 void os_event_set (os_event_t * event, uint32_t value)
 {
-   pthread_mutex_lock (&event->mutex);
-   event->flags |= value;
-   pthread_mutex_unlock (&event->mutex);
-   pthread_cond_signal (&event->cond);
+   uint32_t old;
+
+   old = __atomic_fetch_or (&event->flags, value, __ATOMIC_SEQ_CST);
+   __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+   if (
+      (old | value) != old &&
+      __atomic_load_n (&event->waiters, __ATOMIC_RELAXED) != 0)
+   {
+      os_futex_wake (&event->flags);
+   }
 }
 
 void os_event_clr (os_event_t * event, uint32_t value)
 {
-   pthread_mutex_lock (&event->mutex);
-   event->flags &= ~value;
-   pthread_mutex_unlock (&event->mutex);
-   pthread_cond_signal (&event->cond);
+   /* Waiters only wait for flags to become set */
+   __atomic_fetch_and (&event->flags, ~value, __ATOMIC_SEQ_CST);
 }
 
 void os_event_destroy (os_event_t * event)
 {
-   pthread_cond_destroy (&event->cond);
-   pthread_mutex_destroy (&event->mutex);
    free (event);
 }
 
 os_mbox_t * os_mbox_create (size_t size)
 {
    os_mbox_t * mbox;
-   pthread_mutexattr_t mattr;
-   pthread_condattr_t cattr;
+   size_t i;
 
-   mbox = (os_mbox_t *)malloc (sizeof (*mbox) + size * sizeof (void *));
+   if (size == 0)
+   {
+      return NULL;
+   }
+
+   mbox =
+      (os_mbox_t *)malloc (sizeof (*mbox) + size * sizeof (os_mbox_slot_t));
    if (mbox == NULL)
    {
       return NULL;
    }
 
-   pthread_condattr_init (&cattr);
-   pthread_condattr_setclock (&cattr, CLOCK_MONOTONIC);
-   pthread_cond_init (&mbox->cond, &cattr);
-   pthread_mutexattr_init (&mattr);
-   pthread_mutexattr_setprotocol (&mattr, PTHREAD_PRIO_INHERIT);
-   pthread_mutex_init (&mbox->mutex, &mattr);
+   mbox->r             = 0;
+   mbox->w             = 0;
+   mbox->size          = size;
+   mbox->fetch_seq     = 0;
+   mbox->fetch_waiters = 0;
+   mbox->post_seq      = 0;
+   mbox->post_waiters  = 0;
 
-   mbox->r     = 0;
-   mbox->w     = 0;
-   mbox->count = 0;
-   mbox->size  = size;
+   for (i = 0; i < size; i++)
+   {
+      mbox->slot[i].seq = i;
+      mbox->slot[i].msg = NULL;
+   }
 
    return mbox;
 }
 
-bool os_mbox_fetch (os_mbox_t * mbox, void ** msg, uint32_t time)
+static bool os_mbox_try_fetch (os_mbox_t * mbox, void ** msg)
 {
-   struct timespec ts;
-   int error     = 0;
-   uint64_t nsec = (uint64_t)time * 1000 * 1000;
+   os_mbox_slot_t * slot;
+   size_t pos = __atomic_load_n (&mbox->r, __ATOMIC_RELAXED);
+   size_t seq;
+   intptr_t diff;
 
-   if (time != OS_WAIT_FOREVER)
+   while (1)
    {
-      clock_gettime (CLOCK_MONOTONIC, &ts);
-      nsec += ts.tv_nsec;
+      slot = &mbox->slot[pos % mbox->size];
+      seq  = __atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE);
+      diff = (intptr_t)seq - (intptr_t)(pos + 1);
 
-      ts.tv_sec += nsec / NSECS_PER_SEC;
-      ts.tv_nsec = nsec % NSECS_PER_SEC;
+      if (diff == 0)
+      {
+         if (__atomic_compare_exchange_n (
+                &mbox->r,
+                &pos,
+                pos + 1,
+                true,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED))
+         {
+            break;
+         }
+      }
+      else if (diff < 0)
+      {
+         return false; /* Empty */
+      }
+      else
+      {
+         pos = __atomic_load_n (&mbox->r, __ATOMIC_RELAXED);
+      }
    }
 
-   pthread_mutex_lock (&mbox->mutex);
+   *msg = slot->msg;
+   __atomic_store_n (&slot->seq, pos + mbox->size, __ATOMIC_RELEASE);
+   return true;
+}
+
+static bool os_mbox_try_post (os_mbox_t * mbox, void * msg)
+{
+   os_mbox_slot_t * slot;
+   size_t pos = __atomic_load_n (&mbox->w, __ATOMIC_RELAXED);
+   size_t seq;
+   intptr_t diff;
 
-   while (mbox->count == 0)
+   while (1)
    {
-      if (time != OS_WAIT_FOREVER)
+      slot = &mbox->slot[pos % mbox->size];
+      seq  = __atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE);
+      diff = (intptr_t)seq - (intptr_t)pos;
+
+      if (diff == 0)
       {
-         error = pthread_cond_timedwait (&mbox->cond, &mbox->mutex, &ts);
-         assert (error != EINVAL);
-         if (error)
+         if (__atomic_compare_exchange_n (
+                &mbox->w,
+                &pos,
+                pos + 1,
+                true,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED))
          {
-            goto timeout;
+            break;
          }
       }
+      else if (diff < 0)
+      {
+         return false; /* Full */
+      }
       else
       {
-         error = pthread_cond_wait (&mbox->cond, &mbox->mutex);
-         assert (error != EINVAL);
+         pos = __atomic_load_n (&mbox->w, __ATOMIC_RELAXED);
       }
    }
 
-   *msg = mbox->msg[mbox->r++];
-   if (mbox->r == mbox->size)
-      mbox->r = 0;
-
-   mbox->count--;
-
-timeout:
-   pthread_mutex_unlock (&mbox->mutex);
-   pthread_cond_signal (&mbox->cond);
+   slot->msg = msg;
+   __atomic_store_n (&slot->seq, pos + 1, __ATOMIC_RELEASE);
+   return true;
+}
 
-   return (error != 0);
+/* Wake the threads sleeping on seq, if there are any */
+static void os_mbox_wake (uint32_t * seq, uint32_t * waiters)
+{
+   __atomic_thread_fence (__ATOMIC_SEQ_CST);
+   if (__atomic_load_n (waiters, __ATOMIC_RELAXED) != 0)
+   {
+      __atomic_add_fetch (seq, 1, __ATOMIC_SEQ_CST);
+      os_futex_wake (seq);
+   }
 }
 
-bool os_mbox_post (os_mbox_t * mbox, void * msg, uint32_t time)
+/* Retry op until it succeeds or time ms has passed. Between attempts
+ * sleep on the futex word seq, which is bumped by the other side. */
+static bool os_mbox_wait (
+   os_mbox_t * mbox,
+   bool (*op) (os_mbox_t * mbox, void ** msg),
+   void ** msg,
+   uint32_t * seq,
+   uint32_t * waiters,
+   uint32_t time)
 {
    struct timespec ts;
-   int error     = 0;
-   uint64_t nsec = (uint64_t)time * 1000 * 1000;
+   uint32_t val;
+   int error;
 
    if (time != OS_WAIT_FOREVER)
    {
-      clock_gettime (CLOCK_MONOTONIC, &ts);
-      nsec += ts.tv_nsec;
-
-      ts.tv_sec += nsec / NSECS_PER_SEC;
-      ts.tv_nsec = nsec % NSECS_PER_SEC;
+      os_abstime (&ts, time);
    }
 
-   pthread_mutex_lock (&mbox->mutex);
-
-   while (mbox->count == mbox->size)
+   while (1)
    {
-      if (time != OS_WAIT_FOREVER)
+      /* Read seq before announcing ourselves, so that a wake-up between
+       * the attempt below and the futex wait is not lost */
+      val = __atomic_load_n (seq, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch (waiters, 1, __ATOMIC_SEQ_CST);
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      if (op (mbox, msg))
       {
-         error = pthread_cond_timedwait (&mbox->cond, &mbox->mutex, &ts);
-         assert (error != EINVAL);
-         if (error)
-         {
-            goto timeout;
-         }
+         __atomic_sub_fetch (waiters, 1, __ATOMIC_RELAXED);
+         return true;
       }
-      else
+
+      error = os_futex_wait (seq, val, (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      __atomic_sub_fetch (waiters, 1, __ATOMIC_RELAXED);
+
+      if (error == ETIMEDOUT)
       {
-         error = pthread_cond_wait (&mbox->cond, &mbox->mutex);
-         assert (error != EINVAL);
+         return op (mbox, msg);
       }
    }
+}
 
-   mbox->msg[mbox->w++] = msg;
-   if (mbox->w == mbox->size)
-      mbox->w = 0;
+static bool os_mbox_fetch_op (os_mbox_t * mbox, void ** msg)
+{
+   return os_mbox_try_fetch (mbox, msg);
+}
 
-   mbox->count++;
+static bool os_mbox_post_op (os_mbox_t * mbox, void ** msg)
+{
+   return os_mbox_try_post (mbox, *msg);
+}
 
-timeout:
-   pthread_mutex_unlock (&mbox->mutex);
-   pthread_cond_signal (&mbox->cond);
+bool os_mbox_fetch (os_mbox_t * mbox, void ** msg, uint32_t time)
+{
+   if (!os_mbox_try_fetch (mbox, msg))
+   {
+      if (
+         time == 0 ||
+         !os_mbox_wait (
+            mbox,
+            os_mbox_fetch_op,
+            msg,
+            &mbox->fetch_seq,
+            &mbox->fetch_waiters,
+            time))
+      {
+         return true; /* Timeout */
+      }
+   }
 
-   return (error != 0);
+   os_mbox_wake (&mbox->post_seq, &mbox->post_waiters);
+   return false;
+}
+
+bool os_mbox_post (os_mbox_t * mbox, void * msg, uint32_t time)
+{
+   if (!os_mbox_try_post (mbox, msg))
+   {
+      if (
+         time == 0 ||
+         !os_mbox_wait (
+            mbox,
+            os_mbox_post_op,
+            &msg,
+            &mbox->post_seq,
+            &mbox->post_waiters,
+            time))
+      {
+         return true; /* Timeout */
+      }
+   }
+
+   os_mbox_wake (&mbox->fetch_seq, &mbox->fetch_waiters);
+   return false;
 }
 
 void os_mbox_destroy (os_mbox_t * mbox)
 {
-   pthread_cond_destroy (&mbox->cond);
-   pthread_mutex_destroy (&mbox->mutex);
    free (mbox);
 }
 
+/* All timers share one thread, which waits for their timerfds using epoll.
+ * The list of timers is protected by os_timer_mutex, which is also held
+ * while a timer callback runs. The mutex is recursive, so a callback may
+ * create or destroy timers. */
+static pthread_once_t os_timer_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t os_timer_mutex;
+static int os_timer_epoll_fd = -1;
+static os_timer_t * os_timer_list = NULL;
+
 static void os_timer_thread (void * arg)
 {
-   os_timer_t * timer = arg;
-   sigset_t sigset;
-   siginfo_t si;
-   struct timespec tmo;
+   struct epoll_event event;
+   os_timer_t * timer;
+   uint64_t expirations;
 
-   timer->thread_id = (pid_t)syscall (SYS_gettid);
+   while (1)
+   {
+      /* Fetch one event at a time, as the callback of one timer may destroy
+       * another one */
+      if (epoll_wait (os_timer_epoll_fd, &event, 1, -1) != 1)
+      {
+         continue;
+      }
 
-   /* Add SIGALRM */
-   sigemptyset (&sigset);
-   sigprocmask (SIG_BLOCK, &sigset, NULL);
-   sigaddset (&sigset, SIGALRM);
+      pthread_mutex_lock (&os_timer_mutex);
 
-   tmo.tv_sec  = 0;
-   tmo.tv_nsec = 500 * 1000 * 1000;
+      /* The timer might have been destroyed after epoll_wait() returned */
+      timer = os_timer_list;
+      while (timer != NULL && timer != event.data.ptr)
+      {
+         timer = timer->next;
+      }
 
-   while (!timer->exit)
-   {
-      int sig = sigtimedwait (&sigset, &si, &tmo);
-      if (sig == SIGALRM)
+      /* A stopped (or restarted) timer has nothing to read */
+      if (
+         timer != NULL &&
+         read (timer->fd, &expirations, sizeof (expirations)) ==
+            sizeof (expirations))
       {
          if (timer->fn)
             timer->fn (timer, timer->arg);
       }
+
+      pthread_mutex_unlock (&os_timer_mutex);
+   }
+}
+
+static void os_timer_init_once (void)
+{
+   pthread_mutexattr_t mattr;
+
+   pthread_mutexattr_init (&mattr);
+   pthread_mutexattr_setprotocol (&mattr, PTHREAD_PRIO_INHERIT);
+   pthread_mutexattr_settype (&mattr, PTHREAD_MUTEX_RECURSIVE);
+   pthread_mutex_init (&os_timer_mutex, &mattr);
+
+   os_timer_epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+   if (os_timer_epoll_fd == -1)
+   {
+      return;
+   }
+
+   if (
+      os_thread_create ("os_timer", TIMER_PRIO, 1024, os_timer_thread, NULL) ==
+      NULL)
+   {
+      close (os_timer_epoll_fd);
+      os_timer_epoll_fd = -1;
    }
 }
 
@@ -486,13 +693,13 @@ os_timer_t * os_timer_create (
    bool oneshot)
 {
    os_timer_t * timer;
-   struct sigevent sev;
-   sigset_t sigset;
+   struct epoll_event event;
 
-   /* Block SIGALRM in calling thread */
-   sigemptyset (&sigset);
-   sigaddset (&sigset, SIGALRM);
-   sigprocmask (SIG_BLOCK, &sigset, NULL);
+   pthread_once (&os_timer_once, os_timer_init_once);
+   if (os_timer_epoll_fd == -1)
+   {
+      return NULL;
+   }
 
    timer = (os_timer_t *)malloc (sizeof (*timer));
    if (timer == NULL)
@@ -500,41 +707,35 @@ os_timer_t * os_timer_create (
       return NULL;
    }
 
-   timer->exit      = false;
-   timer->thread_id = 0;
-   timer->fn        = fn;
-   timer->arg       = arg;
-   timer->us        = us;
-   timer->oneshot   = oneshot;
+   timer->fn      = fn;
+   timer->arg     = arg;
+   timer->us      = us;
+   timer->oneshot = oneshot;
 
-   /* Create timer thread */
-   timer->thread =
-      os_thread_create ("os_timer", TIMER_PRIO, 1024, os_timer_thread, timer);
-   if (timer->thread == NULL)
+   timer->fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   if (timer->fd == -1)
    {
       free (timer);
       return NULL;
    }
 
-   /* Wait until timer thread sets its (kernel) thread id */
-   do
-   {
-      sched_yield();
-   } while (timer->thread_id == 0);
+   pthread_mutex_lock (&os_timer_mutex);
 
-   /* Create timer */
-   sev.sigev_notify            = SIGEV_THREAD_ID;
-   sev.sigev_value.sival_ptr   = timer;
-   sev._sigev_un._tid          = timer->thread_id;
-   sev.sigev_signo             = SIGALRM;
-   sev.sigev_notify_attributes = NULL;
-
-   if (timer_create (CLOCK_MONOTONIC, &sev, &timer->timerid) == -1)
+   event.events   = EPOLLIN;
+   event.data.ptr = timer;
+   if (epoll_ctl (os_timer_epoll_fd, EPOLL_CTL_ADD, timer->fd, &event) == -1)
    {
+      pthread_mutex_unlock (&os_timer_mutex);
+      close (timer->fd);
       free (timer);
       return NULL;
    }
 
+   timer->next   = os_timer_list;
+   os_timer_list = timer;
+
+   pthread_mutex_unlock (&os_timer_mutex);
+
    return timer;
 }
 
@@ -548,11 +749,11 @@ void os_timer_start (os_timer_t * timer)
    struct itimerspec its;
 
    /* Start timer */
-   its.it_value.tv_sec     = 0;
-   its.it_value.tv_nsec    = 1000 * timer->us;
+   its.it_value.tv_sec     = timer->us / USECS_PER_SEC;
+   its.it_value.tv_nsec    = 1000 * (timer->us % USECS_PER_SEC);
    its.it_interval.tv_sec  = (timer->oneshot) ? 0 : its.it_value.tv_sec;
    its.it_interval.tv_nsec = (timer->oneshot) ? 0 : its.it_value.tv_nsec;
-   timer_settime (timer->timerid, 0, &its, NULL);
+   timerfd_settime (timer->fd, 0, &its, NULL);
 }
 
 void os_timer_stop (os_timer_t * timer)
@@ -564,13 +765,29 @@ void os_timer_stop (os_timer_t * timer)
    its.it_value.tv_nsec    = 0;
    its.it_interval.tv_sec  = 0;
    its.it_interval.tv_nsec = 0;
-   timer_settime (timer->timerid, 0, &its, NULL);
+   timerfd_settime (timer->fd, 0, &its, NULL);
 }
 
 void os_timer_destroy (os_timer_t * timer)
 {
-   timer->exit = true;
-   pthread_join (*timer->thread, NULL);
-   timer_delete (timer->timerid);
+   os_timer_t ** pp;
+
+   /* Waits for a running callback, unless called from within it */
+   pthread_mutex_lock (&os_timer_mutex);
+
+   for (pp = &os_timer_list; *pp != NULL; pp = &(*pp)->next)
+   {
+      if (*pp == timer)
+      {
+         *pp = timer->next;
+         break;
+      }
+   }
+
+   epoll_ctl (os_timer_epoll_fd, EPOLL_CTL_DEL, timer->fd, NULL);
+   close (timer->fd);
+
+   pthread_mutex_unlock (&os_timer_mutex);
+
    free (timer);
 }
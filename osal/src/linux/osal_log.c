@@ -19,12 +19,28 @@
 #include <stdio.h>
 #include <time.h>
 
+static os_log_fn_t os_log_function = NULL;
+
+void os_log_set_function (os_log_fn_t fn)
+{
+   __atomic_store_n (&os_log_function, fn, __ATOMIC_RELEASE);
+}
+
 void os_log (uint8_t type, const char * fmt, ...)
 {
    va_list list;
    time_t rawtime;
    struct tm timestruct;
    char timestamp[10];
+   os_log_fn_t fn = __atomic_load_n (&os_log_function, __ATOMIC_ACQUIRE);
+
+   if (fn != NULL)
+   {
+      va_start (list, fmt);
+      fn (type, fmt, list);
+      va_end (list);
+      return;
+   }
 
    time (&rawtime);
    localtime_r (&rawtime, &timestruct);
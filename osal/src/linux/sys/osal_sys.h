@@ -40,30 +40,40 @@ typedef struct os_sem
    size_t count;
 } os_sem_t;
 
+/* The event flags double as futex word. The waiter count lets
+ * os_event_set skip the wake-up syscall when nobody waits. */
 typedef struct os_event
 {
-   pthread_cond_t cond;
-   pthread_mutex_t mutex;
    uint32_t flags;
+   uint32_t waiters;
 } os_event_t;
 
+typedef struct os_mbox_slot
+{
+   size_t seq;
+   void * msg;
+} os_mbox_slot_t;
+
+/* Bounded lock-free ring. Every slot carries a sequence number telling
+ * whether it is free for the writer at position w or filled for the
+ * reader at position r. Blocked callers sleep on the futex words
+ * fetch_seq (waiting for data) and post_seq (waiting for space). */
 typedef struct os_mbox
 {
-   pthread_cond_t cond;
-   pthread_mutex_t mutex;
    size_t r;
    size_t w;
-   size_t count;
    size_t size;
-   void * msg[];
+   uint32_t fetch_seq;
+   uint32_t fetch_waiters;
+   uint32_t post_seq;
+   uint32_t post_waiters;
+   os_mbox_slot_t slot[];
 } os_mbox_t;
 
 typedef struct os_timer
 {
-   timer_t timerid;
-   os_thread_t * thread;
-   pid_t thread_id;
-   bool exit;
+   int fd; /* timerfd, multiplexed by the common timer thread */
+   struct os_timer * next;
    void (*fn) (struct os_timer *, void * arg);
    void * arg;
    uint32_t us;
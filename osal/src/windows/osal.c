@@ -74,6 +74,16 @@ os_thread_t * os_thread_create (
    return handle;
 }
 
+int os_thread_set_affinity (os_thread_t * thread, uint32_t cpu_mask)
+{
+   if (cpu_mask == 0)
+   {
+      return 0;
+   }
+
+   return (SetThreadAffinityMask ((HANDLE)thread, cpu_mask) == 0) ? -1 : 0;
+}
+
 uint32_t os_get_current_time_us (void)
 {
    static LARGE_INTEGER performanceFrequency = {0};
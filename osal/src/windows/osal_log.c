@@ -19,9 +19,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+static os_log_fn_t os_log_function = NULL;
+
+void os_log_set_function (os_log_fn_t fn)
+{
+   os_log_function = fn;
+}
+
 void os_log (uint8_t type, const char * fmt, ...)
 {
    va_list list;
+   os_log_fn_t fn = os_log_function;
+
+   if (fn != NULL)
+   {
+      va_start (list, fmt);
+      fn (type, fmt, list);
+      va_end (list);
+      return;
+   }
 
    switch (LOG_LEVEL_GET (type))
    {
@@ -14,6 +14,7 @@
  ********************************************************************/
 
 #include "osal.h"
+#include "osal_log.h"
 #include <gtest/gtest.h>
 
 static int expired_calls;
@@ -136,6 +137,82 @@ TEST_F (Osal, PostToFullMBoxShouldTimeout)
    os_mbox_destroy (mbox);
 }
 
+#define PRODUCERS       4
+#define MSGS_PER_THREAD 10000
+
+static os_mbox_t * producer_mbox;
+
+static void producer (void * arg)
+{
+   uintptr_t base = (uintptr_t)arg;
+   uintptr_t i;
+
+   for (i = 1; i <= MSGS_PER_THREAD; i++)
+   {
+      os_mbox_post (producer_mbox, (void *)(base + i), OS_WAIT_FOREVER);
+   }
+}
+
+TEST_F (Osal, MboxShouldDeliverAllMessagesFromMultipleProducers)
+{
+   uint64_t sum      = 0;
+   uint64_t expected = 0;
+   void * msg;
+   bool tmo;
+   int i;
+
+   producer_mbox = os_mbox_create (8);
+
+   for (i = 0; i < PRODUCERS; i++)
+   {
+      os_thread_create (
+         "producer",
+         5,
+         1024,
+         producer,
+         (void *)(uintptr_t)(i * MSGS_PER_THREAD));
+   }
+
+   for (i = 0; i < PRODUCERS * MSGS_PER_THREAD; i++)
+   {
+      tmo = os_mbox_fetch (producer_mbox, &msg, 1000);
+      ASSERT_FALSE (tmo);
+      sum += (uintptr_t)msg;
+      expected += i + 1;
+   }
+
+   EXPECT_EQ (expected, sum);
+
+   tmo = os_mbox_fetch (producer_mbox, &msg, 10);
+   EXPECT_TRUE (tmo);
+
+   os_usleep (10 * 1000);
+   os_mbox_destroy (producer_mbox);
+}
+
+static os_event_t * setter_event;
+
+static void setter (void * arg)
+{
+   os_usleep (10 * 1000);
+   os_event_set (setter_event, 2);
+}
+
+TEST_F (Osal, EventShouldWakeWaiter)
+{
+   uint32_t value;
+   bool tmo;
+
+   setter_event = os_event_create();
+   os_thread_create ("setter", 5, 1024, setter, NULL);
+
+   tmo = os_event_wait (setter_event, 2, &value, 1000);
+   EXPECT_FALSE (tmo);
+   EXPECT_EQ (2u, value);
+
+   os_event_destroy (setter_event);
+}
+
 #define TEN_MS (10 * 1000)
 #define CALLS   39
 
@@ -199,6 +276,45 @@ TEST_F (Osal, MultipleTimers)
    os_timer_destroy (timer2);
 }
 
+static void expired_destroy (os_timer_t * timer, void * arg)
+{
+   expired_calls++;
+   os_timer_destroy (timer);
+}
+
+TEST_F (Osal, TimerCallbackMayDestroyTimer)
+{
+   os_timer_t * timer;
+
+   timer = os_timer_create (10 * 1000, expired_destroy, NULL, false);
+
+   os_timer_start (timer);
+   os_usleep (100 * 1000);
+
+   EXPECT_EQ (1, expired_calls);
+}
+
+TEST_F (Osal, ManyTimers)
+{
+   os_timer_t * timers[50];
+   int i;
+
+   for (i = 0; i < 50; i++)
+   {
+      timers[i] = os_timer_create (10 * 1000 + i * 100, expired, NULL, true);
+      ASSERT_TRUE (timers[i] != NULL);
+      os_timer_start (timers[i]);
+   }
+   os_usleep (100 * 1000);
+
+   EXPECT_EQ (50, expired_calls);
+
+   for (i = 0; i < 50; i++)
+   {
+      os_timer_destroy (timers[i]);
+   }
+}
+
 TEST_F (Osal, CurrentTime)
 {
    uint32_t t0, t1;
@@ -209,3 +325,21 @@ TEST_F (Osal, CurrentTime)
 
    EXPECT_NEAR (100 * 1000, t1 - t0, 1000);
 }
+
+static uint8_t logged_type;
+static char logged_message[64];
+static void log_function (uint8_t type, const char * fmt, va_list list)
+{
+   logged_type = type;
+   vsnprintf (logged_message, sizeof (logged_message), fmt, list);
+}
+
+TEST_F (Osal, LogShouldCallRedirectedFunction)
+{
+   os_log_set_function (log_function);
+   os_log (LOG_LEVEL_WARNING | LOG_STATE_ON, "value %d of %s", 42, "test");
+   os_log_set_function (NULL);
+
+   EXPECT_EQ (LOG_LEVEL_WARNING | LOG_STATE_ON, logged_type);
+   EXPECT_STREQ ("value 42 of test", logged_message);
+}
@@ -27,6 +27,8 @@ target_sources(pnet
   PRIVATE
   src/ports/linux/pnal.c
   src/ports/linux/pnal_eth.c
+  $<$<BOOL:${PNAL_USE_AF_XDP}>:src/ports/linux/pnal_eth_xdp.c>
+  src/ports/linux/pnal_recv.c
   src/ports/linux/pnal_udp.c
   src/ports/linux/pnal_filetools.c
   $<$<BOOL:${PNET_OPTION_SNMP}>:src/ports/linux/pnal_snmp.c>
@@ -43,6 +45,16 @@ target_sources(pnet
   $<$<BOOL:${PNET_OPTION_SNMP}>:src/ports/linux/mib/lldpXPnoRemTable.c>
   )
 
+option (PNAL_USE_IP_SCRIPT
+  "Always set the IP suite with the profipp_network_parameters script instead of rtnetlink"
+  OFF)
+option (PNAL_USE_AF_XDP
+  "Send and receive Profinet frames via AF_XDP sockets, with fallback to raw sockets"
+  OFF)
+option (PNAL_SET_HOSTNAME
+  "Set the host name to the station name when setting the IP suite with rtnetlink"
+  OFF)
+
 target_compile_options(pnet
   PRIVATE
   -Wall
@@ -51,6 +63,9 @@ target_compile_options(pnet
   -Wno-unused-parameter
   -ffunction-sections
   -fdata-sections
+  $<$<BOOL:${PNAL_USE_IP_SCRIPT}>:-DPNAL_USE_IP_SCRIPT>
+  $<$<BOOL:${PNAL_SET_HOSTNAME}>:-DPNAL_SET_HOSTNAME>
+  $<$<BOOL:${PNAL_USE_AF_XDP}>:-DPNAL_USE_AF_XDP>
   INTERFACE
   $<$<CONFIG:Coverage>:--coverage>
   )
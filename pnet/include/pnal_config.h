@@ -28,23 +28,73 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
 /**
- * Thread priority and stack size
+ * Thread priority, stack size and CPU affinity
  */
 typedef struct pnal_thread_cfg
 {
    uint32_t prio;
    size_t stack_size;
+   uint32_t cpu_mask; /* Bit n set allows CPU n. 0 = no restriction */
+
+   /* Receive thread only. Busy poll the network device for up to this many
+    * microseconds when waiting for frames, instead of waiting for the
+    * interrupt. 0 = disabled */
+   uint32_t busy_poll_us;
+
+   /* Receive thread only. Never sleep, but check the sockets without
+    * blocking in a loop. Occupies a whole CPU, so set cpu_mask to an
+    * isolated CPU */
+   bool busy_spin;
 } pnal_thread_cfg_t;
 
+/**
+ * Timestamping of received and sent Ethernet frames
+ */
+typedef enum pnal_timestamping
+{
+   PNAL_TIMESTAMPING_OFF = 0,
+   PNAL_TIMESTAMPING_SOFTWARE, /* Taken by the network stack and driver */
+   PNAL_TIMESTAMPING_HARDWARE, /* Taken by the network interface. Falls back
+                                  to software timestamps if not supported.
+                                  Requires the clock of the network interface
+                                  to be synchronized to the system clock */
+} pnal_timestamping_t;
+
 typedef struct pnal_cfg
 {
    pnal_thread_cfg_t snmp_thread;
    pnal_thread_cfg_t eth_recv_thread;
    pnal_thread_cfg_t bg_worker_thread;
+   pnal_thread_cfg_t link_monitor_thread;
+
+   /* Service all raw Ethernet and UDP sockets from one thread, configured
+    * by eth_recv_thread, instead of one thread per interface. The RPC
+    * call-backs then run on that thread, see pnet_lock() */
+   bool single_recv_thread;
+
+   /* Timestamp frames on the raw Ethernet sockets */
+   pnal_timestamping_t eth_timestamping;
+
+   /* Socket priority (SO_PRIORITY) of frames sent on the raw Ethernet
+    * sockets. 0 keeps the default. The frames have VLAN priority 6, so 6 is
+    * recommended. It puts them in the highest band of the default pfifo_fast
+    * qdisc, and can be mapped to a separate hardware queue with mqprio, for
+    * example "tc qdisc replace dev eth0 root mqprio num_tc 2
+    * map 0 0 0 0 0 0 1 0 0 0 0 0 0 0 0 0 queues 1@0 1@1 hw 0" */
+   uint32_t eth_priority;
+
+   /* If > 0: Use SO_TXTIME on the raw Ethernet sockets. Cyclic frames are
+    * launched this long after their scheduled send time, and other frames
+    * this long after they are sent, which removes the jitter of the sending
+    * thread. Requires an ETF qdisc with clockid CLOCK_TAI on the queue used
+    * by eth_priority, with a delta smaller than this delay. Frames are
+    * dropped without such a qdisc */
+   uint32_t eth_txtime_delay_us;
 } pnal_cfg_t;
 
 #ifdef __cplusplus
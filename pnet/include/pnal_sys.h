@@ -30,6 +30,8 @@ typedef struct os_buf
 {
    void * payload;
    uint16_t len;
+   uint64_t timestamp_ns; /* Reception time, see pnal_get_time_ns().
+                             0 if not available */
 } pnal_buf_t;
 
 #ifdef __cplusplus
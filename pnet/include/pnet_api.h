@@ -384,6 +384,22 @@ typedef enum pnet_event_values
    PNET_EVENT_DATA
 } pnet_event_values_t;
 
+/**
+ * The steps of a Write Multiple request, sent to the application using the
+ * \a pnet_write_multiple_ind() call-back function.
+ */
+typedef enum pnet_write_multiple_event
+{
+   /** The records of the request follow. */
+   PNET_WRITE_MULTIPLE_BEGIN,
+
+   /** All records of the request were written successfully. */
+   PNET_WRITE_MULTIPLE_COMMIT,
+
+   /** Writing a record failed. The remaining ones were not written. */
+   PNET_WRITE_MULTIPLE_ABORT
+} pnet_write_multiple_event_t;
+
 /**
  * Values used for IOCS and IOPS. The actual values are important, as they are
  * sent on the wire.
@@ -693,6 +709,15 @@ typedef int (*pnet_state_ind) (
    uint32_t arep,
    pnet_event_values_t state);
 
+/**
+ * Return value of \a pnet_read_ind() and \a pnet_write_ind(), if the
+ * application answers the request later.
+ */
+#define PNET_RECORD_PENDING 1
+
+/** Returned by \a pnet_write_chunk_ind() to have a record collected */
+#define PNET_WRITE_NOT_STREAMED 2
+
 /**
  * Indication to the application that an IODRead request was received from the
  * controller.
@@ -713,6 +738,11 @@ typedef int (*pnet_state_ind) (
  * In case of error the application should provide error information in \a
  * p_result.
  *
+ * If reading the value takes long, the application may return
+ * PNET_RECORD_PENDING instead, if \a pnet_record_response_deferrable() is true,
+ * and provide the value later with \a pnet_read_record_done(). The stack
+ * carries on with the cyclic data exchange meanwhile.
+ *
  * @param net              InOut: The p-net stack instance
  * @param arg              InOut: User-defined data (not used by p-net)
  * @param arep             In:    The AREP.
@@ -726,6 +756,7 @@ typedef int (*pnet_state_ind) (
  *                                bytes of the binary value.
  * @param p_result         Out:   Detailed error information if returning != 0
  * @return  0  on success.
+ *          PNET_RECORD_PENDING if the value is provided later.
  *          -1 if an error occurred.
  */
 typedef int (*pnet_read_ind) (
@@ -760,6 +791,12 @@ typedef int (*pnet_read_ind) (
  * In case of error the application should provide error information in \a
  * p_result.
  *
+ * If writing the value takes long, the application may copy \a p_write_data
+ * and return PNET_RECORD_PENDING instead, if
+ * \a pnet_record_response_deferrable() is true, and report the result later
+ * with \a pnet_write_record_done(). The stack carries on with the cyclic data
+ * exchange meanwhile.
+ *
  * @param net              InOut: The p-net stack instance
  * @param arg              InOut: User-defined data (not used by p-net)
  * @param arep             In:    The AREP.
@@ -769,9 +806,11 @@ typedef int (*pnet_read_ind) (
  * @param idx              In:    The data record index.
  * @param sequence_number  In:    The sequence number.
  * @param write_length     In:    The length in bytes of the binary value.
- * @param p_write_data     In:    A pointer to the binary value.
+ * @param p_write_data     In:    A pointer to the binary value. Only valid
+ *                                during the call.
  * @param p_result         Out:   Detailed error information if returning != 0
  * @return  0  on success.
+ *          PNET_RECORD_PENDING if the result is reported later.
  *          -1 if an error occurred.
  */
 typedef int (*pnet_write_ind) (
@@ -787,6 +826,96 @@ typedef int (*pnet_write_ind) (
    const uint8_t * p_write_data,
    pnet_result_t * p_result);
 
+/**
+ * Indication to the application that a part of a large IODWrite request was
+ * received from the controller.
+ *
+ * This optional application call-back function is called instead of
+ * \a pnet_write_ind() for IODWrite requests of an application-specific
+ * \a idx, which the controller sends in several RPC fragments. The data of
+ * each fragment is passed on as it arrives, instead of being collected in the
+ * session buffer first. The length of such records is thereby not limited by
+ * PNET_MAX_SESSION_BUFFER_SIZE.
+ *
+ * The parts arrive in order. \a offset is 0 for the first part, and
+ * \a offset + \a data_length equals \a total_length for the last one. If a
+ * first part arrives while a transfer is incomplete, the controller has
+ * given up on the earlier one.
+ *
+ * Before the first part, the callback is called with \a data_length 0 and
+ * \a p_data NULL, to ask whether the application takes this record in parts.
+ * If it returns PNET_WRITE_NOT_STREAMED, the record is collected and passed to
+ * \a pnet_write_ind() as usual, limited by PNET_MAX_SESSION_BUFFER_SIZE.
+ *
+ * If the application returns -1, the remaining parts are dropped, and the
+ * controller gets the error information in \a p_result once all fragments
+ * have arrived. Otherwise, the response is sent after the last part.
+ * Deferring the response is not supported.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arg              InOut: User-defined data (not used by p-net)
+ * @param arep             In:    The AREP.
+ * @param api              In:    The API identifier.
+ * @param slot             In:    The slot number.
+ * @param subslot          In:    The sub-slot number.
+ * @param idx              In:    The data record index.
+ * @param sequence_number  In:    The sequence number.
+ * @param offset           In:    Position of this part in the record.
+ * @param total_length     In:    The length in bytes of the record.
+ * @param data_length      In:    The length in bytes of this part.
+ * @param p_data           In:    A pointer to this part. Only valid during
+ *                                the call.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  on success.
+ *          PNET_WRITE_NOT_STREAMED if asked before the first part, and the
+ *             record shall be passed to \a pnet_write_ind() instead.
+ *          -1 if an error occurred.
+ */
+typedef int (*pnet_write_chunk_ind) (
+   pnet_t * net,
+   void * arg,
+   uint32_t arep,
+   uint32_t api,
+   uint16_t slot,
+   uint16_t subslot,
+   uint16_t idx,
+   uint16_t sequence_number,
+   uint32_t offset,
+   uint32_t total_length,
+   uint16_t data_length,
+   const uint8_t * p_data,
+   pnet_result_t * p_result);
+
+/**
+ * Indication to the application that a Write Multiple request begins or ends.
+ *
+ * This optional application call-back function is called with
+ * PNET_WRITE_MULTIPLE_BEGIN before the first record of a Write Multiple
+ * request is passed to \a pnet_write_ind(), and with
+ * PNET_WRITE_MULTIPLE_COMMIT or PNET_WRITE_MULTIPLE_ABORT after the last one.
+ * The application may thereby validate and apply all records of the request
+ * at once, instead of record by record.
+ *
+ * The records of a Write Multiple request must be answered at once, see
+ * \a pnet_record_response_deferrable().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arg              InOut: User-defined data (not used by p-net)
+ * @param arep             In:    The AREP.
+ * @param event            In:    The step of the request.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  on success.
+ *          -1 if the application rejects the records on
+ *             PNET_WRITE_MULTIPLE_COMMIT. The controller gets the error
+ *             information in \a p_result. Ignored for the other events.
+ */
+typedef int (*pnet_write_multiple_ind) (
+   pnet_t * net,
+   void * arg,
+   uint32_t arep,
+   pnet_write_multiple_event_t event,
+   pnet_result_t * p_result);
+
 /**
  * Indication to the application that a module is requested by the controller in
  * a specific slot.
@@ -1035,6 +1164,27 @@ typedef int (*pnet_reset_ind) (
  */
 typedef int (*pnet_signal_led_ind) (pnet_t * net, void * arg, bool led_state);
 
+/**
+ * Indication to the application that the earliest scheduled timeout within
+ * the stack has moved forward in time.
+ *
+ * Only used in tickless mode (see \a tickless in \a pnet_cfg_t). An
+ * application sleeping until the time given by \a pnet_get_next_timeout_us()
+ * should wake up and recalculate its sleep time. Not triggered by timeouts
+ * scheduled while \a pnet_handle_periodic() runs the expired ones, as the
+ * application recalculates its sleep time after that call anyway.
+ *
+ * This callback may be triggered from any thread calling into the stack
+ * (for example the Ethernet receive thread), so it must not block and must not
+ * call back into the stack.
+ *
+ * It is optional to implement this callback.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arg              InOut: User-defined data (not used by p-net)
+ */
+typedef void (*pnet_next_timeout_ind) (pnet_t * net, void * arg);
+
 /*
  * Network and device configuration.
  *
@@ -1278,12 +1428,26 @@ typedef struct pnet_cfg
     */
    uint32_t tick_us;
 
+   /** Tickless mode.
+    *  If false, timeouts are rounded to multiples of \a tick_us and the
+    *  application calls \a pnet_handle_periodic() every \a tick_us.
+    *  If true, timeouts are not rounded, and the application calls
+    *  \a pnet_handle_periodic() no later than the time given by
+    *  \a pnet_get_next_timeout_us(). The application must still call it
+    *  regularly to poll for incoming RPC requests.
+    */
+   bool tickless;
+
    pnet_state_ind state_cb;
    pnet_connect_ind connect_cb;
    pnet_release_ind release_cb;
    pnet_dcontrol_ind dcontrol_cb;
    pnet_ccontrol_cnf ccontrol_cb;
    pnet_write_ind write_cb;
+   /** Optional. If NULL, fragmented writes are passed to \a write_cb */
+   pnet_write_chunk_ind write_chunk_cb;
+   /** Optional */
+   pnet_write_multiple_ind write_multiple_cb;
    pnet_read_ind read_cb;
    pnet_exp_module_ind exp_module_cb;
    pnet_exp_submodule_ind exp_submodule_cb;
@@ -1293,6 +1457,7 @@ typedef struct pnet_cfg
    pnet_alarm_ack_cnf alarm_ack_cnf_cb;
    pnet_reset_ind reset_cb;
    pnet_signal_led_ind signal_led_cb;
+   pnet_next_timeout_ind next_timeout_cb;
 
    /** Userdata passed to callbacks, not used by stack */
    void * cb_arg;
@@ -1355,6 +1520,42 @@ typedef struct pnet_cfg
 
 } pnet_cfg_t;
 
+/**
+ * Statistics for time intervals, in nanoseconds.
+ *
+ * The average is sum_ns / count.
+ */
+typedef struct pnet_interval_stats
+{
+   uint32_t count;
+   uint32_t min_ns;
+   uint32_t max_ns;
+   uint64_t sum_ns;
+} pnet_interval_stats_t;
+
+/**
+ * Timing statistics for an IOCR, see \a pnet_get_iocr_timing().
+ *
+ * Requires pnal_cfg.eth_timestamping to be enabled. The values are based
+ * on the timestamps of the network interface, so the accuracy depends on
+ * the type of timestamps.
+ */
+typedef struct pnet_iocr_timing
+{
+   uint16_t frame_id;
+   bool is_input; /* Input CR (sent by the device), or output CR */
+
+   /** For output CRs: Time from the reception of a frame until the
+    *  application reads its data.
+    *  For input CRs: Time from the application writing data until the
+    *  frame with the data is sent. */
+   pnet_interval_stats_t latency;
+
+   /** Deviation of the time between two frames from the configured
+    *  cycle time (send clock factor times reduction ratio) */
+   pnet_interval_stats_t jitter;
+} pnet_iocr_timing_t;
+
 /*
  * API function return values
  *
@@ -1362,6 +1563,25 @@ typedef struct pnet_cfg
  * -1 for an unsuccessful call.
  */
 
+/*
+ * Threading
+ *
+ * The call-backs of the stack run on the thread calling
+ * pnet_handle_periodic(), except if the common receive thread is used (see
+ * single_recv_thread in pnal_cfg_t). Then the call-backs of the RPC handling
+ * (connect, state, module and record indications etc.) run on that thread,
+ * while the application calls pnet_handle_periodic() and the other API
+ * functions on its own threads.
+ *
+ * The stack serializes the RPC handling with pnet_handle_periodic() and with
+ * the API functions that complete an RPC request, e.g. pnet_read_record_done(),
+ * and with pnet_get_iocr_timing().
+ * Any other API function, and any state the application shares with the
+ * call-backs, must be protected by the application with pnet_lock() and
+ * pnet_unlock(). The call-backs themselves run with the lock held, so they may
+ * call any API function.
+ */
+
 /**
  * Initialize the Profinet stack.
  *
@@ -1383,6 +1603,40 @@ PNET_EXPORT pnet_t * pnet_init (const pnet_cfg_t * p_cfg);
  */
 PNET_EXPORT void pnet_handle_periodic (pnet_t * net);
 
+/**
+ * Serialize the calling thread with the RPC handling of the stack.
+ *
+ * While the lock is held, no call-back of the RPC handling runs on another
+ * thread. The lock is recursive, and does nothing unless the common receive
+ * thread is used, as the call-backs then run on the thread calling
+ * pnet_handle_periodic(). Hold it briefly, as the common receive thread
+ * waits for it on every RPC request, and the cyclic frames wait behind.
+ *
+ * @param net              InOut: The p-net stack instance
+ */
+PNET_EXPORT void pnet_lock (pnet_t * net);
+
+/**
+ * Release the lock taken by \a pnet_lock().
+ *
+ * @param net              InOut: The p-net stack instance
+ */
+PNET_EXPORT void pnet_unlock (pnet_t * net);
+
+/**
+ * Get the time until the earliest scheduled timeout within the stack expires.
+ *
+ * Intended for tickless mode, where the application sleeps until the
+ * next timeout instead of calling \a pnet_handle_periodic() every tick.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_delay_us       Out:   Time until the next timeout, in microseconds.
+ *                                0 if a timeout already has expired.
+ * @return  0  if a timeout is scheduled.
+ *          -1 if no timeout is scheduled.
+ */
+PNET_EXPORT int pnet_get_next_timeout_us (pnet_t * net, uint32_t * p_delay_us);
+
 /**
  * Application signals ready to exchange data.
  *
@@ -1722,6 +1976,192 @@ PNET_EXPORT int pnet_get_ar_error_codes (
    uint16_t * p_err_cls,
    uint16_t * p_err_code);
 
+/**
+ * Fetch timing statistics for an IOCR.
+ *
+ * Only the IOCRs handled by the software PPM and CPM drivers have
+ * statistics, and only when timestamping is enabled in
+ * pnal_cfg.eth_timestamping.
+ *
+ * May be called from any thread, also while the AR is aborted.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP.
+ * @param iocr_ix          In:    Index of the IOCR in the AR. Typically 0
+ *                                for the input CR and 1 for the output CR.
+ * @param reset            In:    Restart the statistics after reading
+ * @param p_timing         Out:   The statistics.
+ * @return  0  If the AREP and IOCR are valid.
+ *          -1 if the AREP or IOCR is not valid.
+ */
+PNET_EXPORT int pnet_get_iocr_timing (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t iocr_ix,
+   bool reset,
+   pnet_iocr_timing_t * p_timing);
+
+/**
+ * Fetch the cycle counters of the last cyclic frames of an AR.
+ *
+ * The cycle counter is the one carried in the frame, in units of 31.25 us.
+ * Only the first input CR and the first output CR of the AR are considered.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP.
+ * @param p_ppm_cycle      Out:   Cycle counter of the last frame sent to the
+ *                                controller. 0 if there is no input CR.
+ * @param p_cpm_cycle      Out:   Cycle counter of the last frame received
+ *                                from the controller. 0 if there is no output
+ *                                CR, or if no frame was received yet.
+ * @return  0  If the AREP is valid.
+ *          -1 if the AREP is not valid.
+ */
+PNET_EXPORT int pnet_get_cycle_counters (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t * p_ppm_cycle,
+   uint16_t * p_cpm_cycle);
+
+/**
+ * Check whether the application may answer the current IODRead or IODWrite
+ * request later.
+ *
+ * Only valid during the \a pnet_read_ind() and \a pnet_write_ind() user
+ * callbacks. Explicit reads via an AR and single writes may be answered later.
+ * Implicit reads and the records of a write multiple request must be answered
+ * in the callback.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @return  true  if the callback may return PNET_RECORD_PENDING.
+ *          false otherwise.
+ */
+PNET_EXPORT bool pnet_record_response_deferrable (pnet_t * net);
+
+/**
+ * Provide the value of an IODRead request, for which the \a pnet_read_ind()
+ * user callback returned PNET_RECORD_PENDING, and send the response to the
+ * controller.
+ *
+ * Call it from the thread calling \a pnet_handle_periodic().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP of the request.
+ * @param sequence_number  In:    The sequence number of the request.
+ * @param p_read_data      In:    The binary value. Not used on error.
+ * @param read_length      In:    Length in bytes of the binary value.
+ * @param p_result         In:    Detailed error information, or NULL on
+ *                                success.
+ * @return  0  if the response was sent.
+ *          -1 if no such request is pending, e.g. because the controller
+ *             abandoned it or the AR was aborted.
+ */
+PNET_EXPORT int pnet_read_record_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const uint8_t * p_read_data,
+   uint16_t read_length,
+   const pnet_result_t * p_result);
+
+/**
+ * Report the result of an IODWrite request, for which the \a pnet_write_ind()
+ * user callback returned PNET_RECORD_PENDING, and send the response to the
+ * controller.
+ *
+ * Call it from the thread calling \a pnet_handle_periodic().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP of the request.
+ * @param sequence_number  In:    The sequence number of the request.
+ * @param p_result         In:    Detailed error information, or NULL on
+ *                                success.
+ * @return  0  if the response was sent.
+ *          -1 if no such request is pending, e.g. because the controller
+ *             abandoned it or the AR was aborted.
+ */
+PNET_EXPORT int pnet_write_record_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const pnet_result_t * p_result);
+
+/**
+ * Priority of a background job, see \a pnet_bg_job_submit().
+ */
+typedef enum pnet_bg_job_prio
+{
+   PNET_BG_JOB_PRIO_HIGH = 0,
+   PNET_BG_JOB_PRIO_NORMAL,
+   PNET_BG_JOB_PRIO_LOW,
+} pnet_bg_job_prio_t;
+
+/** Key of a background job which is never coalesced with other jobs */
+#define PNET_BG_JOB_KEY_NONE 0
+
+/** Keys with this bit set are reserved for the jobs of the stack */
+#define PNET_BG_JOB_KEY_RESERVED 0x80000000U
+
+/**
+ * Background job, run by the background worker thread of the stack.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arg              InOut: The argument given when submitting the job.
+ * @return  Result of the job, passed to the completion callback.
+ */
+typedef int (*pnet_bg_job_run_t) (pnet_t * net, void * arg);
+
+/**
+ * Completion callback of a background job, called by the background worker
+ * thread when the job has run.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arg              InOut: The completion argument given when
+ *                                submitting the job.
+ * @param result           In:    Result of the job.
+ */
+typedef void (*pnet_bg_job_done_t) (pnet_t * net, void * arg, int result);
+
+/**
+ * Submit a job to the background worker thread of the stack.
+ *
+ * Use it for work which must not delay the cyclic data exchange, for example
+ * file access. Jobs with higher priority run first, and jobs with the same
+ * priority in the order they were submitted. The jobs of the stack, for
+ * example saving data to files, run in the same queue, but have entries of
+ * their own, which a full queue does not affect.
+ *
+ * If \a key is not PNET_BG_JOB_KEY_NONE and a job with the same key is queued
+ * but not started yet, \a job is not queued, and \a done is called when the
+ * queued job has run. Use it for jobs which bring something up to date, such
+ * that a burst of submissions runs the job once. Such a submission does not
+ * take an entry of the queue. Up to PNET_MAX_BG_JOBS of them with a
+ * completion callback may wait at a time.
+ *
+ * May be called from any thread, also from a job.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param prio             In:    Priority of the job.
+ * @param key              In:    Key for coalescing, or PNET_BG_JOB_KEY_NONE.
+ *                                Keys with PNET_BG_JOB_KEY_RESERVED are not
+ *                                allowed.
+ * @param job              In:    The job. Mandatory.
+ * @param arg              InOut: Argument of the job.
+ * @param done             In:    Completion callback, or NULL.
+ * @param done_arg         InOut: Argument of the completion callback.
+ * @return  0  if the job was queued or coalesced.
+ *          -1 if the queue is full (see PNET_MAX_BG_JOBS), too many
+ *             coalesced submissions wait, or an argument is invalid.
+ */
+PNET_EXPORT int pnet_bg_job_submit (
+   pnet_t * net,
+   pnet_bg_job_prio_t prio,
+   uint32_t key,
+   pnet_bg_job_run_t job,
+   void * arg,
+   pnet_bg_job_done_t done,
+   void * done_arg);
+
 /**
  * Application creates an entry in the log book.
  *
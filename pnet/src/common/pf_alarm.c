@@ -1906,8 +1906,6 @@ static int pf_alarm_get_diag_summary (
 {
    pf_device_t * p_dev = NULL;
    pf_subslot_t * p_subslot = NULL;
-   uint16_t item_ix;
-   pf_diag_item_t * p_item = NULL;
 
    if (pf_cmdev_get_device (net, &p_dev) == 0)
    {
@@ -1937,21 +1935,11 @@ static int pf_alarm_get_diag_summary (
          }
 
          /* Now handle all the already reported diag items. */
-         item_ix = p_subslot->diag_list;
-         pf_cmdev_get_diag_item (net, item_ix, &p_item);
-         while (p_item != NULL)
-         {
-            /* Collect all diags into maintenanceStatus*/
-            pf_alarm_add_diag_item_to_summary (
-               p_ar,
-               p_subslot,
-               p_item,
-               p_alarm_spec,
-               p_maint_status);
-
-            item_ix = p_item->next;
-            pf_cmdev_get_diag_item (net, item_ix, &p_item);
-         }
+         pf_alarm_add_subslot_diag_summary (
+            p_ar,
+            p_subslot,
+            p_alarm_spec,
+            p_maint_status);
       }
    }
 
@@ -2880,6 +2868,56 @@ void pf_alarm_add_diag_item_to_summary (
    }
 }
 
+/**
+ * @internal
+ * Update the alarm specifier and maintenance status from all diagnosis items
+ * of a subslot.
+ *
+ * Gives the same result as pf_alarm_add_diag_item_to_summary() for each item
+ * in the diag list of the subslot, but uses the counters of the subslot
+ * instead of walking the list.
+ *
+ * @param p_ar             In:    The AR instance.
+ * @param p_subslot        In:    The subslot instance.
+ * @param p_alarm_spec     InOut: The updated alarm specifier.
+ * @param p_maint_status   InOut: The updated maintenance status.
+ */
+void pf_alarm_add_subslot_diag_summary (
+   const pf_ar_t * p_ar,
+   const pf_subslot_t * p_subslot,
+   pnet_alarm_spec_t * p_alarm_spec,
+   uint32_t * p_maint_status)
+{
+   const pf_diag_summary_t * p_summary = &p_subslot->diag_summary;
+   uint16_t bit;
+
+   if (p_summary->num_manufacturer > 0)
+   {
+      p_alarm_spec->manufacturer_diagnosis = true;
+   }
+   if (p_summary->num_channel > 0)
+   {
+      p_alarm_spec->channel_diagnosis = true;
+   }
+   if (p_summary->num_submodule > 0)
+   {
+      p_alarm_spec->submodule_diagnosis = true;
+
+      /* The items of the submodule diagnosis are the ones on the AR */
+      if (p_subslot->p_ar == p_ar)
+      {
+         p_alarm_spec->ar_diagnosis = true;
+      }
+   }
+   for (bit = 0; bit < NELEMENTS (p_summary->num_maint_status); bit++)
+   {
+      if (p_summary->num_maint_status[bit] > 0)
+      {
+         *p_maint_status |= 1u << bit;
+      }
+   }
+}
+
 int pf_alarm_periodic (pnet_t * net)
 {
    uint16_t ix;
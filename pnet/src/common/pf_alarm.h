@@ -299,6 +299,12 @@ void pf_alarm_add_diag_item_to_summary (
    pnet_alarm_spec_t * p_alarm_spec,
    uint32_t * p_maint_status);
 
+void pf_alarm_add_subslot_diag_summary (
+   const pf_ar_t * p_ar,
+   const pf_subslot_t * p_subslot,
+   pnet_alarm_spec_t * p_alarm_spec,
+   uint32_t * p_maint_status);
+
 void pf_alarm_receive_queue_reset (pf_alarm_receive_queue_t * q);
 
 int pf_alarm_receive_queue_post (
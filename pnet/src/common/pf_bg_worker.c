@@ -17,6 +17,7 @@
 #include "pf_includes.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 #ifdef UNIT_TEST
 /* Background worker is disabled during unit tests.
@@ -30,47 +31,369 @@
 
 /* Events handled by bg worker task */
 
-#define BG_JOB_EVENT_UPDATE_PORTS_STATUS  BIT (0)
-#define BG_JOB_EVENT_SAVE_ASE_NVM_DATA    BIT (1)
-#define BG_JOB_EVENT_SAVE_IM_NVM_DATA     BIT (2)
-#define BG_JOB_EVENT_SAVE_PDPORT_NVM_DATA BIT (3)
+#define BG_WORKER_EVENT_JOB BIT (0)
+
+/* Keys of the jobs of the stack. A burst of requests runs each job once.
+ * Each job has its own queue entry, see PF_BG_WORKER_STACK_JOBS.
+ */
+
+#define BG_JOB_KEY_UPDATE_PORTS_STATUS  (PNET_BG_JOB_KEY_RESERVED | 0)
+#define BG_JOB_KEY_SAVE_ASE_NVM_DATA    (PNET_BG_JOB_KEY_RESERVED | 1)
+#define BG_JOB_KEY_SAVE_IM_NVM_DATA     (PNET_BG_JOB_KEY_RESERVED | 2)
+#define BG_JOB_KEY_SAVE_PDPORT_NVM_DATA (PNET_BG_JOB_KEY_RESERVED | 3)
+
+/* Time to wait for more save requests before saving, such that a burst of
+ * requests results in a single save of each file.
+ */
+#define BG_JOB_SAVE_HOLDOFF_US (50 * 1000)
+
+CC_STATIC_ASSERT (
+   (BG_JOB_KEY_SAVE_PDPORT_NVM_DATA & ~PNET_BG_JOB_KEY_RESERVED) <
+   PF_BG_WORKER_STACK_JOBS);
 
 static void bg_worker_task (void * arg);
 
 void pf_bg_worker_init (pnet_t * net)
 {
+   os_thread_t * thread;
+
    net->pf_bg_worker.events = os_event_create();
    CC_ASSERT (net->pf_bg_worker.events != NULL);
+   net->pf_bg_worker.mutex = os_mutex_create();
+   CC_ASSERT (net->pf_bg_worker.mutex != NULL);
+   memset (net->pf_bg_worker.jobs, 0, sizeof (net->pf_bg_worker.jobs));
+   memset (net->pf_bg_worker.waiters, 0, sizeof (net->pf_bg_worker.waiters));
+   net->pf_bg_worker.next_seq = 1;
 
-   os_thread_create (
+   thread = os_thread_create (
       "p-net_bg_worker",
       net->fspm_cfg.pnal_cfg.bg_worker_thread.prio,
       net->fspm_cfg.pnal_cfg.bg_worker_thread.stack_size,
       bg_worker_task,
       (void *)net);
+   CC_ASSERT (thread != NULL);
+
+   if (
+      os_thread_set_affinity (
+         thread,
+         net->fspm_cfg.pnal_cfg.bg_worker_thread.cpu_mask) != 0)
+   {
+      LOG_WARNING (
+         PNET_LOG,
+         "BGW(%d): Failed to set CPU affinity of background worker\n",
+         __LINE__);
+   }
 }
 
-int pf_bg_worker_start_job (pnet_t * net, pf_bg_job_t job_id)
+/**
+ * @internal
+ * Find a free entry in the job queue, among those of the submitted jobs.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @return  the entry, or NULL if the queue is full.
+ */
+static pf_bg_job_entry_t * pf_bg_worker_find_free (pnet_t * net)
+{
+   uint16_t ix;
+
+   for (ix = 0; ix < PNET_MAX_BG_JOBS; ix++)
+   {
+      if (net->pf_bg_worker.jobs[ix].in_use == false)
+      {
+         return &net->pf_bg_worker.jobs[ix];
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * @internal
+ * Find a queued job which has not started yet.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param key              In:    Key of the job.
+ * @return  the entry, or NULL if there is no such job.
+ */
+static pf_bg_job_entry_t * pf_bg_worker_find_queued (pnet_t * net, uint32_t key)
+{
+   pf_bg_job_entry_t * p_entry;
+   uint16_t ix;
+
+   for (ix = 0; ix < PNET_MAX_BG_JOBS; ix++)
+   {
+      p_entry = &net->pf_bg_worker.jobs[ix];
+      if (p_entry->in_use && p_entry->running == false && p_entry->key == key)
+      {
+         return p_entry;
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * @internal
+ * Find a free entry for the completion callback of a coalesced submission.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @return  the entry, or NULL if all are in use.
+ */
+static pf_bg_job_waiter_t * pf_bg_worker_find_free_waiter (pnet_t * net)
 {
-   if (net == NULL)
+   uint16_t ix;
+
+   for (ix = 0; ix < PNET_MAX_BG_JOBS; ix++)
+   {
+      if (net->pf_bg_worker.waiters[ix].in_use == false)
+      {
+         return &net->pf_bg_worker.waiters[ix];
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * @internal
+ * Give a queue entry the next sequence number.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_entry          InOut: The entry.
+ */
+static void pf_bg_worker_set_seq (pnet_t * net, pf_bg_job_entry_t * p_entry)
+{
+   p_entry->seq = net->pf_bg_worker.next_seq++;
+   if (net->pf_bg_worker.next_seq == 0)
+   {
+      net->pf_bg_worker.next_seq = 1;
+   }
+}
+
+/**
+ * @internal
+ * Queue a job of the stack in its own entry, such that submitted jobs can
+ * not crowd it out.
+ *
+ * A job which is queued is not queued again. A job which is running is run
+ * once more when it has finished.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param prio             In:    Priority of the job.
+ * @param key              In:    Reserved key of the job.
+ * @param delay_us         In:    The job starts at the earliest after this
+ *                                time.
+ * @param job              In:    The job.
+ * @return  0  if the job was queued or coalesced.
+ *          -1 if the key is not one of the stack.
+ */
+static int pf_bg_worker_queue_stack_job (
+   pnet_t * net,
+   pnet_bg_job_prio_t prio,
+   uint32_t key,
+   uint32_t delay_us,
+   pnet_bg_job_run_t job)
+{
+   uint32_t stack_ix = key & ~PNET_BG_JOB_KEY_RESERVED;
+   pf_bg_job_entry_t * p_entry;
+
+   if (stack_ix >= PF_BG_WORKER_STACK_JOBS)
    {
       return -1;
    }
 
+   p_entry = &net->pf_bg_worker.jobs[PNET_MAX_BG_JOBS + stack_ix];
+   if (p_entry->in_use == false)
+   {
+      memset (p_entry, 0, sizeof (*p_entry));
+      p_entry->in_use = true;
+      p_entry->prio = prio;
+      p_entry->key = key;
+      pf_bg_worker_set_seq (net, p_entry);
+      p_entry->run = job;
+      p_entry->start_time_us = os_get_current_time_us() + delay_us;
+   }
+   else if (p_entry->running && p_entry->rerun == false)
+   {
+      p_entry->rerun = true;
+      p_entry->rerun_start_time_us = os_get_current_time_us() + delay_us;
+   }
+
+   return 0;
+}
+
+int pf_bg_worker_submit_job (
+   pnet_t * net,
+   pnet_bg_job_prio_t prio,
+   uint32_t key,
+   uint32_t delay_us,
+   pnet_bg_job_run_t job,
+   void * arg,
+   pnet_bg_job_done_t done,
+   void * done_arg)
+{
+   pf_bg_job_entry_t * p_leader = NULL;
+   pf_bg_job_entry_t * p_entry = NULL;
+   pf_bg_job_waiter_t * p_waiter = NULL;
+   int ret = 0;
+
+   if (
+      net == NULL || job == NULL || prio < PNET_BG_JOB_PRIO_HIGH ||
+      prio > PNET_BG_JOB_PRIO_LOW)
+   {
+      return -1;
+   }
+
+   os_mutex_lock (net->pf_bg_worker.mutex);
+   if ((key & PNET_BG_JOB_KEY_RESERVED) != 0)
+   {
+      /* The jobs of the stack have neither argument nor completion */
+      ret = pf_bg_worker_queue_stack_job (net, prio, key, delay_us, job);
+   }
+   else
+   {
+      if (key != PNET_BG_JOB_KEY_NONE)
+      {
+         p_leader = pf_bg_worker_find_queued (net, key);
+      }
+
+      if (p_leader == NULL)
+      {
+         p_entry = pf_bg_worker_find_free (net);
+         if (p_entry == NULL)
+         {
+            ret = -1;
+         }
+         else
+         {
+            memset (p_entry, 0, sizeof (*p_entry));
+            p_entry->in_use = true;
+            p_entry->prio = prio;
+            p_entry->key = key;
+            pf_bg_worker_set_seq (net, p_entry);
+            p_entry->run = job;
+            p_entry->arg = arg;
+            p_entry->done = done;
+            p_entry->done_arg = done_arg;
+            p_entry->start_time_us = os_get_current_time_us() + delay_us;
+         }
+      }
+      else if (done != NULL)
+      {
+         /* Coalesced. Only the completion callback waits, outside the queue */
+         p_waiter = pf_bg_worker_find_free_waiter (net);
+         if (p_waiter == NULL)
+         {
+            ret = -1;
+         }
+         else
+         {
+            p_waiter->in_use = true;
+            p_waiter->leader_seq = p_leader->seq;
+            p_waiter->done = done;
+            p_waiter->done_arg = done_arg;
+         }
+      }
+      /* else: Coalesced, and nobody to tell */
+   }
+   os_mutex_unlock (net->pf_bg_worker.mutex);
+
+   if (ret == 0)
+   {
+      os_event_set (net->pf_bg_worker.events, BG_WORKER_EVENT_JOB);
+   }
+   else
+   {
+      LOG_ERROR (
+         PNET_LOG,
+         "BGW(%d): Job queue is full. Increase PNET_MAX_BG_JOBS.\n",
+         __LINE__);
+   }
+
+   return ret;
+}
+
+/** Job function for updating the port status */
+static int pf_bg_job_update_ports_status (pnet_t * net, void * arg)
+{
+   pf_pdport_update_eth_status (net);
+   return 0;
+}
+
+/** Job function for saving the ASE data */
+static int pf_bg_job_save_ase_nvm_data (pnet_t * net, void * arg)
+{
+   pf_cmina_save_ase (net, &net->cmina_nonvolatile_dcp_ase);
+   return 0;
+}
+
+/** Job function for saving the I&M data */
+static int pf_bg_job_save_im_nvm_data (pnet_t * net, void * arg)
+{
+   pf_fspm_save_im (net);
+   return 0;
+}
+
+/** Job function for saving the PDPort data */
+static int pf_bg_job_save_pdport_nvm_data (pnet_t * net, void * arg)
+{
+   return pf_pdport_save_all (net);
+}
+
+int pf_bg_worker_start_job (pnet_t * net, pf_bg_job_t job_id)
+{
    switch (job_id)
    {
    case PF_BGJOB_UPDATE_PORTS_STATUS:
-      os_event_set (net->pf_bg_worker.events, BG_JOB_EVENT_UPDATE_PORTS_STATUS);
-      break;
+      return pf_bg_worker_submit_job (
+         net,
+         PNET_BG_JOB_PRIO_HIGH,
+         BG_JOB_KEY_UPDATE_PORTS_STATUS,
+         0,
+         pf_bg_job_update_ports_status,
+         NULL,
+         NULL,
+         NULL);
    case PF_BGJOB_SAVE_ASE_NVM_DATA:
-      os_event_set (net->pf_bg_worker.events, BG_JOB_EVENT_SAVE_ASE_NVM_DATA);
-      break;
+      return pf_bg_worker_submit_job (
+         net,
+         PNET_BG_JOB_PRIO_NORMAL,
+         BG_JOB_KEY_SAVE_ASE_NVM_DATA,
+         BG_JOB_SAVE_HOLDOFF_US,
+         pf_bg_job_save_ase_nvm_data,
+         NULL,
+         NULL,
+         NULL);
    case PF_BGJOB_SAVE_IM_NVM_DATA:
-      os_event_set (net->pf_bg_worker.events, BG_JOB_EVENT_SAVE_IM_NVM_DATA);
-      break;
+      return pf_bg_worker_submit_job (
+         net,
+         PNET_BG_JOB_PRIO_NORMAL,
+         BG_JOB_KEY_SAVE_IM_NVM_DATA,
+         BG_JOB_SAVE_HOLDOFF_US,
+         pf_bg_job_save_im_nvm_data,
+         NULL,
+         NULL,
+         NULL);
    case PF_BGJOB_SAVE_PDPORT_NVM_DATA:
-      os_event_set (net->pf_bg_worker.events, BG_JOB_EVENT_SAVE_PDPORT_NVM_DATA);
-      break;
+      return pf_bg_worker_submit_job (
+         net,
+         PNET_BG_JOB_PRIO_NORMAL,
+         BG_JOB_KEY_SAVE_PDPORT_NVM_DATA,
+         BG_JOB_SAVE_HOLDOFF_US,
+         pf_bg_job_save_pdport_nvm_data,
+         NULL,
+         NULL,
+         NULL);
    default:
       LOG_ERROR (
          PNET_LOG,
@@ -79,54 +402,154 @@ int pf_bg_worker_start_job (pnet_t * net, pf_bg_job_t job_id)
          (int)job_id);
       return -1;
    }
+}
 
-   return 0;
+/**
+ * @internal
+ * Pick the next job to run, and mark it as running.
+ *
+ * The queue mutex must be held by the caller.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_wait_us        Out:   Time until the next delayed job may start,
+ *                                or UINT32_MAX if there is none. Only set if
+ *                                no job is returned.
+ * @return  the job, or NULL if no job may start now.
+ */
+static pf_bg_job_entry_t * pf_bg_worker_take_next (
+   pnet_t * net,
+   uint32_t * p_wait_us)
+{
+   pf_bg_job_entry_t * p_next = NULL;
+   pf_bg_job_entry_t * p_entry;
+   uint32_t now = os_get_current_time_us();
+   int32_t remaining_us;
+   uint16_t ix;
+
+   *p_wait_us = UINT32_MAX;
+   for (ix = 0; ix < NELEMENTS (net->pf_bg_worker.jobs); ix++)
+   {
+      p_entry = &net->pf_bg_worker.jobs[ix];
+      if (p_entry->in_use == false || p_entry->running)
+      {
+         continue;
+      }
+      remaining_us = (int32_t)(p_entry->start_time_us - now);
+      if (remaining_us > 0)
+      {
+         if ((uint32_t)remaining_us < *p_wait_us)
+         {
+            *p_wait_us = (uint32_t)remaining_us;
+         }
+      }
+      else if (
+         p_next == NULL || p_entry->prio < p_next->prio ||
+         (p_entry->prio == p_next->prio &&
+          (int32_t)(p_entry->seq - p_next->seq) < 0))
+      {
+         p_next = p_entry;
+      }
+   }
+
+   if (p_next != NULL)
+   {
+      p_next->running = true;
+   }
+
+   return p_next;
 }
 
 /**
- * Event handling loop for background thread
+ * @internal
+ * Run a job, and call the completion callbacks of it and of the submissions
+ * coalesced with it.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_job            InOut: The job, marked as running.
+ */
+static void pf_bg_worker_run_job (pnet_t * net, pf_bg_job_entry_t * p_job)
+{
+   pnet_bg_job_done_t done[PNET_MAX_BG_JOBS + 1];
+   void * done_arg[PNET_MAX_BG_JOBS + 1];
+   pf_bg_job_waiter_t * p_waiter;
+   uint16_t num_done = 0;
+   uint16_t ix;
+   int result;
+
+   result = p_job->run (net, p_job->arg);
+
+   os_mutex_lock (net->pf_bg_worker.mutex);
+   if (p_job->done != NULL)
+   {
+      done[num_done] = p_job->done;
+      done_arg[num_done] = p_job->done_arg;
+      num_done++;
+   }
+   for (ix = 0; ix < PNET_MAX_BG_JOBS; ix++)
+   {
+      p_waiter = &net->pf_bg_worker.waiters[ix];
+      if (p_waiter->in_use && p_waiter->leader_seq == p_job->seq)
+      {
+         done[num_done] = p_waiter->done;
+         done_arg[num_done] = p_waiter->done_arg;
+         num_done++;
+         p_waiter->in_use = false;
+      }
+   }
+   if (p_job->rerun)
+   {
+      /* A job of the stack, requested again while it ran */
+      p_job->rerun = false;
+      p_job->running = false;
+      p_job->start_time_us = p_job->rerun_start_time_us;
+      pf_bg_worker_set_seq (net, p_job);
+   }
+   else
+   {
+      p_job->in_use = false;
+   }
+   os_mutex_unlock (net->pf_bg_worker.mutex);
+
+   /* The callbacks may submit new jobs */
+   for (ix = 0; ix < num_done; ix++)
+   {
+      done[ix] (net, done_arg[ix], result);
+   }
+}
+
+/**
+ * Job handling loop for background thread
  *
  * @param arg              InOut: Thread argument, must be of type pnet_t *
  */
 static void bg_worker_task (void * arg)
 {
    pnet_t * net = (pnet_t *)arg;
-   uint32_t mask =
-      BG_JOB_EVENT_UPDATE_PORTS_STATUS | BG_JOB_EVENT_SAVE_ASE_NVM_DATA |
-      BG_JOB_EVENT_SAVE_IM_NVM_DATA | BG_JOB_EVENT_SAVE_PDPORT_NVM_DATA;
+   pf_bg_job_entry_t * p_job;
+   uint32_t wait_us = 0;
    uint32_t flags = 0;
 
    for (;;)
    {
-      os_event_wait (net->pf_bg_worker.events, mask, &flags, OS_WAIT_FOREVER);
+      os_event_clr (net->pf_bg_worker.events, BG_WORKER_EVENT_JOB);
 
-      if (flags & BG_JOB_EVENT_SAVE_ASE_NVM_DATA)
-      {
-         os_event_clr (net->pf_bg_worker.events, BG_JOB_EVENT_SAVE_ASE_NVM_DATA);
-
-         pf_cmina_save_ase (net, &net->cmina_nonvolatile_dcp_ase);
-      }
-      if (flags & BG_JOB_EVENT_SAVE_IM_NVM_DATA)
-      {
-         os_event_clr (net->pf_bg_worker.events, BG_JOB_EVENT_SAVE_IM_NVM_DATA);
+      os_mutex_lock (net->pf_bg_worker.mutex);
+      p_job = pf_bg_worker_take_next (net, &wait_us);
+      os_mutex_unlock (net->pf_bg_worker.mutex);
 
-         pf_fspm_save_im (net);
-      }
-      if (flags & BG_JOB_EVENT_SAVE_PDPORT_NVM_DATA)
+      if (p_job != NULL)
       {
-         os_event_clr (
-            net->pf_bg_worker.events,
-            BG_JOB_EVENT_SAVE_PDPORT_NVM_DATA);
-
-         (void)pf_pdport_save_all (net);
+         pf_bg_worker_run_job (net, p_job);
       }
-      if (flags & BG_JOB_EVENT_UPDATE_PORTS_STATUS)
+      else
       {
-         os_event_clr (
+         /* Wake up for new jobs, or when a delayed job may start */
+         (void)os_event_wait (
             net->pf_bg_worker.events,
-            BG_JOB_EVENT_UPDATE_PORTS_STATUS);
-
-         pf_pdport_update_eth_status (net);
+            BG_WORKER_EVENT_JOB,
+            &flags,
+            (wait_us == UINT32_MAX) ? OS_WAIT_FOREVER
+                                    : (wait_us + 999) / 1000);
       }
    }
 }
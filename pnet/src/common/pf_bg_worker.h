@@ -46,13 +46,44 @@ typedef enum pf_bg_job
 void pf_bg_worker_init (pnet_t * net);
 
 /**
- * Start a background job.
- * This function is non-blocking and sends the job request
- * to the background worker task.
+ * Queue a job for the background worker task.
+ *
+ * See \a pnet_bg_job_submit(), which is this function without \a delay_us
+ * and reserved keys.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param prio             In:    Priority of the job.
+ * @param key              In:    Key for coalescing, or PNET_BG_JOB_KEY_NONE.
+ * @param delay_us         In:    The job starts at the earliest after this
+ *                                time. Submissions with the same key within
+ *                                this time are coalesced.
+ * @param job              In:    The job. Mandatory.
+ * @param arg              InOut: Argument of the job.
+ * @param done             In:    Completion callback, or NULL.
+ * @param done_arg         InOut: Argument of the completion callback.
+ * @return  0  if the job was queued or coalesced.
+ *          -1 if the queue is full or an argument is invalid.
+ */
+int pf_bg_worker_submit_job (
+   pnet_t * net,
+   pnet_bg_job_prio_t prio,
+   uint32_t key,
+   uint32_t delay_us,
+   pnet_bg_job_run_t job,
+   void * arg,
+   pnet_bg_job_done_t done,
+   void * done_arg);
+
+/**
+ * Start a background job of the stack.
+ * This function is non-blocking and queues the job for the background worker
+ * task. A job which is already queued is not queued again, and a job which is
+ * running runs once more. Each job has its own queue entry, so the submitted
+ * jobs of the application can not crowd it out.
  * @param net              InOut: The p-net stack instance
  * @param job_id           In:    Job to run
  * @return  0  if operation is successfully initiated
- *          -1 if an error occurred.
+ *          -1 if \a job_id is invalid.
  */
 int pf_bg_worker_start_job (pnet_t * net, pf_bg_job_t job_id);
 
@@ -218,6 +218,14 @@ static void pf_cpm_get_buf (
       p_cpm->p_buffer_app = p_cpm->p_buffer_cpm;
       p_cpm->p_buffer_cpm = p;
       p_cpm->new_buf = false;
+
+      if (((pnal_buf_t *)p_cpm->p_buffer_app)->timestamp_ns != 0)
+      {
+         pf_eth_interval_stats_add (
+            &p_cpm->rx_to_app,
+            pnal_get_time_ns() -
+               ((pnal_buf_t *)p_cpm->p_buffer_app)->timestamp_ns);
+      }
    }
    else
    {
@@ -236,6 +244,36 @@ static void pf_cpm_get_buf (
    }
 }
 
+/**
+ * @internal
+ * Update the receive jitter statistics with a new frame.
+ * @param net              InOut: The p-net stack instance
+ * @param p_iocr           InOut: The IOCR instance.
+ * @param timestamp_ns     In:    Reception time of the frame.
+ */
+static void pf_cpm_update_rx_jitter (
+   pnet_t * net,
+   pf_iocr_t * p_iocr,
+   uint64_t timestamp_ns)
+{
+   pf_cpm_t * p_cpm = &p_iocr->cpm;
+   uint64_t cycle_ns = (uint64_t)p_iocr->param.send_clock_factor *
+                       p_iocr->param.reduction_ratio * 31250;
+   uint64_t interval_ns;
+
+   os_mutex_lock (net->cpm_buf_lock);
+   if (p_cpm->last_rx_timestamp_ns != 0)
+   {
+      interval_ns = timestamp_ns - p_cpm->last_rx_timestamp_ns;
+      pf_eth_interval_stats_add (
+         &p_cpm->rx_jitter,
+         (interval_ns > cycle_ns) ? interval_ns - cycle_ns
+                                  : cycle_ns - interval_ns);
+   }
+   p_cpm->last_rx_timestamp_ns = timestamp_ns;
+   os_mutex_unlock (net->cpm_buf_lock);
+}
+
 /**
  * @internal
  * Handle new incoming cyclic data frames on Ethernet.
@@ -341,6 +379,11 @@ static int pf_cpm_c_data_ind (
                                                                        */
          }
 
+         if (p_buf->timestamp_ns != 0)
+         {
+            pf_cpm_update_rx_jitter (net, p_iocr, p_buf->timestamp_ns);
+         }
+
          if (update_data)
          {
             /* 20 */
@@ -411,6 +454,10 @@ static int pf_cpm_driver_sw_activate_req (
    p_iocr = &p_ar->iocrs[crep];
    p_cpm = &p_iocr->cpm;
 
+   p_cpm->last_rx_timestamp_ns = 0;
+   memset (&p_cpm->rx_to_app, 0, sizeof (p_cpm->rx_to_app));
+   memset (&p_cpm->rx_jitter, 0, sizeof (p_cpm->rx_jitter));
+
    pf_eth_frame_id_map_add (net, p_cpm->frame_id[0], pf_cpm_c_data_ind, p_iocr);
 
    if (p_cpm->nbr_frame_id == 2)
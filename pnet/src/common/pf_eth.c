@@ -25,9 +25,12 @@
  */
 
 #ifdef UNIT_TEST
-#define pnal_eth_init       mock_pnal_eth_init
-#define pnal_eth_send       mock_pnal_eth_send
-#define pnal_get_macaddress mock_pnal_get_macaddress
+#define pnal_eth_init                mock_pnal_eth_init
+#define pnal_eth_send                mock_pnal_eth_send
+#define pnal_eth_send_cyclic         mock_pnal_eth_send_cyclic
+#define pnal_get_macaddress          mock_pnal_get_macaddress
+#define pnal_eth_set_frame_id_filter mock_pnal_eth_set_frame_id_filter
+#define pnal_eth_get_tx_timestamp    mock_pnal_eth_get_tx_timestamp
 #endif
 
 #include <string.h>
@@ -99,6 +102,47 @@ static int pf_eth_init_netif (
    return 0;
 }
 
+/**
+ * @internal
+ * Let the management port only receive the frames handled by pf_eth_recv().
+ *
+ * Installs a filter for the frame IDs in the frame id map, which drops
+ * all other frames before they are copied to the receive thread.
+ *
+ * @param net              InOut: The p-net stack instance
+ */
+static void pf_eth_update_frame_id_filter (pnet_t * net)
+{
+   uint16_t frame_ids[PF_ETH_MAX_MAP];
+   uint16_t nbr_of_frame_ids = 0;
+   uint16_t ix;
+
+   if (net->pf_interface.main_port.handle == NULL)
+   {
+      return;
+   }
+
+   for (ix = 0; ix < NELEMENTS (net->eth_id_map); ix++)
+   {
+      if (net->eth_id_map[ix].in_use)
+      {
+         frame_ids[nbr_of_frame_ids++] = net->eth_id_map[ix].frame_id;
+      }
+   }
+
+   if (
+      pnal_eth_set_frame_id_filter (
+         net->pf_interface.main_port.handle,
+         frame_ids,
+         nbr_of_frame_ids) != 0)
+   {
+      LOG_DEBUG (
+         PF_ETH_LOG,
+         "ETH(%d): No frame filter. All frames are received.\n",
+         __LINE__);
+   }
+}
+
 int pf_eth_init (pnet_t * net, const pnet_cfg_t * p_cfg)
 {
    int port;
@@ -122,6 +166,7 @@ int pf_eth_init (pnet_t * net, const pnet_cfg_t * p_cfg)
    {
       return -1;
    }
+   pf_eth_update_frame_id_filter (net);
 
    /* Init physical ports */
    pf_port_init_iterator_over_ports (net, &port_iterator);
@@ -194,6 +239,55 @@ int pf_eth_send_on_management_port (pnet_t * net, pnal_buf_t * buf)
    return sent_len;
 }
 
+int pf_eth_send_cyclic_on_management_port (
+   pnet_t * net,
+   pnal_buf_t * buf,
+   uint32_t late_us)
+{
+   int sent_len = 0;
+
+   sent_len =
+      pnal_eth_send_cyclic (net->pf_interface.main_port.handle, buf, late_us);
+   if (sent_len <= 0)
+   {
+      LOG_ERROR (
+         PF_ETH_LOG,
+         "ETH(%d): Error from pnal_eth_send_cyclic()\n",
+         __LINE__);
+   }
+
+   return sent_len;
+}
+
+int pf_eth_get_tx_timestamp_on_management_port (
+   pnet_t * net,
+   const pnal_buf_t * buf,
+   uint64_t * timestamp_ns)
+{
+   return pnal_eth_get_tx_timestamp (
+      net->pf_interface.main_port.handle,
+      buf,
+      timestamp_ns);
+}
+
+void pf_eth_interval_stats_add (
+   pnet_interval_stats_t * p_stats,
+   uint64_t interval_ns)
+{
+   uint32_t ns = (interval_ns > UINT32_MAX) ? UINT32_MAX : interval_ns;
+
+   if (p_stats->count == 0 || ns < p_stats->min_ns)
+   {
+      p_stats->min_ns = ns;
+   }
+   if (ns > p_stats->max_ns)
+   {
+      p_stats->max_ns = ns;
+   }
+   p_stats->sum_ns += ns;
+   p_stats->count++;
+}
+
 int pf_eth_recv (pnal_eth_handle_t * eth_handle, void * arg, pnal_buf_t * p_buf)
 {
    int ret = 0; /* Means: "Not handled" */
@@ -289,6 +383,7 @@ void pf_eth_frame_id_map_add (
       net->eth_id_map[ix].frame_handler = frame_handler;
       net->eth_id_map[ix].p_arg = p_arg;
       net->eth_id_map[ix].in_use = true;
+      pf_eth_update_frame_id_filter (net);
    }
    else
    {
@@ -310,6 +405,7 @@ void pf_eth_frame_id_map_remove (pnet_t * net, uint16_t frame_id)
    if (ix < NELEMENTS (net->eth_id_map))
    {
       net->eth_id_map[ix].in_use = false;
+      pf_eth_update_frame_id_filter (net);
       LOG_DEBUG (
          PF_ETH_LOG,
          "ETH(%d): Free room for FrameIds %#x at index %u\n",
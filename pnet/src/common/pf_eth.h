@@ -58,12 +58,57 @@ int pf_eth_send_on_physical_port (
  */
 int pf_eth_send_on_management_port (pnet_t * net, pnal_buf_t * buf);
 
+/**
+ * Send cyclic raw Ethernet frame on management port.
+ *
+ * See pnal_eth_send_cyclic().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param buf              In:    Buffer with data to be sent
+ * @param late_us          In:    How long after the scheduled send time the
+ *                                frame is sent, in microseconds
+ * @return  The number of bytes sent, or -1 if an error occurred.
+ */
+int pf_eth_send_cyclic_on_management_port (
+   pnet_t * net,
+   pnal_buf_t * buf,
+   uint32_t late_us);
+
+/**
+ * Get the transmit timestamp of a frame sent on the management port.
+ *
+ * Only available when pnal_cfg.eth_timestamping is enabled, and only for
+ * recently sent frames. See pnal_eth_get_tx_timestamp().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param buf              In:    Buffer with the sent frame
+ * @param timestamp_ns     Out:   Time when the frame was sent, see
+ *                                pnal_get_time_ns()
+ * @return  0  if the timestamp was found.
+ *          -1 if not found.
+ */
+int pf_eth_get_tx_timestamp_on_management_port (
+   pnet_t * net,
+   const pnal_buf_t * buf,
+   uint64_t * timestamp_ns);
+
+/**
+ * Add a time interval to timing statistics.
+ *
+ * @param p_stats          InOut: Statistics
+ * @param interval_ns      In:    Time interval in nanoseconds
+ */
+void pf_eth_interval_stats_add (
+   pnet_interval_stats_t * p_stats,
+   uint64_t interval_ns);
+
 /**
  * Add a frame_id entry to the frame id filter map.
  *
  * This function adds an entry to the frame id table.
  * This table is used to map incoming frames to the right handler functions,
- * based on the frame id.
+ * based on the frame id. The management port only receives frames with
+ * a frame id in the table, see pnal_eth_set_frame_id_filter().
  *
  * Used only for incoming frames with Ethtype = Profinet.
  *
@@ -20,6 +20,10 @@
  * Adds the bytes "PNET" and a version indicator to the beginning of the file
  * when writing. Checks the corresponding values when reading.
  *
+ * Keeps a shadow with the size and a content hash of each file loaded or
+ * saved, so pf_file_save_if_modified() can detect changes without reading
+ * the file back.
+ *
  */
 
 #ifdef UNIT_TEST
@@ -41,6 +45,25 @@
 /* Increase every time the saved contents have another format */
 #define PF_FILE_VERSION 0x00000001U
 
+/* Number of files tracked by the shadow. Files not fitting are compared
+ * with the contents on disk instead.
+ */
+#define PF_FILE_SHADOW_ENTRIES 16
+
+#define PF_FILE_HASH_OFFSET 0xCBF29CE484222325ULL /* FNV-1a 64 bit */
+#define PF_FILE_HASH_PRIME  0x00000100000001B3ULL
+
+typedef struct pf_file_shadow_entry
+{
+   bool in_use;
+   size_t size;
+   uint64_t hash;
+   char path[PNET_MAX_FILE_FULLPATH_SIZE]; /**< Terminated string */
+} pf_file_shadow_entry_t;
+
+static os_mutex_t * pf_file_shadow_mutex = NULL;
+static pf_file_shadow_entry_t pf_file_shadow[PF_FILE_SHADOW_ENTRIES];
+
 /* The configurable constant PNET_MAX_FILENAME_SIZE should be at least
  * as large as the longest filename used, including termination.
  */
@@ -137,6 +160,168 @@ int pf_file_join_directory_filename (
    return 0;
 }
 
+void pf_file_init (void)
+{
+   if (pf_file_shadow_mutex == NULL)
+   {
+      pf_file_shadow_mutex = os_mutex_create();
+      CC_ASSERT (pf_file_shadow_mutex != NULL);
+   }
+}
+
+/**
+ * @internal
+ * Calculate the content hash of an object.
+ *
+ * @param p_object         In:    Object
+ * @param size             In:    Size of object
+ * @return  the FNV-1a hash of the object.
+ */
+static uint64_t pf_file_hash (const void * p_object, size_t size)
+{
+   const uint8_t * p_byte = (const uint8_t *)p_object;
+   uint64_t hash = PF_FILE_HASH_OFFSET;
+   size_t ix;
+
+   for (ix = 0; ix < size; ix++)
+   {
+      hash ^= p_byte[ix];
+      hash *= PF_FILE_HASH_PRIME;
+   }
+
+   return hash;
+}
+
+/**
+ * @internal
+ * Find the shadow entry of a file.
+ *
+ * The shadow mutex must be held by the caller.
+ *
+ * @param path             In:    Full path to the file. Terminated string.
+ * @return  the entry, or NULL if the file is not in the shadow.
+ */
+static pf_file_shadow_entry_t * pf_file_shadow_find (const char * path)
+{
+   uint16_t ix;
+
+   for (ix = 0; ix < PF_FILE_SHADOW_ENTRIES; ix++)
+   {
+      if (
+         pf_file_shadow[ix].in_use &&
+         strcmp (pf_file_shadow[ix].path, path) == 0)
+      {
+         return &pf_file_shadow[ix];
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * @internal
+ * Remember the contents of a file, as it is on disk.
+ *
+ * If the shadow is full, the file is not remembered.
+ *
+ * @param path             In:    Full path to the file. Terminated string.
+ * @param p_object         In:    Contents of the file, without version
+ *                                information.
+ * @param size             In:    Size of the contents.
+ */
+static void pf_file_shadow_update (
+   const char * path,
+   const void * p_object,
+   size_t size)
+{
+   pf_file_shadow_entry_t * p_entry = NULL;
+   uint64_t hash = pf_file_hash (p_object, size);
+   uint16_t ix;
+
+   if (pf_file_shadow_mutex == NULL)
+   {
+      return;
+   }
+
+   os_mutex_lock (pf_file_shadow_mutex);
+   p_entry = pf_file_shadow_find (path);
+   for (ix = 0; p_entry == NULL && ix < PF_FILE_SHADOW_ENTRIES; ix++)
+   {
+      if (pf_file_shadow[ix].in_use == false)
+      {
+         p_entry = &pf_file_shadow[ix];
+         strcpy (p_entry->path, path);
+         p_entry->in_use = true;
+      }
+   }
+   if (p_entry != NULL)
+   {
+      p_entry->size = size;
+      p_entry->hash = hash;
+   }
+   os_mutex_unlock (pf_file_shadow_mutex);
+}
+
+/**
+ * @internal
+ * Forget the contents of a file, for example when it has been removed.
+ *
+ * @param path             In:    Full path to the file. Terminated string.
+ */
+static void pf_file_shadow_invalidate (const char * path)
+{
+   pf_file_shadow_entry_t * p_entry = NULL;
+
+   if (pf_file_shadow_mutex == NULL)
+   {
+      return;
+   }
+
+   os_mutex_lock (pf_file_shadow_mutex);
+   p_entry = pf_file_shadow_find (path);
+   if (p_entry != NULL)
+   {
+      p_entry->in_use = false;
+   }
+   os_mutex_unlock (pf_file_shadow_mutex);
+}
+
+/**
+ * @internal
+ * Compare an object with the shadow of a file.
+ *
+ * @param path             In:    Full path to the file. Terminated string.
+ * @param p_object         In:    Object to compare.
+ * @param size             In:    Size of object.
+ * @return  1  if the file is known to have other contents.
+ *          0  if the file is known to have the same contents.
+ *          -1 if the file is not in the shadow.
+ */
+static int pf_file_shadow_compare (
+   const char * path,
+   const void * p_object,
+   size_t size)
+{
+   pf_file_shadow_entry_t * p_entry = NULL;
+   uint64_t hash = pf_file_hash (p_object, size);
+   int ret = -1;
+
+   if (pf_file_shadow_mutex == NULL)
+   {
+      return -1;
+   }
+
+   os_mutex_lock (pf_file_shadow_mutex);
+   p_entry = pf_file_shadow_find (path);
+   if (p_entry != NULL)
+   {
+      ret = (p_entry->size == size && p_entry->hash == hash) ? 0 : 1;
+   }
+   os_mutex_unlock (pf_file_shadow_mutex);
+
+   return ret;
+}
+
 int pf_file_load (
    const char * directory,
    const char * filename,
@@ -213,6 +398,8 @@ int pf_file_load (
       return -1;
    }
 
+   pf_file_shadow_update (path, p_object, size);
+
    return 0;
 }
 
@@ -265,6 +452,16 @@ int pf_file_save (
       path,
       ((os_get_current_time_us() - start_time_us) / 1000));
 
+   if (ret == 0)
+   {
+      pf_file_shadow_update (path, p_object, size);
+   }
+   else
+   {
+      /* The file may be left unchanged, or be removed */
+      pf_file_shadow_invalidate (path);
+   }
+
    return ret;
 }
 
@@ -275,26 +472,44 @@ int pf_file_save_if_modified (
    void * p_tempobject,
    size_t size)
 {
-   bool save = false;
-   int ret = 0; /* Assume no changes */
+   char path[PNET_MAX_FILE_FULLPATH_SIZE]; /**< Terminated string */
+   int ret = 0;                            /* Assume no changes */
 
-   memset (p_tempobject, 0, size);
+   if (
+      pf_file_join_directory_filename (
+         directory,
+         filename,
+         path,
+         PNET_MAX_FILE_FULLPATH_SIZE) != 0)
+   {
+      return -1;
+   }
 
-   if (pf_file_load (directory, filename, p_tempobject, size) == 0)
+   switch (pf_file_shadow_compare (path, p_object, size))
    {
-      if (memcmp (p_tempobject, p_object, size) != 0)
+   case 0:
+      break;
+   case 1:
+      ret = 1;
+      break;
+   default:
+      /* Not known yet. Loading the file also adds it to the shadow. */
+      memset (p_tempobject, 0, size);
+      if (pf_file_load (directory, filename, p_tempobject, size) == 0)
       {
-         ret = 1;
-         save = true;
+         if (memcmp (p_tempobject, p_object, size) != 0)
+         {
+            ret = 1;
+         }
       }
-   }
-   else
-   {
-      ret = 2;
-      save = true;
+      else
+      {
+         ret = 2;
+      }
+      break;
    }
 
-   if (save == true)
+   if (ret != 0)
    {
       if (pf_file_save (directory, filename, p_object, size) != 0)
       {
@@ -319,5 +534,6 @@ void pf_file_clear (const char * directory, const char * filename)
       return;
    }
 
-   return pnal_clear_file (path);
+   pf_file_shadow_invalidate (path);
+   pnal_clear_file (path);
 }
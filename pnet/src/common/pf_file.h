@@ -33,6 +33,13 @@ extern "C" {
 #define PF_FILENAME_PDPORT_3    "pnet_data_pdport_3.bin"
 #define PF_FILENAME_PDPORT_4    "pnet_data_pdport_4.bin"
 
+/**
+ * Initialize the file handling.
+ *
+ * May be called several times, also by several stack instances.
+ */
+void pf_file_init (void);
+
 /**
  * Load a binary file, and verify the file version.
  *
@@ -73,7 +80,9 @@ int pf_file_save (
  * Save a binary file if modified, and include version information.
  *
  * No saving is done if the content would be the same. This reduces the flash
- * memory wear.
+ * memory wear. The content is compared with the shadow of the last contents
+ * loaded or saved, and the file is only read from disk if it is not in the
+ * shadow yet.
  *
  * @param directory        In:    Directory for files. Terminated string. NULL
  *                                or empty string is interpreted as current
@@ -81,7 +90,7 @@ int pf_file_save (
  * @param filename         In:    File name. Terminated string.
  * @param p_object         In:    Struct to save
  * @param p_tempobject     Temp:  Temporary buffer (of same size as object) for
- *                                loading existing file.
+ *                                loading existing file, if not in the shadow.
  * @param size             In:    Size of struct to save
  * @return  2 First saving of file (no previous file with correct version found)
  *          1 Updated file
@@ -192,6 +192,8 @@ void pf_ppm_finish_buffer (pnet_t * net, pf_ppm_t * p_ppm, uint16_t data_length)
    /* Insert data */
    os_mutex_lock (net->ppm_buf_lock);
    memcpy (&p_payload[p_ppm->buffer_pos], p_ppm->buffer_data, data_length);
+   p_ppm->sent_app_data_time_ns = p_ppm->app_data_time_ns;
+   p_ppm->app_data_time_ns = 0;
    os_mutex_unlock (net->ppm_buf_lock);
 
    /* Insert cycle counter */
@@ -18,6 +18,56 @@
 #include <string.h>
 #include <inttypes.h>
 
+/**
+ * @internal
+ * Update the timing statistics with the transmit timestamp of the
+ * previously sent frame.
+ *
+ * Call before the send buffer is updated with the next frame.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_iocr           InOut: The IOCR instance.
+ */
+static void pf_ppm_drv_sw_update_tx_timing (pnet_t * net, pf_iocr_t * p_iocr)
+{
+   pf_ppm_t * p_ppm = &p_iocr->ppm;
+   uint64_t cycle_ns = (uint64_t)p_iocr->param.send_clock_factor *
+                       p_iocr->param.reduction_ratio * 31250;
+   uint64_t interval_ns;
+   uint64_t timestamp_ns;
+
+   if (
+      pf_eth_get_tx_timestamp_on_management_port (
+         net,
+         p_ppm->p_send_buffer,
+         &timestamp_ns) != 0)
+   {
+      p_ppm->last_tx_timestamp_ns = 0;
+      return;
+   }
+
+   os_mutex_lock (net->ppm_buf_lock);
+   if (p_ppm->last_tx_timestamp_ns != 0)
+   {
+      interval_ns = timestamp_ns - p_ppm->last_tx_timestamp_ns;
+      pf_eth_interval_stats_add (
+         &p_ppm->tx_jitter,
+         (interval_ns > cycle_ns) ? interval_ns - cycle_ns
+                                  : cycle_ns - interval_ns);
+   }
+   if (
+      p_ppm->sent_app_data_time_ns != 0 &&
+      timestamp_ns > p_ppm->sent_app_data_time_ns)
+   {
+      pf_eth_interval_stats_add (
+         &p_ppm->app_to_tx,
+         timestamp_ns - p_ppm->sent_app_data_time_ns);
+   }
+   os_mutex_unlock (net->ppm_buf_lock);
+
+   p_ppm->last_tx_timestamp_ns = timestamp_ns;
+}
+
 /**
  * @internal
  * Send the process data frame.
@@ -38,16 +88,30 @@ static void pf_ppm_drv_sw_send (pnet_t * net, void * arg, uint32_t current_time)
 {
    pf_iocr_t * p_arg = (pf_iocr_t *)arg;
    uint32_t delay = 0;
+   int32_t late_us;
 
    pf_scheduler_reset_handle (&p_arg->ppm.ci_timeout);
    if (p_arg->ppm.ci_running == true)
    {
+      if (
+         net->fspm_cfg.pnal_cfg.eth_timestamping != PNAL_TIMESTAMPING_OFF &&
+         p_arg->ppm.first_transmit == true)
+      {
+         pf_ppm_drv_sw_update_tx_timing (net, p_arg);
+      }
+
       /* Insert data, status etc. The in_length is the size of input to the
        * controller */
       pf_ppm_finish_buffer (net, &p_arg->ppm, p_arg->in_length);
 
-      /* Now send it */
-      if (pf_eth_send_on_management_port (net, p_arg->ppm.p_send_buffer) > 0)
+      /* Now send it. The lateness allows a launch time to compensate for
+       * the scheduling jitter. */
+      late_us = (int32_t)(os_get_current_time_us() - p_arg->ppm.next_exec);
+      if (
+         pf_eth_send_cyclic_on_management_port (
+            net,
+            p_arg->ppm.p_send_buffer,
+            (late_us > 0) ? late_us : 0) > 0)
       {
          /* Schedule next execution */
          p_arg->ppm.next_exec += p_arg->ppm.control_interval;
@@ -95,6 +159,10 @@ int pf_ppm_drv_sw_activate_req (pnet_t * net, pf_ar_t * p_ar, uint32_t crep)
       p_ar->arep,
       crep);
 
+   p_ppm->last_tx_timestamp_ns = 0;
+   memset (&p_ppm->app_to_tx, 0, sizeof (p_ppm->app_to_tx));
+   memset (&p_ppm->tx_jitter, 0, sizeof (p_ppm->tx_jitter));
+
    pf_scheduler_init_handle (&p_ppm->ci_timeout, "ppm");
    ret = pf_scheduler_add (
       net,
@@ -157,6 +225,13 @@ int pf_ppm_drv_sw_write_data_and_iops (
    int ret = 0;
    os_mutex_lock (net->ppm_buf_lock);
 
+   if (
+      iocr->ppm.app_data_time_ns == 0 &&
+      net->fspm_cfg.pnal_cfg.eth_timestamping != PNAL_TIMESTAMPING_OFF)
+   {
+      iocr->ppm.app_data_time_ns = pnal_get_time_ns();
+   }
+
    if (data != NULL)
    {
       ret = pf_ppm_drv_sw_write_frame_buffer (
@@ -267,7 +267,7 @@ int pf_scheduler_restart (
    return pf_scheduler_add (net, delay, cb, arg, handle);
 }
 
-void pf_scheduler_init (pnet_t * net, uint32_t tick_interval)
+void pf_scheduler_init (pnet_t * net, uint32_t tick_interval, bool tickless)
 {
    uint32_t ix;
 
@@ -281,6 +281,8 @@ void pf_scheduler_init (pnet_t * net, uint32_t tick_interval)
    memset ((void *)net->scheduler_timeouts, 0, sizeof (net->scheduler_timeouts));
 
    net->scheduler_tick_interval = tick_interval;
+   net->scheduler_tickless = tickless;
+   net->scheduler_in_tick = false;
    CC_ASSERT (net->scheduler_tick_interval > 0);
 
    /* Link all entries into a list and put them into the free queue. */
@@ -307,9 +309,18 @@ int pf_scheduler_add (
    uint32_t ix_prev;
    uint32_t ix_free;
    uint32_t now = os_get_current_time_us();
+   bool is_first = false;
 
-   delay =
-      pf_scheduler_sanitize_delay (delay, net->scheduler_tick_interval, true);
+   if (net->scheduler_tickless == false)
+   {
+      delay =
+         pf_scheduler_sanitize_delay (delay, net->scheduler_tick_interval, true);
+   }
+   else if (delay > PF_SCHEDULER_MAX_DELAY_US)
+   {
+      /* Deadline already missed. Fire at next call to the tick function. */
+      delay = 0;
+   }
 
    os_mutex_lock (net->scheduler_timeout_mutex);
    /* Unlink from the free list */
@@ -376,10 +387,19 @@ int pf_scheduler_add (
          ix_free,
          ix_prev);
    }
+   /* The application computes its next wakeup after a tick anyway */
+   is_first = (net->scheduler_timeout_first == ix_free) &&
+              !net->scheduler_in_tick;
    os_mutex_unlock (net->scheduler_timeout_mutex);
 
    handle->timer_index = ix_free + 1; /* Make sure 0 is invalid. */
 
+   if (is_first && net->scheduler_tickless)
+   {
+      /* Wake up the application if it sleeps until the previous timeout */
+      pf_fspm_next_timeout_ind (net);
+   }
+
    return 0;
 }
 
@@ -449,15 +469,14 @@ void pf_scheduler_tick (pnet_t * net)
    uint32_t pf_current_time = os_get_current_time_us();
 
    os_mutex_lock (net->scheduler_timeout_mutex);
+   net->scheduler_in_tick = true;
 
    /* Send event to all expired delay entries. */
-   while ((net->scheduler_timeout_first < PF_MAX_TIMEOUTS) &&
-          ((int32_t) (
-              pf_current_time -
-              net->scheduler_timeouts[net->scheduler_timeout_first].when) >= 0))
+   ix = net->scheduler_timeout_first;
+   while ((ix < PF_MAX_TIMEOUTS) &&
+          ((int32_t) (pf_current_time - net->scheduler_timeouts[ix].when) >= 0))
    {
       /* Unlink from busy list */
-      ix = net->scheduler_timeout_first;
       pf_scheduler_unlink (net, &net->scheduler_timeout_first, ix);
 
       ftn = net->scheduler_timeouts[ix].cb;
@@ -475,11 +494,38 @@ void pf_scheduler_tick (pnet_t * net)
       os_mutex_unlock (net->scheduler_timeout_mutex);
       ftn (net, arg, pf_current_time);
       os_mutex_lock (net->scheduler_timeout_mutex);
+
+      ix = net->scheduler_timeout_first;
    }
 
+   net->scheduler_in_tick = false;
    os_mutex_unlock (net->scheduler_timeout_mutex);
 }
 
+int pf_scheduler_get_next_timeout (
+   pnet_t * net,
+   uint32_t current_time,
+   uint32_t * p_delay)
+{
+   int ret = -1;
+   uint32_t ix;
+   int32_t remaining;
+
+   os_mutex_lock (net->scheduler_timeout_mutex);
+
+   ix = net->scheduler_timeout_first;
+   if (ix < PF_MAX_TIMEOUTS)
+   {
+      remaining = (int32_t) (net->scheduler_timeouts[ix].when - current_time);
+      *p_delay = (remaining > 0) ? (uint32_t)remaining : 0;
+      ret = 0;
+   }
+
+   os_mutex_unlock (net->scheduler_timeout_mutex);
+
+   return ret;
+}
+
 void pf_scheduler_show (pnet_t * net)
 {
    uint32_t ix;
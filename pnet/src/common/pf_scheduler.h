@@ -28,8 +28,12 @@ extern "C" {
  * @param tick_interval    In:    System calls the tick function at these
  *                                intervals, in microseconds. Must be
  *                                larger than 0.
+ * @param tickless         In:    If true, delays are not rounded to the tick
+ *                                interval. The system instead calls the tick
+ *                                function when the next timeout expires,
+ *                                see \a pf_scheduler_get_next_timeout().
  */
-void pf_scheduler_init (pnet_t * net, uint32_t tick_interval);
+void pf_scheduler_init (pnet_t * net, uint32_t tick_interval, bool tickless);
 
 /**
  * Initialize a timeout handle.
@@ -158,6 +162,23 @@ void pf_scheduler_remove (pnet_t * net, pf_scheduler_handle_t * handle);
  */
 void pf_scheduler_tick (pnet_t * net);
 
+/**
+ * Get the time until the first scheduled call-back is due.
+ *
+ * Locks the mutex temporarily.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param current_time     In:    The current system time, in microseconds.
+ * @param p_delay          Out:   Time until the first call-back is due, in
+ *                                microseconds. 0 if it already is due.
+ * @return  0  if a call-back is scheduled.
+ *          -1 if nothing is scheduled.
+ */
+int pf_scheduler_get_next_timeout (
+   pnet_t * net,
+   uint32_t current_time,
+   uint32_t * p_delay);
+
 /**
  * Show scheduler (busy and free) instances.
  *
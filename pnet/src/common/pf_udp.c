@@ -19,10 +19,11 @@
  */
 
 #ifdef UNIT_TEST
-#define pnal_udp_close    mock_pnal_udp_close
-#define pnal_udp_open     mock_pnal_udp_open
-#define pnal_udp_recvfrom mock_pnal_udp_recvfrom
-#define pnal_udp_sendto   mock_pnal_udp_sendto
+#define pnal_udp_close             mock_pnal_udp_close
+#define pnal_udp_open              mock_pnal_udp_open
+#define pnal_udp_recvfrom          mock_pnal_udp_recvfrom
+#define pnal_udp_sendto            mock_pnal_udp_sendto
+#define pnal_udp_set_recv_callback mock_pnal_udp_set_recv_callback
 #endif
 
 #include <string.h>
@@ -68,6 +69,15 @@ int pf_udp_recvfrom (
    return pnal_udp_recvfrom (id, src_addr, src_port, data, size);
 }
 
+int pf_udp_set_recv_callback (
+   pnet_t * net,
+   uint32_t id,
+   pnal_udp_callback_t * callback,
+   void * arg)
+{
+   return pnal_udp_set_recv_callback (id, callback, arg);
+}
+
 void pf_udp_close (pnet_t * net, uint32_t id)
 {
    pnal_udp_close (id);
@@ -71,6 +71,24 @@ int pf_udp_recvfrom (
    uint8_t * data,
    int size);
 
+/**
+ * Let the common receive thread call a callback when a UDP socket has data.
+ *
+ * The callback must read the data with pf_udp_recvfrom().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param id               In:    Socket ID
+ * @param callback         In:    Callback for incoming data
+ * @param arg              In:    User argument passed to the callback
+ * @return  0 if the callback is registered,
+ *          -1 if the socket must be polled with pf_udp_recvfrom()
+ */
+int pf_udp_set_recv_callback (
+   pnet_t * net,
+   uint32_t id,
+   pnal_udp_callback_t * callback,
+   void * arg);
+
 /**
  * Close an UDP socket.
  *
@@ -398,6 +398,246 @@ void pf_cmdev_free_diag (pnet_t * net, uint16_t item_ix)
    }
 }
 
+/**
+ * @internal
+ * Get the key identifying a diag item within its subslot.
+ *
+ * @param p_item           In:    The diag item.
+ * @param p_key            Out:   The key of the item.
+ */
+static void pf_cmdev_get_diag_key (
+   const pf_diag_item_t * p_item,
+   pf_diag_key_t * p_key)
+{
+   memset (p_key, 0, sizeof (*p_key));
+   if (p_item->usi < PF_USI_CHANNEL_DIAGNOSIS)
+   {
+      p_key->usi = p_item->usi;
+   }
+   else
+   {
+      p_key->usi = PF_USI_CHANNEL_DIAGNOSIS;
+      p_key->ch_nbr = p_item->fmt.std.ch_nbr;
+      p_key->accumulative =
+         PF_DIAG_CH_PROP_ACC_GET (p_item->fmt.std.ch_properties);
+      p_key->direction = PF_DIAG_CH_PROP_DIR_GET (p_item->fmt.std.ch_properties);
+      p_key->ch_error_type = p_item->fmt.std.ch_error_type;
+      p_key->ext_ch_error_type = p_item->fmt.std.ext_ch_error_type;
+   }
+}
+
+/**
+ * @internal
+ * Calculate the hash bucket of a diag key (FNV-1a of the members).
+ *
+ * @param p_subslot        In:    The subslot of the item.
+ * @param p_key            In:    The key of the item.
+ * @return  The index into device.diag_hash[].
+ */
+static uint16_t pf_cmdev_diag_hash (
+   const pf_subslot_t * p_subslot,
+   const pf_diag_key_t * p_key)
+{
+   uint32_t hash = 2166136261u;
+   const uint32_t values[] = {
+      (uint32_t)(uintptr_t)p_subslot,
+      p_key->usi,
+      p_key->ch_nbr,
+      ((uint32_t)p_key->accumulative << 16) | p_key->direction,
+      p_key->ch_error_type,
+      p_key->ext_ch_error_type};
+   uint16_t ix;
+
+   for (ix = 0; ix < NELEMENTS (values); ix++)
+   {
+      hash = (hash ^ values[ix]) * 16777619u;
+   }
+
+   return (uint16_t)((hash ^ (hash >> 16)) % PNET_MAX_DIAG_ITEMS);
+}
+
+/**
+ * @internal
+ * Add or remove a diag item from the diagnosis summary of its subslot.
+ *
+ * @param p_subslot        InOut: The subslot of the item.
+ * @param p_item           In:    The diag item.
+ * @param add              In:    true to add the item, false to remove it.
+ */
+static void pf_cmdev_count_diag (
+   pf_subslot_t * p_subslot,
+   const pf_diag_item_t * p_item,
+   bool add)
+{
+   pf_diag_summary_t * p_summary = &p_subslot->diag_summary;
+   pnet_alarm_spec_t alarm_spec = {0};
+   uint32_t maint_status = 0;
+   uint16_t delta = add ? 1 : (uint16_t)-1;
+   uint16_t bit;
+
+   /* Only the AR independent parts of the item summary are counted */
+   pf_alarm_add_diag_item_to_summary (
+      p_subslot->p_ar,
+      p_subslot,
+      p_item,
+      &alarm_spec,
+      &maint_status);
+
+   if (alarm_spec.manufacturer_diagnosis == true)
+   {
+      p_summary->num_manufacturer += delta;
+   }
+   if (alarm_spec.channel_diagnosis == true)
+   {
+      p_summary->num_channel += delta;
+   }
+   if (alarm_spec.submodule_diagnosis == true)
+   {
+      p_summary->num_submodule += delta;
+   }
+   if (
+      (p_item->usi < PF_USI_CHANNEL_DIAGNOSIS) ||
+      (PF_DIAG_CH_PROP_MAINT_GET (p_item->fmt.std.ch_properties) ==
+       PNET_DIAG_CH_PROP_MAINT_FAULT))
+   {
+      p_summary->num_problem += delta;
+   }
+   for (bit = 0; maint_status != 0; bit++, maint_status >>= 1)
+   {
+      if (maint_status & 1)
+      {
+         p_summary->num_maint_status[bit] += delta;
+      }
+   }
+}
+
+int pf_cmdev_find_diag (
+   pnet_t * net,
+   const pf_subslot_t * p_subslot,
+   const pf_diag_key_t * p_key,
+   uint16_t * p_item_ix)
+{
+   pf_diag_item_t * p_item = NULL;
+   pf_diag_key_t key;
+   uint16_t item_ix;
+
+   item_ix = net->cmdev_device.diag_hash[pf_cmdev_diag_hash (p_subslot, p_key)];
+   pf_cmdev_get_diag_item (net, item_ix, &p_item);
+   while (p_item != NULL)
+   {
+      if (net->cmdev_device.diag_links[item_ix].p_subslot == p_subslot)
+      {
+         pf_cmdev_get_diag_key (p_item, &key);
+         if (memcmp (&key, p_key, sizeof (key)) == 0)
+         {
+            *p_item_ix = item_ix;
+            return 0;
+         }
+      }
+
+      item_ix = net->cmdev_device.diag_links[item_ix].hash_next;
+      pf_cmdev_get_diag_item (net, item_ix, &p_item);
+   }
+
+   *p_item_ix = PF_DIAG_IX_NULL;
+   return -1;
+}
+
+void pf_cmdev_link_diag (
+   pnet_t * net,
+   pf_subslot_t * p_subslot,
+   uint16_t item_ix)
+{
+   pf_device_t * p_dev = &net->cmdev_device;
+   pf_diag_item_t * p_item = &p_dev->diag_items[item_ix];
+   pf_diag_link_t * p_link = &p_dev->diag_links[item_ix];
+   pf_diag_key_t key;
+   uint16_t bucket;
+
+   /* Insert first in the list of the subslot */
+   p_link->prev = PF_DIAG_IX_NULL;
+   p_item->next = p_subslot->diag_list;
+   if (p_item->next != PF_DIAG_IX_NULL)
+   {
+      p_dev->diag_links[p_item->next].prev = item_ix;
+   }
+   p_subslot->diag_list = item_ix;
+
+   /* Insert first in its hash bucket */
+   pf_cmdev_get_diag_key (p_item, &key);
+   bucket = pf_cmdev_diag_hash (p_subslot, &key);
+   p_link->p_subslot = p_subslot;
+   p_link->hash_next = p_dev->diag_hash[bucket];
+   p_dev->diag_hash[bucket] = item_ix;
+
+   pf_cmdev_count_diag (p_subslot, p_item, true);
+}
+
+void pf_cmdev_unlink_diag (
+   pnet_t * net,
+   pf_subslot_t * p_subslot,
+   uint16_t item_ix)
+{
+   pf_device_t * p_dev = &net->cmdev_device;
+   pf_diag_item_t * p_item = &p_dev->diag_items[item_ix];
+   pf_diag_link_t * p_link = &p_dev->diag_links[item_ix];
+   pf_diag_key_t key;
+   uint16_t * p_ix;
+
+   if (p_link->prev != PF_DIAG_IX_NULL)
+   {
+      p_dev->diag_items[p_link->prev].next = p_item->next;
+   }
+   else
+   {
+      p_subslot->diag_list = p_item->next;
+   }
+   if (p_item->next != PF_DIAG_IX_NULL)
+   {
+      p_dev->diag_links[p_item->next].prev = p_link->prev;
+   }
+
+   /* The bucket is short, as there are as many buckets as items */
+   pf_cmdev_get_diag_key (p_item, &key);
+   p_ix = &p_dev->diag_hash[pf_cmdev_diag_hash (p_subslot, &key)];
+   while ((*p_ix != PF_DIAG_IX_NULL) && (*p_ix != item_ix))
+   {
+      p_ix = &p_dev->diag_links[*p_ix].hash_next;
+   }
+   if (*p_ix == item_ix)
+   {
+      *p_ix = p_link->hash_next;
+   }
+
+   pf_cmdev_count_diag (p_subslot, p_item, false);
+
+   p_item->next = PF_DIAG_IX_NULL;
+   p_link->p_subslot = NULL;
+   p_link->prev = PF_DIAG_IX_NULL;
+   p_link->hash_next = PF_DIAG_IX_NULL;
+}
+
+/**
+ * @internal
+ * Remove and free all diag items of a subslot.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_subslot        InOut: The subslot instance.
+ */
+static void pf_cmdev_free_all_diag (pnet_t * net, pf_subslot_t * p_subslot)
+{
+   uint16_t item_ix;
+
+   os_mutex_lock (net->cmdev_device.diag_mutex);
+   while (p_subslot->diag_list != PF_DIAG_IX_NULL)
+   {
+      item_ix = p_subslot->diag_list;
+      pf_cmdev_unlink_diag (net, p_subslot, item_ix);
+      pf_cmdev_free_diag (net, item_ix);
+   }
+   os_mutex_unlock (net->cmdev_device.diag_mutex);
+}
+
 int pf_cmdev_get_next_diagnosis_usi (
    pnet_t * net,
    uint16_t list_head,
@@ -708,6 +948,9 @@ int pf_cmdev_pull_submodule (
    }
    else
    {
+      /* The diagnoses of the submodule disappear with it */
+      pf_cmdev_free_all_diag (net, p_subslot);
+
       p_subslot->in_use = false;
       p_subslot->submodule_state.ident_info = PF_SUBMOD_PLUG_NO;
 
@@ -1414,6 +1657,12 @@ void pf_cmdev_init (pnet_t * net)
       net->cmdev_device.diag_items[NELEMENTS (net->cmdev_device.diag_items) - 1]
          .next = PF_DIAG_IX_NULL;
 
+      /* All hash buckets are empty */
+      for (ix = 0; ix < NELEMENTS (net->cmdev_device.diag_hash); ix++)
+      {
+         net->cmdev_device.diag_hash[ix] = PF_DIAG_IX_NULL;
+      }
+
       (void)pf_diag_init();
 
       /* Create the default API */
@@ -277,6 +277,53 @@ int pf_cmdev_new_diag (pnet_t * net, uint16_t * p_item_ix);
  */
 void pf_cmdev_free_diag (pnet_t * net, uint16_t item_ix);
 
+/**
+ * Find a diag item in the list of a subslot, by looking it up in the hash
+ * index of the device.
+ *
+ * Must be called with the device.diag_mutex locked.
+ * @param net              InOut: The p-net stack instance
+ * @param p_subslot        In:    The subslot instance.
+ * @param p_key            In:    The key of the item, see pf_diag_key_t.
+ * @param p_item_ix        Out:   Index of the item, or PF_DIAG_IX_NULL.
+ * @return  0  If the item was found.
+ *          -1 If the subslot has no such item.
+ */
+int pf_cmdev_find_diag (
+   pnet_t * net,
+   const pf_subslot_t * p_subslot,
+   const pf_diag_key_t * p_key,
+   uint16_t * p_item_ix);
+
+/**
+ * Insert a diag item first in the list of a subslot, and add it to the hash
+ * index and to the diagnosis summary of the subslot.
+ *
+ * The members of the item must not be changed while it is in the list.
+ * Must be called with the device.diag_mutex locked.
+ * @param net              InOut: The p-net stack instance
+ * @param p_subslot        InOut: The subslot instance.
+ * @param item_ix          In:    Index of the item.
+ */
+void pf_cmdev_link_diag (
+   pnet_t * net,
+   pf_subslot_t * p_subslot,
+   uint16_t item_ix);
+
+/**
+ * Remove a diag item from the list of a subslot, from the hash index and from
+ * the diagnosis summary of the subslot. The item is not freed.
+ *
+ * Must be called with the device.diag_mutex locked.
+ * @param net              InOut: The p-net stack instance
+ * @param p_subslot        InOut: The subslot instance.
+ * @param item_ix          In:    Index of the item.
+ */
+void pf_cmdev_unlink_diag (
+   pnet_t * net,
+   pf_subslot_t * p_subslot,
+   uint16_t item_ix);
+
 /**
  * Find next diagnosis USI value (sorted) for a subslot
  *
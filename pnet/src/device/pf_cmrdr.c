@@ -27,6 +27,8 @@
  *
  * Contains mainly one function \a pf_cmrdr_rm_read_ind(),
  * that handles a RPC parameter read request (and read implicit request).
+ * If the application provides the value later, \a pf_cmrdr_rm_read_done()
+ * creates the response.
  *
  * Triggers the \a pnet_read_ind() user callback for some values.
  *
@@ -36,6 +38,119 @@
  * for a POWER-ON state.
  */
 
+/**
+ * @internal
+ * Insert the IODReadRes block header, with a dummy record data length.
+ *
+ * The only result that can fail is from FSPM or the application, so it is
+ * already known. The actual record data length is inserted by
+ * \a pf_cmrdr_put_read_end().
+ *
+ * @param p_read_request   In:    The read request.
+ * @param p_read_status    In:    The result information.
+ * @param p_read_result    Out:   The read result block.
+ * @param res_size         In:    The size of the output buffer.
+ * @param p_res            Out:   The output buffer.
+ * @param p_pos            InOut: Position in the output buffer.
+ * @param p_data_length_pos Out:  Position of the record data length.
+ */
+static void pf_cmrdr_put_read_start (
+   const pf_iod_read_request_t * p_read_request,
+   const pnet_result_t * p_read_status,
+   pf_iod_read_result_t * p_read_result,
+   uint16_t res_size,
+   uint8_t * p_res,
+   uint16_t * p_pos,
+   uint16_t * p_data_length_pos)
+{
+   memset (p_read_result, 0, sizeof (*p_read_result));
+   p_read_result->sequence_number = p_read_request->sequence_number;
+   p_read_result->ar_uuid = p_read_request->ar_uuid;
+   p_read_result->api = p_read_request->api;
+   p_read_result->slot_number = p_read_request->slot_number;
+   p_read_result->subslot_number = p_read_request->subslot_number;
+   p_read_result->index = p_read_request->index;
+   p_read_result->record_data_length = 0;
+   p_read_result->add_data_1 = p_read_status->add_data_1;
+   p_read_result->add_data_2 = p_read_status->add_data_2;
+
+   pf_put_read_result (
+      true,
+      p_read_result,
+      res_size,
+      p_res,
+      p_pos,
+      p_data_length_pos);
+}
+
+/**
+ * @internal
+ * Finish the response of a read request, after the record data has been
+ * inserted.
+ *
+ * Sets the error information if no record data could be provided, inserts the
+ * actual record data length and restarts the CMSM timer.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             InOut: The AR instance.
+ * @param p_read_request   In:    The read request.
+ * @param p_read_status    Out:   The result information.
+ * @param data_ret         In:    0 if the record data was inserted.
+ * @param start_pos        In:    Position of the record data.
+ * @param data_length_pos  In:    Position of the record data length.
+ * @param res_size         In:    The size of the output buffer.
+ * @param p_res            Out:   The output buffer.
+ * @param p_pos            InOut: Position in the output buffer.
+ * @return  0  if operation succeeded.
+ *          -1 if an error occurred.
+ */
+static int pf_cmrdr_put_read_end (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_read_request_t * p_read_request,
+   pnet_result_t * p_read_status,
+   int data_ret,
+   uint16_t start_pos,
+   uint16_t data_length_pos,
+   uint16_t res_size,
+   uint8_t * p_res,
+   uint16_t * p_pos)
+{
+   int ret = 0;
+
+   if (data_ret != 0)
+   {
+      LOG_INFO (
+         PNET_LOG,
+         "CMRDR(%d): Could not read index 0x%04X for slot %u subslot 0x%04X.\n",
+         __LINE__,
+         p_read_request->index,
+         p_read_request->slot_number,
+         p_read_request->subslot_number);
+
+      p_read_status->pnio_status.error_code = PNET_ERROR_CODE_READ;
+      p_read_status->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+      p_read_status->pnio_status.error_code_1 =
+         PNET_ERROR_CODE_1_ACC_INVALID_INDEX;
+      p_read_status->pnio_status.error_code_2 = 10;
+   }
+
+   pf_put_uint32 (
+      true,
+      (uint32_t)(*p_pos - start_pos),
+      res_size,
+      p_res,
+      &data_length_pos); /* Insert actual data length */
+
+   /* Restart timer */
+   if (pf_cmsm_cm_read_ind (net, p_ar, p_read_request) != 0)
+   {
+      ret = -1;
+   }
+
+   return ret;
+}
+
 int pf_cmrdr_rm_read_ind (
    pnet_t * net,
    pf_ar_t * p_ar,
@@ -46,6 +161,7 @@ int pf_cmrdr_rm_read_ind (
    uint16_t * p_pos)
 {
    int ret = -1;
+   int fspm_ret;
    pf_iod_read_result_t read_result;
    uint8_t * p_data = NULL;
    uint16_t data_length_pos = 0;
@@ -87,46 +203,30 @@ int pf_cmrdr_rm_read_ind (
          pf_index_to_logstring (p_read_request->index));
    }
 
-   read_result.sequence_number = p_read_request->sequence_number;
-   read_result.ar_uuid = p_read_request->ar_uuid;
-   read_result.api = p_read_request->api;
-   read_result.slot_number = p_read_request->slot_number;
-   read_result.subslot_number = p_read_request->subslot_number;
-   read_result.index = p_read_request->index;
-
    /* Get the data from FSPM or the application, if possible. */
    data_len = res_size - *p_pos;
-   if (
-      pf_fspm_cm_read_ind (
-         net,
-         p_ar,
-         p_read_request,
-         &p_data,
-         &data_len,
-         p_read_status) != 0)
+   fspm_ret = pf_fspm_cm_read_ind (
+      net,
+      p_ar,
+      p_read_request,
+      &p_data,
+      &data_len,
+      p_read_status);
+   if (fspm_ret == PNET_RECORD_PENDING)
+   {
+      /* The application provides the data later, see
+       * pf_cmrdr_rm_read_done(). Nothing is inserted yet. */
+      return PNET_RECORD_PENDING;
+   }
+   else if (fspm_ret != 0)
    {
       data_len = 0; /* Handled: No data available. */
    }
 
-   /*
-    * Just insert a dummy value for now.
-    * It will be properly computed after the answer has been written to the
-    * buffer.
-    */
-   read_result.record_data_length = 0;
-
-   /*
-    * The only result that can fail is from FSPM or the application.
-    * All well-known indices are handled without error.
-    * It is therefore OK to write the result already now.
-    * This is needed in order to get the correct position for the actual answer.
-    */
-   read_result.add_data_1 = p_read_status->add_data_1;
-   read_result.add_data_2 = p_read_status->add_data_2;
-
    /* Also: Retrieve a position to write the total record length to. */
-   pf_put_read_result (
-      true,
+   pf_cmrdr_put_read_start (
+      p_read_request,
+      p_read_status,
       &read_result,
       res_size,
       p_res,
@@ -893,39 +993,67 @@ int pf_cmrdr_rm_read_ind (
       }
    }
 
-   if (ret != 0)
-   {
-      LOG_INFO (
-         PNET_LOG,
-         "CMRDR(%d): Could not read index 0x%04X for slot %u subslot 0x%04X.\n",
-         __LINE__,
-         p_read_request->index,
-         p_read_request->slot_number,
-         p_read_request->subslot_number);
+   return pf_cmrdr_put_read_end (
+      net,
+      p_ar,
+      p_read_request,
+      p_read_status,
+      ret,
+      start_pos,
+      data_length_pos,
+      res_size,
+      p_res,
+      p_pos);
+}
 
-      p_read_status->pnio_status.error_code = PNET_ERROR_CODE_READ;
-      p_read_status->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_read_status->pnio_status.error_code_1 =
-         PNET_ERROR_CODE_1_ACC_INVALID_INDEX;
-      p_read_status->pnio_status.error_code_2 = 10;
-      ret = 0;
-   }
+int pf_cmrdr_rm_read_done (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_read_request_t * p_read_request,
+   pnet_result_t * p_read_status,
+   const uint8_t * p_data,
+   uint16_t data_len,
+   uint16_t res_size,
+   uint8_t * p_res,
+   uint16_t * p_pos)
+{
+   int ret = -1;
+   pf_iod_read_result_t read_result;
+   uint16_t data_length_pos = 0;
+   uint16_t start_pos = 0;
 
-   read_result.record_data_length = *p_pos - start_pos;
-   pf_put_uint32 (
-      true,
-      read_result.record_data_length,
+   pf_cmrdr_put_read_start (
+      p_read_request,
+      p_read_status,
+      &read_result,
       res_size,
       p_res,
-      &data_length_pos); /* Insert actual data length */
+      p_pos,
+      &data_length_pos);
 
-   /* Restart timer */
-   if (pf_cmsm_cm_read_ind (net, p_ar, p_read_request) != 0)
+   /* Provided by application - accept whatever it says. */
+   start_pos = *p_pos;
+   if (*p_pos + data_len <= res_size)
    {
-      ret = -1;
+      if (data_len > 0)
+      {
+         memcpy (&p_res[*p_pos], p_data, data_len);
+      }
+      *p_pos += data_len;
+      ret = 0;
    }
 
-   return ret;
+   return pf_cmrdr_put_read_end (
+      net,
+      p_ar,
+      p_read_request,
+      p_read_status,
+      ret,
+      start_pos,
+      data_length_pos,
+      res_size,
+      p_res,
+      p_pos);
 }
 
 const char * pf_index_to_logstring (uint16_t index)
@@ -32,6 +32,9 @@ extern "C" {
  * @param p_res            Out:   The output buffer.
  * @param p_pos            InOut: Position in the output buffer.
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application provides the value later.
+ *                              Nothing has been inserted into the output
+ *                              buffer then.
  *          -1 if an error occurred.
  */
 int pf_cmrdr_rm_read_ind (
@@ -43,6 +46,33 @@ int pf_cmrdr_rm_read_ind (
    uint8_t * p_res,
    uint16_t * p_pos);
 
+/**
+ * Create the response of a read request, for which the application returned
+ * PNET_RECORD_PENDING, with the value it provided later.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             InOut: The AR instance.
+ * @param p_read_request   In:    The read request.
+ * @param p_read_status    InOut: The result information.
+ * @param p_data           In:    The value provided by the application.
+ * @param data_len         In:    Length of the value.
+ * @param res_size         In:    The size of the output buffer.
+ * @param p_res            Out:   The output buffer.
+ * @param p_pos            InOut: Position in the output buffer.
+ * @return  0  if operation succeeded.
+ *          -1 if an error occurred.
+ */
+int pf_cmrdr_rm_read_done (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_read_request_t * p_read_request,
+   pnet_result_t * p_read_status,
+   const uint8_t * p_data,
+   uint16_t data_len,
+   uint16_t res_size,
+   uint8_t * p_res,
+   uint16_t * p_pos);
+
 /**
  * Describe an index on a subslot.
  *
@@ -77,6 +77,8 @@ static const pf_uuid_t uuid_io_device_interface = {
 
 #define PF_CMRPC_NUMBER_OF_RESENDS 3
 
+static void pf_cmrpc_udp_recv_ind (uint32_t id, void * arg);
+
 /**************** Diagnostic strings *****************************************/
 
 void pf_memory_contents_show (const uint8_t * data, int size)
@@ -2786,6 +2788,66 @@ static int pf_cmrpc_rm_read_interpret_ind (
    return ret;
 }
 
+/**
+ * @internal
+ * Finish the response of an IODRead or IODWrite request.
+ *
+ * Inserts the actual operation result, and the length of the result blocks
+ * into the NDR header. For responses the actual_count = args_length.
+ *
+ * @param p_sess           InOut: The session instance.
+ * @param status_pos       In:    Position of the PNIO status.
+ * @param ndr_hdr_pos      In:    Position of the NDR header.
+ * @param blocks_pos       In:    Position of the first result block.
+ * @param end_pos          In:    Position after the last result block.
+ * @param res_size         In:    The size of the response buffer.
+ * @param p_res            Out:   The response buffer.
+ */
+static void pf_cmrpc_put_record_res_end (
+   pf_session_info_t * p_sess,
+   uint16_t status_pos,
+   uint16_t ndr_hdr_pos,
+   uint16_t blocks_pos,
+   uint16_t end_pos,
+   uint16_t res_size,
+   uint8_t * p_res)
+{
+   pf_put_pnet_status (
+      p_sess->get_info.is_big_endian,
+      &p_sess->rpc_result.pnio_status,
+      res_size,
+      p_res,
+      &status_pos);
+
+   p_sess->ndr_data.args_length = end_pos - blocks_pos;
+   p_sess->ndr_data.array.actual_count = end_pos - blocks_pos;
+
+   pf_put_uint32 (
+      p_sess->get_info.is_big_endian,
+      p_sess->ndr_data.args_length,
+      res_size,
+      p_res,
+      &ndr_hdr_pos);
+   pf_put_uint32 (
+      p_sess->get_info.is_big_endian,
+      p_sess->ndr_data.array.maximum_count,
+      res_size,
+      p_res,
+      &ndr_hdr_pos);
+   pf_put_uint32 (
+      p_sess->get_info.is_big_endian,
+      p_sess->ndr_data.array.offset,
+      res_size,
+      p_res,
+      &ndr_hdr_pos);
+   pf_put_uint32 (
+      p_sess->get_info.is_big_endian,
+      p_sess->ndr_data.array.actual_count,
+      res_size,
+      p_res,
+      &ndr_hdr_pos);
+}
+
 /**
  * @internal
  * Take a DCE RPC IODRead request and create a DCE RPC IODRead response.
@@ -2804,7 +2866,9 @@ static int pf_cmrpc_rm_read_interpret_ind (
  * @param res_size         In:    The size of the response buffer.
  * @param p_res            Out:   The response buffer.
  * @param p_res_pos        InOut: Position within the response buffer.
- * @return  0  if operation succeeded.
+ * @return  0  if operation succeeded, or if the application provides the
+ *             value later. The pending_record of the session is set then,
+ *             and the response ends after the NDR header.
  *          -1 if an error occurred.
  */
 static int pf_cmrpc_rm_read_ind (
@@ -2817,6 +2881,7 @@ static int pf_cmrpc_rm_read_ind (
    uint16_t * p_res_pos)
 {
    int ret = -1;
+   int read_ret;
    pf_iod_read_request_t read_request;
    pf_ar_t * p_ar = NULL; /* Assume the implicit AR */
    uint16_t status_pos;
@@ -2924,16 +2989,33 @@ static int pf_cmrpc_rm_read_ind (
 
          start_pos = *p_res_pos; /* Start of blocks - save for last */
 
-         /* Do actual reading */
-         if (
-            pf_cmrdr_rm_read_ind (
-               net,
-               p_ar,
-               &read_request,
-               &p_sess->rpc_result,
-               res_size,
-               p_res,
-               p_res_pos) == 0)
+         /* Do actual reading. Only explicit reads via an AR may be answered
+          * later by the application. */
+         net->cmrpc_record_deferrable =
+            (opnum == PF_RPC_DEV_OPNUM_READ) && (p_ar != NULL);
+         read_ret = pf_cmrdr_rm_read_ind (
+            net,
+            p_ar,
+            &read_request,
+            &p_sess->rpc_result,
+            res_size,
+            p_res,
+            p_res_pos);
+         net->cmrpc_record_deferrable = false;
+
+         if (read_ret == PNET_RECORD_PENDING)
+         {
+            /* The response is completed by pf_cmrpc_rm_read_done() */
+            p_sess->pending_record.active = true;
+            p_sess->pending_record.opnum = opnum;
+            p_sess->pending_record.arep = p_ar->arep;
+            p_sess->pending_record.read_request = read_request;
+            p_sess->pending_record.status_pos = status_pos;
+            p_sess->pending_record.ndr_hdr_pos = hdr_pos;
+            p_sess->pending_record.blocks_pos = start_pos;
+            return 0;
+         }
+         else if (read_ret == 0)
          {
             ret = pf_cmsm_rm_read_ind (net, p_ar, &read_request);
          }
@@ -2945,44 +3027,14 @@ static int pf_cmrpc_rm_read_ind (
                __LINE__);
          }
 
-         /* Insert the actual operation result */
-         pf_put_pnet_status (
-            p_sess->get_info.is_big_endian,
-            &p_sess->rpc_result.pnio_status,
-            res_size,
-            p_res,
-            &status_pos);
-
-         /* Fixup the header with correct length info. */
-         p_sess->ndr_data.args_length = *p_res_pos - start_pos;
-         p_sess->ndr_data.array.actual_count = *p_res_pos - start_pos;
-
-         /* Over-write the response header with correct length and actual_count.
-          */
-         pf_put_uint32 (
-            p_sess->get_info.is_big_endian,
-            p_sess->ndr_data.args_length,
-            res_size,
-            p_res,
-            &hdr_pos);
-         pf_put_uint32 (
-            p_sess->get_info.is_big_endian,
-            p_sess->ndr_data.array.maximum_count,
-            res_size,
-            p_res,
-            &hdr_pos);
-         pf_put_uint32 (
-            p_sess->get_info.is_big_endian,
-            p_sess->ndr_data.array.offset,
-            res_size,
-            p_res,
-            &hdr_pos);
-         pf_put_uint32 (
-            p_sess->get_info.is_big_endian,
-            p_sess->ndr_data.array.actual_count,
+         pf_cmrpc_put_record_res_end (
+            p_sess,
+            status_pos,
+            hdr_pos,
+            start_pos,
+            *p_res_pos,
             res_size,
-            p_res,
-            &hdr_pos);
+            p_res);
       }
    }
 
@@ -3103,6 +3155,230 @@ static int pf_cmrpc_rm_write_interpret_ind (
    return ret;
 }
 
+/**
+ * @internal
+ * Check whether the record data of a fragmented IODWrite request is passed to
+ * the application as it arrives, see \a pnet_write_chunk_ind().
+ *
+ * This is the case for single writes of an application-specific index to an
+ * existing AR, if the application has a chunk callback and accepts the record.
+ * All other requests are collected in the input buffer of the session as usual.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_sess           InOut: The session instance.
+ * @param p_rpc_req        In:    The RPC header of the first fragment.
+ * @param p_body           In:    The body of the first fragment.
+ * @return  true if the record data is passed to the application.
+ */
+static bool pf_cmrpc_write_stream_start (
+   pnet_t * net,
+   pf_session_info_t * p_sess,
+   const pf_rpc_header_t * p_rpc_req,
+   const uint8_t * p_body)
+{
+   pf_session_write_stream_t * p_stream = &p_sess->write_stream;
+   pf_get_info_t get_info;
+   pf_ndr_data_t ndr_data;
+   pnet_result_t stat;
+   pf_ar_t * p_ar = NULL;
+   uint16_t pos = 0;
+
+   memset (p_stream, 0, sizeof (*p_stream));
+   if (
+      (net->fspm_cfg.write_chunk_cb == NULL) ||
+      (p_rpc_req->packet_type != PF_RPC_PT_REQUEST) ||
+      (p_rpc_req->opnum != PF_RPC_DEV_OPNUM_WRITE) ||
+      (memcmp (
+          &p_rpc_req->interface_uuid,
+          &uuid_io_device_interface,
+          sizeof (p_rpc_req->interface_uuid)) != 0))
+   {
+      return false;
+   }
+
+   memset (&stat, 0, sizeof (stat));
+   get_info.result = PF_PARSE_OK;
+   get_info.p_buf = p_body;
+   get_info.len = p_rpc_req->length_of_body;
+   get_info.is_big_endian = p_rpc_req->is_big_endian;
+   pf_get_ndr_data (&get_info, &pos, &ndr_data);
+   get_info.is_big_endian = true;
+
+   /* Anything unexpected is collected as usual, and reported when the
+    * request is complete. */
+   if (
+      (get_info.result != PF_PARSE_OK) ||
+      (pf_cmrpc_rm_write_interpret_ind (
+          &get_info,
+          &p_stream->write_request,
+          &pos,
+          &stat) != 0) ||
+      (get_info.result != PF_PARSE_OK) ||
+      (p_stream->write_request.index > PF_IDX_USER_MAX) ||
+      (pf_ar_find_by_uuid (net, &p_stream->write_request.ar_uuid, &p_ar) != 0) ||
+      !pf_fspm_cm_write_chunk_accepted (net, p_ar, &p_stream->write_request))
+   {
+      return false;
+   }
+
+   LOG_DEBUG (
+      PF_RPC_LOG,
+      "CMRPC(%d): Passing the fragments of the write of index %u to the "
+      "application. Record length %" PRIu32 "\n",
+      __LINE__,
+      p_stream->write_request.index,
+      p_stream->write_request.record_data_length);
+   p_stream->active = true;
+   p_stream->arep = p_ar->arep;
+   p_stream->header_len = pos;
+
+   return true;
+}
+
+/**
+ * @internal
+ * Pass the record data of a fragment of a streamed IODWrite request to the
+ * application.
+ *
+ * The headers in the first fragment are copied to the input buffer of the
+ * session, such that the request is parsed as usual when it is complete.
+ * Once a part is rejected, the remaining parts are dropped.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_sess           InOut: The session instance.
+ * @param p_body           In:    The body of the fragment.
+ * @param body_len         In:    The length of the body.
+ */
+static void pf_cmrpc_write_stream_put (
+   pnet_t * net,
+   pf_session_info_t * p_sess,
+   const uint8_t * p_body,
+   uint16_t body_len)
+{
+   pf_session_write_stream_t * p_stream = &p_sess->write_stream;
+   pf_ar_t * p_ar = NULL;
+   uint16_t data_pos = 0;
+   uint16_t data_len;
+
+   if (p_sess->in_fragment_nbr == 0)
+   {
+      memcpy (p_sess->in_buffer, p_body, p_stream->header_len);
+      p_sess->in_buf_len = p_stream->header_len;
+      data_pos = p_stream->header_len;
+   }
+   data_len = body_len - data_pos;
+
+   if (p_stream->failed || (data_len == 0))
+   {
+      return;
+   }
+
+   if (
+      (p_stream->offset + data_len) >
+      p_stream->write_request.record_data_length)
+   {
+      LOG_ERROR (
+         PF_RPC_LOG,
+         "CMRPC(%d): Write request of index %u holds more than the record "
+         "length %" PRIu32 "\n",
+         __LINE__,
+         p_stream->write_request.index,
+         p_stream->write_request.record_data_length);
+      pf_set_error (
+         &p_stream->result,
+         PNET_ERROR_CODE_WRITE,
+         PNET_ERROR_DECODE_PNIORW,
+         PNET_ERROR_CODE_1_ACC_WRITE_LENGTH_ERROR,
+         0);
+      p_stream->failed = true;
+   }
+   else if (pf_ar_find_by_arep (net, p_stream->arep, &p_ar) != 0)
+   {
+      pf_set_error (
+         &p_stream->result,
+         PNET_ERROR_CODE_WRITE,
+         PNET_ERROR_DECODE_PNIO,
+         PNET_ERROR_CODE_1_CMRPC,
+         PNET_ERROR_CODE_2_CMRPC_AR_UUID_UNKNOWN);
+      p_stream->failed = true;
+   }
+   else if (
+      pf_cmwrr_rm_write_chunk_ind (
+         net,
+         p_ar,
+         &p_stream->write_request,
+         p_stream->offset,
+         data_len,
+         &p_body[data_pos],
+         &p_stream->result) != 0)
+   {
+      pf_set_error_if_not_already_set (
+         &p_stream->result,
+         PNET_ERROR_CODE_WRITE,
+         PNET_ERROR_DECODE_PNIORW,
+         PNET_ERROR_CODE_1_APP_WRITE_ERROR,
+         0);
+      p_stream->failed = true;
+   }
+   else
+   {
+      p_stream->offset += data_len;
+   }
+}
+
+/**
+ * @internal
+ * Complete a streamed IODWrite request, whose record data has already been
+ * passed to the application.
+ *
+ * @param p_sess           In:    The session instance.
+ * @param p_write_request  In:    The IODWrite request block.
+ * @param p_write_result   Out:   The IODWrite result block.
+ * @param p_stat           Out:   Detailed error information if returning != 0
+ * @return  0  if all parts were accepted.
+ *          -1 if an error occurred.
+ */
+static int pf_cmrpc_write_stream_end (
+   const pf_session_info_t * p_sess,
+   const pf_iod_write_request_t * p_write_request,
+   pf_iod_write_result_t * p_write_result,
+   pnet_result_t * p_stat)
+{
+   int ret = -1;
+   const pf_session_write_stream_t * p_stream = &p_sess->write_stream;
+
+   p_write_result->sequence_number = p_write_request->sequence_number;
+   p_write_result->ar_uuid = p_write_request->ar_uuid;
+   p_write_result->api = p_write_request->api;
+   p_write_result->slot_number = p_write_request->slot_number;
+   p_write_result->subslot_number = p_write_request->subslot_number;
+   p_write_result->index = p_write_request->index;
+   p_write_result->record_data_length = 0;
+
+   if (p_stream->failed)
+   {
+      *p_stat = p_stream->result;
+   }
+   else if (p_stream->offset != p_write_request->record_data_length)
+   {
+      pf_set_error (
+         p_stat,
+         PNET_ERROR_CODE_WRITE,
+         PNET_ERROR_DECODE_PNIORW,
+         PNET_ERROR_CODE_1_ACC_WRITE_LENGTH_ERROR,
+         0);
+   }
+   else
+   {
+      ret = 0;
+   }
+
+   p_write_result->add_data_1 = p_stat->add_data_1;
+   p_write_result->add_data_2 = p_stat->add_data_2;
+
+   return ret;
+}
+
 /**
  * @internal
  * Perform write of one data record.
@@ -3116,6 +3392,7 @@ static int pf_cmrpc_rm_write_interpret_ind (
  * @param p_stat           Out:   Detailed error information if returning != 0
  * @param p_req_pos        InOut: Position in the request buffer.
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application reports the result later.
  *          -1 if an error occurred.
  */
 static int pf_cmrpc_perform_one_write (
@@ -3152,6 +3429,15 @@ static int pf_cmrpc_perform_one_write (
          PNET_ERROR_CODE_1_ACC_INVALID_AREA_API,
          1);
    }
+   else if (p_sess->write_stream.active)
+   {
+      /* The record data was passed to the application while it arrived */
+      ret = pf_cmrpc_write_stream_end (
+         p_sess,
+         p_write_request,
+         p_write_result,
+         p_stat);
+   }
    else if (
       (*p_req_pos + p_write_request->record_data_length) <=
       p_sess->get_info.len)
@@ -3160,21 +3446,18 @@ static int pf_cmrpc_perform_one_write (
       {
          /* This is a write of a user defined index. No block header in this
           * case. */
-         if (
-            pf_cmwrr_rm_write_ind (
-               net,
-               p_ar,
-               p_write_request,
-               p_write_result,
-               p_stat,
-               p_sess->get_info.p_buf,
-               p_write_request->record_data_length,
-               p_req_pos) == 0)
-         {
-            ret = 0;
-         }
-         else
+         ret = pf_cmwrr_rm_write_ind (
+            net,
+            p_ar,
+            p_write_request,
+            p_write_result,
+            p_stat,
+            p_sess->get_info.p_buf,
+            p_write_request->record_data_length,
+            p_req_pos);
+         if ((ret != 0) && (ret != PNET_RECORD_PENDING))
          {
+            ret = -1;
             pf_set_error_if_not_already_set (
                p_stat,
                PNET_ERROR_CODE_WRITE,
@@ -3228,7 +3511,7 @@ static int pf_cmrpc_perform_one_write (
          4);
    }
 
-   if (ret != 0)
+   if ((ret != 0) && (ret != PNET_RECORD_PENDING))
    {
       p_write_result->pnio_status = p_stat->pnio_status;
    }
@@ -3250,7 +3533,9 @@ static int pf_cmrpc_perform_one_write (
  * @param res_size         In:    The size of the response buffer.
  * @param p_res            Out:   The response buffer.
  * @param p_res_pos        InOut: Position within the response buffer.
- * @return  0  if operation succeeded.
+ * @return  0  if operation succeeded, or if the application reports the
+ *             result later. The pending_record of the session is set then,
+ *             and the response ends after the NDR header.
  *          -1 if an error occurred.
  */
 static int pf_cmrpc_rm_write_ind (
@@ -3271,6 +3556,9 @@ static int pf_cmrpc_rm_write_ind (
    uint16_t res_hdr_pos;
    uint16_t res_start_pos;
    uint16_t res_status_pos;
+   uint32_t req_len;
+   bool is_pending = false;
+   pf_ar_t * p_ar = NULL;
 
    memset (&write_request, 0, sizeof (write_request));
    memset (&write_result, 0, sizeof (write_result));
@@ -3367,6 +3655,21 @@ static int pf_cmrpc_rm_write_ind (
                p_res,
                p_res_pos);
 
+            /* Let the application apply the records as a whole */
+            if (
+               pf_ar_find_by_uuid (net, &write_request.ar_uuid, &p_ar) != 0)
+            {
+               p_ar = NULL;
+            }
+            if (p_ar != NULL)
+            {
+               (void)pf_fspm_cm_write_multiple_ind (
+                  net,
+                  p_ar,
+                  PNET_WRITE_MULTIPLE_BEGIN,
+                  &p_sess->rpc_result);
+            }
+
             /* Do each write, and store the corresponding response blocks */
             memset (&write_result_multi, 0, sizeof (write_result_multi));
             while (((req_pos + 58) <
@@ -3407,10 +3710,34 @@ static int pf_cmrpc_rm_write_ind (
             {
                ret = -1;
             }
+
+            if (p_ar != NULL)
+            {
+               if (
+                  (ret == 0) && (write_result_multi.pnio_status.error_code ==
+                                 PNET_ERROR_CODE_NOERROR))
+               {
+                  ret = pf_fspm_cm_write_multiple_ind (
+                     net,
+                     p_ar,
+                     PNET_WRITE_MULTIPLE_COMMIT,
+                     &p_sess->rpc_result);
+               }
+               else
+               {
+                  (void)pf_fspm_cm_write_multiple_ind (
+                     net,
+                     p_ar,
+                     PNET_WRITE_MULTIPLE_ABORT,
+                     &p_sess->rpc_result);
+               }
+            }
          }
          else /* single write */
          {
-            /* Do the write, and store the corresponding response block */
+            /* Do the write, and store the corresponding response block.
+             * Only single writes may be answered later by the application. */
+            net->cmrpc_record_deferrable = true;
             ret = pf_cmrpc_perform_one_write (
                net,
                p_sess,
@@ -3418,6 +3745,12 @@ static int pf_cmrpc_rm_write_ind (
                &write_result,
                &p_sess->rpc_result,
                &req_pos);
+            net->cmrpc_record_deferrable = false;
+            if (ret == PNET_RECORD_PENDING)
+            {
+               is_pending = true;
+               ret = 0;
+            }
             pf_put_write_result (
                p_sess->get_info.is_big_endian,
                &write_result,
@@ -3431,14 +3764,20 @@ static int pf_cmrpc_rm_write_ind (
       {
          if (p_sess->get_info.result == PF_PARSE_OK)
          {
-            if ((uint32_t)(req_pos - req_start_pos) != p_sess->ndr_data.args_length)
+            /* The record data of a streamed request is not in the buffer */
+            req_len = (uint32_t)(req_pos - req_start_pos);
+            if (p_sess->write_stream.active)
+            {
+               req_len += p_sess->write_stream.offset;
+            }
+            if (req_len != p_sess->ndr_data.args_length)
             {
                LOG_ERROR (
                   PF_RPC_LOG,
                   "CMRPC(%d): args_length %u != request length %u\n",
                   __LINE__,
                   (unsigned)p_sess->ndr_data.args_length,
-                  (unsigned)(req_pos - req_start_pos));
+                  (unsigned)req_len);
                pf_set_error (
                   &p_sess->rpc_result,
                   PNET_ERROR_CODE_WRITE,
@@ -3465,44 +3804,41 @@ static int pf_cmrpc_rm_write_ind (
          }
       }
 
-      /* Fixup the NDR header with correct length info. */
-      /* For responses the actual_count = args_length. Offset is always zero. */
-      p_sess->ndr_data.args_length = *p_res_pos - res_start_pos;
-      p_sess->ndr_data.array.actual_count = p_sess->ndr_data.args_length;
+      if (is_pending)
+      {
+         if (
+            (ret == 0) &&
+            (pf_ar_find_by_uuid (net, &write_request.ar_uuid, &p_ar) == 0))
+         {
+            /* The response is completed by pf_cmrpc_rm_write_done() */
+            p_sess->pending_record.active = true;
+            p_sess->pending_record.opnum = PF_RPC_DEV_OPNUM_WRITE;
+            p_sess->pending_record.arep = p_ar->arep;
+            p_sess->pending_record.write_request = write_request;
+            p_sess->pending_record.write_result = write_result;
+            p_sess->pending_record.status_pos = res_status_pos;
+            p_sess->pending_record.ndr_hdr_pos = res_hdr_pos;
+            p_sess->pending_record.blocks_pos = res_start_pos;
+            return 0;
+         }
 
-      pf_put_uint32 (
-         p_sess->get_info.is_big_endian,
-         p_sess->ndr_data.args_length,
+         LOG_ERROR (
+            PF_RPC_LOG,
+            "CMRPC(%d): Invalid write request. The result of the application "
+            "will be discarded.\n",
+            __LINE__);
+      }
+
+      /* Fixup the NDR header with correct length info, and insert the actual
+       * result of the write operation into the first result block */
+      pf_cmrpc_put_record_res_end (
+         p_sess,
+         res_status_pos,
+         res_hdr_pos,
+         res_start_pos,
+         *p_res_pos,
          res_size,
-         p_res,
-         &res_hdr_pos);
-      pf_put_uint32 (
-         p_sess->get_info.is_big_endian,
-         p_sess->ndr_data.array.maximum_count,
-         res_size,
-         p_res,
-         &res_hdr_pos);
-      pf_put_uint32 (
-         p_sess->get_info.is_big_endian,
-         p_sess->ndr_data.array.offset,
-         res_size,
-         p_res,
-         &res_hdr_pos);
-      pf_put_uint32 (
-         p_sess->get_info.is_big_endian,
-         p_sess->ndr_data.array.actual_count,
-         res_size,
-         p_res,
-         &res_hdr_pos);
-
-      /* Insert the actual result of the write operation into the first result
-       * block */
-      pf_put_pnet_status (
-         p_sess->get_info.is_big_endian,
-         &p_sess->rpc_result.pnio_status,
-         res_size,
-         p_res,
-         &res_status_pos);
+         p_res);
    }
 
    return ret;
@@ -3877,6 +4213,13 @@ int pf_cmrpc_rm_ccontrol_req (pnet_t * net, pf_ar_t * p_ar)
 
       /* Open socket for CControl interchange */
       p_sess->socket = pf_udp_open (net, PF_RPC_CCONTROL_EPHEMERAL_PORT);
+      p_sess->socket_has_recv_callback =
+         (net->periodic_mutex != NULL) &&
+         (pf_udp_set_recv_callback (
+             net,
+             p_sess->socket,
+             pf_cmrpc_udp_recv_ind,
+             net) == 0);
       p_sess->resend_counter = PF_CMRPC_NUMBER_OF_RESENDS;
       pf_cmrpc_send_with_timeout (net, p_sess, os_get_current_time_us());
 
@@ -4142,6 +4485,93 @@ static int pf_cmrpc_rpc_response (
    return ret;
 }
 
+/**
+ * @internal
+ * Send the response to an RPC request, which has been put into the output
+ * buffer of the session.
+ *
+ * If it does not fit into one frame, the first fragment is sent and the
+ * remaining fragments are sent when the controller acknowledges.
+ *
+ * @param net                 InOut: The p-net stack instance
+ * @param p_sess              InOut: The session instance.
+ * @param p_rpc_res           InOut: The RPC header of the response. The
+ *                                   fragment flags are updated.
+ * @param max_rsp_len         In:    Max length of the response.
+ * @param rpc_hdr_start_pos   In:    Position of the RPC header.
+ * @param length_of_body_pos  In:    Position of the length_of_body field.
+ * @param start_pos           In:    Start of the RPC payload.
+ * @return  0  if operation succeeded.
+ *          -1 if an error occurred.
+ */
+static int pf_cmrpc_send_response (
+   pnet_t * net,
+   pf_session_info_t * p_sess,
+   pf_rpc_header_t * p_rpc_res,
+   uint16_t max_rsp_len,
+   uint16_t rpc_hdr_start_pos,
+   uint16_t length_of_body_pos,
+   uint16_t start_pos)
+{
+   int ret = 0;
+
+   if (p_sess->out_buf_len < PF_MAX_UDP_PAYLOAD_SIZE)
+   {
+      /* Our response will fit into send buffer (not fragmented) */
+      p_sess->out_buf_send_len = p_sess->out_buf_len; /* Send everything */
+   }
+   else
+   {
+      /* Send a fragmented response - Send the first fragment now */
+      p_sess->out_buf_send_len = PF_MAX_UDP_PAYLOAD_SIZE; /* Send as much as
+                                                             can fit */
+
+      /* Also set the fragment bit in the RPC response header */
+      p_rpc_res->flags.fragment = true;
+      p_rpc_res->flags.no_fack = false;
+
+      /* Re-write the header with the new info */
+      pf_put_dce_rpc_header (
+         p_rpc_res,
+         max_rsp_len,
+         p_sess->out_buffer,
+         &rpc_hdr_start_pos,
+         &length_of_body_pos);
+   }
+
+   LOG_DEBUG (
+      PF_RPC_LOG,
+      "CMRPC(%d): Send RPC response. Total response length %u, "
+      "sending %u bytes. Start of RPC payload: %u\n",
+      __LINE__,
+      p_sess->out_buf_len,
+      p_sess->out_buf_send_len,
+      start_pos);
+
+   /* Insert the real value of length_of_body in the rpc header */
+   pf_put_uint16 (
+      p_rpc_res->is_big_endian,
+      (uint16_t)(p_sess->out_buf_send_len - start_pos),
+      p_sess->out_buf_send_len,
+      p_sess->out_buffer,
+      &length_of_body_pos);
+
+   if (p_rpc_res->flags.fragment == true)
+   {
+      /* Fragmented respones from us (with ack) are supposed to be
+       * re-transmitted according to the spec. */
+      p_sess->resend_counter = PF_CMRPC_NUMBER_OF_RESENDS;
+      pf_cmrpc_send_with_timeout (net, p_sess, os_get_current_time_us());
+   }
+   else
+   {
+      /* Non-fragmented responses from us are not re-transmitted */
+      ret = pf_cmrpc_send_once (net, p_sess, "response");
+   }
+
+   return ret;
+}
+
 /**
  * @internal
  * Handle one incoming DCE RPC message, and typically sends a response.
@@ -4254,6 +4684,7 @@ static int pf_cmrpc_dce_packet (
          p_sess->is_big_endian = p_sess->get_info.is_big_endian;
          p_sess->in_fragment_nbr = 0;
          p_sess->kill_session = false;
+         p_sess->write_stream.active = false;
       }
       else
       {
@@ -4274,6 +4705,11 @@ static int pf_cmrpc_dce_packet (
             p_sess->is_big_endian = p_sess->get_info.is_big_endian;
             p_sess->in_fragment_nbr = 0;
             p_sess->kill_session = false;
+            (void)pf_cmrpc_write_stream_start (
+               net,
+               p_sess,
+               &rpc_req,
+               &p_req[req_pos]);
          }
          else
          {
@@ -4314,6 +4750,24 @@ static int pf_cmrpc_dce_packet (
                PNET_ERROR_CODE_1_CMRPC,
                PNET_ERROR_CODE_2_CMRPC_STATE_CONFLICT);
          }
+         else if (p_sess->write_stream.active)
+         {
+            /* Pass the record data on at once instead of collecting it */
+            pf_cmrpc_write_stream_put (
+               net,
+               p_sess,
+               &p_req[req_pos],
+               rpc_req.length_of_body);
+            p_sess->in_fragment_nbr++;
+
+            if (rpc_req.flags.last_fragment == true)
+            {
+               /* Re-route the parser to the headers in the session buffer */
+               req_pos = 0;
+               p_sess->get_info.p_buf = p_sess->in_buffer;
+               p_sess->get_info.len = p_sess->in_buf_len;
+            }
+         }
          else if (
             (p_sess->in_buf_len + rpc_req.length_of_body) >
             sizeof (p_sess->in_buffer))
@@ -4367,15 +4821,26 @@ static int pf_cmrpc_dce_packet (
                PF_RPC_LOG,
                "CMRPC(%d): Incoming DCE RPC ping on UDP\n",
                __LINE__);
-            /* A new request - clear the response buffer */
-            p_sess->out_buf_len = 0;
-            p_sess->out_buf_sent_pos = 0;
-            p_sess->out_buf_send_len = 0;
-            p_sess->out_fragment_nbr = 0;
+            if (p_sess->pending_record.active)
+            {
+               /* Tell the controller that the application is still working
+                * on its request. Keep the response being built. */
+               rpc_res = rpc_req;
+               rpc_res.packet_type = PF_RPC_PT_WORKING;
+            }
+            else
+            {
+               /* A new request - clear the response buffer */
+               p_sess->out_buf_len = 0;
+               p_sess->out_buf_sent_pos = 0;
+               p_sess->out_buf_send_len = 0;
+               p_sess->out_fragment_nbr = 0;
+
+               rpc_res = rpc_req;
+               rpc_res.packet_type = PF_RPC_PT_RESP_PING;
+            }
 
             /* Prepare the response */
-            rpc_res = rpc_req;
-            rpc_res.packet_type = PF_RPC_PT_RESP_PING;
             rpc_res.flags.last_fragment = false;
             rpc_res.flags.fragment = false;
             rpc_res.flags.no_fack = true;
@@ -4407,6 +4872,34 @@ static int pf_cmrpc_dce_packet (
                PF_RPC_LOG,
                "CMRPC(%d): Incoming DCE RPC request on UDP.\n",
                __LINE__);
+            if (p_sess->pending_record.active)
+            {
+               if (
+                  rpc_req.sequence_nmb ==
+                  p_sess->pending_record.rpc_res.sequence_nmb)
+               {
+                  /* The controller re-sends the request, since the
+                   * application has not answered yet. */
+                  LOG_DEBUG (
+                     PF_RPC_LOG,
+                     "CMRPC(%d): Ignoring the re-sent request. Its response "
+                     "is pending.\n",
+                     __LINE__);
+                  res_pos = 0;
+                  ret = 0;
+                  break;
+               }
+
+               /* The controller has given up on the pending request */
+               LOG_INFO (
+                  PF_RPC_LOG,
+                  "CMRPC(%d): New request while the response to sequence "
+                  "number %" PRIu32 " is pending. Discarding it.\n",
+                  __LINE__,
+                  p_sess->pending_record.rpc_res.sequence_nmb);
+               p_sess->pending_record.active = false;
+            }
+
             /* A new request - clear the response buffer */
             p_sess->out_buf_len = 0;
             p_sess->out_buf_sent_pos = 0;
@@ -4527,65 +5020,32 @@ static int pf_cmrpc_dce_packet (
                /*ToDo: Report NULL endpoint with proper error code*/
             }
 
-            if (p_sess->out_buf_len < PF_MAX_UDP_PAYLOAD_SIZE)
-            {
-               /* Our response will fit into send buffer (not fragmented) */
-               p_sess->out_buf_send_len = p_sess->out_buf_len; /* Send
-                                                                  everything */
-            }
-            else
+            if (p_sess->pending_record.active)
             {
-               /* Send a fragmented response - Send the first fragment now */
-               p_sess->out_buf_send_len = PF_MAX_UDP_PAYLOAD_SIZE; /* Send as
-                                                                      much as
-                                                                      can fit */
-
-               /* Also set the fragment bit in the RPC response header */
-               rpc_res.flags.fragment = true;
-               rpc_res.flags.no_fack = false;
-
-               /* Re-write the header with the new info */
-               pf_put_dce_rpc_header (
-                  &rpc_res,
-                  max_rsp_len,
-                  p_sess->out_buffer,
-                  &rpc_hdr_start_pos,
-                  &length_of_body_pos);
+               /* The application answers later. Keep what is needed to send
+                * the response, see pf_cmrpc_rm_read_done() */
+               p_sess->pending_record.rpc_res = rpc_res;
+               p_sess->pending_record.max_rsp_len = max_rsp_len;
+               p_sess->pending_record.rpc_hdr_start_pos = rpc_hdr_start_pos;
+               p_sess->pending_record.length_of_body_pos = length_of_body_pos;
+               p_sess->pending_record.start_pos = start_pos;
+               LOG_DEBUG (
+                  PF_RPC_LOG,
+                  "CMRPC(%d): The response is pending. Seq: %" PRIu32 "\n",
+                  __LINE__,
+                  rpc_res.sequence_nmb);
+               break;
             }
 
-            LOG_DEBUG (
-               PF_RPC_LOG,
-               "CMRPC(%d): Send RPC response. Total response length %u, "
-               "sending %u bytes. Start of RPC payload: %u\n",
-               __LINE__,
-               p_sess->out_buf_len,
-               p_sess->out_buf_send_len,
+            ret = pf_cmrpc_send_response (
+               net,
+               p_sess,
+               &rpc_res,
+               max_rsp_len,
+               rpc_hdr_start_pos,
+               length_of_body_pos,
                start_pos);
 
-            /* Insert the real value of length_of_body in the rpc header */
-            pf_put_uint16 (
-               rpc_res.is_big_endian,
-               (uint16_t)(p_sess->out_buf_send_len - start_pos),
-               p_sess->out_buf_send_len,
-               p_sess->out_buffer,
-               &length_of_body_pos);
-
-            if (rpc_res.flags.fragment == true)
-            {
-               /* Fragmented respones from us (with ack) are supposed to be
-                * re-transmitted according to the spec. */
-               p_sess->resend_counter = PF_CMRPC_NUMBER_OF_RESENDS;
-               pf_cmrpc_send_with_timeout (
-                  net,
-                  p_sess,
-                  os_get_current_time_us());
-            }
-            else
-            {
-               /* Non-fragmented responses from us are not re-transmitted */
-               ret = pf_cmrpc_send_once (net, p_sess, "response");
-            }
-
             if (set_state_paramend && p_sess->p_ar != NULL)
             {
                pf_cmdev_state_ind (net, p_sess->p_ar, PNET_EVENT_PRMEND);
@@ -4598,6 +5058,13 @@ static int pf_cmrpc_dce_packet (
                "CMRPC(%d): Received fragment ACK.\n",
                __LINE__);
 
+            if (p_sess->pending_record.active)
+            {
+               /* Nothing has been sent yet */
+               res_pos = 0;
+               break;
+            }
+
             /* Update how much the controller has received (ack'ed) */
             p_sess->out_buf_sent_pos += p_sess->out_buf_send_len;
             p_sess->out_fragment_nbr++;
@@ -4900,74 +5367,83 @@ static int pf_cmrpc_dce_packet (
    return ret;
 }
 
-void pf_cmrpc_periodic (pnet_t * net)
+/**
+ * @internal
+ * Handle an incoming frame on the socket of a session, if any.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param ix               In:    Session index
+ */
+static void pf_cmrpc_handle_session_socket (pnet_t * net, uint16_t ix)
 {
    uint32_t dcerpc_addr;
    uint16_t dcerpc_port;
    int dcerpc_input_len;
    uint16_t dcerpc_resp_len = 0;
-   uint16_t ix;
    bool close_socket = false;
    char ip_string[PNAL_INET_ADDRSTR_SIZE] = {0}; /** Terminated string */
 
-   /* TODO Use a common function to avoid code duplication, remove some
-    * arguments for pf_cmrpc_dce_packet() */
-
-   /* Poll for RPC session confirmations */
-   for (ix = 0; ix < NELEMENTS (net->cmrpc_session_info); ix++)
+   /* We are waiting for a response from the IO-controller */
+   dcerpc_input_len = pf_udp_recvfrom (
+      net,
+      net->cmrpc_session_info[ix].socket,
+      &dcerpc_addr,
+      &dcerpc_port,
+      net->cmrpc_dcerpc_input_frame,
+      sizeof (net->cmrpc_dcerpc_input_frame));
+   if (dcerpc_input_len > 0)
    {
-      if (
-         (net->cmrpc_session_info[ix].in_use == true) &&
-         (net->cmrpc_session_info[ix].from_me == true))
+      pf_cmina_ip_to_string (dcerpc_addr, ip_string);
+      dcerpc_resp_len = PF_MAX_UDP_PAYLOAD_SIZE;
+      LOG_INFO (
+         PF_RPC_LOG,
+         "CMRPC(%d): Received %u bytes UDP payload from remote %s:%u, on "
+         "socket %d used in session with index %u\n",
+         __LINE__,
+         dcerpc_input_len,
+         ip_string,
+         dcerpc_port,
+         net->cmrpc_session_info[ix].socket,
+         ix);
+      close_socket = false;
+      (void)pf_cmrpc_dce_packet (
+         net,
+         dcerpc_addr,
+         dcerpc_port,
+         net->cmrpc_dcerpc_input_frame,
+         dcerpc_input_len,
+         net->cmrpc_dcerpc_output_frame,
+         &dcerpc_resp_len,
+         &close_socket);
+
+      if (close_socket)
       {
-         /* We are waiting for a response from the IO-controller */
-         dcerpc_input_len = pf_udp_recvfrom (
-            net,
-            net->cmrpc_session_info[ix].socket,
-            &dcerpc_addr,
-            &dcerpc_port,
-            net->cmrpc_dcerpc_input_frame,
-            sizeof (net->cmrpc_dcerpc_input_frame));
-         if (dcerpc_input_len > 0)
-         {
-            pf_cmina_ip_to_string (dcerpc_addr, ip_string);
-            dcerpc_resp_len = PF_MAX_UDP_PAYLOAD_SIZE;
-            LOG_INFO (
-               PF_RPC_LOG,
-               "CMRPC(%d): Received %u bytes UDP payload from remote %s:%u, on "
-               "socket %d used in session with index %u\n",
-               __LINE__,
-               dcerpc_input_len,
-               ip_string,
-               dcerpc_port,
-               net->cmrpc_session_info[ix].socket,
-               ix);
-            close_socket = false;
-            (void)pf_cmrpc_dce_packet (
-               net,
-               dcerpc_addr,
-               dcerpc_port,
-               net->cmrpc_dcerpc_input_frame,
-               dcerpc_input_len,
-               net->cmrpc_dcerpc_output_frame,
-               &dcerpc_resp_len,
-               &close_socket);
-
-            if (close_socket)
-            {
-               LOG_DEBUG (
-                  PF_RPC_LOG,
-                  "CMRPC(%d): Closing socket used in session with index %u\n",
-                  __LINE__,
-                  ix);
-               pf_udp_close (net, net->cmrpc_session_info[ix].socket);
-               net->cmrpc_session_info[ix].socket = -1;
-            }
-         }
+         LOG_DEBUG (
+            PF_RPC_LOG,
+            "CMRPC(%d): Closing socket used in session with index %u\n",
+            __LINE__,
+            ix);
+         pf_udp_close (net, net->cmrpc_session_info[ix].socket);
+         net->cmrpc_session_info[ix].socket = -1;
       }
    }
+}
+
+/**
+ * @internal
+ * Handle an incoming frame on the main socket for DCE RPC requests, if any.
+ *
+ * @param net              InOut: The p-net stack instance
+ */
+static void pf_cmrpc_handle_rpcreq_socket (pnet_t * net)
+{
+   uint32_t dcerpc_addr;
+   uint16_t dcerpc_port;
+   int dcerpc_input_len;
+   uint16_t dcerpc_resp_len = 0;
+   bool close_socket = false;
+   char ip_string[PNAL_INET_ADDRSTR_SIZE] = {0}; /** Terminated string */
 
-   /* Poll RPC requests */
    dcerpc_input_len = pf_udp_recvfrom (
       net,
       net->cmrpc_rpcreq_socket,
@@ -5010,6 +5486,280 @@ void pf_cmrpc_periodic (pnet_t * net)
    }
 }
 
+/**
+ * @internal
+ * Handle incoming data on a UDP socket. Called from the common receive
+ * thread.
+ *
+ * Runs under the periodic mutex, so incoming frames are handled as if
+ * they were polled by pnet_handle_periodic().
+ *
+ * This is a callback for the pf_udp_set_recv_callback() function.
+ *
+ * @param id               In:    Socket ID
+ * @param arg              InOut: The p-net stack instance
+ */
+static void pf_cmrpc_udp_recv_ind (uint32_t id, void * arg)
+{
+   pnet_t * net = (pnet_t *)arg;
+   uint32_t dcerpc_addr;
+   uint16_t dcerpc_port;
+   uint16_t ix;
+
+   os_mutex_lock (net->periodic_mutex);
+
+   if ((int)id == net->cmrpc_rpcreq_socket)
+   {
+      pf_cmrpc_handle_rpcreq_socket (net);
+      os_mutex_unlock (net->periodic_mutex);
+      return;
+   }
+
+   for (ix = 0; ix < NELEMENTS (net->cmrpc_session_info); ix++)
+   {
+      if (
+         (net->cmrpc_session_info[ix].in_use == true) &&
+         (net->cmrpc_session_info[ix].from_me == true) &&
+         (net->cmrpc_session_info[ix].socket == (int)id))
+      {
+         pf_cmrpc_handle_session_socket (net, ix);
+         os_mutex_unlock (net->periodic_mutex);
+         return;
+      }
+   }
+
+   /* The session was released while the frame was waiting */
+   (void)pf_udp_recvfrom (
+      net,
+      id,
+      &dcerpc_addr,
+      &dcerpc_port,
+      net->cmrpc_dcerpc_input_frame,
+      sizeof (net->cmrpc_dcerpc_input_frame));
+
+   os_mutex_unlock (net->periodic_mutex);
+}
+
+void pf_cmrpc_periodic (pnet_t * net)
+{
+   uint16_t ix;
+
+   /* TODO Use a common function to avoid code duplication, remove some
+    * arguments for pf_cmrpc_dce_packet() */
+
+   /* Poll for RPC session confirmations */
+   for (ix = 0; ix < NELEMENTS (net->cmrpc_session_info); ix++)
+   {
+      if (
+         (net->cmrpc_session_info[ix].in_use == true) &&
+         (net->cmrpc_session_info[ix].from_me == true) &&
+         (net->cmrpc_session_info[ix].socket_has_recv_callback == false))
+      {
+         pf_cmrpc_handle_session_socket (net, ix);
+      }
+   }
+
+   /* Poll RPC requests, unless handled by the common receive thread */
+   if (net->periodic_mutex == NULL)
+   {
+      pf_cmrpc_handle_rpcreq_socket (net);
+   }
+}
+
+/*********************** Deferred record responses ***************************/
+
+/**
+ * @internal
+ * Find the session of a read or write request, whose response is pending.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param opnum            In:    PF_RPC_DEV_OPNUM_READ or
+ *                                PF_RPC_DEV_OPNUM_WRITE.
+ * @param arep             In:    The AREP of the request.
+ * @param sequence_number  In:    The sequence number of the request.
+ * @return  The session, or NULL if not found.
+ */
+static pf_session_info_t * pf_cmrpc_find_pending_record (
+   pnet_t * net,
+   uint16_t opnum,
+   uint32_t arep,
+   uint16_t sequence_number)
+{
+   uint16_t ix;
+   pf_session_info_t * p_sess;
+
+   for (ix = 0; ix < NELEMENTS (net->cmrpc_session_info); ix++)
+   {
+      p_sess = &net->cmrpc_session_info[ix];
+      if (
+         (p_sess->in_use == true) && (p_sess->pending_record.active == true) &&
+         (p_sess->pending_record.opnum == opnum) &&
+         (p_sess->pending_record.arep == arep) &&
+         (((opnum == PF_RPC_DEV_OPNUM_READ) &&
+           (p_sess->pending_record.read_request.sequence_number ==
+            sequence_number)) ||
+          ((opnum == PF_RPC_DEV_OPNUM_WRITE) &&
+           (p_sess->pending_record.write_request.sequence_number ==
+            sequence_number))))
+      {
+         return p_sess;
+      }
+   }
+
+   LOG_INFO (
+      PF_RPC_LOG,
+      "CMRPC(%d): No pending %s request for AREP %" PRIu32
+      " with sequence number %u. The controller might have given up.\n",
+      __LINE__,
+      opnum == PF_RPC_DEV_OPNUM_READ ? "read" : "write",
+      arep,
+      sequence_number);
+   return NULL;
+}
+
+int pf_cmrpc_rm_read_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const uint8_t * p_read_data,
+   uint16_t read_length,
+   const pnet_result_t * p_result)
+{
+   pf_session_info_t * p_sess;
+   pf_session_pending_record_t * p_pending;
+   pf_ar_t * p_ar = NULL;
+
+   p_sess = pf_cmrpc_find_pending_record (
+      net,
+      PF_RPC_DEV_OPNUM_READ,
+      arep,
+      sequence_number);
+   if (p_sess == NULL)
+   {
+      return -1;
+   }
+   p_pending = &p_sess->pending_record;
+   p_pending->active = false;
+
+   if (pf_ar_find_by_arep (net, arep, &p_ar) != 0)
+   {
+      LOG_INFO (
+         PF_RPC_LOG,
+         "CMRPC(%d): AREP %" PRIu32 " was released while reading.\n",
+         __LINE__,
+         arep);
+      return -1;
+   }
+
+   memset (&p_sess->rpc_result, 0, sizeof (p_sess->rpc_result));
+   if (p_result != NULL)
+   {
+      p_sess->rpc_result = *p_result;
+      if (p_result->pnio_status.error_code != PNET_ERROR_CODE_NOERROR)
+      {
+         read_length = 0;
+      }
+   }
+
+   /* Continue the response after the NDR header */
+   p_sess->get_info.is_big_endian = true;
+   p_sess->out_buf_len = p_pending->blocks_pos;
+   if (
+      pf_cmrdr_rm_read_done (
+         net,
+         p_ar,
+         &p_pending->read_request,
+         &p_sess->rpc_result,
+         p_read_data,
+         read_length,
+         p_pending->max_rsp_len,
+         p_sess->out_buffer,
+         &p_sess->out_buf_len) == 0)
+   {
+      (void)pf_cmsm_rm_read_ind (net, p_ar, &p_pending->read_request);
+   }
+
+   pf_cmrpc_put_record_res_end (
+      p_sess,
+      p_pending->status_pos,
+      p_pending->ndr_hdr_pos,
+      p_pending->blocks_pos,
+      p_sess->out_buf_len,
+      p_pending->max_rsp_len,
+      p_sess->out_buffer);
+
+   return pf_cmrpc_send_response (
+      net,
+      p_sess,
+      &p_pending->rpc_res,
+      p_pending->max_rsp_len,
+      p_pending->rpc_hdr_start_pos,
+      p_pending->length_of_body_pos,
+      p_pending->start_pos);
+}
+
+int pf_cmrpc_rm_write_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const pnet_result_t * p_result)
+{
+   pf_session_info_t * p_sess;
+   pf_session_pending_record_t * p_pending;
+
+   p_sess = pf_cmrpc_find_pending_record (
+      net,
+      PF_RPC_DEV_OPNUM_WRITE,
+      arep,
+      sequence_number);
+   if (p_sess == NULL)
+   {
+      return -1;
+   }
+   p_pending = &p_sess->pending_record;
+   p_pending->active = false;
+
+   memset (&p_sess->rpc_result, 0, sizeof (p_sess->rpc_result));
+   if (p_result != NULL)
+   {
+      p_pending->write_result.add_data_1 = p_result->add_data_1;
+      p_pending->write_result.add_data_2 = p_result->add_data_2;
+      if (p_result->pnio_status.error_code != PNET_ERROR_CODE_NOERROR)
+      {
+         p_sess->rpc_result = *p_result;
+         p_pending->write_result.pnio_status = p_result->pnio_status;
+      }
+   }
+
+   /* Continue the response after the NDR header */
+   p_sess->get_info.is_big_endian = true;
+   p_sess->out_buf_len = p_pending->blocks_pos;
+   pf_put_write_result (
+      p_sess->get_info.is_big_endian,
+      &p_pending->write_result,
+      p_pending->max_rsp_len,
+      p_sess->out_buffer,
+      &p_sess->out_buf_len);
+
+   pf_cmrpc_put_record_res_end (
+      p_sess,
+      p_pending->status_pos,
+      p_pending->ndr_hdr_pos,
+      p_pending->blocks_pos,
+      p_sess->out_buf_len,
+      p_pending->max_rsp_len,
+      p_sess->out_buffer);
+
+   return pf_cmrpc_send_response (
+      net,
+      p_sess,
+      &p_pending->rpc_res,
+      p_pending->max_rsp_len,
+      p_pending->rpc_hdr_start_pos,
+      p_pending->length_of_body_pos,
+      p_pending->start_pos);
+}
+
 /*********************** Initialize ******************************************/
 
 void pf_cmrpc_init (pnet_t * net)
@@ -5027,6 +5777,21 @@ void pf_cmrpc_init (pnet_t * net)
       }
 
       net->cmrpc_rpcreq_socket = pf_udp_open (net, PF_RPC_SERVER_PORT);
+
+      /* Handle incoming RPC frames as they arrive, if the common receive
+       * thread is used */
+      net->periodic_mutex = os_mutex_create();
+      if (
+         net->periodic_mutex != NULL &&
+         pf_udp_set_recv_callback (
+            net,
+            net->cmrpc_rpcreq_socket,
+            pf_cmrpc_udp_recv_ind,
+            net) != 0)
+      {
+         os_mutex_destroy (net->periodic_mutex);
+         net->periodic_mutex = NULL;
+      }
    }
 
    /* Save for later (put it into each session */
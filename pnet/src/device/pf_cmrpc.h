@@ -137,6 +137,44 @@ int pf_cmrpc_cmdev_state_ind (
  */
 int pf_cmrpc_rm_ccontrol_req (pnet_t * net, pf_ar_t * p_ar);
 
+/**
+ * Complete an IODRead request, for which the application returned
+ * PNET_RECORD_PENDING, and send the response.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP of the request.
+ * @param sequence_number  In:    The sequence number of the request.
+ * @param p_read_data      In:    The value read by the application.
+ * @param read_length      In:    Length of the value.
+ * @param p_result         In:    Error information, or NULL on success.
+ * @return  0  if operation succeeded.
+ *          -1 if no such request is pending.
+ */
+int pf_cmrpc_rm_read_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const uint8_t * p_read_data,
+   uint16_t read_length,
+   const pnet_result_t * p_result);
+
+/**
+ * Complete an IODWrite request, for which the application returned
+ * PNET_RECORD_PENDING, and send the response.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param arep             In:    The AREP of the request.
+ * @param sequence_number  In:    The sequence number of the request.
+ * @param p_result         In:    Error information, or NULL on success.
+ * @return  0  if operation succeeded.
+ *          -1 if no such request is pending.
+ */
+int pf_cmrpc_rm_write_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const pnet_result_t * p_result);
+
 /**
  * Show AR and session information.
  *
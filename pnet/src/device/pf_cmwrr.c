@@ -22,6 +22,8 @@
 #include "pf_block_writer.h"
 #include "pf_block_reader.h"
 
+#include <inttypes.h>
+
 /**
  * @file
  * @brief Implements the Context Management Write Record Responder protocol
@@ -168,6 +170,7 @@ int pf_cmwrr_cmdev_state_ind (
  * @param p_req_pos        InOut: Position within the request buffer.
  * @param p_result         Out:   Detailed error information if returning != 0
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application reports the result later.
  *          -1 if an error occurred.
  */
 static int pf_cmwrr_write (
@@ -259,7 +262,7 @@ static int pf_cmwrr_write (
 
    (*p_req_pos) += data_length;
 
-   if (ret != 0)
+   if ((ret != 0) && (ret != PNET_RECORD_PENDING))
    {
       LOG_INFO (
          PNET_LOG,
@@ -279,57 +282,28 @@ static int pf_cmwrr_write (
    return ret;
 }
 
-int pf_cmwrr_rm_write_ind (
-   pnet_t * net,
-   pf_ar_t * p_ar,
-   const pf_iod_write_request_t * p_write_request,
-   pf_iod_write_result_t * p_write_result,
-   pnet_result_t * p_result,
-   const uint8_t * p_req_buf,
-   uint16_t data_length,
-   uint16_t * p_req_pos)
+/**
+ * @internal
+ * Check that the state of the AR allows writing records.
+ *
+ * @param p_ar             In:    The AR instance.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  if records may be written.
+ *          -1 if not.
+ */
+static int pf_cmwrr_check_state (const pf_ar_t * p_ar, pnet_result_t * p_result)
 {
    int ret = -1;
 
-   p_write_result->sequence_number = p_write_request->sequence_number;
-   p_write_result->ar_uuid = p_write_request->ar_uuid;
-   p_write_result->api = p_write_request->api;
-   p_write_result->slot_number = p_write_request->slot_number;
-   p_write_result->subslot_number = p_write_request->subslot_number;
-   p_write_result->index = p_write_request->index;
-   p_write_result->record_data_length = 0;
-
    switch (p_ar->cmwrr_state)
    {
    case PF_CMWRR_STATE_IDLE:
-      p_result->pnio_status.error_code = PNET_ERROR_CODE_PNIO;
-      p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_ACC_STATE_CONFLICT;
-      break;
-   case PF_CMWRR_STATE_STARTUP:
-      if (p_ar->ar_state == PF_AR_STATE_BACKUP)
-      {
-         p_result->pnio_status.error_code = PNET_ERROR_CODE_PNIO;
-         p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-         p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_ACC_BACKUP;
-      }
-      else
-      {
-         ret = pf_cmwrr_write (
-            net,
-            p_ar,
-            p_write_request,
-            p_req_buf,
-            data_length,
-            p_req_pos,
-            p_result);
-      }
-      break;
    case PF_CMWRR_STATE_PRMEND:
       p_result->pnio_status.error_code = PNET_ERROR_CODE_PNIO;
       p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
       p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_ACC_STATE_CONFLICT;
       break;
+   case PF_CMWRR_STATE_STARTUP:
    case PF_CMWRR_STATE_DATA:
       if (p_ar->ar_state == PF_AR_STATE_BACKUP)
       {
@@ -339,18 +313,46 @@ int pf_cmwrr_rm_write_ind (
       }
       else
       {
-         ret = pf_cmwrr_write (
-            net,
-            p_ar,
-            p_write_request,
-            p_req_buf,
-            data_length,
-            p_req_pos,
-            p_result);
+         ret = 0;
       }
       break;
    }
 
+   return ret;
+}
+
+int pf_cmwrr_rm_write_ind (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request,
+   pf_iod_write_result_t * p_write_result,
+   pnet_result_t * p_result,
+   const uint8_t * p_req_buf,
+   uint16_t data_length,
+   uint16_t * p_req_pos)
+{
+   int ret = -1;
+
+   p_write_result->sequence_number = p_write_request->sequence_number;
+   p_write_result->ar_uuid = p_write_request->ar_uuid;
+   p_write_result->api = p_write_request->api;
+   p_write_result->slot_number = p_write_request->slot_number;
+   p_write_result->subslot_number = p_write_request->subslot_number;
+   p_write_result->index = p_write_request->index;
+   p_write_result->record_data_length = 0;
+
+   if (pf_cmwrr_check_state (p_ar, p_result) == 0)
+   {
+      ret = pf_cmwrr_write (
+         net,
+         p_ar,
+         p_write_request,
+         p_req_buf,
+         data_length,
+         p_req_pos,
+         p_result);
+   }
+
    p_write_result->add_data_1 = p_result->add_data_1;
    p_write_result->add_data_2 = p_result->add_data_2;
 
@@ -362,3 +364,45 @@ int pf_cmwrr_rm_write_ind (
 
    return ret;
 }
+
+int pf_cmwrr_rm_write_chunk_ind (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request,
+   uint32_t offset,
+   uint16_t data_length,
+   const uint8_t * p_data,
+   pnet_result_t * p_result)
+{
+   int ret = -1;
+
+   if (pf_cmwrr_check_state (p_ar, p_result) == 0)
+   {
+      ret = pf_fspm_cm_write_chunk_ind (
+         net,
+         p_ar,
+         p_write_request,
+         offset,
+         data_length,
+         p_data,
+         p_result);
+      if (ret != 0)
+      {
+         LOG_INFO (
+            PNET_LOG,
+            "CMWRR(%d): The application rejected a part of index %u at "
+            "offset %" PRIu32 ".\n",
+            __LINE__,
+            p_write_request->index,
+            offset);
+      }
+   }
+
+   /* A long transfer must not trigger the start-up timeout */
+   if (pf_cmsm_cm_write_ind (net, p_ar, p_write_request) != 0)
+   {
+      ret = -1;
+   }
+
+   return ret;
+}
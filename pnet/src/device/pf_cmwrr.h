@@ -63,6 +63,7 @@ int pf_cmwrr_cmdev_state_ind (
  * @param data_length      In:    The length of the data to write.
  * @param p_req_pos        In:    Position in p_req_buf.
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application reports the result later.
  *          -1 if an error occurred.
  */
 int pf_cmwrr_rm_write_ind (
@@ -75,6 +76,32 @@ int pf_cmwrr_rm_write_ind (
    uint16_t data_length,
    uint16_t * p_req_pos);
 
+/**
+ * Handle a part of a fragmented RPC write request of an application-specific
+ * index, see \a pnet_write_chunk_ind().
+ *
+ * If the state is correct, it will trigger the \a pnet_write_chunk_ind() user
+ * callback.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             InOut: The AR instance.
+ * @param p_write_request  In:    The write request block.
+ * @param offset           In:    Position of the part in the record.
+ * @param data_length      In:    The length of the part.
+ * @param p_data           In:    The part.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  if operation succeeded.
+ *          -1 if an error occurred.
+ */
+int pf_cmwrr_rm_write_chunk_ind (
+   pnet_t * net,
+   pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request,
+   uint32_t offset,
+   uint16_t data_length,
+   const uint8_t * p_data,
+   pnet_result_t * p_result);
+
 #ifdef __cplusplus
 }
 #endif
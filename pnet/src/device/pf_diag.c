@@ -28,10 +28,13 @@
  *  - pf_cmdev_new_diag()
  *  - pf_cmdev_get_diag_item()
  *  - pf_cmdev_free_diag()
+ *  - pf_cmdev_find_diag(), pf_cmdev_link_diag() and pf_cmdev_unlink_diag()
  *
  * An array of PNET_MAX_DIAG_ITEMS diagnosis items is available for use.
  * In CMDEV, each subslot uses a linked list of diagnosis items, and stores the
- * index to the head of its (possibly empty) list.
+ * index to the head of its (possibly empty) list. Items are looked up by a
+ * hash index, and CMDEV keeps a summary per subslot of the items in its list,
+ * such that no operation walks the list.
  */
 
 #ifdef UNIT_TEST
@@ -64,7 +67,7 @@ int pf_diag_exit (void)
 /**
  * @internal
  * Update the problem indicator in the PPM data status
- * by looking at all diagnosis items of a sub-slot.
+ * from the diagnosis summary of a sub-slot.
  *
  * @param net              InOut: The p-net stack instance.
  * @param p_ar             InOut: The AR instance.
@@ -75,33 +78,11 @@ static void pf_diag_update_station_problem_indicator (
    pf_ar_t * p_ar,
    const pf_subslot_t * p_subslot)
 {
-   bool is_problem = false;
-   pf_device_t * p_dev = NULL;
-   uint16_t ix;
-   pf_diag_item_t * p_item;
-
-   if (pf_cmdev_get_device (net, &p_dev) == 0)
-   {
-      /* A problem is indicated if at least one FAULT diagnosis exists. */
-      ix = p_subslot->diag_list;
-      pf_cmdev_get_diag_item (net, ix, &p_item);
-      while (p_item != NULL)
-      {
-         if (
-            (p_item->in_use == true) &&
-            ((p_item->usi < PF_USI_CHANNEL_DIAGNOSIS) ||
-             (PF_DIAG_CH_PROP_MAINT_GET (p_item->fmt.std.ch_properties) ==
-              PNET_DIAG_CH_PROP_MAINT_FAULT)))
-         {
-            is_problem = true;
-         }
-
-         ix = p_item->next;
-         pf_cmdev_get_diag_item (net, ix, &p_item);
-      }
-   }
-
-   pf_ppm_set_problem_indicator (net, p_ar, is_problem);
+   /* A problem is indicated if at least one FAULT diagnosis exists. */
+   pf_ppm_set_problem_indicator (
+      net,
+      p_ar,
+      p_subslot->diag_summary.num_problem > 0);
 }
 
 /**
@@ -117,56 +98,20 @@ static void pf_diag_update_submodule_state (
    pf_ar_t * p_ar,
    pf_subslot_t * p_subslot)
 {
-   pf_device_t * p_dev = NULL;
-   uint16_t ix;
-   pf_diag_item_t * p_item;
-   pf_submod_state_t submodule_state;
    pnet_alarm_spec_t alarm_spec = {0};
    uint32_t maint_status = 0;
 
-   memset (&submodule_state, 0, sizeof (submodule_state));
-
-   if (pf_cmdev_get_device (net, &p_dev) == 0)
-   {
-      ix = p_subslot->diag_list;
-      pf_cmdev_get_diag_item (net, ix, &p_item);
-      while (p_item != NULL)
-      {
-         if (p_item->in_use == true)
-         {
-            pf_alarm_add_diag_item_to_summary (
-               p_ar,
-               p_subslot,
-               p_item,
-               &alarm_spec,
-               &maint_status);
-
-            if (alarm_spec.submodule_diagnosis == true)
-            {
-               submodule_state.fault = true;
-            }
-
-            if (maint_status & PF_DIAG_BIT_MAINTENANCE_REQUIRED)
-            {
-               submodule_state.maintenance_required = true;
-            }
-
-            if (maint_status & PF_DIAG_BIT_MAINTENANCE_DEMANDED)
-            {
-               submodule_state.maintenance_demanded = true;
-            }
-         }
-
-         ix = p_item->next;
-         pf_cmdev_get_diag_item (net, ix, &p_item);
-      }
-
-      p_subslot->submodule_state.fault = submodule_state.fault;
-      p_subslot->submodule_state.maintenance_required =
-         submodule_state.maintenance_required;
-      p_subslot->submodule_state.maintenance_demanded =
-         submodule_state.maintenance_demanded;
-   }
+   pf_alarm_add_subslot_diag_summary (
+      p_ar,
+      p_subslot,
+      &alarm_spec,
+      &maint_status);
+
+   p_subslot->submodule_state.fault = alarm_spec.submodule_diagnosis;
+   p_subslot->submodule_state.maintenance_required =
+      (maint_status & PF_DIAG_BIT_MAINTENANCE_REQUIRED) != 0;
+   p_subslot->submodule_state.maintenance_demanded =
+      (maint_status & PF_DIAG_BIT_MAINTENANCE_DEMANDED) != 0;
 }
 
 /**
@@ -180,6 +125,8 @@ static void pf_diag_update_submodule_state (
  * - Channel error type.
  * - Extended error type.
  *
+ * The item is looked up in the hash index kept by CMDEV.
+ *
  * Note that the severity or ExtChannelErrorAddValue are not used for
  * identification, so there could be no two diagnosis where these values
  * differ but the values above are the same.
@@ -204,9 +151,7 @@ static void pf_diag_find_entry (
    pf_subslot_t ** pp_subslot,
    uint16_t * p_diag_ix)
 {
-   pf_diag_item_t * p_item = NULL;
-   pf_diag_item_t * p_prev = NULL;
-   uint16_t prev_ix;
+   pf_diag_key_t key;
    uint16_t item_ix;
 
    *p_diag_ix = PF_DIAG_IX_NULL;
@@ -228,68 +173,26 @@ static void pf_diag_find_entry (
           ((*pp_subslot)->submodule_state.ar_info ==
            PF_SUBMOD_AR_INFO_APPLICATION_READY_PENDING)))
       {
-         prev_ix = PF_DIAG_IX_NULL;
-         item_ix = (*pp_subslot)->diag_list;
-         pf_cmdev_get_diag_item (net, item_ix, &p_item);
-         while ((p_item != NULL) && (*p_diag_ix == PF_DIAG_IX_NULL))
+         memset (&key, 0, sizeof (key));
+         if (usi >= PF_USI_CHANNEL_DIAGNOSIS)
          {
-            /* Found a match if all of:
-             *    format is STD.
-             *    channel number matches.
-             *    individual channel or channel group
-             *    direction matches.
-             *    ch_error_type matches.
-             *    ext_ch_error_type matches.
-             * ToDo: How do we find manuf_data diag entries??
-             */
-            if (p_item->usi >= PF_USI_CHANNEL_DIAGNOSIS)
-            {
-               if (
-                  (p_item->fmt.std.ch_nbr == p_diag_source->ch) &&
-                  (p_item->fmt.std.ch_error_type == ch_error_type) &&
-                  (p_item->fmt.std.ext_ch_error_type == ext_ch_error_type) &&
-                  (PF_DIAG_CH_PROP_ACC_GET (p_item->fmt.std.ch_properties) ==
-                   p_diag_source->ch_grouping) &&
-                  (PF_DIAG_CH_PROP_DIR_GET (p_item->fmt.std.ch_properties) ==
-                   p_diag_source->ch_direction))
-               {
-                  *p_diag_ix = item_ix;
-
-                  /* Unlink it from the list so it can be updated. */
-                  if (prev_ix != PF_DIAG_IX_NULL)
-                  {
-                     /* Not first in list */
-                     pf_cmdev_get_diag_item (net, prev_ix, &p_prev);
-                     p_prev->next = p_item->next;
-                  }
-                  else
-                  {
-                     /* Unlink the first item in the list */
-                     (*pp_subslot)->diag_list = p_item->next;
-                  }
-               }
-            }
-            else if (p_item->usi == usi)
-            {
-               *p_diag_ix = item_ix;
-
-               /* Unlink it from the list so it can be updated. */
-               if (prev_ix != PF_DIAG_IX_NULL)
-               {
-                  /* Not first in list */
-                  pf_cmdev_get_diag_item (net, prev_ix, &p_prev);
-                  p_prev->next = p_item->next;
-               }
-               else
-               {
-                  /* Unlink the first item in the list */
-                  (*pp_subslot)->diag_list = p_item->next;
-               }
-            }
+            key.usi = PF_USI_CHANNEL_DIAGNOSIS;
+            key.ch_nbr = p_diag_source->ch;
+            key.accumulative = p_diag_source->ch_grouping;
+            key.direction = p_diag_source->ch_direction;
+            key.ch_error_type = ch_error_type;
+            key.ext_ch_error_type = ext_ch_error_type;
+         }
+         else
+         {
+            key.usi = usi;
+         }
 
-            prev_ix = item_ix;
-            item_ix = p_item->next;
-            pf_cmdev_get_diag_item (net, item_ix, &p_item);
+         if (pf_cmdev_find_diag (net, *pp_subslot, &key, &item_ix) == 0)
+         {
+            /* Unlink it from the list so it can be updated. */
+            pf_cmdev_unlink_diag (net, *pp_subslot, item_ix);
+            *p_diag_ix = item_ix;
          }
       }
       else
@@ -544,8 +447,7 @@ int pf_diag_add (
             }
 
             /* Link it into the sub-slot reported list */
-            p_item->next = p_subslot->diag_list;
-            p_subslot->diag_list = item_ix;
+            pf_cmdev_link_diag (net, p_subslot, item_ix);
 
             pf_diag_update_submodule_state (net, p_ar, p_subslot);
 
@@ -746,8 +648,7 @@ int pf_diag_update (
             }
 
             /* Link it into the sub-slot diag list */
-            p_item->next = p_subslot->diag_list;
-            p_subslot->diag_list = item_ix;
+            pf_cmdev_link_diag (net, p_subslot, item_ix);
 
             pf_diag_update_submodule_state (net, p_ar, p_subslot);
 
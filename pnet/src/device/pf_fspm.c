@@ -696,6 +696,21 @@ int pf_fspm_cm_read_ind (
             pp_read_data,
             p_read_length,
             p_read_status);
+
+         if ((ret == PNET_RECORD_PENDING) && !net->cmrpc_record_deferrable)
+         {
+            LOG_ERROR (
+               PNET_LOG,
+               "FSPM(%d): The read callback deferred the response of a "
+               "request which must be answered at once.\n",
+               __LINE__);
+            p_read_status->pnio_status.error_code = PNET_ERROR_CODE_READ;
+            p_read_status->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+            p_read_status->pnio_status.error_code_1 =
+               PNET_ERROR_CODE_1_APP_BUSY;
+            p_read_status->pnio_status.error_code_2 = 0;
+            ret = -1;
+         }
       }
       else
       {
@@ -840,6 +855,146 @@ int pf_fspm_cm_read_ind (
    return ret;
 }
 
+int pf_fspm_cm_write_multiple_ind (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   pnet_write_multiple_event_t event,
+   pnet_result_t * p_write_status)
+{
+   int ret = 0;
+   pnet_result_t ignored_status;
+
+   if (net->fspm_cfg.write_multiple_cb != NULL)
+   {
+      /* Only the result of a commit is reported to the controller */
+      memset (&ignored_status, 0, sizeof (ignored_status));
+
+      LOG_DEBUG (
+         PNET_LOG,
+         "FSPM(%d): Triggering write multiple callback for AREP %u. Event "
+         "%u\n",
+         __LINE__,
+         p_ar->arep,
+         (unsigned)event);
+
+      ret = net->fspm_cfg.write_multiple_cb (
+         net,
+         net->fspm_cfg.cb_arg,
+         p_ar->arep,
+         event,
+         (event == PNET_WRITE_MULTIPLE_COMMIT) ? p_write_status
+                                               : &ignored_status);
+      if ((ret != 0) && (event == PNET_WRITE_MULTIPLE_COMMIT))
+      {
+         if (p_write_status->pnio_status.error_code == PNET_ERROR_CODE_NOERROR)
+         {
+            p_write_status->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
+            p_write_status->pnio_status.error_decode =
+               PNET_ERROR_DECODE_PNIORW;
+            p_write_status->pnio_status.error_code_1 =
+               PNET_ERROR_CODE_1_APP_WRITE_ERROR;
+            p_write_status->pnio_status.error_code_2 = 0;
+         }
+         ret = -1;
+      }
+      else
+      {
+         ret = 0;
+      }
+   }
+
+   return ret;
+}
+
+bool pf_fspm_cm_write_chunk_accepted (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request)
+{
+   pnet_result_t result;
+
+   if (
+      (p_write_request->index > PF_IDX_USER_MAX) ||
+      (net->fspm_cfg.write_chunk_cb == NULL))
+   {
+      return false;
+   }
+
+   memset (&result, 0, sizeof (result));
+   return net->fspm_cfg.write_chunk_cb (
+             net,
+             net->fspm_cfg.cb_arg,
+             p_ar->arep,
+             p_write_request->api,
+             p_write_request->slot_number,
+             p_write_request->subslot_number,
+             p_write_request->index,
+             p_write_request->sequence_number,
+             0,
+             p_write_request->record_data_length,
+             0,
+             NULL,
+             &result) == 0;
+}
+
+int pf_fspm_cm_write_chunk_ind (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request,
+   uint32_t offset,
+   uint16_t data_length,
+   const uint8_t * p_data,
+   pnet_result_t * p_write_status)
+{
+   int ret = -1;
+
+   if (
+      (p_write_request->index <= PF_IDX_USER_MAX) &&
+      (net->fspm_cfg.write_chunk_cb != NULL))
+   {
+      LOG_DEBUG (
+         PNET_LOG,
+         "FSPM(%d): Triggering write chunk callback for AREP %u. Slot %u "
+         "subslot %u index %u offset %" PRIu32 " len %u\n",
+         __LINE__,
+         p_ar->arep,
+         p_write_request->slot_number,
+         p_write_request->subslot_number,
+         p_write_request->index,
+         offset,
+         data_length);
+
+      ret = net->fspm_cfg.write_chunk_cb (
+         net,
+         net->fspm_cfg.cb_arg,
+         p_ar->arep,
+         p_write_request->api,
+         p_write_request->slot_number,
+         p_write_request->subslot_number,
+         p_write_request->index,
+         p_write_request->sequence_number,
+         offset,
+         p_write_request->record_data_length,
+         data_length,
+         p_data,
+         p_write_status);
+      if (ret != 0)
+      {
+         ret = -1;
+      }
+   }
+   else
+   {
+      p_write_status->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
+      p_write_status->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+      p_write_status->pnio_status.error_code_1 =
+         PNET_ERROR_CODE_1_APP_NOT_SUPPORTED;
+      p_write_status->pnio_status.error_code_2 = 0;
+   }
+
+   return ret;
+}
+
 int pf_fspm_cm_write_ind (
    pnet_t * net,
    const pf_ar_t * p_ar,
@@ -880,6 +1035,21 @@ int pf_fspm_cm_write_ind (
             write_length,
             p_write_data,
             p_write_status);
+
+         if ((ret == PNET_RECORD_PENDING) && !net->cmrpc_record_deferrable)
+         {
+            LOG_ERROR (
+               PNET_LOG,
+               "FSPM(%d): The write callback deferred the response of a "
+               "request which must be answered at once.\n",
+               __LINE__);
+            p_write_status->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
+            p_write_status->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+            p_write_status->pnio_status.error_code_1 =
+               PNET_ERROR_CODE_1_APP_BUSY;
+            p_write_status->pnio_status.error_code_2 = 0;
+            ret = -1;
+         }
       }
       else
       {
@@ -1419,3 +1589,11 @@ int pf_fspm_signal_led_ind (pnet_t * net, bool led_state)
 
    return ret;
 }
+
+void pf_fspm_next_timeout_ind (pnet_t * net)
+{
+   if (net->fspm_cfg.next_timeout_cb != NULL)
+   {
+      net->fspm_cfg.next_timeout_cb (net, net->fspm_cfg.cb_arg);
+   }
+}
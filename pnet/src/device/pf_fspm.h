@@ -67,6 +67,62 @@ void pf_fspm_create_log_book_entry (
    const pnet_pnio_status_t * p_pnio_status,
    uint32_t entry_detail);
 
+/**
+ * Tell the application that a Write Multiple request begins or ends, using
+ * the application call-back \a pnet_write_multiple_ind() if defined.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             In:    The AR instance.
+ * @param event            In:    The step of the request.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  if operation succeeded.
+ *          -1 if the application rejects the records on
+ *             PNET_WRITE_MULTIPLE_COMMIT.
+ */
+int pf_fspm_cm_write_multiple_ind (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   pnet_write_multiple_event_t event,
+   pnet_result_t * p_result);
+
+/**
+ * Pass a part of a fragmented write record request of an application-specific
+ * index to the application call-back \a pnet_write_chunk_ind().
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             In:    The AR instance.
+ * @param p_write_request  In:    The write request record.
+ * @param offset           In:    Position of the part in the record.
+ * @param data_length      In:    Length in bytes of the part.
+ * @param p_data           In:    The part.
+ * @param p_result         Out:   Detailed error information if returning != 0
+ * @return  0  if operation succeeded.
+ *          -1 if an error occurred.
+ */
+int pf_fspm_cm_write_chunk_ind (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request,
+   uint32_t offset,
+   uint16_t data_length,
+   const uint8_t * p_data,
+   pnet_result_t * p_result);
+
+/**
+ * Ask the application call-back \a pnet_write_chunk_ind() whether a
+ * fragmented write record request of an application-specific index is passed
+ * to it in parts.
+ *
+ * @param net              InOut: The p-net stack instance
+ * @param p_ar             In:    The AR instance.
+ * @param p_write_request  In:    The write request record.
+ * @return  true if the application takes the record in parts.
+ */
+bool pf_fspm_cm_write_chunk_accepted (
+   pnet_t * net,
+   const pf_ar_t * p_ar,
+   const pf_iod_write_request_t * p_write_request);
+
 /**
  * Process write record requests from the controller.
  * If index indicates I&M data records then handle here.
@@ -81,6 +137,7 @@ void pf_fspm_create_log_book_entry (
  * @param p_write_data     In:    The data to write.
  * @param p_result         Out:   Detailed error information if returning != 0
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application reports the result later.
  *          -1 if an error occurred.
  */
 int pf_fspm_cm_write_ind (
@@ -103,6 +160,7 @@ int pf_fspm_cm_write_ind (
  *                                bytes of the binary value.
  * @param p_result         Out:   The result information.
  * @return  0  if operation succeeded.
+ *          PNET_RECORD_PENDING if the application provides the value later.
  *          -1 if not handled or an error occurred.
  */
 int pf_fspm_cm_read_ind (
@@ -324,6 +382,15 @@ void pf_fspm_reset_ind (
  */
 int pf_fspm_signal_led_ind (pnet_t * net, bool led_state);
 
+/**
+ * Call user call-back when the earliest scheduled timeout has moved forward.
+ *
+ * This uses the \a pnet_next_timeout_ind() callback.
+ *
+ * @param net                       InOut: The p-net stack instance
+ */
+void pf_fspm_next_timeout_ind (pnet_t * net);
+
 /**
  * Retrieve a pointer to the current configuration data.
  * @param net              InOut: The p-net stack instance
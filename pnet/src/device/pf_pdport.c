@@ -15,6 +15,7 @@
 
 #ifdef UNIT_TEST
 #define pnal_eth_get_status      mock_pnal_eth_get_status
+#define pnal_link_monitor_init   mock_pnal_link_monitor_init
 #define pnal_get_port_statistics mock_pnal_get_port_statistics
 #define pf_bg_worker_start_job   mock_pf_bg_worker_start_job
 #endif
@@ -1081,7 +1082,10 @@ static void pf_lldp_trigger_linkmonitor (
    int port =
       pf_port_get_next_repeat_cyclic (&net->pf_interface.link_monitor_iterator);
 
-   (void)pf_bg_worker_start_job (net, PF_BGJOB_UPDATE_PORTS_STATUS);
+   if (!net->pf_interface.link_events_active)
+   {
+      (void)pf_bg_worker_start_job (net, PF_BGJOB_UPDATE_PORTS_STATUS);
+   }
 
    pf_pdport_monitor_link (net, port);
 
@@ -1100,8 +1104,65 @@ static void pf_lldp_trigger_linkmonitor (
    }
 }
 
+/**
+ * @internal
+ * Store a new Ethernet link status pushed by the link monitor.
+ *
+ * Runs in the link monitor thread. The link change is handled by
+ * pf_pdport_periodic().
+ *
+ * This is a callback for pnal_link_monitor_init(). Arguments should fulfill
+ * pnal_link_status_callback_t
+ *
+ * @param arg              InOut: The p-net stack instance
+ * @param interface_name   In:    Ethernet interface name
+ * @param status           In:    New link status
+ */
+static void pf_pdport_link_status_ind (
+   void * arg,
+   const char * interface_name,
+   const pnal_eth_status_t * status)
+{
+   pnet_t * net = (pnet_t *)arg;
+   int loc_port_num;
+   pf_port_iterator_t port_iterator;
+   pf_port_t * p_port_data = NULL;
+
+   pf_port_init_iterator_over_ports (net, &port_iterator);
+   loc_port_num = pf_port_get_next (&port_iterator);
+
+   while (loc_port_num != 0)
+   {
+      p_port_data = pf_port_get_state (net, loc_port_num);
+      if (strcmp (p_port_data->netif.name, interface_name) == 0)
+      {
+         os_mutex_lock (net->pf_interface.port_mutex);
+         p_port_data->eth_status = *status;
+         os_mutex_unlock (net->pf_interface.port_mutex);
+
+         net->pf_interface.link_status_changed = true;
+      }
+
+      loc_port_num = pf_port_get_next (&port_iterator);
+   }
+}
+
 void pf_pdport_start_linkmonitor (pnet_t * net)
 {
+   net->pf_interface.link_status_changed = false;
+   net->pf_interface.link_events_active =
+      (pnal_link_monitor_init (
+          &net->fspm_cfg.pnal_cfg,
+          pf_pdport_link_status_ind,
+          net) == 0);
+   if (!net->pf_interface.link_events_active)
+   {
+      LOG_INFO (
+         PF_LLDP_LOG,
+         "LLDP(%d): No link events available. Polling Ethernet link status.\n",
+         __LINE__);
+   }
+
    if (
       pf_scheduler_add (
          net,
@@ -1123,6 +1184,13 @@ void pf_pdport_periodic (pnet_t * net)
    pf_port_iterator_t port_iterator;
    pf_port_t * p_port_data = NULL;
 
+   bool link_status_changed = net->pf_interface.link_status_changed;
+
+   if (link_status_changed)
+   {
+      net->pf_interface.link_status_changed = false;
+   }
+
    pf_port_init_iterator_over_ports (net, &port_iterator);
    port = pf_port_get_next (&port_iterator);
 
@@ -1130,6 +1198,11 @@ void pf_pdport_periodic (pnet_t * net)
    {
       p_port_data = pf_port_get_state (net, port);
 
+      if (link_status_changed)
+      {
+         pf_pdport_monitor_link (net, port);
+      }
+
       if (p_port_data->pdport.lldp_peer_info_updated)
       {
          p_port_data->pdport.lldp_peer_info_updated = false;
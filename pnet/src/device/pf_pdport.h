@@ -138,13 +138,17 @@ void pf_pdport_peer_indication (pnet_t * net, int loc_port_num);
 /**
  * Start Ethernet link monitoring
  *
+ * Link status changes are pushed by the link monitor of pnal if available,
+ * otherwise the status is polled by the background worker.
+ *
  * @param net              InOut: The p-net stack instance
  */
 void pf_pdport_start_linkmonitor (pnet_t * net);
 
 /**
  * Run PDPort observers.
- * Run enabled checks and set diagnoses.
+ * Handle link changes reported by the link monitor, run enabled checks and
+ * set diagnoses.
  *
  * @param net              InOut: The p-net stack instance
  */
@@ -189,8 +193,9 @@ void pf_pdport_update_eth_status (pnet_t * net);
 /**
  * Get current ethernet status for local port.
  * This is a non-blocking function reading from mutex-protected memory.
- * The status values are updated by the background worker task
- * in a periodic job executing the pf_pdport_update_eth_status() function.
+ * The status values are updated by the link monitor of pnal, or if not
+ * available, by the background worker task in a periodic job executing the
+ * pf_pdport_update_eth_status() function.
  *
  * @param net              InOut: The p-net stack instance
  * @param loc_port_num     In:    Local port number.
@@ -48,7 +48,7 @@ int pnet_init_only (pnet_t * net, const pnet_cfg_t * p_cfg)
    net->cmdev_initialized = false; /* TODO How to handle that pf_cmdev_exit()
                                       is used before pf_cmdev_init()? */
 
-   pf_scheduler_init (net, p_cfg->tick_us);
+   pf_scheduler_init (net, p_cfg->tick_us, p_cfg->tickless);
 
 #if PNET_OPTION_DRIVER_ENABLE
    if (net->fspm_cfg.driver_enable)
@@ -70,6 +70,7 @@ int pnet_init_only (pnet_t * net, const pnet_cfg_t * p_cfg)
       return -1;
    }
 
+   pf_file_init();
    pf_bg_worker_init (net);
    pf_cmina_init (net); /* Read from permanent pool */
 
@@ -147,6 +148,11 @@ void pnet_handle_periodic (pnet_t * net)
    }
 #endif
 
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_lock (net->periodic_mutex);
+   }
+
    pf_cmrpc_periodic (net);
    pf_alarm_periodic (net);
 
@@ -155,6 +161,11 @@ void pnet_handle_periodic (pnet_t * net)
 
    pf_pdport_periodic (net);
 
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_unlock (net->periodic_mutex);
+   }
+
 #if LOG_DEBUG_ENABLED(PNET_LOG)
    end_time_us = os_get_current_time_us();
    if (pf_cmina_has_timed_out (
@@ -174,6 +185,30 @@ void pnet_handle_periodic (pnet_t * net)
 #endif
 }
 
+void pnet_lock (pnet_t * net)
+{
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_lock (net->periodic_mutex);
+   }
+}
+
+void pnet_unlock (pnet_t * net)
+{
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_unlock (net->periodic_mutex);
+   }
+}
+
+int pnet_get_next_timeout_us (pnet_t * net, uint32_t * p_delay_us)
+{
+   return pf_scheduler_get_next_timeout (
+      net,
+      os_get_current_time_us(),
+      p_delay_us);
+}
+
 void pnet_show (pnet_t * net, unsigned level)
 {
    if (net != NULL)
@@ -545,6 +580,192 @@ int pnet_get_ar_error_codes (
    return ret;
 }
 
+int pnet_get_iocr_timing (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t iocr_ix,
+   bool reset,
+   pnet_iocr_timing_t * p_timing)
+{
+   pf_ar_t * p_ar = NULL;
+   pf_iocr_t * p_iocr;
+
+   /* Called from application threads, while an abort may release the AR */
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_lock (net->periodic_mutex);
+   }
+
+   if (
+      pf_ar_find_by_arep (net, arep, &p_ar) != 0 ||
+      iocr_ix >= p_ar->nbr_iocrs)
+   {
+      if (net->periodic_mutex != NULL)
+      {
+         os_mutex_unlock (net->periodic_mutex);
+      }
+      return -1;
+   }
+
+   p_iocr = &p_ar->iocrs[iocr_ix];
+   p_timing->frame_id = p_iocr->param.frame_id;
+   p_timing->is_input = p_iocr->param.iocr_type == PF_IOCR_TYPE_INPUT;
+
+   if (p_timing->is_input)
+   {
+      os_mutex_lock (net->ppm_buf_lock);
+      p_timing->latency = p_iocr->ppm.app_to_tx;
+      p_timing->jitter = p_iocr->ppm.tx_jitter;
+      if (reset)
+      {
+         memset (&p_iocr->ppm.app_to_tx, 0, sizeof (p_iocr->ppm.app_to_tx));
+         memset (&p_iocr->ppm.tx_jitter, 0, sizeof (p_iocr->ppm.tx_jitter));
+      }
+      os_mutex_unlock (net->ppm_buf_lock);
+   }
+   else
+   {
+      os_mutex_lock (net->cpm_buf_lock);
+      p_timing->latency = p_iocr->cpm.rx_to_app;
+      p_timing->jitter = p_iocr->cpm.rx_jitter;
+      if (reset)
+      {
+         memset (&p_iocr->cpm.rx_to_app, 0, sizeof (p_iocr->cpm.rx_to_app));
+         memset (&p_iocr->cpm.rx_jitter, 0, sizeof (p_iocr->cpm.rx_jitter));
+      }
+      os_mutex_unlock (net->cpm_buf_lock);
+   }
+
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_unlock (net->periodic_mutex);
+   }
+
+   return 0;
+}
+
+int pnet_get_cycle_counters (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t * p_ppm_cycle,
+   uint16_t * p_cpm_cycle)
+{
+   pf_ar_t * p_ar = NULL;
+   pf_iocr_t * p_iocr;
+   bool ppm_found = false;
+   bool cpm_found = false;
+   uint16_t ix;
+
+   if (pf_ar_find_by_arep (net, arep, &p_ar) != 0)
+   {
+      return -1;
+   }
+
+   *p_ppm_cycle = 0;
+   *p_cpm_cycle = 0;
+   for (ix = 0; ix < p_ar->nbr_iocrs; ix++)
+   {
+      p_iocr = &p_ar->iocrs[ix];
+      if (p_iocr->param.iocr_type == PF_IOCR_TYPE_INPUT && !ppm_found)
+      {
+         *p_ppm_cycle = p_iocr->ppm.cycle;
+         ppm_found = true;
+      }
+      else if (p_iocr->param.iocr_type == PF_IOCR_TYPE_OUTPUT && !cpm_found)
+      {
+         if (p_iocr->cpm.cycle >= 0)
+         {
+            *p_cpm_cycle = (uint16_t)p_iocr->cpm.cycle;
+         }
+         cpm_found = true;
+      }
+   }
+
+   return 0;
+}
+
+bool pnet_record_response_deferrable (pnet_t * net)
+{
+   return net->cmrpc_record_deferrable;
+}
+
+int pnet_read_record_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const uint8_t * p_read_data,
+   uint16_t read_length,
+   const pnet_result_t * p_result)
+{
+   int ret;
+
+   /* Serialize with the RPC frames handled by the common receive thread */
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_lock (net->periodic_mutex);
+   }
+
+   ret = pf_cmrpc_rm_read_done (
+      net,
+      arep,
+      sequence_number,
+      p_read_data,
+      read_length,
+      p_result);
+
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_unlock (net->periodic_mutex);
+   }
+
+   return ret;
+}
+
+int pnet_write_record_done (
+   pnet_t * net,
+   uint32_t arep,
+   uint16_t sequence_number,
+   const pnet_result_t * p_result)
+{
+   int ret;
+
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_lock (net->periodic_mutex);
+   }
+
+   ret = pf_cmrpc_rm_write_done (net, arep, sequence_number, p_result);
+
+   if (net->periodic_mutex != NULL)
+   {
+      os_mutex_unlock (net->periodic_mutex);
+   }
+
+   return ret;
+}
+
+int pnet_bg_job_submit (
+   pnet_t * net,
+   pnet_bg_job_prio_t prio,
+   uint32_t key,
+   pnet_bg_job_run_t job,
+   void * arg,
+   pnet_bg_job_done_t done,
+   void * done_arg)
+{
+   if ((key & PNET_BG_JOB_KEY_RESERVED) != 0)
+   {
+      LOG_ERROR (
+         PNET_LOG,
+         "API(%d): Background job key 0x%08" PRIx32 " is reserved.\n",
+         __LINE__,
+         key);
+      return -1;
+   }
+
+   return pf_bg_worker_submit_job (net, prio, key, 0, job, arg, done, done_arg);
+}
+
 int pnet_alarm_send_process_alarm (
    pnet_t * net,
    uint32_t arep,
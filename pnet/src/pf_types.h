@@ -958,6 +958,33 @@ typedef struct pf_diag_item
    uint16_t next; /* Next in list (array index) */
 } pf_diag_item_t;
 
+/*
+ * Links of a diag item in use, beside the item since items are copied into
+ * alarm payloads. See pf_cmdev_find_diag().
+ */
+typedef struct pf_diag_link
+{
+   const struct pf_subslot * p_subslot; /* Owner, while in its list */
+   uint16_t prev;      /* Previous in list of the subslot (array index) */
+   uint16_t hash_next; /* Next in hash bucket (array index) */
+} pf_diag_link_t;
+
+/*
+ * Identifies a diag item within its subslot, see pf_cmdev_find_diag().
+ * Items in standard format are identified by the channel members, and use
+ * PF_USI_CHANNEL_DIAGNOSIS as usi. Items in manufacturer specific format are
+ * identified by the usi only, and have the channel members set to 0.
+ */
+typedef struct pf_diag_key
+{
+   uint16_t usi;
+   uint16_t ch_nbr;
+   uint16_t accumulative; /* pnet_diag_ch_group_values_t */
+   uint16_t direction;    /* pnet_diag_ch_prop_dir_values_t */
+   uint16_t ch_error_type;
+   uint16_t ext_ch_error_type;
+} pf_diag_key_t;
+
 /* Incoming alarm frames */
 typedef struct pf_apmr_msg
 {
@@ -1734,6 +1761,14 @@ typedef struct pf_ppm
 
    pf_drv_frame_t * frame; /* Driver specific ppm frame configuration */
 
+   /* Timing statistics, when timestamping is enabled. Protected by
+    * ppm_buf_lock. */
+   uint64_t app_data_time_ns;      /* First data write since last frame */
+   uint64_t sent_app_data_time_ns; /* app_data_time_ns of the last frame */
+   uint64_t last_tx_timestamp_ns;
+   pnet_interval_stats_t app_to_tx;
+   pnet_interval_stats_t tx_jitter;
+
 } pf_ppm_t;
 
 typedef struct pf_cpm
@@ -1778,6 +1813,12 @@ typedef struct pf_cpm
 
    pf_drv_frame_t * frame; /* Driver specific cpm frame configuration */
 
+   /* Timing statistics, when timestamping is enabled. Protected by
+    * cpm_buf_lock. */
+   uint64_t last_rx_timestamp_ns;
+   pnet_interval_stats_t rx_to_app;
+   pnet_interval_stats_t rx_jitter;
+
 } pf_cpm_t;
 
 typedef struct pf_iodata_object
@@ -1969,6 +2010,110 @@ typedef struct pf_get_info
    uint16_t len;
 } pf_get_info_t;
 
+/* =================== read/write data record structures ================= */
+
+typedef struct pf_iod_read_request /* Read from dcontrol */
+{
+   uint16_t sequence_number;
+   pf_uuid_t ar_uuid;
+   uint32_t api;
+   uint16_t slot_number;
+   uint16_t subslot_number;
+   uint8_t padding[2];
+   uint16_t index;
+   uint32_t record_data_length;
+   pf_uuid_t target_ar_uuid; /* Only used if implicit AR */
+   uint8_t rw_padding[8];
+} pf_iod_read_request_t;
+
+typedef struct pf_iod_read_result
+{
+   uint16_t sequence_number;
+   pf_uuid_t ar_uuid;
+   uint32_t api;
+   uint16_t slot_number;
+   uint16_t subslot_number;
+   uint8_t padding[2];
+   uint16_t index;
+   uint32_t record_data_length;
+   uint16_t add_data_1;
+   uint16_t add_data_2;
+   uint8_t rw_padding[20];
+} pf_iod_read_result_t;
+
+typedef struct pf_iod_write_request /* Write from dcontrol */
+{
+   uint16_t sequence_number;
+   pf_uuid_t ar_uuid;
+   uint32_t api;
+   uint16_t slot_number;
+   uint16_t subslot_number;
+   uint8_t padding[2];
+   uint16_t index;
+   uint32_t record_data_length;
+   uint8_t rw_padding[24];
+} pf_iod_write_request_t;
+
+typedef struct pf_iod_write_result
+{
+   uint16_t sequence_number;
+   pf_uuid_t ar_uuid;
+   uint32_t api;
+   uint16_t slot_number;
+   uint16_t subslot_number;
+   uint8_t padding[2];
+   uint16_t index;
+   uint32_t record_data_length;
+   uint16_t add_data_1;
+   uint16_t add_data_2;
+   pnet_pnio_status_t pnio_status;
+   uint8_t rw_padding[16];
+} pf_iod_write_result_t;
+
+/*
+ * An IODRead or IODWrite request of a session, whose response is completed
+ * when the application calls pnet_read_record_done() or
+ * pnet_write_record_done(). The beginning of the response is already in the
+ * output buffer of the session.
+ */
+typedef struct pf_session_pending_record
+{
+   bool active;
+   uint16_t opnum; /* PF_RPC_DEV_OPNUM_READ or PF_RPC_DEV_OPNUM_WRITE */
+   uint32_t arep;
+   pf_iod_read_request_t read_request;
+   pf_iod_write_request_t write_request;
+   pf_iod_write_result_t write_result;
+
+   /* Positions in the output buffer of the session */
+   uint16_t status_pos;  /* PNIO status */
+   uint16_t ndr_hdr_pos; /* NDR header */
+   uint16_t blocks_pos;  /* Start of the result blocks */
+
+   /* The DCE RPC header of the response */
+   pf_rpc_header_t rpc_res;
+   uint16_t max_rsp_len;
+   uint16_t rpc_hdr_start_pos;
+   uint16_t length_of_body_pos;
+   uint16_t start_pos; /* Start of the RPC payload */
+} pf_session_pending_record_t;
+
+/*
+ * A fragmented IODWrite request of a session, whose record data is passed to
+ * pnet_write_chunk_ind() fragment by fragment. Only the headers of the request
+ * are kept in the input buffer of the session.
+ */
+typedef struct pf_session_write_stream
+{
+   bool active;
+   bool failed; /* The application or the stack rejected a part */
+   uint32_t arep;
+   pf_iod_write_request_t write_request;
+   uint16_t header_len; /* NDR header and IODWriteReqHeader */
+   uint32_t offset;     /* Record data passed to the application so far */
+   pnet_result_t result;
+} pf_session_write_stream_t;
+
 /*
  * A session stores information used for supervision of connection activity.
  * A session is allocated for each connect in order to handle fragmented RPC
@@ -1988,6 +2133,8 @@ typedef struct pf_session_info
                          the end of handling the incoming RPC frame. */
    int socket; /* Socket for CControl messaging, or reference to the main CMRPC
                   socket. Close it only if from_me==true */
+   bool socket_has_recv_callback; /* Socket is serviced by the common receive
+                                     thread instead of pf_cmrpc_periodic() */
    struct pf_ar * p_ar; /* Parent AR */
    bool from_me;        /* True if the session originates from the device (i.e.
                            CControl requests and responses). */
@@ -2028,6 +2175,12 @@ typedef struct pf_session_info
    /* This timer is used to handle ccontrol and fragment re-transmissions */
    pf_scheduler_handle_t resend_timeout;
    uint32_t resend_counter;
+
+   /* Read or write request waiting for the response of the application */
+   pf_session_pending_record_t pending_record;
+
+   /* Fragmented write request passed to the application as it arrives */
+   pf_session_write_stream_t write_stream;
 } pf_session_info_t;
 
 typedef struct pf_ar
@@ -2244,6 +2397,21 @@ typedef enum pf_diag_filter_level
    PF_DIAG_FILTER_M_DEM      /* Manufacturer specific or maintenance demanded */
 } pf_diag_filter_level_t;
 
+/*
+ * Counters of the diag items of a subslot, by what they contribute to the
+ * alarm specifier and maintenance status of a diagnosis summary. Updated when
+ * an item is linked into or out of the subslot, such that the summary does not
+ * have to walk the list.
+ */
+typedef struct pf_diag_summary
+{
+   uint16_t num_manufacturer; /* alarm_spec.manufacturer_diagnosis */
+   uint16_t num_channel;      /* alarm_spec.channel_diagnosis */
+   uint16_t num_submodule;    /* alarm_spec.submodule_diagnosis */
+   uint16_t num_problem;      /* Manufacturer specific or fault severity */
+   uint16_t num_maint_status[32]; /* Per bit of the maintenance status */
+} pf_diag_summary_t;
+
 typedef struct pf_subslot
 {
    bool in_use;
@@ -2268,6 +2436,9 @@ typedef struct pf_subslot
     * Each subslot has its own list of diagnosis items.
     */
    uint16_t diag_list;
+
+   /* Kept up to date as items are added to and removed from diag_list */
+   pf_diag_summary_t diag_summary;
 } pf_subslot_t;
 
 typedef struct pf_slot
@@ -2316,6 +2487,10 @@ typedef struct pf_device
    os_mutex_t * diag_mutex; /* Protect the diag items */
    pf_diag_item_t diag_items[PNET_MAX_DIAG_ITEMS];
    uint16_t diag_items_free; /* Head of the unused list */
+
+   /* Index of the items in use, see pf_cmdev_find_diag() */
+   pf_diag_link_t diag_links[PNET_MAX_DIAG_ITEMS];
+   uint16_t diag_hash[PNET_MAX_DIAG_ITEMS]; /* Heads of the hash buckets */
 } pf_device_t;
 
 /*
@@ -2332,66 +2507,6 @@ typedef enum pf_dev_filter_level
    PF_DEV_FILTER_LEVEL_SUBSLOT,
 } pf_dev_filter_level_t;
 
-/* =================== read/write data record structures ================= */
-
-typedef struct pf_iod_read_request /* Read from dcontrol */
-{
-   uint16_t sequence_number;
-   pf_uuid_t ar_uuid;
-   uint32_t api;
-   uint16_t slot_number;
-   uint16_t subslot_number;
-   uint8_t padding[2];
-   uint16_t index;
-   uint32_t record_data_length;
-   pf_uuid_t target_ar_uuid; /* Only used if implicit AR */
-   uint8_t rw_padding[8];
-} pf_iod_read_request_t;
-
-typedef struct pf_iod_read_result
-{
-   uint16_t sequence_number;
-   pf_uuid_t ar_uuid;
-   uint32_t api;
-   uint16_t slot_number;
-   uint16_t subslot_number;
-   uint8_t padding[2];
-   uint16_t index;
-   uint32_t record_data_length;
-   uint16_t add_data_1;
-   uint16_t add_data_2;
-   uint8_t rw_padding[20];
-} pf_iod_read_result_t;
-
-typedef struct pf_iod_write_request /* Write from dcontrol */
-{
-   uint16_t sequence_number;
-   pf_uuid_t ar_uuid;
-   uint32_t api;
-   uint16_t slot_number;
-   uint16_t subslot_number;
-   uint8_t padding[2];
-   uint16_t index;
-   uint32_t record_data_length;
-   uint8_t rw_padding[24];
-} pf_iod_write_request_t;
-
-typedef struct pf_iod_write_result
-{
-   uint16_t sequence_number;
-   pf_uuid_t ar_uuid;
-   uint32_t api;
-   uint16_t slot_number;
-   uint16_t subslot_number;
-   uint8_t padding[2];
-   uint16_t index;
-   uint32_t record_data_length;
-   uint16_t add_data_1;
-   uint16_t add_data_2;
-   pnet_pnio_status_t pnio_status;
-   uint8_t rw_padding[16];
-} pf_iod_write_result_t;
-
 /* ============= LogBook typedefs ================== */
 /* block_version_low == 1 */
 
@@ -2872,6 +2987,35 @@ typedef struct pf_snmp_data
    pf_snmp_system_location_t system_location;
 } pf_snmp_data_t;
 
+/** Number of jobs of the stack, see pf_bg_job_t. Each has its own entry. */
+#define PF_BG_WORKER_STACK_JOBS 4
+
+/** Entry of the background worker job queue */
+typedef struct pf_bg_job_entry
+{
+   bool in_use;
+   bool running;
+   bool rerun; /* Job of the stack, submitted again while running */
+   pnet_bg_job_prio_t prio;
+   uint32_t key;
+   uint32_t seq;           /* Order of submission */
+   uint32_t start_time_us; /* Not started before this time */
+   uint32_t rerun_start_time_us;
+   pnet_bg_job_run_t run;
+   void * arg;
+   pnet_bg_job_done_t done;
+   void * done_arg;
+} pf_bg_job_entry_t;
+
+/** Completion callback of a submission coalesced with a queued job */
+typedef struct pf_bg_job_waiter
+{
+   bool in_use;
+   uint32_t leader_seq; /* Job whose completion to wait for */
+   pnet_bg_job_done_t done;
+   void * done_arg;
+} pf_bg_job_waiter_t;
+
 struct pnet
 {
    uint32_t pnal_buf_alloc_cnt;
@@ -2909,6 +3053,8 @@ struct pnet
    volatile uint32_t scheduler_timeout_free;
    os_mutex_t * scheduler_timeout_mutex;
    uint32_t scheduler_tick_interval; /* microseconds */
+   bool scheduler_tickless;
+   bool scheduler_in_tick; /* Timeouts added now are seen after the tick */
 
    /********** CMDEV **********/
 
@@ -2951,6 +3097,10 @@ struct pnet
    uint8_t cmrpc_dcerpc_input_frame[PF_FRAME_BUFFER_SIZE];
    uint8_t cmrpc_dcerpc_output_frame[PF_FRAME_BUFFER_SIZE];
 
+   /** The read or write indication to the application may return
+    * PNET_RECORD_PENDING. See pnet_record_response_deferrable() */
+   bool cmrpc_record_deferrable;
+
    /********** FSPM **********/
 
    /** Default configuration from user. Used at factory reset */
@@ -2965,6 +3115,11 @@ struct pnet
    /** Last \a time pnet_handle_periodic() was invoked */
    uint32_t timestamp_handle_periodic_us;
 
+   /** Serializes pnet_handle_periodic() with the handling of incoming RPC
+    *  frames in the common receive thread. NULL if RPC frames are polled by
+    *  pnet_handle_periodic(). */
+   os_mutex_t * periodic_mutex;
+
    /* Mutex for protecting access to writable I&M data.
     *
     * Note I&M may be both read and written by SNMP, which executes from
@@ -3002,11 +3157,23 @@ struct pnet
 
       /* Scheduler handle for Ethernet link monitoring */
       pf_scheduler_handle_t link_monitor_timeout;
+
+      /* True if the port link status is pushed by pnal_link_monitor_init()
+       * instead of polled by the background worker */
+      bool link_events_active;
+
+      /* Set by the link monitor thread when the status of a port changed */
+      volatile bool link_status_changed;
    } pf_interface;
 
    struct
    {
       os_event_t * events;
+      os_mutex_t * mutex; /* Protects the job queue */
+      uint32_t next_seq;
+      /* Submitted jobs, followed by the entries of the jobs of the stack */
+      pf_bg_job_entry_t jobs[PNET_MAX_BG_JOBS + PF_BG_WORKER_STACK_JOBS];
+      pf_bg_job_waiter_t waiters[PNET_MAX_BG_JOBS];
    } pf_bg_worker;
 
    const pf_ppm_driver_t * ppm_drv;
@@ -207,6 +207,15 @@ typedef struct pnal_eth_status_t
  */
 uint32_t pnal_get_system_uptime_10ms (void);
 
+/**
+ * Get the current time in the clock of the frame timestamps.
+ *
+ * See pnal_buf_t.timestamp_ns and pnal_eth_get_tx_timestamp().
+ *
+ * @return Time, in nanoseconds.
+ */
+uint64_t pnal_get_time_ns (void);
+
 /**
  * Load a binary file.
  *
@@ -232,6 +241,10 @@ int pnal_load_file (
  *
  * Can handle two output buffers.
  *
+ * The file must be replaced atomically, such that a power loss during the
+ * save leaves either the old or the new contents. The function returns when
+ * the contents are on disk.
+ *
  * @param fullpath         In:    Full path to the file
  * @param object_1         In:    Data to save, or NULL. Mandatory if size_1 > 0
  * @param size_1           In:    Size of object_1.
@@ -312,6 +325,39 @@ int pnal_eth_get_status (
    const char * interface_name,
    pnal_eth_status_t * status);
 
+/**
+ * Link status callback, see pnal_link_monitor_init().
+ *
+ * @param arg              InOut: User-defined (may be NULL).
+ * @param interface_name   In:    Ethernet interface name, for example eth0
+ * @param status           In:    New link status of the interface
+ */
+typedef void (pnal_link_status_callback_t) (
+   void * arg,
+   const char * interface_name,
+   const pnal_eth_status_t * status);
+
+/**
+ * Start monitoring the link status of the network interfaces.
+ *
+ * The callback is invoked from a separate thread, once per interface
+ * at startup and then whenever the operating system reports a change of
+ * an interface (for example link up or down, or a new speed).
+ *
+ * Only one link monitor per process is supported.
+ *
+ * @param pnal_cfg         In:    Operating system dependent configuration
+ * @param callback         In:    Callback for link status changes
+ * @param arg              InOut: User argument passed to the callback
+ * @return  0 if the operation succeeded.
+ *         -1 if not supported or an error occurred. Use
+ *            pnal_eth_get_status() to poll the status instead.
+ */
+int pnal_link_monitor_init (
+   const pnal_cfg_t * pnal_cfg,
+   pnal_link_status_callback_t * callback,
+   void * arg);
+
 /**
  * Get network interface index
  *
@@ -350,6 +396,24 @@ int pnal_get_port_statistics (
  */
 int pnal_eth_send (pnal_eth_handle_t * handle, pnal_buf_t * buf);
 
+/**
+ * Send a cyclic raw Ethernet frame
+ *
+ * If pnal_cfg_t.eth_txtime_delay_us is set, the frame is launched that
+ * long after its scheduled send time. Lateness of more than half the delay
+ * is not compensated. Otherwise the same as pnal_eth_send().
+ *
+ * @param handle           In:    Ethernet handle
+ * @param buf              In:    Buffer with data to be sent
+ * @param late_us          In:    How long after the scheduled send time this
+ *                                function is called, in microseconds
+ * @return  The number of bytes sent, or -1 if an error occurred.
+ */
+int pnal_eth_send_cyclic (
+   pnal_eth_handle_t * handle,
+   pnal_buf_t * buf,
+   uint32_t late_us);
+
 /**
  * Initialize receiving of raw Ethernet frames on one interface (in separate
  * thread)
@@ -370,6 +434,44 @@ pnal_eth_handle_t * pnal_eth_init (
    pnal_eth_callback_t * callback,
    void * arg);
 
+/**
+ * Drop uninteresting frames before they reach the receive callback
+ *
+ * Afterwards, only LLDP frames and Profinet frames with one of the given
+ * frame IDs are passed to the callback, also if they carry a VLAN tag.
+ * Calling it again replaces the previous filter.
+ *
+ * @param handle           In:    Ethernet handle
+ * @param frame_ids        In:    Profinet frame IDs to receive
+ * @param nbr_of_frame_ids In:    Number of frame IDs
+ * @return  0 if the operation succeeded.
+ *         -1 if not supported or an error occurred. All frames of the
+ *            configured receive type are then still received.
+ */
+int pnal_eth_set_frame_id_filter (
+   pnal_eth_handle_t * handle,
+   const uint16_t * frame_ids,
+   uint16_t nbr_of_frame_ids);
+
+/**
+ * Get the time when a frame, sent with pnal_eth_send(), left the interface.
+ *
+ * Only available if enabled by pnal_cfg_t.eth_timestamping. The timestamp
+ * arrives shortly after the frame is sent, and is found by the contents of
+ * the frame. Call this function before the buffer is modified for the next
+ * frame.
+ *
+ * @param handle           In:    Ethernet handle
+ * @param buf              In:    Buffer with the sent frame
+ * @param timestamp_ns     Out:   Send time, see pnal_get_time_ns()
+ * @return  0 if the operation succeeded.
+ *         -1 if no timestamp is available.
+ */
+int pnal_eth_get_tx_timestamp (
+   pnal_eth_handle_t * handle,
+   const pnal_buf_t * buf,
+   uint64_t * timestamp_ns);
+
 /**
  * Open an UDP socket
  *
@@ -417,6 +519,33 @@ int pnal_udp_recvfrom (
    uint8_t * data,
    int size);
 
+/**
+ * Callback for UDP data, see pnal_udp_set_recv_callback()
+ *
+ * @param id               In:    Socket ID
+ * @param arg              InOut: User argument
+ */
+typedef void (pnal_udp_callback_t) (uint32_t id, void * arg);
+
+/**
+ * Let the common receive thread call a callback when a UDP socket has data.
+ *
+ * The callback runs in the receive thread and must read the data with
+ * pnal_udp_recvfrom(). Only available if the common receive thread is
+ * enabled by pnal_cfg_t.single_recv_thread and started by pnal_eth_init().
+ * The callback is removed when the socket is closed.
+ *
+ * @param id               In:    Socket ID
+ * @param callback         In:    Callback for incoming data
+ * @param arg              In:    User argument passed to the callback
+ * @return  0 if the callback is registered,
+ *          -1 if the socket must be polled with pnal_udp_recvfrom()
+ */
+int pnal_udp_set_recv_callback (
+   uint32_t id,
+   pnal_udp_callback_t * callback,
+   void * arg);
+
 /**
  * Close an UDP socket
  *
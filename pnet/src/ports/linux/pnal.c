@@ -26,6 +26,8 @@
 #include <ifaddrs.h>
 #include <linux/ethtool.h>
 #include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <linux/sockios.h>
 #include <net/if.h>
 #include <pthread.h>
@@ -56,12 +58,21 @@ int pnal_save_file (
 {
    int ret = 0; /* Assume everything goes well */
    int outputfile;
+   int directory;
+   char * temppath = NULL;
+   char * directorypath = NULL;
+   char * separator = NULL;
+
+   /* Write to a temporary file, and replace the file when all data is on
+      disk. A power loss leaves either the old or the new file. */
+   if (asprintf (&temppath, "%s.tmp", fullpath) < 0)
+   {
+      return -1;
+   }
 
-   /* Open file
-      Use synchronized write to make sure it ends up on disk immediately */
    outputfile = open (
-      fullpath,
-      O_WRONLY | O_CREAT | O_TRUNC | O_SYNC,
+      temppath,
+      O_WRONLY | O_CREAT | O_TRUNC,
       S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
    if (outputfile == -1)
    {
@@ -69,35 +80,45 @@ int pnal_save_file (
          PF_PNAL_LOG,
          "PNAL(%d): Could not open file %s\n",
          __LINE__,
-         fullpath);
+         temppath);
+      free (temppath);
       return -1;
    }
 
    /* Write file contents */
    if (size_1 > 0)
    {
-      if (write (outputfile, object_1, size_1) == -1)
+      if (write (outputfile, object_1, size_1) != (ssize_t)size_1)
       {
          ret = -1;
          LOG_ERROR (
             PF_PNAL_LOG,
             "PNAL(%d): Failed to write file %s\n",
             __LINE__,
-            fullpath);
+            temppath);
       }
    }
    if (size_2 > 0 && ret == 0)
    {
-      if (write (outputfile, object_2, size_2) == -1)
+      if (write (outputfile, object_2, size_2) != (ssize_t)size_2)
       {
          ret = -1;
          LOG_ERROR (
             PF_PNAL_LOG,
             "PNAL(%d): Failed to write file %s (second buffer)\n",
             __LINE__,
-            fullpath);
+            temppath);
       }
    }
+   if (ret == 0 && fsync (outputfile) != 0)
+   {
+      ret = -1;
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to sync file %s\n",
+         __LINE__,
+         temppath);
+   }
 
    /* Close file */
    if (close (outputfile) != 0)
@@ -105,6 +126,50 @@ int pnal_save_file (
       ret = -1;
    }
 
+   if (ret == 0 && rename (temppath, fullpath) != 0)
+   {
+      ret = -1;
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to rename file %s\n",
+         __LINE__,
+         temppath);
+   }
+   if (ret != 0)
+   {
+      (void)remove (temppath);
+      free (temppath);
+      return ret;
+   }
+   free (temppath);
+
+   /* Make the rename itself persistent */
+   directorypath = strdup (fullpath);
+   if (directorypath == NULL)
+   {
+      return 0;
+   }
+   separator = strrchr (directorypath, '/');
+   if (separator == NULL)
+   {
+      strcpy (directorypath, ".");
+   }
+   else if (separator == directorypath)
+   {
+      separator[1] = '\0';
+   }
+   else
+   {
+      separator[0] = '\0';
+   }
+   directory = open (directorypath, O_RDONLY | O_DIRECTORY);
+   if (directory != -1)
+   {
+      (void)fsync (directory);
+      (void)close (directory);
+   }
+   free (directorypath);
+
    return ret;
 }
 
@@ -186,6 +251,14 @@ uint32_t pnal_get_system_uptime_10ms (void)
    return systeminfo.uptime * 100;
 }
 
+uint64_t pnal_get_time_ns (void)
+{
+   struct timespec now;
+
+   clock_gettime (CLOCK_REALTIME, &now);
+   return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
 uint32_t pnal_buf_alloc_cnt = 0; /* Count outstanding buffers */
 
 pnal_buf_t * pnal_buf_alloc (uint16_t length)
@@ -199,6 +272,7 @@ pnal_buf_t * pnal_buf_alloc (uint16_t length)
                                                                   follows header
                                                                   struct */
       p->len = length;
+      p->timestamp_ns = 0;
 #endif
       pnal_buf_alloc_cnt++;
    }
@@ -242,7 +316,441 @@ static void os_ip_to_string (pnal_ipaddr_t ip, char * outputstring)
       (uint8_t)(ip & 0xFF));
 }
 
-int pnal_set_ip_suite (
+#if !defined(PNAL_USE_IP_SCRIPT)
+
+/** Max number of IPv4 addresses removed from an interface */
+#define PNAL_NETLINK_MAX_ADDRESSES 16
+
+/** Size of netlink receive buffers */
+#define PNAL_NETLINK_BUFFER_SIZE 8192
+
+/**
+ * Netlink request with room for attributes
+ */
+typedef struct pnal_netlink_request
+{
+   struct nlmsghdr header;
+   union
+   {
+      struct ifinfomsg ifinfo;
+      struct ifaddrmsg ifaddr;
+      struct rtmsg route;
+   };
+   uint8_t attributes[64];
+} pnal_netlink_request_t;
+
+/**
+ * Working memory of the netlink requests. Kept off the stack, as the IP suite
+ * is set from the Ethernet receive thread, which has a small stack.
+ * The mutex is held while the IP suite is set.
+ */
+static struct
+{
+   pthread_mutex_t mutex;
+   uint8_t buffer[PNAL_NETLINK_BUFFER_SIZE];
+   struct ifaddrmsg addresses[PNAL_NETLINK_MAX_ADDRESSES];
+   uint32_t locals[PNAL_NETLINK_MAX_ADDRESSES];
+} pnal_netlink = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @internal
+ * Initialise a netlink request
+ *
+ * @param request          Out:   Request to initialise
+ * @param type             In:    Message type, RTM_xxx
+ * @param flags            In:    Additional NLM_F_xxx flags
+ * @param payload_size     In:    Size of the fixed message payload
+ */
+static void pnal_netlink_init_request (
+   pnal_netlink_request_t * request,
+   uint16_t type,
+   uint16_t flags,
+   size_t payload_size)
+{
+   memset (request, 0, sizeof (*request));
+   request->header.nlmsg_len = NLMSG_LENGTH (payload_size);
+   request->header.nlmsg_type = type;
+   request->header.nlmsg_flags = NLM_F_REQUEST | flags;
+}
+
+/**
+ * @internal
+ * Append a 32 bit attribute to a netlink request
+ *
+ * @param request          InOut: Request
+ * @param type             In:    Attribute type
+ * @param value            In:    Attribute value, in network byte order
+ *                                where applicable
+ */
+static void pnal_netlink_add_u32 (
+   pnal_netlink_request_t * request,
+   uint16_t type,
+   uint32_t value)
+{
+   struct rtattr * attribute =
+      (struct rtattr *)((uint8_t *)request +
+                        NLMSG_ALIGN (request->header.nlmsg_len));
+
+   CC_ASSERT (
+      NLMSG_ALIGN (request->header.nlmsg_len) + RTA_LENGTH (sizeof (value)) <=
+      sizeof (*request));
+
+   attribute->rta_type = type;
+   attribute->rta_len = RTA_LENGTH (sizeof (value));
+   memcpy (RTA_DATA (attribute), &value, sizeof (value));
+   request->header.nlmsg_len =
+      NLMSG_ALIGN (request->header.nlmsg_len) + attribute->rta_len;
+}
+
+/**
+ * @internal
+ * Send a netlink request and wait for the acknowledge of the kernel
+ *
+ * @param netlink_socket   In:    NETLINK_ROUTE socket
+ * @param request          InOut: Request. The sequence number is updated.
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred. errno is set.
+ */
+static int pnal_netlink_transaction (
+   int netlink_socket,
+   pnal_netlink_request_t * request)
+{
+   static uint32_t sequence_number = 0;
+   uint8_t * buffer = pnal_netlink.buffer;
+   struct nlmsghdr * header;
+   struct nlmsgerr * error;
+   ssize_t len;
+
+   request->header.nlmsg_flags |= NLM_F_ACK;
+   request->header.nlmsg_seq = ++sequence_number;
+   if (send (netlink_socket, request, request->header.nlmsg_len, 0) < 0)
+   {
+      return -1;
+   }
+
+   while (1)
+   {
+      len = recv (netlink_socket, buffer, PNAL_NETLINK_BUFFER_SIZE, 0);
+      if (len < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return -1;
+      }
+
+      for (header = (struct nlmsghdr *)buffer; NLMSG_OK (header, (size_t)len);
+           header = NLMSG_NEXT (header, len))
+      {
+         if (
+            header->nlmsg_seq == request->header.nlmsg_seq &&
+            header->nlmsg_type == NLMSG_ERROR)
+         {
+            error = NLMSG_DATA (header);
+            if (error->error != 0)
+            {
+               errno = -error->error;
+               return -1;
+            }
+            return 0;
+         }
+      }
+   }
+}
+
+/**
+ * @internal
+ * Remove all IPv4 addresses with the interface name as label
+ *
+ * Corresponds to "ip address flush label <interface_name>".
+ *
+ * @param netlink_socket   In:    NETLINK_ROUTE socket
+ * @param interface_name   In:    Ethernet interface name, for example eth0
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred.
+ */
+static int pnal_netlink_flush_addresses (
+   int netlink_socket,
+   const char * interface_name)
+{
+   pnal_netlink_request_t request;
+   struct ifaddrmsg * addresses = pnal_netlink.addresses;
+   uint32_t * locals = pnal_netlink.locals;
+   uint16_t number_of_addresses = 0;
+   uint8_t * buffer = pnal_netlink.buffer;
+   struct nlmsghdr * header;
+   const struct ifaddrmsg * ifaddr;
+   const struct rtattr * attribute;
+   int attributes_len;
+   const char * label;
+   uint32_t local;
+   bool done = false;
+   ssize_t len;
+   uint16_t ix;
+
+   /* Collect the addresses first, as the dump must be completely read
+      before the next request is sent */
+   pnal_netlink_init_request (
+      &request,
+      RTM_GETADDR,
+      NLM_F_DUMP,
+      sizeof (request.ifaddr));
+   request.ifaddr.ifa_family = AF_INET;
+   if (send (netlink_socket, &request, request.header.nlmsg_len, 0) < 0)
+   {
+      return -1;
+   }
+
+   while (!done)
+   {
+      len = recv (netlink_socket, buffer, PNAL_NETLINK_BUFFER_SIZE, 0);
+      if (len < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return -1;
+      }
+
+      for (header = (struct nlmsghdr *)buffer; NLMSG_OK (header, (size_t)len);
+           header = NLMSG_NEXT (header, len))
+      {
+         if (header->nlmsg_type == NLMSG_DONE)
+         {
+            done = true;
+            break;
+         }
+         if (header->nlmsg_type == NLMSG_ERROR)
+         {
+            return -1;
+         }
+         if (header->nlmsg_type != RTM_NEWADDR)
+         {
+            continue;
+         }
+
+         ifaddr = NLMSG_DATA (header);
+         attribute = IFA_RTA (ifaddr);
+         attributes_len = IFA_PAYLOAD (header);
+         label = NULL;
+         local = 0;
+         while (RTA_OK (attribute, attributes_len))
+         {
+            if (attribute->rta_type == IFA_LABEL)
+            {
+               label = RTA_DATA (attribute);
+            }
+            else if (attribute->rta_type == IFA_LOCAL)
+            {
+               memcpy (&local, RTA_DATA (attribute), sizeof (local));
+            }
+            attribute = RTA_NEXT (attribute, attributes_len);
+         }
+
+         if (
+            label != NULL && strcmp (label, interface_name) == 0 &&
+            number_of_addresses < PNAL_NETLINK_MAX_ADDRESSES)
+         {
+            addresses[number_of_addresses] = *ifaddr;
+            locals[number_of_addresses] = local;
+            number_of_addresses++;
+         }
+      }
+   }
+
+   for (ix = 0; ix < number_of_addresses; ix++)
+   {
+      pnal_netlink_init_request (
+         &request,
+         RTM_DELADDR,
+         0,
+         sizeof (request.ifaddr));
+      request.ifaddr = addresses[ix];
+      pnal_netlink_add_u32 (&request, IFA_LOCAL, locals[ix]);
+      if (
+         pnal_netlink_transaction (netlink_socket, &request) != 0 &&
+         errno != EADDRNOTAVAIL)
+      {
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * @internal
+ * Configure the IP suite with rtnetlink
+ *
+ * Does the same as the profipp_network_parameters script, but without
+ * starting a process.
+ *
+ * @param interface_name   In:    Ethernet interface name, for example eth0
+ * @param p_ipaddr         In:    IPv4 address
+ * @param p_netmask        In:    Netmask
+ * @param p_gw             In:    Default gateway
+ * @param hostname         In:    Host name, only used if PNAL_SET_HOSTNAME
+ *                                is defined
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred.
+ */
+static int pnal_set_ip_suite_netlink (
+   const char * interface_name,
+   const pnal_ipaddr_t * p_ipaddr,
+   const pnal_ipaddr_t * p_netmask,
+   const pnal_ipaddr_t * p_gw,
+   const char * hostname)
+{
+   int ret = -1;
+   int netlink_socket;
+   pnal_netlink_request_t request;
+   unsigned int ifindex;
+   struct sockaddr_nl address;
+
+   ifindex = if_nametoindex (interface_name);
+   if (ifindex == 0)
+   {
+      return -1;
+   }
+
+   netlink_socket = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+   if (netlink_socket < 0)
+   {
+      return -1;
+   }
+   pthread_mutex_lock (&pnal_netlink.mutex);
+   memset (&address, 0, sizeof (address));
+   address.nl_family = AF_NETLINK;
+   if (
+      bind (netlink_socket, (struct sockaddr *)&address, sizeof (address)) < 0)
+   {
+      goto out;
+   }
+
+   if (pnal_netlink_flush_addresses (netlink_socket, interface_name) != 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to flush network interface: %s\n",
+         __LINE__,
+         strerror (errno));
+      goto out;
+   }
+
+   if (*p_ipaddr != 0)
+   {
+      pnal_netlink_init_request (
+         &request,
+         RTM_NEWADDR,
+         NLM_F_CREATE | NLM_F_EXCL,
+         sizeof (request.ifaddr));
+      request.ifaddr.ifa_family = AF_INET;
+      request.ifaddr.ifa_prefixlen = __builtin_popcount (*p_netmask);
+      request.ifaddr.ifa_scope = RT_SCOPE_UNIVERSE;
+      request.ifaddr.ifa_index = ifindex;
+      pnal_netlink_add_u32 (&request, IFA_LOCAL, htonl (*p_ipaddr));
+      pnal_netlink_add_u32 (&request, IFA_ADDRESS, htonl (*p_ipaddr));
+      if (request.ifaddr.ifa_prefixlen < 31)
+      {
+         pnal_netlink_add_u32 (
+            &request,
+            IFA_BROADCAST,
+            htonl (*p_ipaddr | ~*p_netmask));
+      }
+      if (pnal_netlink_transaction (netlink_socket, &request) != 0)
+      {
+         LOG_ERROR (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to set IP address and netmask: %s\n",
+            __LINE__,
+            strerror (errno));
+         goto out;
+      }
+   }
+
+   pnal_netlink_init_request (
+      &request,
+      RTM_NEWLINK,
+      0,
+      sizeof (request.ifinfo));
+   request.ifinfo.ifi_family = AF_UNSPEC;
+   request.ifinfo.ifi_index = ifindex;
+   request.ifinfo.ifi_flags = IFF_UP;
+   request.ifinfo.ifi_change = IFF_UP;
+   if (pnal_netlink_transaction (netlink_socket, &request) != 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set network interface up: %s\n",
+         __LINE__,
+         strerror (errno));
+      goto out;
+   }
+
+   if (*p_gw != 0)
+   {
+      pnal_netlink_init_request (
+         &request,
+         RTM_NEWROUTE,
+         NLM_F_CREATE | NLM_F_EXCL,
+         sizeof (request.route));
+      request.route.rtm_family = AF_INET;
+      request.route.rtm_table = RT_TABLE_MAIN;
+      request.route.rtm_protocol = RTPROT_BOOT;
+      request.route.rtm_scope = RT_SCOPE_UNIVERSE;
+      request.route.rtm_type = RTN_UNICAST;
+      pnal_netlink_add_u32 (&request, RTA_GATEWAY, htonl (*p_gw));
+      pnal_netlink_add_u32 (&request, RTA_OIF, ifindex);
+      if (pnal_netlink_transaction (netlink_socket, &request) != 0)
+      {
+         LOG_ERROR (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to set default gateway: %s\n",
+            __LINE__,
+            strerror (errno));
+         goto out;
+      }
+   }
+
+#if defined(PNAL_SET_HOSTNAME)
+   if (sethostname (hostname, strlen (hostname)) != 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set hostname to %s: %s\n",
+         __LINE__,
+         hostname,
+         strerror (errno));
+      goto out;
+   }
+#endif
+
+   ret = 0;
+
+out:
+   pthread_mutex_unlock (&pnal_netlink.mutex);
+   close (netlink_socket);
+   return ret;
+}
+
+#endif /* !defined(PNAL_USE_IP_SCRIPT) */
+
+/**
+ * @internal
+ * Configure the IP suite with the profipp_network_parameters script
+ *
+ * @param interface_name   In:    Ethernet interface name, for example eth0
+ * @param p_ipaddr         In:    IPv4 address
+ * @param p_netmask        In:    Netmask
+ * @param p_gw             In:    Default gateway
+ * @param hostname         In:    Host name
+ * @param permanent        In:    1 if changes are permanent, or 0 if temporary
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred.
+ */
+static int pnal_set_ip_suite_script (
    const char * interface_name,
    const pnal_ipaddr_t * p_ipaddr,
    const pnal_ipaddr_t * p_netmask,
@@ -271,6 +779,41 @@ int pnal_set_ip_suite (
    return pnal_execute_script (argv);
 }
 
+int pnal_set_ip_suite (
+   const char * interface_name,
+   const pnal_ipaddr_t * p_ipaddr,
+   const pnal_ipaddr_t * p_netmask,
+   const pnal_ipaddr_t * p_gw,
+   const char * hostname,
+   bool permanent)
+{
+#if !defined(PNAL_USE_IP_SCRIPT)
+   if (
+      pnal_set_ip_suite_netlink (
+         interface_name,
+         p_ipaddr,
+         p_netmask,
+         p_gw,
+         hostname) == 0)
+   {
+      return 0;
+   }
+
+   LOG_WARNING (
+      PF_PNAL_LOG,
+      "PNAL(%d): Falling back to the network parameters script\n",
+      __LINE__);
+#endif
+
+   return pnal_set_ip_suite_script (
+      interface_name,
+      p_ipaddr,
+      p_netmask,
+      p_gw,
+      hostname,
+      permanent);
+}
+
 /**
  * Calculate MAU type.
  *
@@ -399,30 +942,39 @@ static uint16_t calculate_capabilities (uint32_t advertised)
    return out;
 }
 
-int pnal_eth_get_status (const char * interface_name, pnal_eth_status_t * status)
+/**
+ * Read link settings of an interface with ethtool
+ *
+ * Uses ETHTOOL_GLINKSETTINGS, and falls back to the legacy ETHTOOL_GSET for
+ * drivers not supporting it. Does not touch status->running.
+ *
+ * @param control_socket   In:    Socket for ioctl() calls
+ * @param interface_name   In:    Ethernet interface name, for example eth0
+ * @param status           Out:   Link settings (autoneg etc)
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred.
+ */
+static int pnal_eth_get_ethtool_status (
+   int control_socket,
+   const char * interface_name,
+   pnal_eth_status_t * status)
 {
-   /* TODO: Possibly use the new ETHTOOL_GLINKSETTINGS instead of ETHTOOL_GSET
-      See:
-   https://stackoverflow.com/questions/41822920/how-to-get-ethtool-settings */
-
    int ret = -1;
-   int control_socket;
    struct ifreq ifr;
+   struct
+   {
+      struct ethtool_link_settings settings;
+      /* supported, advertising and lp_advertising, each nwords long */
+      uint32_t link_mode_masks[3 * SCHAR_MAX];
+   } link_settings;
    struct ethtool_cmd eth_status_linux;
+   int8_t nwords;
    uint32_t speed = 0;          /* Mbit/s */
    uint8_t port_type = PORT_TP; /* Linux PORT_xxx */
 
-   control_socket = socket (PF_INET, SOCK_DGRAM, IPPROTO_IP);
-   if (control_socket < 0)
-   {
-      return ret;
-   }
-
    snprintf (ifr.ifr_name, sizeof (ifr.ifr_name), "%s", interface_name);
-   ifr.ifr_data = (char *)&eth_status_linux;
-   eth_status_linux.cmd = ETHTOOL_GSET;
 
-   if(strncmp("wlan", interface_name, strlen("wlan")) == 0)
+   if (strncmp ("wlan", interface_name, strlen ("wlan")) == 0)
    {
       // TODO: ETH tool seems to have problems detecting wifi interfaces. In case it's
       // wifi, we just intermediately pretend it's a copper full duplex. Note that
@@ -436,6 +988,46 @@ int pnal_eth_get_status (const char * interface_name, pnal_eth_status_t * status
       status->autonegotiation_advertised_capabilities = PNAL_ETH_AUTONEG_CAP_UNKNOWN;
       ret = 0;
    }
+
+   /* The first request returns the number of words of the link mode masks
+      as a negative value, the second one the masks themselves */
+   memset (&link_settings, 0, sizeof (link_settings));
+   link_settings.settings.cmd = ETHTOOL_GLINKSETTINGS;
+   ifr.ifr_data = (char *)&link_settings;
+   if (
+      ioctl (control_socket, SIOCETHTOOL, &ifr) >= 0 &&
+      link_settings.settings.link_mode_masks_nwords < 0)
+   {
+      nwords = -link_settings.settings.link_mode_masks_nwords;
+      link_settings.settings.cmd = ETHTOOL_GLINKSETTINGS;
+      link_settings.settings.link_mode_masks_nwords = nwords;
+      if (
+         ioctl (control_socket, SIOCETHTOOL, &ifr) >= 0 &&
+         link_settings.settings.link_mode_masks_nwords == nwords)
+      {
+         /* The first word of the masks has the same layout as the legacy
+            ADVERTISED_xxx bits */
+         uint32_t advertising = link_settings.link_mode_masks[nwords];
+
+         speed = link_settings.settings.speed;
+         port_type = link_settings.settings.port;
+         status->is_autonegotiation_enabled =
+            (link_settings.settings.autoneg == AUTONEG_ENABLE);
+         status->is_autonegotiation_supported = advertising &
+                                                ADVERTISED_Autoneg;
+         status->operational_mau_type = calculate_mau_type (
+            port_type,
+            speed,
+            link_settings.settings.duplex);
+         status->autonegotiation_advertised_capabilities =
+            calculate_capabilities (advertising);
+
+         return 0;
+      }
+   }
+
+   ifr.ifr_data = (char *)&eth_status_linux;
+   eth_status_linux.cmd = ETHTOOL_GSET;
    if (ioctl (control_socket, SIOCETHTOOL, &ifr) >= 0)
    {
       speed = ethtool_cmd_speed (&eth_status_linux);
@@ -452,6 +1044,24 @@ int pnal_eth_get_status (const char * interface_name, pnal_eth_status_t * status
       ret = 0;
    }
 
+   return ret;
+}
+
+int pnal_eth_get_status (const char * interface_name, pnal_eth_status_t * status)
+{
+   int ret = -1;
+   int control_socket;
+   struct ifreq ifr;
+
+   control_socket = socket (PF_INET, SOCK_DGRAM, IPPROTO_IP);
+   if (control_socket < 0)
+   {
+      return ret;
+   }
+
+   ret = pnal_eth_get_ethtool_status (control_socket, interface_name, status);
+
+   snprintf (ifr.ifr_name, sizeof (ifr.ifr_name), "%s", interface_name);
    if (ioctl (control_socket, SIOCGIFFLAGS, &ifr) >= 0)
    {
       status->running = (ifr.ifr_flags & IFF_RUNNING) ? true : false;
@@ -462,6 +1072,221 @@ int pnal_eth_get_status (const char * interface_name, pnal_eth_status_t * status
    return ret;
 }
 
+/* Link monitor. Listens for RTM_NEWLINK messages of the kernel and reads the
+ * link settings with ethtool only when the kernel reports a change. */
+static struct
+{
+   pnal_link_status_callback_t * callback;
+   void * arg;
+   int netlink_socket;
+   int control_socket;
+   uint8_t buffer[8192];
+} pnal_link_monitor = {.netlink_socket = -1, .control_socket = -1};
+
+/**
+ * Request the current state of all interfaces from the kernel.
+ * The answers are RTM_NEWLINK messages, as for changes.
+ *
+ * @return  0 if the operation succeeded.
+ *         -1 if an error occurred.
+ */
+static int pnal_link_monitor_request_dump (void)
+{
+   struct
+   {
+      struct nlmsghdr header;
+      struct ifinfomsg ifinfo;
+   } request;
+
+   memset (&request, 0, sizeof (request));
+   request.header.nlmsg_len = NLMSG_LENGTH (sizeof (request.ifinfo));
+   request.header.nlmsg_type = RTM_GETLINK;
+   request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+   request.ifinfo.ifi_family = AF_UNSPEC;
+
+   if (
+      send (
+         pnal_link_monitor.netlink_socket,
+         &request,
+         request.header.nlmsg_len,
+         0) < 0)
+   {
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * Handle a RTM_NEWLINK message
+ *
+ * @param header           In:    Netlink message
+ */
+static void pnal_link_monitor_handle_newlink (const struct nlmsghdr * header)
+{
+   const struct ifinfomsg * ifinfo = NLMSG_DATA (header);
+   const struct rtattr * attribute = IFLA_RTA (ifinfo);
+   int attributes_len = IFLA_PAYLOAD (header);
+   const char * interface_name = NULL;
+   pnal_eth_status_t status;
+
+   while (RTA_OK (attribute, attributes_len))
+   {
+      if (attribute->rta_type == IFLA_IFNAME)
+      {
+         interface_name = RTA_DATA (attribute);
+      }
+      attribute = RTA_NEXT (attribute, attributes_len);
+   }
+
+   if (interface_name == NULL || (ifinfo->ifi_flags & IFF_LOOPBACK))
+   {
+      return;
+   }
+
+   memset (&status, 0, sizeof (status));
+   if (
+      pnal_eth_get_ethtool_status (
+         pnal_link_monitor.control_socket,
+         interface_name,
+         &status) != 0)
+   {
+      LOG_DEBUG (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to read link settings of %s\n",
+         __LINE__,
+         interface_name);
+   }
+   status.running = (ifinfo->ifi_flags & IFF_RUNNING) ? true : false;
+
+   pnal_link_monitor.callback (pnal_link_monitor.arg, interface_name, &status);
+}
+
+/**
+ * Thread receiving link change messages from the kernel
+ *
+ * This is a function to be passed into os_thread_create()
+ *
+ * @param arg              InOut: Not used
+ */
+static void pnal_link_monitor_task (void * arg)
+{
+   ssize_t len;
+   struct nlmsghdr * header;
+
+   (void)pnal_link_monitor_request_dump();
+
+   while (1)
+   {
+      len = recv (
+         pnal_link_monitor.netlink_socket,
+         pnal_link_monitor.buffer,
+         sizeof (pnal_link_monitor.buffer),
+         0);
+      if (len < 0)
+      {
+         if (errno == ENOBUFS)
+         {
+            /* Messages were lost, read the state of all interfaces again */
+            (void)pnal_link_monitor_request_dump();
+         }
+         continue;
+      }
+
+      for (header = (struct nlmsghdr *)pnal_link_monitor.buffer;
+           NLMSG_OK (header, (size_t)len);
+           header = NLMSG_NEXT (header, len))
+      {
+         if (header->nlmsg_type == RTM_NEWLINK)
+         {
+            pnal_link_monitor_handle_newlink (header);
+         }
+      }
+   }
+}
+
+int pnal_link_monitor_init (
+   const pnal_cfg_t * pnal_cfg,
+   pnal_link_status_callback_t * callback,
+   void * arg)
+{
+   struct sockaddr_nl address;
+   os_thread_t * thread;
+
+   if (pnal_link_monitor.netlink_socket >= 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Link monitor is already running\n",
+         __LINE__);
+      return -1;
+   }
+
+   pnal_link_monitor.callback = callback;
+   pnal_link_monitor.arg = arg;
+
+   pnal_link_monitor.control_socket = socket (PF_INET, SOCK_DGRAM, IPPROTO_IP);
+   pnal_link_monitor.netlink_socket =
+      socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+   if (
+      pnal_link_monitor.control_socket < 0 ||
+      pnal_link_monitor.netlink_socket < 0)
+   {
+      goto error;
+   }
+
+   memset (&address, 0, sizeof (address));
+   address.nl_family = AF_NETLINK;
+   address.nl_groups = RTMGRP_LINK;
+   if (
+      bind (
+         pnal_link_monitor.netlink_socket,
+         (struct sockaddr *)&address,
+         sizeof (address)) < 0)
+   {
+      goto error;
+   }
+
+   thread = os_thread_create (
+      "p-net_link_monitor",
+      pnal_cfg->link_monitor_thread.prio,
+      pnal_cfg->link_monitor_thread.stack_size,
+      pnal_link_monitor_task,
+      NULL);
+   if (thread == NULL)
+   {
+      goto error;
+   }
+   if (
+      os_thread_set_affinity (thread, pnal_cfg->link_monitor_thread.cpu_mask) !=
+      0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set CPU affinity of link monitor thread\n",
+         __LINE__);
+   }
+
+   return 0;
+
+error:
+   LOG_ERROR (
+      PF_PNAL_LOG,
+      "PNAL(%d): Failed to start link monitor: %s\n",
+      __LINE__,
+      strerror (errno));
+   if (pnal_link_monitor.netlink_socket >= 0)
+   {
+      close (pnal_link_monitor.netlink_socket);
+      pnal_link_monitor.netlink_socket = -1;
+   }
+   if (pnal_link_monitor.control_socket >= 0)
+   {
+      close (pnal_link_monitor.control_socket);
+      pnal_link_monitor.control_socket = -1;
+   }
+   return -1;
+}
+
 int pnal_get_interface_index (const char * interface_name)
 {
    return if_nametoindex (interface_name);
@@ -23,25 +23,419 @@
 #include "pnet_options.h"
 #include "options.h"
 #include "osal_log.h"
+#include "pnal_recv.h"
 
+#if defined(PNAL_USE_AF_XDP)
+#include "pnal_eth_xdp.h"
+#endif
+
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
 #include <net/ethernet.h>
 #include <net/if.h>
 #include <netpacket/packet.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <errno.h>
 
+/* Number of recent transmit timestamps kept for
+ * pnal_eth_get_tx_timestamp() */
+#define PNAL_ETH_TX_TIMESTAMPS 16
+
+typedef struct pnal_eth_tx_timestamp
+{
+   uint32_t hash; /* Of the frame contents */
+   uint16_t len;
+   uint64_t timestamp_ns;
+} pnal_eth_tx_timestamp_t;
+
 struct pnal_eth_handle
 {
    pnal_eth_callback_t * callback;
    void * arg;
    int socket;
    os_thread_t * thread;
+   pnal_buf_t * rx_buf;
+   bool busy_spin;
+#if defined(PNAL_USE_AF_XDP)
+   pnal_eth_xdp_t * xdp;
+#endif
+
+   /* Timestamping. The transmit timestamps are read from the error queue
+    * of the socket, under tx_timestamp_mutex. */
+   pnal_timestamping_t timestamping;
+   os_mutex_t * tx_timestamp_mutex;
+   pnal_eth_tx_timestamp_t tx_timestamps[PNAL_ETH_TX_TIMESTAMPS];
+   uint16_t tx_timestamp_ix;
+   uint8_t tx_echo[PNAL_BUF_MAX_SIZE];
+
+   uint64_t txtime_delay_ns; /* 0 if SO_TXTIME is not used */
 };
 
+/* Max number of frames read from a socket per wakeup of the common receive
+ * thread, so that one busy socket does not starve the others */
+#define PNAL_ETH_RECV_BURST 16
+
+/**
+ * @internal
+ * Hash the contents of a frame, to find its transmit timestamp.
+ *
+ * @param data           In:    Frame
+ * @param len            In:    Length of the frame
+ * @return FNV-1a hash of the frame
+ */
+static uint32_t pnal_eth_frame_hash (const uint8_t * data, uint16_t len)
+{
+   uint32_t hash = 2166136261u;
+   uint16_t ix;
+
+   for (ix = 0; ix < len; ix++)
+   {
+      hash = (hash ^ data[ix]) * 16777619u;
+   }
+
+   return hash;
+}
+
+/**
+ * @internal
+ * Get the timestamp from the control messages of a received message.
+ *
+ * @param msg            In:    Received message
+ * @param hardware       In:    Prefer the hardware timestamp
+ * @return the timestamp in nanoseconds, or 0 if not available
+ */
+static uint64_t pnal_eth_get_cmsg_timestamp (
+   struct msghdr * msg,
+   bool hardware)
+{
+   struct cmsghdr * cmsg;
+   struct scm_timestamping ts;
+
+   for (cmsg = CMSG_FIRSTHDR (msg); cmsg != NULL;
+        cmsg = CMSG_NXTHDR (msg, cmsg))
+   {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+      {
+         memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+
+         /* ts[0] is the software timestamp, ts[2] the hardware timestamp */
+         if (hardware && (ts.ts[2].tv_sec != 0 || ts.ts[2].tv_nsec != 0))
+         {
+            return (uint64_t)ts.ts[2].tv_sec * 1000000000 + ts.ts[2].tv_nsec;
+         }
+         return (uint64_t)ts.ts[0].tv_sec * 1000000000 + ts.ts[0].tv_nsec;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * @internal
+ * Receive a frame into eth_handle->rx_buf, with its timestamp if enabled.
+ *
+ * @param eth_handle     InOut: Ethernet handle
+ * @param flags          In:    Flags for recvmsg()
+ * @return the length of the frame, or -1 on error
+ */
+static ssize_t pnal_eth_recv_frame (pnal_eth_handle_t * eth_handle, int flags)
+{
+   uint8_t control[CMSG_SPACE (sizeof (struct scm_timestamping))];
+   struct iovec iov = {
+      .iov_base = eth_handle->rx_buf->payload,
+      .iov_len = PNAL_BUF_MAX_SIZE};
+   struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1};
+   ssize_t readlen;
+
+   if (eth_handle->timestamping == PNAL_TIMESTAMPING_OFF)
+   {
+      return recv (
+         eth_handle->socket,
+         eth_handle->rx_buf->payload,
+         PNAL_BUF_MAX_SIZE,
+         flags);
+   }
+
+   msg.msg_control = control;
+   msg.msg_controllen = sizeof (control);
+   readlen = recvmsg (eth_handle->socket, &msg, flags);
+   if (readlen >= 0)
+   {
+      eth_handle->rx_buf->timestamp_ns = pnal_eth_get_cmsg_timestamp (
+         &msg,
+         eth_handle->timestamping == PNAL_TIMESTAMPING_HARDWARE);
+   }
+
+   return readlen;
+}
+
+/**
+ * @internal
+ * Move the transmit timestamps from the error queue of the socket to
+ * eth_handle->tx_timestamps.
+ *
+ * The error queue shares the receive buffer space of the socket, so it
+ * must be emptied regularly. Call with tx_timestamp_mutex locked.
+ *
+ * @param eth_handle     InOut: Ethernet handle
+ */
+static void pnal_eth_read_tx_timestamps (pnal_eth_handle_t * eth_handle)
+{
+   uint8_t control
+      [CMSG_SPACE (sizeof (struct scm_timestamping)) +
+       CMSG_SPACE (sizeof (struct sock_extended_err))];
+   struct iovec iov;
+   struct msghdr msg;
+   pnal_eth_tx_timestamp_t * entry;
+   uint64_t timestamp_ns;
+   ssize_t len;
+
+   while (1)
+   {
+      iov.iov_base = eth_handle->tx_echo;
+      iov.iov_len = sizeof (eth_handle->tx_echo);
+      memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof (control);
+
+      len = recvmsg (eth_handle->socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+      if (len < 0)
+      {
+         return;
+      }
+
+      timestamp_ns = pnal_eth_get_cmsg_timestamp (
+         &msg,
+         eth_handle->timestamping == PNAL_TIMESTAMPING_HARDWARE);
+      if (timestamp_ns != 0)
+      {
+         entry = &eth_handle->tx_timestamps[eth_handle->tx_timestamp_ix];
+         entry->hash = pnal_eth_frame_hash (eth_handle->tx_echo, len);
+         entry->len = len;
+         entry->timestamp_ns = timestamp_ns;
+         eth_handle->tx_timestamp_ix =
+            (eth_handle->tx_timestamp_ix + 1) % PNAL_ETH_TX_TIMESTAMPS;
+      }
+   }
+}
+
+/**
+ * @internal
+ * Enable timestamping of received and sent frames on the socket.
+ *
+ * Hardware timestamping is also enabled in the network interface, which
+ * affects all users of the interface.
+ *
+ * @param eth_handle     InOut: Ethernet handle
+ * @param if_name        In:    Interface name
+ * @param timestamping   In:    Type of timestamps
+ * @return 0 on success, -1 on error
+ */
+static int pnal_eth_enable_timestamping (
+   pnal_eth_handle_t * eth_handle,
+   const char * if_name,
+   pnal_timestamping_t timestamping)
+{
+   struct hwtstamp_config hwconfig;
+   struct ifreq ifr;
+   int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE |
+               SOF_TIMESTAMPING_SOFTWARE;
+
+   if (timestamping == PNAL_TIMESTAMPING_HARDWARE)
+   {
+      memset (&hwconfig, 0, sizeof (hwconfig));
+      hwconfig.tx_type = HWTSTAMP_TX_ON;
+      hwconfig.rx_filter = HWTSTAMP_FILTER_ALL;
+      memset (&ifr, 0, sizeof (ifr));
+      snprintf (ifr.ifr_name, sizeof (ifr.ifr_name), "%s", if_name);
+      ifr.ifr_data = (void *)&hwconfig;
+      if (ioctl (eth_handle->socket, SIOCSHWTSTAMP, &ifr) == 0)
+      {
+         flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE |
+                  SOF_TIMESTAMPING_RAW_HARDWARE;
+      }
+      else
+      {
+         LOG_WARNING (
+            PF_PNAL_LOG,
+            "PNAL(%d): No hardware timestamping on %s. Using software "
+            "timestamps.\n",
+            __LINE__,
+            if_name);
+      }
+   }
+
+   eth_handle->tx_timestamp_mutex = os_mutex_create();
+   if (eth_handle->tx_timestamp_mutex == NULL)
+   {
+      return -1;
+   }
+
+   if (
+      setsockopt (
+         eth_handle->socket,
+         SOL_SOCKET,
+         SO_TIMESTAMPING,
+         &flags,
+         sizeof (flags)) != 0)
+   {
+      os_mutex_destroy (eth_handle->tx_timestamp_mutex);
+      eth_handle->tx_timestamp_mutex = NULL;
+      return -1;
+   }
+
+   eth_handle->timestamping = timestamping;
+   return 0;
+}
+
+/**
+ * @internal
+ * Set the socket priority, and enable launch times if configured.
+ *
+ * @param eth_handle     InOut: Ethernet handle
+ * @param if_name        In:    Interface name
+ * @param pnal_cfg       In:    Operating system dependent configuration
+ */
+static void pnal_eth_set_priority (
+   pnal_eth_handle_t * eth_handle,
+   const char * if_name,
+   const pnal_cfg_t * pnal_cfg)
+{
+   struct sock_txtime txtime = {.clockid = CLOCK_TAI, .flags = 0};
+   int priority = pnal_cfg->eth_priority;
+
+   if (
+      priority > 0 &&
+      setsockopt (
+         eth_handle->socket,
+         SOL_SOCKET,
+         SO_PRIORITY,
+         &priority,
+         sizeof (priority)) != 0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set socket priority %d on %s\n",
+         __LINE__,
+         priority,
+         if_name);
+   }
+
+   if (pnal_cfg->eth_txtime_delay_us > 0)
+   {
+      if (
+         setsockopt (
+            eth_handle->socket,
+            SOL_SOCKET,
+            SO_TXTIME,
+            &txtime,
+            sizeof (txtime)) == 0)
+      {
+         eth_handle->txtime_delay_ns =
+            (uint64_t)pnal_cfg->eth_txtime_delay_us * 1000;
+      }
+      else
+      {
+         LOG_WARNING (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to enable SO_TXTIME on %s\n",
+            __LINE__,
+            if_name);
+      }
+   }
+}
+
+/**
+ * @internal
+ * Send a frame on the socket, with a launch time if SO_TXTIME is enabled.
+ *
+ * @param eth_handle     In:    Ethernet handle
+ * @param buf            In:    Buffer with data to be sent
+ * @param late_ns        In:    Lateness of the frame, in nanoseconds
+ * @return The number of bytes sent, or -1 if an error occurred.
+ */
+static int pnal_eth_socket_send (
+   pnal_eth_handle_t * eth_handle,
+   pnal_buf_t * buf,
+   uint64_t late_ns)
+{
+   uint8_t control[CMSG_SPACE (sizeof (uint64_t))] = {0};
+   struct iovec iov = {.iov_base = buf->payload, .iov_len = buf->len};
+   struct msghdr msg = {
+      .msg_iov = &iov,
+      .msg_iovlen = 1,
+      .msg_control = control,
+      .msg_controllen = sizeof (control)};
+   struct cmsghdr * cmsg;
+   struct timespec now;
+   uint64_t launch_time_ns;
+
+   if (eth_handle->txtime_delay_ns == 0)
+   {
+      return send (eth_handle->socket, buf->payload, buf->len, 0);
+   }
+
+   if (late_ns > eth_handle->txtime_delay_ns / 2)
+   {
+      late_ns = 0;
+   }
+   clock_gettime (CLOCK_TAI, &now);
+   launch_time_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec +
+                    eth_handle->txtime_delay_ns - late_ns;
+
+   cmsg = CMSG_FIRSTHDR (&msg);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type = SCM_TXTIME;
+   cmsg->cmsg_len = CMSG_LEN (sizeof (launch_time_ns));
+   memcpy (CMSG_DATA (cmsg), &launch_time_ns, sizeof (launch_time_ns));
+
+   return sendmsg (eth_handle->socket, &msg, 0);
+}
+
+/**
+ * @internal
+ * Pass a received frame to the callback.
+ *
+ * Allocates a new receive buffer if the callback keeps the frame.
+ *
+ * @param eth_handle     InOut: Ethernet handle
+ * @param readlen        In:    Length of the frame in eth_handle->rx_buf
+ */
+static void pnal_eth_handle_frame (
+   pnal_eth_handle_t * eth_handle,
+   ssize_t readlen)
+{
+   int handled = 0;
+
+   eth_handle->rx_buf->len = readlen;
+
+   if (eth_handle->callback != NULL)
+   {
+      handled =
+         eth_handle->callback (eth_handle, eth_handle->arg, eth_handle->rx_buf);
+   }
+   else
+   {
+      handled = 0; /* Message not handled */
+   }
+
+   if (handled == 1)
+   {
+      eth_handle->rx_buf = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
+      assert (eth_handle->rx_buf != NULL);
+   }
+}
+
 /**
  * @internal
  * Run a thread that listens to incoming raw Ethernet sockets.
@@ -55,33 +449,51 @@ struct pnal_eth_handle
 static void os_eth_task (void * thread_arg)
 {
    pnal_eth_handle_t * eth_handle = thread_arg;
+   const int flags = eth_handle->busy_spin ? MSG_DONTWAIT : 0;
    ssize_t readlen;
-   int handled = 0;
-
-   pnal_buf_t * p = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
-   assert (p != NULL);
 
    while (1)
    {
-      readlen = recv (eth_handle->socket, p->payload, PNAL_BUF_MAX_SIZE, 0);
+      readlen = pnal_eth_recv_frame (eth_handle, flags);
       if (readlen == -1)
          continue;
-      p->len = readlen;
 
-      if (eth_handle->callback != NULL)
-      {
-         handled = eth_handle->callback (eth_handle, eth_handle->arg, p);
-      }
-      else
-      {
-         handled = 0; /* Message not handled */
-      }
+      pnal_eth_handle_frame (eth_handle, readlen);
+   }
+}
 
-      if (handled == 1)
+/**
+ * @internal
+ * Read the frames waiting on a raw Ethernet socket.
+ *
+ * Called from the common receive thread.
+ *
+ * @param id             In:    Socket
+ * @param arg            InOut: Will be converted to pnal_eth_handle_t
+ */
+static void pnal_eth_recv_ready (uint32_t id, void * arg)
+{
+   pnal_eth_handle_t * eth_handle = arg;
+   ssize_t readlen;
+   int n;
+
+   if (eth_handle->timestamping != PNAL_TIMESTAMPING_OFF)
+   {
+      /* Pending transmit timestamps make epoll report the socket */
+      os_mutex_lock (eth_handle->tx_timestamp_mutex);
+      pnal_eth_read_tx_timestamps (eth_handle);
+      os_mutex_unlock (eth_handle->tx_timestamp_mutex);
+   }
+
+   for (n = 0; n < PNAL_ETH_RECV_BURST; n++)
+   {
+      readlen = pnal_eth_recv_frame (eth_handle, MSG_DONTWAIT);
+      if (readlen < 0)
       {
-         p = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
-         assert (p != NULL);
+         return;
       }
+
+      pnal_eth_handle_frame (eth_handle, readlen);
    }
 }
 
@@ -111,6 +523,33 @@ pnal_eth_handle_t * pnal_eth_init (
 
    handle->arg = arg;
    handle->callback = callback;
+   handle->timestamping = PNAL_TIMESTAMPING_OFF;
+   handle->tx_timestamp_mutex = NULL;
+   handle->tx_timestamp_ix = 0;
+   memset (handle->tx_timestamps, 0, sizeof (handle->tx_timestamps));
+   handle->txtime_delay_ns = 0;
+
+#if defined(PNAL_USE_AF_XDP)
+   handle->xdp = pnal_eth_xdp_init (
+      if_name,
+      receive_type,
+      pnal_cfg,
+      handle,
+      callback,
+      arg);
+   if (handle->xdp != NULL)
+   {
+      handle->socket = -1;
+      handle->thread = NULL;
+      return handle;
+   }
+   LOG_WARNING (
+      PF_PNAL_LOG,
+      "PNAL(%d): AF_XDP not available on %s. Using a raw socket.\n",
+      __LINE__,
+      if_name);
+#endif
+
    handle->socket = socket (PF_PACKET, SOCK_RAW, htons (linux_receive_type));
 
    if(handle->socket == -1)
@@ -181,12 +620,60 @@ pnal_eth_handle_t * pnal_eth_init (
 
    if (handle->socket > -1)
    {
+      handle->rx_buf = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
+      assert (handle->rx_buf != NULL);
+      handle->busy_spin = pnal_cfg->eth_recv_thread.busy_spin;
+      if (
+         pnal_cfg->eth_timestamping != PNAL_TIMESTAMPING_OFF &&
+         pnal_eth_enable_timestamping (
+            handle,
+            if_name,
+            pnal_cfg->eth_timestamping) != 0)
+      {
+         LOG_WARNING (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to enable timestamping on %s\n",
+            __LINE__,
+            if_name);
+      }
+      (void)pnal_recv_set_busy_poll (
+         handle->socket,
+         &pnal_cfg->eth_recv_thread);
+      pnal_eth_set_priority (handle, if_name, pnal_cfg);
+
+      if (pnal_cfg->single_recv_thread)
+      {
+         handle->thread = NULL;
+         if (
+            pnal_recv_init (&pnal_cfg->eth_recv_thread) == 0 &&
+            pnal_recv_add (handle->socket, pnal_eth_recv_ready, handle) == 0)
+         {
+            return handle;
+         }
+         LOG_WARNING (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to use the common receive thread for %s\n",
+            __LINE__,
+            if_name);
+      }
+
       handle->thread = os_thread_create (
          "os_eth_task",
          pnal_cfg->eth_recv_thread.prio,
          pnal_cfg->eth_recv_thread.stack_size,
          os_eth_task,
          handle);
+      if (
+         handle->thread != NULL &&
+         os_thread_set_affinity (
+            handle->thread,
+            pnal_cfg->eth_recv_thread.cpu_mask) != 0)
+      {
+         LOG_WARNING (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to set CPU affinity of receive thread\n",
+            __LINE__);
+      }
       return handle;
    }
    else
@@ -198,6 +685,190 @@ pnal_eth_handle_t * pnal_eth_init (
 
 int pnal_eth_send (pnal_eth_handle_t * handle, pnal_buf_t * buf)
 {
-   int ret = send (handle->socket, buf->payload, buf->len, 0);
+   return pnal_eth_send_cyclic (handle, buf, 0);
+}
+
+int pnal_eth_send_cyclic (
+   pnal_eth_handle_t * handle,
+   pnal_buf_t * buf,
+   uint32_t late_us)
+{
+#if defined(PNAL_USE_AF_XDP)
+   if (handle->xdp != NULL)
+   {
+      return pnal_eth_xdp_send (handle->xdp, buf);
+   }
+#endif
+   int ret;
+
+   if (handle->timestamping == PNAL_TIMESTAMPING_OFF)
+   {
+      return pnal_eth_socket_send (handle, buf, (uint64_t)late_us * 1000);
+   }
+
+   os_mutex_lock (handle->tx_timestamp_mutex);
+   pnal_eth_read_tx_timestamps (handle);
+   ret = pnal_eth_socket_send (handle, buf, (uint64_t)late_us * 1000);
+   os_mutex_unlock (handle->tx_timestamp_mutex);
+
    return ret;
 }
+
+int pnal_eth_get_tx_timestamp (
+   pnal_eth_handle_t * handle,
+   const pnal_buf_t * buf,
+   uint64_t * timestamp_ns)
+{
+   const pnal_eth_tx_timestamp_t * entry;
+   uint32_t hash;
+   uint16_t n;
+   int ret = -1;
+
+   if (handle->timestamping == PNAL_TIMESTAMPING_OFF)
+   {
+      return -1;
+   }
+
+   hash = pnal_eth_frame_hash (buf->payload, buf->len);
+
+   os_mutex_lock (handle->tx_timestamp_mutex);
+   pnal_eth_read_tx_timestamps (handle);
+
+   /* Search from the newest timestamp */
+   for (n = 1; n <= PNAL_ETH_TX_TIMESTAMPS; n++)
+   {
+      entry = &handle->tx_timestamps
+                  [(handle->tx_timestamp_ix + PNAL_ETH_TX_TIMESTAMPS - n) %
+                   PNAL_ETH_TX_TIMESTAMPS];
+      if (
+         entry->timestamp_ns != 0 && entry->len == buf->len &&
+         entry->hash == hash)
+      {
+         *timestamp_ns = entry->timestamp_ns;
+         ret = 0;
+         break;
+      }
+   }
+   os_mutex_unlock (handle->tx_timestamp_mutex);
+
+   return ret;
+}
+
+/* The frame ID comparisons must be reachable with the 8 bit jump offsets
+ * of classic BPF */
+#define PNAL_ETH_FILTER_MAX_FRAME_IDS 200
+#define PNAL_ETH_FILTER_HEADER_LEN    10
+
+int pnal_eth_set_frame_id_filter (
+   pnal_eth_handle_t * handle,
+   const uint16_t * frame_ids,
+   uint16_t nbr_of_frame_ids)
+{
+   struct sock_filter
+      code[PNAL_ETH_FILTER_HEADER_LEN + PNAL_ETH_FILTER_MAX_FRAME_IDS + 2];
+   struct sock_fprog program;
+   uint16_t drop;
+   uint16_t accept;
+   uint16_t ix;
+   uint16_t len = 0;
+
+#if defined(PNAL_USE_AF_XDP)
+   if (handle->xdp != NULL)
+   {
+      /* The XDP program already passes only Profinet and LLDP frames to
+       * the receive thread */
+      return 0;
+   }
+#endif
+
+   if (nbr_of_frame_ids > PNAL_ETH_FILTER_MAX_FRAME_IDS)
+   {
+      return -1;
+   }
+
+   /* Index of the last two instructions */
+   drop = PNAL_ETH_FILTER_HEADER_LEN + nbr_of_frame_ids;
+   accept = drop + 1;
+
+/* Jump offset from the instruction at index len to instruction target */
+#define PNAL_ETH_FILTER_JUMP(target) ((target)-len - 1)
+
+   /* Check the ethertype, directly or after a VLAN tag, and load the frame ID
+    * of Profinet frames */
+   code[len] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_H | BPF_ABS, 12);
+   len++;
+   code[len] = (struct sock_filter)
+      BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, PNAL_ETHTYPE_VLAN, 4, 0);
+   len++;
+   code[len] = (struct sock_filter)BPF_JUMP (
+      BPF_JMP | BPF_JEQ | BPF_K,
+      PNAL_ETHTYPE_LLDP,
+      PNAL_ETH_FILTER_JUMP (accept),
+      0);
+   len++;
+   code[len] = (struct sock_filter)BPF_JUMP (
+      BPF_JMP | BPF_JEQ | BPF_K,
+      PNAL_ETHTYPE_PROFINET,
+      0,
+      PNAL_ETH_FILTER_JUMP (drop));
+   len++;
+   code[len] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_H | BPF_ABS, 14);
+   len++;
+   code[len] = (struct sock_filter)BPF_JUMP (BPF_JMP | BPF_JA, 4, 0, 0);
+   len++;
+   code[len] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_H | BPF_ABS, 16);
+   len++;
+   code[len] = (struct sock_filter)BPF_JUMP (
+      BPF_JMP | BPF_JEQ | BPF_K,
+      PNAL_ETHTYPE_LLDP,
+      PNAL_ETH_FILTER_JUMP (accept),
+      0);
+   len++;
+   code[len] = (struct sock_filter)BPF_JUMP (
+      BPF_JMP | BPF_JEQ | BPF_K,
+      PNAL_ETHTYPE_PROFINET,
+      0,
+      PNAL_ETH_FILTER_JUMP (drop));
+   len++;
+   code[len] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_H | BPF_ABS, 18);
+   len++;
+   CC_ASSERT (len == PNAL_ETH_FILTER_HEADER_LEN);
+
+   for (ix = 0; ix < nbr_of_frame_ids; ix++)
+   {
+      code[len] = (struct sock_filter)BPF_JUMP (
+         BPF_JMP | BPF_JEQ | BPF_K,
+         frame_ids[ix],
+         PNAL_ETH_FILTER_JUMP (accept),
+         0);
+      len++;
+   }
+
+#undef PNAL_ETH_FILTER_JUMP
+
+   /* Drop, or pass the whole frame */
+   code[len] = (struct sock_filter)BPF_STMT (BPF_RET | BPF_K, 0);
+   len++;
+   code[len] = (struct sock_filter)BPF_STMT (BPF_RET | BPF_K, 0xFFFFFFFF);
+   len++;
+
+   program.len = len;
+   program.filter = code;
+   if (
+      setsockopt (
+         handle->socket,
+         SOL_SOCKET,
+         SO_ATTACH_FILTER,
+         &program,
+         sizeof (program)) != 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to attach frame filter: %s\n",
+         __LINE__,
+         strerror (errno));
+      return -1;
+   }
+
+   return 0;
+}
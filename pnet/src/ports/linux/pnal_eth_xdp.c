@@ -0,0 +1,841 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2018 rt-labs AB, Sweden.
+ *
+ * This software is dual-licensed under GPLv3 and a commercial
+ * license. See the file LICENSE.md distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+/**
+ * @file
+ * @brief AF_XDP backend for the Linux Ethernet functions
+ *
+ * The XDP program and the XSKMAP are loaded with the bpf() system call
+ * directly, so no libbpf or libxdp is needed. The program is attached via
+ * a BPF link, which detaches it automatically when the process exits.
+ */
+
+#include "pnal_eth_xdp.h"
+#include "pnal_recv.h"
+
+#include "options.h"
+#include "osal.h"
+#include "osal_log.h"
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+/* UMEM layout. The first half of the frames is used for receiving and the
+ * second half for sending. The ring sizes must be powers of two. */
+#define PNAL_ETH_XDP_FRAME_SIZE 2048
+#define PNAL_ETH_XDP_NUM_FRAMES 1024
+#define PNAL_ETH_XDP_RING_SIZE  (PNAL_ETH_XDP_NUM_FRAMES / 2)
+#define PNAL_ETH_XDP_QUEUE_ID   0
+
+/* Size of the XSKMAP, which is indexed by receive queue */
+#define PNAL_ETH_XDP_MAX_QUEUES 64
+
+#define PNAL_ETH_XDP_MAX_INSNS 20
+
+typedef struct pnal_eth_xdp_ring
+{
+   uint32_t * producer;
+   uint32_t * consumer;
+   uint32_t * flags;
+   void * desc;
+   uint32_t mask;
+   void * map;
+   size_t map_size;
+} pnal_eth_xdp_ring_t;
+
+struct pnal_eth_xdp
+{
+   pnal_eth_handle_t * handle;
+   pnal_eth_callback_t * callback;
+   void * arg;
+
+   int xsk;
+   int map_fd;
+   int prog_fd;
+   int link_fd;
+
+   uint8_t * umem;
+   pnal_eth_xdp_ring_t fill;
+   pnal_eth_xdp_ring_t comp;
+   pnal_eth_xdp_ring_t rx;
+   pnal_eth_xdp_ring_t tx;
+
+   /* Free transmit frames. Protected by tx_mutex. */
+   os_mutex_t * tx_mutex;
+   uint64_t tx_free[PNAL_ETH_XDP_RING_SIZE];
+   uint32_t tx_free_count;
+
+   os_thread_t * thread;
+   bool busy_spin;
+   bool timestamping;
+};
+
+static int pnal_eth_xdp_bpf (int cmd, union bpf_attr * attr)
+{
+   return syscall (__NR_bpf, cmd, attr, sizeof (*attr));
+}
+
+#define PNAL_ETH_XDP_INSN(c, d, s, o, i)                                       \
+   ((struct bpf_insn){                                                         \
+      .code = (c),                                                             \
+      .dst_reg = (d),                                                          \
+      .src_reg = (s),                                                          \
+      .off = (o),                                                              \
+      .imm = (i)})
+
+/**
+ * @internal
+ * Load the XDP program.
+ *
+ * The program redirects frames with the given ethertypes, directly or after
+ * one VLAN tag, to the AF_XDP socket registered for the receive queue in
+ * the XSKMAP. Other frames, and frames arriving on queues without a socket,
+ * are passed to the kernel network stack.
+ *
+ * @param map_fd           In:    File descriptor of the XSKMAP
+ * @param ethertypes       In:    Ethertypes to redirect
+ * @param nbr_of_types     In:    Number of ethertypes. Max 2.
+ * @return the program file descriptor, or -1 on error
+ */
+static int pnal_eth_xdp_load_program (
+   int map_fd,
+   const uint16_t * ethertypes,
+   uint16_t nbr_of_types)
+{
+   struct bpf_insn code[PNAL_ETH_XDP_MAX_INSNS];
+   union bpf_attr attr;
+   static char verifier_log[4096];
+   uint16_t pass;
+   uint16_t redirect;
+   uint16_t ix;
+   uint16_t len = 0;
+   int fd;
+
+   /* Index of the pass and redirect sections */
+   pass = 9 + nbr_of_types;
+   redirect = pass + 2;
+
+/* Jump offset from the instruction at index len to instruction target */
+#define PNAL_ETH_XDP_JUMP(target) ((target)-len - 1)
+
+   /* r6 = ctx, r2 = data, r3 = data_end */
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_ALU64 | BPF_MOV | BPF_X,
+      BPF_REG_6,
+      BPF_REG_1,
+      0,
+      0);
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_LDX | BPF_MEM | BPF_W,
+      BPF_REG_2,
+      BPF_REG_6,
+      offsetof (struct xdp_md, data),
+      0);
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_LDX | BPF_MEM | BPF_W,
+      BPF_REG_3,
+      BPF_REG_6,
+      offsetof (struct xdp_md, data_end),
+      0);
+
+   /* Pass frames too short to hold a VLAN tagged ethertype */
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 18);
+   code[len] = PNAL_ETH_XDP_INSN (
+      BPF_JMP | BPF_JGT | BPF_X,
+      BPF_REG_4,
+      BPF_REG_3,
+      PNAL_ETH_XDP_JUMP (pass),
+      0);
+   len++;
+
+   /* r5 = ethertype, in network byte order */
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 12, 0);
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_JMP | BPF_JNE | BPF_K,
+      BPF_REG_5,
+      0,
+      1,
+      htons (PNAL_ETHTYPE_VLAN));
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 16, 0);
+
+   for (ix = 0; ix < nbr_of_types; ix++)
+   {
+      code[len] = PNAL_ETH_XDP_INSN (
+         BPF_JMP | BPF_JEQ | BPF_K,
+         BPF_REG_5,
+         0,
+         PNAL_ETH_XDP_JUMP (redirect),
+         htons (ethertypes[ix]));
+      len++;
+   }
+
+#undef PNAL_ETH_XDP_JUMP
+
+   /* return XDP_PASS */
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+   code[len++] = PNAL_ETH_XDP_INSN (BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+   /* return bpf_redirect_map (map, ctx->rx_queue_index, XDP_PASS) */
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_LDX | BPF_MEM | BPF_W,
+      BPF_REG_2,
+      BPF_REG_6,
+      offsetof (struct xdp_md, rx_queue_index),
+      0);
+   code[len++] = PNAL_ETH_XDP_INSN (
+      BPF_LD | BPF_DW | BPF_IMM,
+      BPF_REG_1,
+      BPF_PSEUDO_MAP_FD,
+      0,
+      map_fd);
+   code[len++] = PNAL_ETH_XDP_INSN (0, 0, 0, 0, 0);
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+   code[len++] =
+      PNAL_ETH_XDP_INSN (BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+   code[len++] = PNAL_ETH_XDP_INSN (BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+   memset (&attr, 0, sizeof (attr));
+   attr.prog_type = BPF_PROG_TYPE_XDP;
+   attr.expected_attach_type = BPF_XDP;
+   attr.insns = (uint64_t)(uintptr_t)code;
+   attr.insn_cnt = len;
+   attr.license = (uint64_t)(uintptr_t) "GPL";
+   strncpy (attr.prog_name, "pnet_xdp", sizeof (attr.prog_name) - 1);
+
+   fd = pnal_eth_xdp_bpf (BPF_PROG_LOAD, &attr);
+   if (fd < 0 && errno != EPERM)
+   {
+      /* Load again, to get the reason from the verifier */
+      attr.log_buf = (uint64_t)(uintptr_t)verifier_log;
+      attr.log_size = sizeof (verifier_log);
+      attr.log_level = 1;
+      verifier_log[0] = '\0';
+      fd = pnal_eth_xdp_bpf (BPF_PROG_LOAD, &attr);
+      if (fd < 0)
+      {
+         LOG_ERROR (
+            PF_PNAL_LOG,
+            "PNAL(%d): Failed to load XDP program: %s\n%s\n",
+            __LINE__,
+            strerror (errno),
+            verifier_log);
+      }
+   }
+
+   return fd;
+}
+
+/**
+ * @internal
+ * Map one of the rings of the AF_XDP socket.
+ *
+ * @param xsk              In:    AF_XDP socket
+ * @param offset           In:    Ring offsets from XDP_MMAP_OFFSETS
+ * @param pgoff            In:    Ring identifier, XDP_xxx_PGOFF_yyy
+ * @param desc_size        In:    Size of a ring descriptor
+ * @param ring             Out:   Mapped ring
+ * @return 0 on success, -1 on error
+ */
+static int pnal_eth_xdp_map_ring (
+   int xsk,
+   const struct xdp_ring_offset * offset,
+   off_t pgoff,
+   size_t desc_size,
+   pnal_eth_xdp_ring_t * ring)
+{
+   uint8_t * map;
+
+   ring->map_size = offset->desc + PNAL_ETH_XDP_RING_SIZE * desc_size;
+   map = mmap (
+      NULL,
+      ring->map_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      xsk,
+      pgoff);
+   if (map == MAP_FAILED)
+   {
+      return -1;
+   }
+
+   ring->map = map;
+   ring->producer = (uint32_t *)(map + offset->producer);
+   ring->consumer = (uint32_t *)(map + offset->consumer);
+   ring->flags = (uint32_t *)(map + offset->flags);
+   ring->desc = map + offset->desc;
+   ring->mask = PNAL_ETH_XDP_RING_SIZE - 1;
+
+   return 0;
+}
+
+/**
+ * @internal
+ * Create the AF_XDP socket with its UMEM and rings, and bind it to the
+ * receive queue.
+ *
+ * Zero-copy mode is used when the driver supports it.
+ *
+ * @param xdp              InOut: AF_XDP instance
+ * @param ifindex          In:    Interface index
+ * @return 0 on success, -1 on error
+ */
+static int pnal_eth_xdp_open_socket (pnal_eth_xdp_t * xdp, int ifindex)
+{
+   struct xdp_umem_reg umem_reg;
+   struct xdp_mmap_offsets offsets;
+   struct sockaddr_xdp sxdp;
+   socklen_t optlen = sizeof (offsets);
+   int ring_size = PNAL_ETH_XDP_RING_SIZE;
+   uint64_t * fill_desc;
+   uint32_t ix;
+
+   xdp->umem = mmap (
+      NULL,
+      PNAL_ETH_XDP_NUM_FRAMES * PNAL_ETH_XDP_FRAME_SIZE,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,
+      -1,
+      0);
+   if (xdp->umem == MAP_FAILED)
+   {
+      xdp->umem = NULL;
+      return -1;
+   }
+
+   xdp->xsk = socket (AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+   if (xdp->xsk < 0)
+   {
+      return -1;
+   }
+
+   memset (&umem_reg, 0, sizeof (umem_reg));
+   umem_reg.addr = (uint64_t)(uintptr_t)xdp->umem;
+   umem_reg.len = PNAL_ETH_XDP_NUM_FRAMES * PNAL_ETH_XDP_FRAME_SIZE;
+   umem_reg.chunk_size = PNAL_ETH_XDP_FRAME_SIZE;
+
+   if (
+      setsockopt (
+         xdp->xsk,
+         SOL_XDP,
+         XDP_UMEM_REG,
+         &umem_reg,
+         sizeof (umem_reg)) != 0 ||
+      setsockopt (
+         xdp->xsk,
+         SOL_XDP,
+         XDP_UMEM_FILL_RING,
+         &ring_size,
+         sizeof (ring_size)) != 0 ||
+      setsockopt (
+         xdp->xsk,
+         SOL_XDP,
+         XDP_UMEM_COMPLETION_RING,
+         &ring_size,
+         sizeof (ring_size)) != 0 ||
+      setsockopt (
+         xdp->xsk,
+         SOL_XDP,
+         XDP_RX_RING,
+         &ring_size,
+         sizeof (ring_size)) != 0 ||
+      setsockopt (
+         xdp->xsk,
+         SOL_XDP,
+         XDP_TX_RING,
+         &ring_size,
+         sizeof (ring_size)) != 0 ||
+      getsockopt (xdp->xsk, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &optlen) !=
+         0)
+   {
+      return -1;
+   }
+
+   if (
+      pnal_eth_xdp_map_ring (
+         xdp->xsk,
+         &offsets.fr,
+         XDP_UMEM_PGOFF_FILL_RING,
+         sizeof (uint64_t),
+         &xdp->fill) != 0 ||
+      pnal_eth_xdp_map_ring (
+         xdp->xsk,
+         &offsets.cr,
+         XDP_UMEM_PGOFF_COMPLETION_RING,
+         sizeof (uint64_t),
+         &xdp->comp) != 0 ||
+      pnal_eth_xdp_map_ring (
+         xdp->xsk,
+         &offsets.rx,
+         XDP_PGOFF_RX_RING,
+         sizeof (struct xdp_desc),
+         &xdp->rx) != 0 ||
+      pnal_eth_xdp_map_ring (
+         xdp->xsk,
+         &offsets.tx,
+         XDP_PGOFF_TX_RING,
+         sizeof (struct xdp_desc),
+         &xdp->tx) != 0)
+   {
+      return -1;
+   }
+
+   /* Hand all receive frames to the kernel */
+   fill_desc = xdp->fill.desc;
+   for (ix = 0; ix < PNAL_ETH_XDP_RING_SIZE; ix++)
+   {
+      fill_desc[ix] = (uint64_t)ix * PNAL_ETH_XDP_FRAME_SIZE;
+   }
+   __atomic_store_n (
+      xdp->fill.producer,
+      PNAL_ETH_XDP_RING_SIZE,
+      __ATOMIC_RELEASE);
+
+   for (ix = 0; ix < PNAL_ETH_XDP_RING_SIZE; ix++)
+   {
+      xdp->tx_free[ix] =
+         (uint64_t)(PNAL_ETH_XDP_RING_SIZE + ix) * PNAL_ETH_XDP_FRAME_SIZE;
+   }
+   xdp->tx_free_count = PNAL_ETH_XDP_RING_SIZE;
+
+   memset (&sxdp, 0, sizeof (sxdp));
+   sxdp.sxdp_family = AF_XDP;
+   sxdp.sxdp_ifindex = ifindex;
+   sxdp.sxdp_queue_id = PNAL_ETH_XDP_QUEUE_ID;
+   sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+   if (bind (xdp->xsk, (struct sockaddr *)&sxdp, sizeof (sxdp)) != 0)
+   {
+      sxdp.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+      if (bind (xdp->xsk, (struct sockaddr *)&sxdp, sizeof (sxdp)) != 0)
+      {
+         return -1;
+      }
+      LOG_INFO (
+         PF_PNAL_LOG,
+         "PNAL(%d): AF_XDP socket uses copy mode\n",
+         __LINE__);
+   }
+
+   return 0;
+}
+
+/**
+ * @internal
+ * Enable reception of the Profinet multicast frames, like the raw socket
+ * backend does.
+ *
+ * @param if_name          In:    Interface name
+ * @param receive_type     In:    Ethertype to receive
+ */
+static void pnal_eth_xdp_set_multicast (
+   const char * if_name,
+   pnal_ethertype_t receive_type)
+{
+   const uint8_t pn_mcast_addr[6] = {0x01, 0x0e, 0xcf, 0x00, 0x00, 0x00};
+   struct ifreq ifr;
+   int control_socket;
+
+   control_socket = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (control_socket < 0)
+   {
+      return;
+   }
+
+   memset (&ifr, 0, sizeof (ifr));
+   snprintf (ifr.ifr_name, sizeof (ifr.ifr_name), "%s", if_name);
+   if (ioctl (control_socket, SIOCGIFFLAGS, &ifr) == 0)
+   {
+      ifr.ifr_flags |= IFF_MULTICAST | IFF_BROADCAST;
+      if (receive_type == PNAL_ETHTYPE_ALL)
+      {
+         ifr.ifr_flags |= IFF_ALLMULTI; /* Receive all multicasts */
+      }
+      ioctl (control_socket, SIOCSIFFLAGS, &ifr);
+   }
+
+   memset (&ifr.ifr_hwaddr, 0, sizeof (ifr.ifr_hwaddr));
+   ifr.ifr_hwaddr.sa_family = AF_UNSPEC;
+   memcpy (ifr.ifr_hwaddr.sa_data, pn_mcast_addr, sizeof (pn_mcast_addr));
+   if (ioctl (control_socket, SIOCADDMULTI, &ifr) != 0 && errno != EEXIST)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to join Profinet multicast group\n",
+         __LINE__);
+   }
+
+   close (control_socket);
+}
+
+/**
+ * @internal
+ * Release all resources of an AF_XDP instance.
+ *
+ * Closing the link file descriptor detaches the XDP program.
+ *
+ * @param xdp              InOut: AF_XDP instance. Is freed.
+ */
+static void pnal_eth_xdp_close (pnal_eth_xdp_t * xdp)
+{
+   pnal_eth_xdp_ring_t * rings[] = {&xdp->fill, &xdp->comp, &xdp->rx, &xdp->tx};
+   size_t ix;
+
+   if (xdp->link_fd >= 0)
+   {
+      close (xdp->link_fd);
+   }
+   if (xdp->prog_fd >= 0)
+   {
+      close (xdp->prog_fd);
+   }
+   if (xdp->map_fd >= 0)
+   {
+      close (xdp->map_fd);
+   }
+   for (ix = 0; ix < sizeof (rings) / sizeof (rings[0]); ix++)
+   {
+      if (rings[ix]->map != NULL)
+      {
+         munmap (rings[ix]->map, rings[ix]->map_size);
+      }
+   }
+   if (xdp->xsk >= 0)
+   {
+      close (xdp->xsk);
+   }
+   if (xdp->umem != NULL)
+   {
+      munmap (xdp->umem, PNAL_ETH_XDP_NUM_FRAMES * PNAL_ETH_XDP_FRAME_SIZE);
+   }
+   if (xdp->tx_mutex != NULL)
+   {
+      os_mutex_destroy (xdp->tx_mutex);
+   }
+   free (xdp);
+}
+
+/**
+ * @internal
+ * Run a thread that receives frames from the AF_XDP socket.
+ *
+ * Each frame is copied from its UMEM frame to a pnal buffer, and the UMEM
+ * frame is given back to the kernel right away. This keeps the fill ring
+ * full even when the stack holds on to buffers.
+ *
+ * This is a function to be passed into os_thread_create()
+ * Do not change the argument types.
+ *
+ * @param thread_arg     InOut: Will be converted to pnal_eth_xdp_t
+ */
+static void pnal_eth_xdp_task (void * thread_arg)
+{
+   pnal_eth_xdp_t * xdp = thread_arg;
+   struct pollfd pfd = {.fd = xdp->xsk, .events = POLLIN};
+   const struct xdp_desc * rx_desc = xdp->rx.desc;
+   uint64_t * fill_desc = xdp->fill.desc;
+   uint32_t rx_consumer = *xdp->rx.consumer;
+   uint32_t fill_producer = *xdp->fill.producer;
+   uint32_t rx_producer;
+   struct xdp_desc desc;
+   int handled = 0;
+
+   pnal_buf_t * p = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
+   assert (p != NULL);
+
+   while (1)
+   {
+      rx_producer = __atomic_load_n (xdp->rx.producer, __ATOMIC_ACQUIRE);
+      if (rx_producer == rx_consumer)
+      {
+         if (xdp->busy_spin)
+         {
+            /* Let the kernel process the device queue, by busy polling
+             * it if enabled */
+            recvfrom (xdp->xsk, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+         }
+         else
+         {
+            poll (&pfd, 1, -1);
+         }
+         continue;
+      }
+
+      desc = rx_desc[rx_consumer & xdp->rx.mask];
+      p->len = (desc.len < PNAL_BUF_MAX_SIZE) ? desc.len : PNAL_BUF_MAX_SIZE;
+      memcpy (p->payload, xdp->umem + desc.addr, p->len);
+      if (xdp->timestamping)
+      {
+         /* No kernel timestamps for AF_XDP, use the time of pickup */
+         p->timestamp_ns = pnal_get_time_ns();
+      }
+
+      /* Recycle the UMEM frame */
+      rx_consumer++;
+      __atomic_store_n (xdp->rx.consumer, rx_consumer, __ATOMIC_RELEASE);
+      fill_desc[fill_producer & xdp->fill.mask] =
+         desc.addr & ~((uint64_t)PNAL_ETH_XDP_FRAME_SIZE - 1);
+      fill_producer++;
+      __atomic_store_n (xdp->fill.producer, fill_producer, __ATOMIC_RELEASE);
+
+      if (xdp->callback != NULL)
+      {
+         handled = xdp->callback (xdp->handle, xdp->arg, p);
+      }
+      else
+      {
+         handled = 0; /* Message not handled */
+      }
+
+      if (handled == 1)
+      {
+         p = pnal_buf_alloc (PNAL_BUF_MAX_SIZE);
+         assert (p != NULL);
+      }
+   }
+}
+
+pnal_eth_xdp_t * pnal_eth_xdp_init (
+   const char * if_name,
+   pnal_ethertype_t receive_type,
+   const pnal_cfg_t * pnal_cfg,
+   pnal_eth_handle_t * handle,
+   pnal_eth_callback_t * callback,
+   void * arg)
+{
+   pnal_eth_xdp_t * xdp;
+   union bpf_attr attr;
+   uint16_t ethertypes[2];
+   uint16_t nbr_of_types = 0;
+   uint32_t queue_id = PNAL_ETH_XDP_QUEUE_ID;
+   int ifindex;
+
+   ifindex = if_nametoindex (if_name);
+   if (ifindex == 0)
+   {
+      return NULL;
+   }
+
+   if (receive_type == PNAL_ETHTYPE_ALL || receive_type == PNAL_ETHTYPE_PROFINET)
+   {
+      ethertypes[nbr_of_types++] = PNAL_ETHTYPE_PROFINET;
+   }
+   if (receive_type == PNAL_ETHTYPE_ALL || receive_type == PNAL_ETHTYPE_LLDP)
+   {
+      ethertypes[nbr_of_types++] = PNAL_ETHTYPE_LLDP;
+   }
+   if (nbr_of_types == 0)
+   {
+      return NULL;
+   }
+
+   xdp = calloc (1, sizeof (pnal_eth_xdp_t));
+   if (xdp == NULL)
+   {
+      return NULL;
+   }
+   xdp->handle = handle;
+   xdp->callback = callback;
+   xdp->arg = arg;
+   xdp->xsk = -1;
+   xdp->map_fd = -1;
+   xdp->prog_fd = -1;
+   xdp->link_fd = -1;
+
+   xdp->tx_mutex = os_mutex_create();
+   if (xdp->tx_mutex == NULL)
+   {
+      goto error;
+   }
+
+   memset (&attr, 0, sizeof (attr));
+   attr.map_type = BPF_MAP_TYPE_XSKMAP;
+   attr.key_size = sizeof (uint32_t);
+   attr.value_size = sizeof (int);
+   attr.max_entries = PNAL_ETH_XDP_MAX_QUEUES;
+   strncpy (attr.map_name, "pnet_xsks", sizeof (attr.map_name) - 1);
+   xdp->map_fd = pnal_eth_xdp_bpf (BPF_MAP_CREATE, &attr);
+   if (xdp->map_fd < 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to create XSKMAP: %s\n",
+         __LINE__,
+         strerror (errno));
+      goto error;
+   }
+
+   xdp->prog_fd =
+      pnal_eth_xdp_load_program (xdp->map_fd, ethertypes, nbr_of_types);
+   if (xdp->prog_fd < 0)
+   {
+      goto error;
+   }
+
+   if (pnal_eth_xdp_open_socket (xdp, ifindex) != 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set up AF_XDP socket on %s: %s\n",
+         __LINE__,
+         if_name,
+         strerror (errno));
+      goto error;
+   }
+
+   memset (&attr, 0, sizeof (attr));
+   attr.map_fd = xdp->map_fd;
+   attr.key = (uint64_t)(uintptr_t)&queue_id;
+   attr.value = (uint64_t)(uintptr_t)&xdp->xsk;
+   if (pnal_eth_xdp_bpf (BPF_MAP_UPDATE_ELEM, &attr) != 0)
+   {
+      goto error;
+   }
+
+   pnal_eth_xdp_set_multicast (if_name, receive_type);
+   (void)pnal_recv_set_busy_poll (xdp->xsk, &pnal_cfg->eth_recv_thread);
+   xdp->busy_spin = pnal_cfg->eth_recv_thread.busy_spin;
+   xdp->timestamping = pnal_cfg->eth_timestamping != PNAL_TIMESTAMPING_OFF;
+
+   /* Attach in driver mode if supported, otherwise in generic mode */
+   memset (&attr, 0, sizeof (attr));
+   attr.link_create.prog_fd = xdp->prog_fd;
+   attr.link_create.target_ifindex = ifindex;
+   attr.link_create.attach_type = BPF_XDP;
+   attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+   xdp->link_fd = pnal_eth_xdp_bpf (BPF_LINK_CREATE, &attr);
+   if (xdp->link_fd < 0)
+   {
+      attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+      xdp->link_fd = pnal_eth_xdp_bpf (BPF_LINK_CREATE, &attr);
+   }
+   if (xdp->link_fd < 0)
+   {
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to attach XDP program to %s: %s\n",
+         __LINE__,
+         if_name,
+         strerror (errno));
+      goto error;
+   }
+
+   xdp->thread = os_thread_create (
+      "os_eth_xdp_task",
+      pnal_cfg->eth_recv_thread.prio,
+      pnal_cfg->eth_recv_thread.stack_size,
+      pnal_eth_xdp_task,
+      xdp);
+   if (xdp->thread == NULL)
+   {
+      goto error;
+   }
+   if (
+      os_thread_set_affinity (
+         xdp->thread,
+         pnal_cfg->eth_recv_thread.cpu_mask) != 0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set CPU affinity of receive thread\n",
+         __LINE__);
+   }
+
+   return xdp;
+
+error:
+   pnal_eth_xdp_close (xdp);
+   return NULL;
+}
+
+int pnal_eth_xdp_send (pnal_eth_xdp_t * xdp, pnal_buf_t * buf)
+{
+   struct xdp_desc * tx_desc = xdp->tx.desc;
+   const uint64_t * comp_desc = xdp->comp.desc;
+   uint32_t comp_consumer;
+   uint32_t comp_producer;
+   uint32_t tx_producer;
+   uint64_t addr;
+
+   if (buf->len > PNAL_ETH_XDP_FRAME_SIZE)
+   {
+      return -1;
+   }
+
+   os_mutex_lock (xdp->tx_mutex);
+
+   /* Take back the frames the kernel has finished sending */
+   comp_consumer = *xdp->comp.consumer;
+   comp_producer = __atomic_load_n (xdp->comp.producer, __ATOMIC_ACQUIRE);
+   while (comp_consumer != comp_producer)
+   {
+      xdp->tx_free[xdp->tx_free_count++] =
+         comp_desc[comp_consumer & xdp->comp.mask];
+      comp_consumer++;
+   }
+   __atomic_store_n (xdp->comp.consumer, comp_consumer, __ATOMIC_RELEASE);
+
+   if (xdp->tx_free_count == 0)
+   {
+      os_mutex_unlock (xdp->tx_mutex);
+      return -1;
+   }
+
+   addr = xdp->tx_free[--xdp->tx_free_count];
+   memcpy (xdp->umem + addr, buf->payload, buf->len);
+
+   tx_producer = *xdp->tx.producer;
+   tx_desc[tx_producer & xdp->tx.mask] =
+      (struct xdp_desc){.addr = addr, .len = buf->len};
+   __atomic_store_n (xdp->tx.producer, tx_producer + 1, __ATOMIC_RELEASE);
+
+   if (__atomic_load_n (xdp->tx.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)
+   {
+      /* EAGAIN and EBUSY only mean that the kernel is already sending */
+      sendto (xdp->xsk, NULL, 0, MSG_DONTWAIT, NULL, 0);
+   }
+
+   os_mutex_unlock (xdp->tx_mutex);
+
+   return buf->len;
+}
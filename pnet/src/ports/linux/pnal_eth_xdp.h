@@ -0,0 +1,81 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2018 rt-labs AB, Sweden.
+ *
+ * This software is dual-licensed under GPLv3 and a commercial
+ * license. See the file LICENSE.md distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+/**
+ * @file
+ * @brief AF_XDP backend for the Linux Ethernet functions
+ *
+ * Used by pnal_eth.c when built with PNAL_USE_AF_XDP. An XDP program
+ * redirects Profinet and LLDP frames (also when VLAN tagged) to an AF_XDP
+ * socket bound to receive queue 0 of the interface. All other frames are
+ * passed on to the kernel network stack.
+ *
+ * The NIC must deliver the Profinet frames on queue 0, for example by
+ * running "ethtool -L <interface> combined 1" or by adding a flow rule
+ * with "ethtool -N <interface> flow-type ether proto 0x8892 action 0".
+ */
+
+#ifndef PNAL_ETH_XDP_H
+#define PNAL_ETH_XDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pnal.h"
+
+typedef struct pnal_eth_xdp pnal_eth_xdp_t;
+
+/**
+ * Set up an AF_XDP socket and XDP program for an interface.
+ *
+ * Starts a receive thread configured by pnal_cfg->eth_recv_thread, which
+ * calls the callback for each received frame.
+ *
+ * @param if_name          In:    Interface name
+ * @param receive_type     In:    PNAL_ETHTYPE_ALL, PNAL_ETHTYPE_PROFINET
+ *                                or PNAL_ETHTYPE_LLDP
+ * @param pnal_cfg         In:    Operating system dependent configuration
+ * @param handle           In:    Handle passed to the callback
+ * @param callback         In:    Callback for received frames
+ * @param arg              In:    User argument passed to the callback
+ * @return the AF_XDP instance, or NULL if XDP is not available for the
+ *         interface
+ */
+pnal_eth_xdp_t * pnal_eth_xdp_init (
+   const char * if_name,
+   pnal_ethertype_t receive_type,
+   const pnal_cfg_t * pnal_cfg,
+   pnal_eth_handle_t * handle,
+   pnal_eth_callback_t * callback,
+   void * arg);
+
+/**
+ * Send a frame via the AF_XDP socket.
+ *
+ * The payload is copied to a UMEM frame, so the caller keeps the ownership
+ * of the buffer.
+ *
+ * @param xdp              InOut: AF_XDP instance
+ * @param buf              In:    Buffer with data to be sent
+ * @return The number of bytes sent, or -1 if an error occurred.
+ */
+int pnal_eth_xdp_send (pnal_eth_xdp_t * xdp, pnal_buf_t * buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PNAL_ETH_XDP_H */
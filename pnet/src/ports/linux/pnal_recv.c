@@ -0,0 +1,290 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2018 rt-labs AB, Sweden.
+ *
+ * This software is dual-licensed under GPLv3 and a commercial
+ * license. See the file LICENSE.md distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+/**
+ * @file
+ * @brief Common receive thread for raw Ethernet and UDP sockets
+ */
+
+#include "pnal_recv.h"
+
+#include "options.h"
+#include "osal.h"
+#include "osal_log.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Raw sockets for the management port and the physical ports, the DCE RPC
+ * server socket and the CControl session sockets */
+#define PNAL_RECV_MAX_SOCKETS 32
+#define PNAL_RECV_MAX_EVENTS  8
+
+/* Max number of frames the device driver processes per busy poll */
+#define PNAL_RECV_BUSY_POLL_BUDGET 16
+
+typedef struct pnal_recv_entry
+{
+   bool in_use;
+   uint32_t id;
+   uint32_t generation;
+   pnal_recv_callback_t * callback;
+   void * arg;
+} pnal_recv_entry_t;
+
+/* Entries are looked up by the index stored in the epoll event. The
+ * generation stored along with it detects events for entries that were
+ * removed, and possibly reused, while the event was pending. */
+static struct
+{
+   int epoll_fd;
+   int timeout_ms;
+   os_thread_t * thread;
+   os_mutex_t * mutex;
+   pnal_recv_entry_t entries[PNAL_RECV_MAX_SOCKETS];
+} pnal_recv = {.epoll_fd = -1};
+
+/**
+ * @internal
+ * Run the common receive thread.
+ *
+ * This is a function to be passed into os_thread_create()
+ * Do not change the argument types.
+ *
+ * @param thread_arg       InOut: Not used
+ */
+static void pnal_recv_task (void * thread_arg)
+{
+   struct epoll_event events[PNAL_RECV_MAX_EVENTS];
+   pnal_recv_entry_t * entry;
+   pnal_recv_callback_t * callback;
+   void * arg;
+   uint32_t id;
+   uint32_t ix;
+   int nbr_of_events;
+   int n;
+
+   while (1)
+   {
+      nbr_of_events = epoll_wait (
+         pnal_recv.epoll_fd,
+         events,
+         PNAL_RECV_MAX_EVENTS,
+         pnal_recv.timeout_ms);
+
+      for (n = 0; n < nbr_of_events; n++)
+      {
+         ix = (uint32_t)events[n].data.u64;
+         if (ix >= PNAL_RECV_MAX_SOCKETS)
+         {
+            continue;
+         }
+
+         os_mutex_lock (pnal_recv.mutex);
+         entry = &pnal_recv.entries[ix];
+         if (
+            !entry->in_use ||
+            entry->generation != (uint32_t)(events[n].data.u64 >> 32))
+         {
+            os_mutex_unlock (pnal_recv.mutex);
+            continue;
+         }
+         callback = entry->callback;
+         arg = entry->arg;
+         id = entry->id;
+         os_mutex_unlock (pnal_recv.mutex);
+
+         callback (id, arg);
+      }
+   }
+}
+
+int pnal_recv_init (const pnal_thread_cfg_t * thread_cfg)
+{
+   if (pnal_recv.thread != NULL)
+   {
+      return 0;
+   }
+
+   pnal_recv.mutex = os_mutex_create();
+   if (pnal_recv.mutex == NULL)
+   {
+      return -1;
+   }
+
+   /* Busy spinning polls the sockets without sleeping */
+   pnal_recv.timeout_ms = thread_cfg->busy_spin ? 0 : -1;
+
+   pnal_recv.epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+   if (pnal_recv.epoll_fd < 0)
+   {
+      os_mutex_destroy (pnal_recv.mutex);
+      pnal_recv.mutex = NULL;
+      return -1;
+   }
+
+   pnal_recv.thread = os_thread_create (
+      "p-net_recv",
+      thread_cfg->prio,
+      thread_cfg->stack_size,
+      pnal_recv_task,
+      NULL);
+   if (pnal_recv.thread == NULL)
+   {
+      close (pnal_recv.epoll_fd);
+      pnal_recv.epoll_fd = -1;
+      os_mutex_destroy (pnal_recv.mutex);
+      pnal_recv.mutex = NULL;
+      return -1;
+   }
+
+   if (os_thread_set_affinity (pnal_recv.thread, thread_cfg->cpu_mask) != 0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set CPU affinity of receive thread\n",
+         __LINE__);
+   }
+
+   return 0;
+}
+
+bool pnal_recv_is_running (void)
+{
+   return pnal_recv.thread != NULL;
+}
+
+int pnal_recv_add (uint32_t id, pnal_recv_callback_t * callback, void * arg)
+{
+   struct epoll_event event;
+   pnal_recv_entry_t * entry;
+   uint32_t ix;
+
+   if (pnal_recv.thread == NULL)
+   {
+      return -1;
+   }
+
+   os_mutex_lock (pnal_recv.mutex);
+   for (ix = 0; ix < PNAL_RECV_MAX_SOCKETS; ix++)
+   {
+      if (!pnal_recv.entries[ix].in_use)
+      {
+         break;
+      }
+   }
+   if (ix == PNAL_RECV_MAX_SOCKETS)
+   {
+      os_mutex_unlock (pnal_recv.mutex);
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Too many sockets for the receive thread\n",
+         __LINE__);
+      return -1;
+   }
+
+   entry = &pnal_recv.entries[ix];
+   entry->generation++;
+   entry->id = id;
+   entry->callback = callback;
+   entry->arg = arg;
+
+   memset (&event, 0, sizeof (event));
+   event.events = EPOLLIN;
+   event.data.u64 = ((uint64_t)entry->generation << 32) | ix;
+   if (epoll_ctl (pnal_recv.epoll_fd, EPOLL_CTL_ADD, id, &event) != 0)
+   {
+      os_mutex_unlock (pnal_recv.mutex);
+      LOG_ERROR (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to add socket %u to the receive thread: %s\n",
+         __LINE__,
+         (unsigned)id,
+         strerror (errno));
+      return -1;
+   }
+   entry->in_use = true;
+   os_mutex_unlock (pnal_recv.mutex);
+
+   return 0;
+}
+
+void pnal_recv_remove (uint32_t id)
+{
+   uint32_t ix;
+
+   if (pnal_recv.thread == NULL)
+   {
+      return;
+   }
+
+   os_mutex_lock (pnal_recv.mutex);
+   for (ix = 0; ix < PNAL_RECV_MAX_SOCKETS; ix++)
+   {
+      if (pnal_recv.entries[ix].in_use && pnal_recv.entries[ix].id == id)
+      {
+         epoll_ctl (pnal_recv.epoll_fd, EPOLL_CTL_DEL, id, NULL);
+         pnal_recv.entries[ix].in_use = false;
+         break;
+      }
+   }
+   os_mutex_unlock (pnal_recv.mutex);
+}
+
+int pnal_recv_set_busy_poll (int id, const pnal_thread_cfg_t * thread_cfg)
+{
+   const int busy_poll_us = thread_cfg->busy_poll_us;
+   const int prefer_busy_poll = 1;
+   const int budget = PNAL_RECV_BUSY_POLL_BUDGET;
+
+   if (busy_poll_us == 0)
+   {
+      return 0;
+   }
+
+   if (
+      setsockopt (
+         id,
+         SOL_SOCKET,
+         SO_BUSY_POLL,
+         &busy_poll_us,
+         sizeof (busy_poll_us)) != 0 ||
+      setsockopt (
+         id,
+         SOL_SOCKET,
+         SO_PREFER_BUSY_POLL,
+         &prefer_busy_poll,
+         sizeof (prefer_busy_poll)) != 0 ||
+      setsockopt (
+         id,
+         SOL_SOCKET,
+         SO_BUSY_POLL_BUDGET,
+         &budget,
+         sizeof (budget)) != 0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to enable busy polling: %s\n",
+         __LINE__,
+         strerror (errno));
+      return -1;
+   }
+
+   return 0;
+}
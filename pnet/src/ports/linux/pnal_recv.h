@@ -0,0 +1,98 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2018 rt-labs AB, Sweden.
+ *
+ * This software is dual-licensed under GPLv3 and a commercial
+ * license. See the file LICENSE.md distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+/**
+ * @file
+ * @brief Common receive thread for raw Ethernet and UDP sockets
+ *
+ * Used when pnal_cfg_t.single_recv_thread is set. One thread waits with
+ * epoll for all registered sockets and calls the callback of each socket
+ * that has data to read.
+ */
+
+#ifndef PNAL_RECV_H
+#define PNAL_RECV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pnal.h"
+
+#include <stdbool.h>
+
+/**
+ * Callback for a socket with data to read.
+ *
+ * Called from the receive thread. The callback must read at least one
+ * message from the socket, otherwise it is called again immediately.
+ *
+ * @param id               In:    Socket
+ * @param arg              InOut: User argument
+ */
+typedef void (pnal_recv_callback_t) (uint32_t id, void * arg);
+
+/**
+ * Start the receive thread, unless already started.
+ *
+ * @param thread_cfg       In:    Thread configuration
+ * @return 0 on success, -1 on error
+ */
+int pnal_recv_init (const pnal_thread_cfg_t * thread_cfg);
+
+/**
+ * Check whether the receive thread is running.
+ *
+ * @return true if pnal_recv_init() has succeeded
+ */
+bool pnal_recv_is_running (void);
+
+/**
+ * Let the receive thread service a socket.
+ *
+ * @param id               In:    Socket
+ * @param callback         In:    Callback for incoming data
+ * @param arg              In:    User argument passed to the callback
+ * @return 0 on success, -1 on error
+ */
+int pnal_recv_add (uint32_t id, pnal_recv_callback_t * callback, void * arg);
+
+/**
+ * Stop servicing a socket. Must be called before the socket is closed.
+ *
+ * The callback is not called for the socket after this function returns,
+ * unless it is already running.
+ *
+ * @param id               In:    Socket. Ignored if not added.
+ */
+void pnal_recv_remove (uint32_t id);
+
+/**
+ * Enable busy polling of the network device for a socket, if configured.
+ *
+ * Sets SO_BUSY_POLL, SO_PREFER_BUSY_POLL and SO_BUSY_POLL_BUDGET when
+ * thread_cfg->busy_poll_us is not 0. Requires CAP_NET_ADMIN.
+ *
+ * @param id               In:    Socket
+ * @param thread_cfg       In:    Receive thread configuration
+ * @return 0 on success or if not configured, -1 on error
+ */
+int pnal_recv_set_busy_poll (int id, const pnal_thread_cfg_t * thread_cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PNAL_RECV_H */
@@ -71,11 +71,25 @@ static void pnal_snmp_thread (void * arg)
 
 int pnal_snmp_init (struct pnet * pnet, const pnal_cfg_t * pnal_cfg)
 {
-   os_thread_create (
+   os_thread_t * thread;
+
+   thread = os_thread_create (
       "pn_snmp",
       pnal_cfg->snmp_thread.prio,
       pnal_cfg->snmp_thread.stack_size,
       pnal_snmp_thread,
       pnet);
+   if (thread == NULL)
+   {
+      return -1;
+   }
+
+   if (os_thread_set_affinity (thread, pnal_cfg->snmp_thread.cpu_mask) != 0)
+   {
+      LOG_WARNING (
+         PF_PNAL_LOG,
+         "PNAL(%d): Failed to set CPU affinity of SNMP thread\n",
+         __LINE__);
+   }
    return 0;
 }
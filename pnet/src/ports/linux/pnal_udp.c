@@ -15,6 +15,7 @@
 
 #include "pnal.h"
 #include "pf_includes.h"
+#include "pnal_recv.h"
 
 #include <string.h>
 #include <unistd.h>
@@ -106,7 +107,16 @@ int pnal_udp_recvfrom (
    return len;
 }
 
+int pnal_udp_set_recv_callback (
+   uint32_t id,
+   pnal_udp_callback_t * callback,
+   void * arg)
+{
+   return pnal_recv_add (id, callback, arg);
+}
+
 void pnal_udp_close (uint32_t id)
 {
+   pnal_recv_remove (id);
    close (id);
 }
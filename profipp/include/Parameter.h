@@ -15,6 +15,13 @@ class Parameter final
 public:
     using SetCallbackType = std::function<bool(const uint8_t* buffer, std::size_t numBytes)>;
     using GetCallbackType = std::function<bool(uint8_t* buffer, std::size_t numBytes)>;
+    /**
+     * @brief Receives a part of a large record written by the PLC. offset is the position of the part in the record,
+     * totalLength the length of the record. A part with offset 0 starts a new record, and the record is complete
+     * when offset + numBytes equals totalLength. Return false to reject the record.
+     */
+    using WriteChunkCallbackType = std::function<bool(std::size_t offset, std::size_t totalLength,
+        const uint8_t* buffer, std::size_t numBytes)>;
     static const SetCallbackType emptySetCallback;
     static const GetCallbackType emptyGetCallback;
 
@@ -25,6 +32,16 @@ public:
     const GetCallbackType& GetGetCallback() const;
     std::size_t GetLengthInBytes() const;
 
+    /**
+     * @brief If set, records which the PLC sends in several frames, e.g. tables of many kB, are passed to this
+     * callback frame by frame as they arrive, instead of to the set callback. Their length is then neither limited
+     * by the buffers of the stack, nor are they held in memory as a whole. Without it, the stack collects such records,
+     * up to PNET_MAX_SESSION_BUFFER_SIZE, and they are written like any other record. The parts are passed on the
+     * thread of the stack, also for asynchronous parameters, and are not stored for persistent parameters.
+     */
+    void SetWriteChunkCallback(const WriteChunkCallbackType& writeChunkCallback_);
+    const WriteChunkCallbackType& GetWriteChunkCallback() const;
+
 public:
     ParameterProperties properties;
 private:
@@ -32,6 +49,7 @@ private:
     const uint16_t idx;
     SetCallbackType setCallback;
     GetCallbackType getCallback; 
+    WriteChunkCallbackType writeChunkCallback{};
     std::size_t lengthInBytes;
 };
 }
@@ -26,6 +26,20 @@ namespace profinet
         std::string defaultValue{"0"};
         // set to length for strings. Keep empty for non-strings.
         std::string length{""};
+        /**
+         * @brief If true, the set and get callbacks run on a record worker thread, and the PLC gets the response when
+         * they return. Use this for callbacks which take long, e.g. since they access a file or a bus, such that they
+         * neither delay other records nor the cyclic data exchange. The callbacks of one parameter never run
+         * concurrently, but those of different parameters might.
+         */
+        bool asynchronous{false};
+        /**
+         * @brief If true, the values written by the PLC are stored in a file in ProfinetProperties::pathStorageDirectory,
+         * and passed to the set callback when profipp is initialized the next time, within the transaction callbacks
+         * of the submodule. The PLC then need not send the parameter again before the device is operational. Values written in a batch are only stored if the batch is
+         * committed. Records passed to a write chunk callback, see Parameter::SetWriteChunkCallback(), are not stored.
+         */
+        bool persistent{false};
     };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef PROCESSIMAGE_H
+#define PROCESSIMAGE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Layout of the process image which profipp publishes in a POSIX shared-memory segment,
+ * if ProfinetProperties::processImageShmName is set.
+ *
+ * The segment starts with a Header, followed by one SubslotEntry per submodule (ordered by slot and subslot),
+ * followed by the data. All offsets are relative to the start of the segment.
+ * The image is protected by a sequence lock: the writer increments Header::sequence before and after each update,
+ * such that it is odd while the image changes. A reader copies what it needs between two reads of the sequence,
+ * and retries if the sequence was odd or has changed. The writer never waits for readers.
+ */
+namespace processimage
+{
+inline constexpr uint32_t magic{0x49505050}; // "PPPI"
+inline constexpr uint32_t version{1};
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    uint32_t connected;     // 1 while a controller exchanges cyclic data with the device
+    uint64_t cycleCounter;  // Incremented with every published cycle
+    uint64_t timestampNs;   // CLOCK_REALTIME when the last cycle was published
+    uint32_t numSubslots;
+    uint32_t imageSize;     // Bytes of the segment used by the image. The segment itself only grows.
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The sequence lock requires lock-free atomics");
+
+struct SubslotEntry
+{
+    uint32_t api;
+    uint16_t slot;
+    uint16_t subslot;
+    uint32_t inputOffset;   // Data received from the controller
+    uint32_t inputLength;
+    uint32_t outputOffset;  // Data sent to the controller
+    uint32_t outputLength;
+    uint8_t inputIops;      // Provider status of the controller for the input data, see pnet_ioxs_values
+    uint8_t outputIocs;     // Consumer status of the controller for the output data
+    uint8_t reserved[2];
+};
+}
+
+/**
+ * @brief Reads the process image published by profipp from another process.
+ */
+class ProcessImageReader final
+{
+public:
+    ProcessImageReader();
+    ~ProcessImageReader();
+
+    ProcessImageReader(const ProcessImageReader&) = delete;
+    ProcessImageReader& operator=(const ProcessImageReader&) = delete;
+
+    /**
+     * @brief Opens the shared-memory segment with the given name, e.g. "/profipp". Fails if profipp did not create it yet.
+     */
+    bool Open(const std::string& name);
+    void Close();
+
+    /**
+     * @brief Copies a consistent snapshot of the whole process image into snapshot.
+     * Returns false if not open, or if no consistent snapshot was obtained in maxRetries attempts.
+     */
+    bool Read(std::vector<uint8_t>& snapshot, unsigned int maxRetries = 1000);
+
+    /**
+     * @brief For reading in place, without copying the whole image: call BeginRead(), read from GetImage(),
+     * and only use what was read if EndRead() returns true. Otherwise the writer updated the image meanwhile, and the
+     * read has to be repeated.
+     */
+    uint32_t BeginRead();
+    bool EndRead(uint32_t sequence) const;
+    const uint8_t* GetImage() const;
+
+    static const processimage::Header* GetHeader(const uint8_t* image);
+    static const processimage::SubslotEntry* GetSubslots(const uint8_t* image);
+
+private:
+    bool Remap(std::size_t size);
+
+    int fd{-1};
+    const uint8_t* image{nullptr};
+    std::size_t mappedSize{0};
+};
+}
+#endif
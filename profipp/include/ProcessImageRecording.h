@@ -0,0 +1,126 @@
+#ifndef PROCESSIMAGERECORDING_H
+#define PROCESSIMAGERECORDING_H
+
+#pragma once
+
+#include "Device.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Layout of the recording file which profipp writes if ProfinetProperties::processImageRecordFile is set.
+ *
+ * The file is preallocated and memory-mapped. It starts with a FileHeader, followed by one SubslotEntry per submodule
+ * (ordered by slot and subslot), followed by numRecords records of recordSize bytes each, starting at headerSize.
+ * Every cycle of the cyclic data exchange is stored in one record, and the records form a ring: the record with
+ * sequence number n is stored at position n % numRecords. Each record starts with a RecordHeader, followed by the
+ * IOPS and IOCS of every subslot, followed by the data. The data offsets in SubslotEntry are relative to the start of
+ * the record.
+ *
+ * The writer clears RecordHeader::sequence before it overwrites a record, and sets it to the sequence number plus one
+ * once the record is complete. Records which were being written when the process stopped are thus detected and
+ * skipped. Since the file is shared memory of the page cache, the records survive a crash of the process.
+ */
+namespace recording
+{
+inline constexpr uint32_t magic{0x43525050}; // "PPRC"
+inline constexpr uint32_t version{1};
+
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;    // Offset of the first record
+    uint32_t recordSize;
+    uint32_t numRecords;
+    uint32_t numSubslots;
+    uint32_t cycleTimeUs;   // Nominal time between two records
+    uint32_t reserved;
+    std::atomic<uint64_t> nextSequence; // Sequence number of the next record to be written
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The recording requires lock-free atomics");
+
+struct SubslotEntry
+{
+    uint32_t api;
+    uint16_t slot;
+    uint16_t subslot;
+    uint32_t moduleId;
+    uint32_t submoduleId;
+    uint32_t inputOffset;   // Data received from the controller
+    uint32_t inputLength;
+    uint32_t outputOffset;  // Data sent to the controller
+    uint32_t outputLength;
+};
+
+struct RecordHeader
+{
+    std::atomic<uint64_t> sequence; // Sequence number plus one, 0 while the record is written
+    uint64_t timestampNs;           // CLOCK_REALTIME when the cycle was recorded
+    uint16_t ppmCycle;              // Cycle counter of the last frame sent to the controller
+    uint16_t cpmCycle;              // Cycle counter of the last frame received from the controller
+    uint32_t reserved;
+    // Followed by numSubslots pairs of input IOPS and output IOCS, see pnet_ioxs_values.
+};
+}
+
+/**
+ * @brief Reads a recording of the process image offline, or while profipp is still writing it.
+ */
+class ProcessImageRecording final
+{
+public:
+    struct Cycle
+    {
+        uint64_t sequence;
+        uint64_t timestampNs;
+        uint16_t ppmCycle;
+        uint16_t cpmCycle;
+        // The complete record, including the RecordHeader. Use GetInput(), GetOutput() etc. to access it.
+        const uint8_t* record;
+    };
+    using CycleCallbackType = std::function<void(const Cycle& cycle)>;
+
+    ProcessImageRecording();
+    ~ProcessImageRecording();
+
+    ProcessImageRecording(const ProcessImageRecording&) = delete;
+    ProcessImageRecording& operator=(const ProcessImageRecording&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const recording::FileHeader* GetHeader() const;
+    const recording::SubslotEntry* GetSubslots() const;
+
+    /**
+     * @brief Calls callback for every complete record, from the oldest to the newest. Returns the number of records.
+     */
+    std::size_t ForEachCycle(const CycleCallbackType& callback) const;
+
+    const uint8_t* GetInput(const Cycle& cycle, std::size_t subslotIx) const;
+    const uint8_t* GetOutput(const Cycle& cycle, std::size_t subslotIx) const;
+    uint8_t GetInputIops(const Cycle& cycle, std::size_t subslotIx) const;
+    uint8_t GetOutputIocs(const Cycle& cycle, std::size_t subslotIx) const;
+
+    /**
+     * @brief Writes the recording as CSV, one line per cycle. The inputs and outputs are decoded according to their
+     * data types in the given device configuration, which should be the configuration the recording was made with.
+     * The data of submodules not found in the configuration is written as hexadecimal bytes.
+     */
+    bool Decode(const Device& device, std::ostream& stream) const;
+
+private:
+    int fd{-1};
+    const uint8_t* file{nullptr};
+    std::size_t mappedSize{0};
+};
+}
+#endif
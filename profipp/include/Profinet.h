@@ -6,6 +6,8 @@
 #include "ProfinetProperties.h"
 #include "Device.h"
 #include "logging.h"
+#include <cstdint>
+#include <functional>
 #include <map>
 
 namespace profinet
@@ -14,6 +16,64 @@ class ProfinetControl
 {
 public:
     virtual bool Start() = 0;
+    /**
+     * @brief Changes the level up to which messages are passed to the logger, see ProfinetProperties::logLevel.
+     */
+    virtual void SetLogLevel(LogLevel logLevel) = 0;
+
+    enum class JobPriority
+    {
+        high,
+        normal,
+        low
+    };
+    /**
+     * @brief Work to be done in the background. Returns whether it succeeded.
+     */
+    using BackgroundJobType = std::function<bool()>;
+    using BackgroundJobDoneType = std::function<void(bool success)>;
+    /**
+     * @brief Runs job on the background worker thread of the stack, which also saves the data of the stack to
+     * files. Use it for work which must not run on the cyclic thread or in the callbacks, e.g. file access. Jobs with
+     * higher priority run first, and jobs with the same priority in the order they were submitted. done, if set, is
+     * called on the same thread after the job.
+     *
+     * If key is not 0 and a job with the same key is queued but has not started yet, job is dropped, and done is
+     * called when the queued job has run. Use it for jobs which bring something up to date, such that a burst of
+     * submissions runs the job once. Keys with the most significant bit set are reserved.
+     *
+     * Returns false if the stack is not initialized, the key is reserved, or the queue is full, see PNET_MAX_BG_JOBS.
+     */
+    virtual bool SubmitBackgroundJob(JobPriority priority, uint32_t key, const BackgroundJobType& job,
+        const BackgroundJobDoneType& done) = 0;
+
+    /**
+     * @brief Statistics of time intervals in nanoseconds. The average is sumNs / count.
+     */
+    struct IntervalStatistics
+    {
+        uint32_t count{0};
+        uint32_t minNs{0};
+        uint32_t maxNs{0};
+        uint64_t sumNs{0};
+    };
+    struct CyclicTiming
+    {
+        uint16_t frameId{0};
+        bool isInput{false}; // Input CR (sent by the device), or output CR
+        // Output CR: from the reception of a frame until its data is read. Input CR: from writing the data until
+        // the frame is sent.
+        IntervalStatistics latency{};
+        // Deviation of the time between two frames from the cycle time.
+        IntervalStatistics jitter{};
+    };
+    /**
+     * @brief Reads the latency and jitter statistics of the IO communication relation iocrIndex (0 and up) of the
+     * current connection to the controller, and restarts them if reset is set. Requires
+     * ProfinetProperties::ethTimestamping, otherwise the counts stay 0. Returns false if not connected or if there
+     * is no such IO communication relation.
+     */
+    virtual bool GetCyclicTiming(uint16_t iocrIndex, bool reset, CyclicTiming& timing) = 0;
 };
 
 class Profinet final
@@ -4,6 +4,8 @@
 #pragma once
 
 
+#include "logging.h"
+
 #include <string>
 #include <vector>
 // header provides typedefs like uint32_t
@@ -19,17 +21,165 @@ namespace profinet
         size_t  ethThreadStacksize{4096}; /* bytes */
         uint32_t  bgWorkerThreadPriority{5};
         size_t  bgWorkerThreadStacksize{4096}; /* bytes */
+        uint32_t  linkMonitorThreadPriority{5};
+        size_t  linkMonitorThreadStacksize{4096}; /* bytes */
 
         // TODO: refactor
         uint32_t cycleTimerPriority{30};
         uint32_t cycleWorkerPriority{15};
         uint32_t cycleTimeUs = 1000; // 1ms
 
+        /**
+         * @brief CPU affinity of the threads above. Bit n set allows the thread to run on CPU n,
+         * 0 (default) lets the operating system choose.
+         * Recommended layout on a 4-core system, with CPUs 2 and 3 isolated from the scheduler
+         * (e.g. isolcpus=2,3 nohz_full=2,3 rcu_nocbs=2,3 on the kernel command line) and the application on CPUs 0 and 1:
+         * ethThreadCpuMask and cycleWorkerCpuMask on CPU 3 (0x8), which keeps the data of the
+         * real-time path in one cache, cycleTimerCpuMask on CPU 2 (0x4) and the SNMP and background worker threads,
+         * which do blocking file and network I/O, as well as the link monitor thread, on the application CPUs (0x3).
+         * Also move IRQs of the network interface to CPU 3, see /proc/irq/<n>/smp_affinity.
+         */
+        uint32_t snmpThreadCpuMask{0};
+        uint32_t ethThreadCpuMask{0};
+        uint32_t bgWorkerThreadCpuMask{0};
+        uint32_t linkMonitorThreadCpuMask{0};
+        uint32_t cycleTimerCpuMask{0};
+        uint32_t cycleWorkerCpuMask{0};
+
+        /**
+         * @brief Low-latency receive modes of the Ethernet thread, for devices with a CPU dedicated to it.
+         * ethThreadBusyPollUs > 0 busy polls the network device for up to this many microseconds while waiting
+         * for frames (SO_BUSY_POLL), instead of waiting for the interrupt. ethThreadBusySpin never lets the thread
+         * sleep. Both cut the latency and jitter of frame reception by tens of microseconds, at the cost of CPU time.
+         * With ethThreadBusySpin, set ethThreadCpuMask to an isolated CPU, since the thread takes all of it.
+         */
+        uint32_t ethThreadBusyPollUs{0};
+        bool ethThreadBusySpin{false};
+
+        /**
+         * @brief If true, one thread with the settings of the Ethernet thread services the raw sockets of all
+         * network interfaces as well as the UDP sockets for RPC, instead of one thread per interface and polling
+         * of the UDP sockets in the stack cycle. Fewer threads and context switches, and RPC requests are handled
+         * when they arrive. Cyclic frames wait while an RPC request is handled, though.
+         * The thread then also runs the RPC handling of the stack and all callbacks of the application, e.g. the set
+         * and get callbacks of the parameters, so its stack is raised to at least minSingleReceiveThreadStacksize.
+         * Raise ethThreadStacksize beyond that if the callbacks of the application need more than a few kB.
+         * The callbacks never run concurrently with the cyclic data exchange, which holds the lock of the stack.
+         */
+        bool singleReceiveThread{false};
+        static constexpr size_t minSingleReceiveThreadStacksize{64 * 1024}; /* bytes */
+
+        enum class EthTimestamping
+        {
+            off,
+            software, // taken by the kernel
+            hardware // taken by the network interface, falls back to software if not supported
+        };
+        /**
+         * @brief Timestamping of sent and received Ethernet frames. Enables the latency and jitter statistics of
+         * the cyclic data, see ProfinetControl::GetCyclicTiming(). Costs a few microseconds per frame.
+         * Hardware timestamps require the clock of the network interface to be synchronized to the system clock.
+         */
+        EthTimestamping ethTimestamping{EthTimestamping::off};
+
+        /**
+         * @brief Socket priority (SO_PRIORITY) of the sent Ethernet frames, 0 keeps the default of the system.
+         * 6 matches the VLAN priority of the cyclic frames and puts them ahead of other traffic of the host in the
+         * default qdisc. Map it to a separate hardware queue with mqprio for full separation from bulk traffic.
+         */
+        uint32_t ethPriority{6};
+
+        /**
+         * @brief If > 0, cyclic frames are launched this many microseconds after their scheduled send time by an
+         * ETF qdisc (SO_TXTIME), which removes the jitter of the sending thread. Requires an ETF qdisc with clockid
+         * CLOCK_TAI on the queue of ethPriority, otherwise the frames are dropped.
+         */
+        uint32_t ethTxtimeDelayUs{0};
+
+        /**
+         * @brief If not empty, the name of a POSIX shared-memory segment, e.g. "/profipp", in which the process image is
+         * published every cycle: the data received from and sent to the controller of every subslot, with IOPS/IOCS and
+         * a cycle counter. Other processes read consistent snapshots with ProcessImageReader, see ProcessImage.h.
+         */
+        std::string processImageShmName{""};
+
+        /**
+         * @brief If not empty, the path of a file in which the process image of every cycle is recorded for post-mortem
+         * analysis: the data of every subslot, IOPS/IOCS, a timestamp and the cycle counters of the last frames.
+         * The file is preallocated and memory-mapped, and it is a ring holding the last processImageRecordDurationMs.
+         * It is sized at initialization for the configured modules, each plugged once. If the PLC plugs modules with
+         * more data, the ring holds fewer cycles.
+         * Decode it with ProcessImageRecording, see ProcessImageRecording.h.
+         */
+        std::string processImageRecordFile{""};
+        uint32_t processImageRecordDurationMs{10000};
+
+        /**
+         * @brief Messages with a higher level are dropped before they are formatted, and never reach the logger.
+         * Also applies to the messages of p-net if asyncLogging is enabled. Can be changed at runtime with
+         * ProfinetControl::SetLogLevel(). Set to logDebug for a logger which should receive debug messages.
+         * Levels above PROFIPP_MAX_LOG_LEVEL, configured with CMake, are removed from profipp at compile time.
+         */
+        LogLevel logLevel{logInfo};
+
+        /**
+         * @brief If true, messages are not formatted on the logging thread. Only the format string, the arguments and
+         * a timestamp are stored in a lock-free buffer of the thread, and a drain thread formats them and passes them
+         * to the logger, prefixed with the timestamp. Also the messages of p-net are routed to the logger then.
+         * Keeps logging, even at debug level, from delaying the cyclic data exchange.
+         * asyncLogBufferBytes is the size of the buffer of each logging thread. Messages are dropped if it is full.
+         */
+        bool asyncLogging{false};
+        uint32_t asyncLogBufferBytes{64 * 1024};
+
+        /**
+         * @brief Number of threads running the callbacks of asynchronous parameters, see
+         * ParameterProperties::asynchronous. The threads have normal priority. If 0, the callbacks of all parameters
+         * run on the thread of the stack.
+         */
+        uint32_t recordWorkerThreads{1};
+
+        /**
+         * @brief If true, the stack is not woken up every cycleTimeUs, but sleeps until the next timeout
+         * of the profinet stack or, if connected, the next cyclic data exchange is due.
+         * Reduces CPU wakeups when idle and improves timer precision.
+         */
+        bool tickless{false};
+        /**
+         * @brief Only used if tickless is true. Longest time the stack sleeps while not connected to a controller.
+         * Bounds the reaction time to connect requests, which are polled.
+         */
+        uint32_t maxIdleSleepUs{10000}; // 10ms
+
+        /**
+         * @brief Real-time memory mode. Locks all current and future memory of the process with mlockall()
+         * before the stack creates its threads, such that their stacks are locked and populated,
+         * stops malloc from returning memory to the operating system, prefaults stackPrefaultBytes of the
+         * cycle timer and worker stacks and presizes all buffers of the cyclic data exchange when the controller
+         * finishes parametrization (PRMEND). Afterwards, the cyclic data exchange of profipp does not allocate or page-fault.
+         * If profipp is built with PROFIPP_CHECK_CYCLIC_ALLOCATIONS and without NDEBUG,
+         * heap allocations during the cyclic data exchange trigger an assert.
+         * Requires CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK.
+         */
+        bool realtimeMemory{false};
+        /**
+         * @brief Only used if realtimeMemory is true. Number of bytes of the cycle timer and worker thread stacks
+         * which are touched when the threads start.
+         */
+        size_t stackPrefaultBytes{64 * 1024}; /* bytes */
+
         /**
          * @brief Directory to persistantly store data. Empty string means current directory.
          * 
          */
         std::string pathStorageDirectory{""}; // current directory
+
+        /**
+         * @brief Size of the file profipp_parameters.bin in pathStorageDirectory, which keeps the values of persistent
+         * parameters, see ParameterProperties::persistent. The file is a journal, and it is rewritten with only the
+         * current values when it is full. The file is only created if a parameter is persistent.
+         */
+        size_t parameterStoreBytes{64 * 1024}; /* bytes */
         
         /* Name of the main network interface used for communication with the PLC. Typically eth0. */
         std::string mainNetworkInterface{"eth0"};
@@ -129,9 +129,30 @@ public:
     class Parameters : public tools::MapView<uint16_t, Parameter>
     {
     public:
+        /**
+         * @brief Called before the PLC writes several parameters of the submodule as a batch: the parameterization
+         * when connecting, which ends with PRMEND, and every write multiple request. The set callbacks of the written
+         * parameters follow, and then the end transaction callback. Only called if the batch writes a parameter of
+         * the submodule. A write multiple request within the parameterization is part of its batch.
+         */
+        using BeginTransactionCallbackType = std::function<void()>;
+        /**
+         * @brief Called after the batch. If commit is true, validate and apply the values set since the begin at once,
+         * and return false to reject them. If commit is false, a write failed or the connection was aborted, and the
+         * values should be discarded. A failed write multiple request within the parameterization ends the batch of
+         * the submodules it wrote to in this way, while the other submodules stay in the batch of the
+         * parameterization.
+         */
+        using EndTransactionCallbackType = std::function<bool(bool commit)>;
+
         Parameters() : tools::MapView<uint16_t, Parameter>{}
         {
         }
+        void SetTransactionCallbacks(const BeginTransactionCallbackType& beginTransactionCallback_,
+            const EndTransactionCallbackType& endTransactionCallback_);
+        void ClearTransactionCallbacks();
+        const BeginTransactionCallbackType& GetBeginTransactionCallback() const;
+        const EndTransactionCallbackType& GetEndTransactionCallback() const;
         Parameter* Create(uint16_t parameterIdx, const Parameter::SetCallbackType& setCallback_, const Parameter::GetCallbackType& getCallback_, std::size_t lengthInBytes);
         template<typename T, std::size_t lengthInBytes=sizeof(T)> Parameter* Create(
             uint16_t parameterIdx, 
@@ -192,6 +213,10 @@ public:
             }
             return retVal;
         }
+
+    private:
+        BeginTransactionCallbackType beginTransactionCallback{};
+        EndTransactionCallbackType endTransactionCallback{};
     } parameters;
 
     SubmoduleProperties properties;
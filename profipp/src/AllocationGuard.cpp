@@ -0,0 +1,63 @@
+#include "AllocationGuard.h"
+
+#if defined(PROFIPP_CHECK_CYCLIC_ALLOCATIONS) && !defined(NDEBUG)
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+   thread_local bool allocationForbidden{false};
+
+   void* CheckedAllocate(std::size_t size)
+   {
+      assert(!allocationForbidden && "Heap allocation on the cyclic thread during steady state.");
+      void* ptr = std::malloc(size == 0 ? 1 : size);
+      if(!ptr)
+         throw std::bad_alloc();
+      return ptr;
+   }
+}
+
+namespace profinet
+{
+namespace tools
+{
+CyclicAllocationGuard::CyclicAllocationGuard(bool enable) : previous{allocationForbidden}
+{
+   allocationForbidden = previous || enable;
+}
+CyclicAllocationGuard::~CyclicAllocationGuard()
+{
+   allocationForbidden = previous;
+}
+AllocationGuardSuspend::AllocationGuardSuspend() : previous{allocationForbidden}
+{
+   allocationForbidden = false;
+}
+AllocationGuardSuspend::~AllocationGuardSuspend()
+{
+   allocationForbidden = previous;
+}
+}
+}
+
+// Replacements of the global allocation functions. The nothrow, array and sized delete
+// variants of the standard library forward to these.
+void* operator new(std::size_t size)
+{
+   return CheckedAllocate(size);
+}
+void* operator new[](std::size_t size)
+{
+   return CheckedAllocate(size);
+}
+void operator delete(void* ptr) noexcept
+{
+   std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+   std::free(ptr);
+}
+#endif
@@ -0,0 +1,52 @@
+#ifndef ALLOCATIONGUARD_H
+#define ALLOCATIONGUARD_H
+
+#pragma once
+
+namespace profinet
+{
+namespace tools
+{
+/**
+ * @brief Debug aid for the real-time mode. While a CyclicAllocationGuard exists on a thread,
+ * every allocation with operator new on that thread triggers an assert.
+ * Only active if profipp is configured with PROFIPP_CHECK_CYCLIC_ALLOCATIONS and built without NDEBUG,
+ * otherwise the guards do nothing.
+ */
+#if defined(PROFIPP_CHECK_CYCLIC_ALLOCATIONS) && !defined(NDEBUG)
+class CyclicAllocationGuard
+{
+public:
+    CyclicAllocationGuard(bool enable = true);
+    ~CyclicAllocationGuard();
+    CyclicAllocationGuard(const CyclicAllocationGuard&) = delete;
+    CyclicAllocationGuard& operator=(const CyclicAllocationGuard&) = delete;
+private:
+    bool previous;
+};
+/**
+ * @brief Allows allocations again while it exists, e.g. for logging errors.
+ */
+class AllocationGuardSuspend
+{
+public:
+    AllocationGuardSuspend();
+    ~AllocationGuardSuspend();
+    AllocationGuardSuspend(const AllocationGuardSuspend&) = delete;
+    AllocationGuardSuspend& operator=(const AllocationGuardSuspend&) = delete;
+private:
+    bool previous;
+};
+#else
+class CyclicAllocationGuard
+{
+public:
+    CyclicAllocationGuard(bool enable = true) {}
+};
+class AllocationGuardSuspend
+{
+};
+#endif
+}
+}
+#endif // ALLOCATIONGUARD_H
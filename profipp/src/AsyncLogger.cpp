@@ -0,0 +1,670 @@
+#include "AsyncLogger.h"
+#include "AllocationGuard.h"
+#include "osal_log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+
+namespace profinet
+{
+namespace
+{
+// Upper limit for the size of a single message in a ring, including the copied strings. Longer strings are truncated.
+constexpr std::size_t maxMessageBytes{1024};
+constexpr std::size_t minBufferBytes{4096};
+constexpr auto drainInterval{std::chrono::milliseconds{10}};
+constexpr uint32_t paddingLevel{0xFFFFFFFF};
+
+std::atomic<uint64_t> nextLoggerId{1};
+
+enum class ArgType
+{
+    none,
+    percent,
+    integer,
+    longInteger,
+    longLongInteger,
+    sizeType,
+    maxInteger,
+    pointerDifference,
+    floating,
+    longFloating,
+    string,
+    wideString,
+    pointer,
+    count
+};
+
+struct Spec
+{
+    const char* begin;  // '%' of the conversion specification
+    const char* end;
+    int stars;          // Number of '*' for width and precision, each taking an int argument
+    bool starPrecision; // The precision is the last of the '*' arguments
+    int precision;      // Given as digits, or -1 if none or given by '*'
+    ArgType type;
+};
+
+/**
+ * @brief Finds the next conversion specification in format. Returns false if there is none, then spec.begin
+ * points to the end of the string. Both the producer and the drain thread parse the format string with this
+ * function, so the arguments are stored without type tags.
+ */
+bool NextSpec(const char* format, Spec& spec)
+{
+    const char* p{format};
+    while(*p && *p != '%')
+        p++;
+    spec.begin = p;
+    spec.end = p;
+    spec.stars = 0;
+    spec.starPrecision = false;
+    spec.precision = -1;
+    spec.type = ArgType::none;
+    if(!*p)
+        return false;
+    p++;
+    if(*p == '%')
+    {
+        spec.end = p + 1;
+        spec.type = ArgType::percent;
+        return true;
+    }
+    while(*p && std::strchr("-+ #0'", *p))
+        p++;
+    if(*p == '*')
+    {
+        spec.stars++;
+        p++;
+    }
+    while(std::isdigit(static_cast<unsigned char>(*p)))
+        p++;
+    if(*p == '.')
+    {
+        p++;
+        if(*p == '*')
+        {
+            spec.stars++;
+            spec.starPrecision = true;
+            p++;
+        }
+        else
+        {
+            spec.precision = 0;
+            while(std::isdigit(static_cast<unsigned char>(*p)))
+                spec.precision = std::min(spec.precision * 10 + (*p++ - '0'), 0xFFFF);
+        }
+    }
+    char length{0};
+    bool doubled{false};
+    if(*p && std::strchr("hljztL", *p))
+    {
+        length = *p++;
+        if((length == 'h' || length == 'l') && *p == length)
+        {
+            doubled = true;
+            p++;
+        }
+    }
+    const char conversion{*p};
+    if(*p)
+        p++;
+    spec.end = p;
+    switch(conversion)
+    {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        if(length == 'l')
+            spec.type = doubled ? ArgType::longLongInteger : (conversion == 'c' ? ArgType::integer : ArgType::longInteger);
+        else if(length == 'j')
+            spec.type = ArgType::maxInteger;
+        else if(length == 'z')
+            spec.type = ArgType::sizeType;
+        else if(length == 't')
+            spec.type = ArgType::pointerDifference;
+        else
+            spec.type = ArgType::integer;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec.type = length == 'L' ? ArgType::longFloating : ArgType::floating;
+        break;
+    case 's':
+        spec.type = length == 'l' ? ArgType::wideString : ArgType::string;
+        break;
+    case 'p':
+        spec.type = ArgType::pointer;
+        break;
+    case 'n':
+        spec.type = ArgType::count;
+        break;
+    default:
+        spec.type = ArgType::none;
+        break;
+    }
+    return true;
+}
+
+struct RecordHeader
+{
+    uint32_t size;      // Of the whole record, a multiple of 8
+    uint32_t level;     // LogLevel, or paddingLevel for the unused end of the ring
+    uint64_t timestampNs;
+    const char* format;
+};
+
+constexpr std::size_t Align(std::size_t size)
+{
+    return (size + 7) & ~std::size_t{7};
+}
+
+class Writer
+{
+public:
+    Writer(uint8_t* buffer_, std::size_t capacity_) : buffer{buffer_}, capacity{capacity_}
+    {
+    }
+    void Put(const void* data, std::size_t length)
+    {
+        if(size + Align(length) > capacity)
+        {
+            overflow = true;
+            return;
+        }
+        std::memcpy(buffer + size, data, length);
+        size += Align(length);
+    }
+    template<typename T> void Put(T value)
+    {
+        Put(&value, sizeof(value));
+    }
+    // A string with a precision need not be terminated, as with %.*s, and is not read beyond the precision.
+    void PutString(const char* string, int precision = -1)
+    {
+        if(!string)
+            string = "(null)";
+        // Always leave room for the remaining arguments, and truncate long strings.
+        std::size_t available{capacity > size + 64 ? capacity - size - 64 : 0};
+        if(precision >= 0)
+            available = std::min(available, static_cast<std::size_t>(precision));
+        uint32_t length{static_cast<uint32_t>(strnlen(string, available))};
+        Put(length);
+        Put(string, length);
+    }
+    std::size_t size{sizeof(RecordHeader)};
+    bool overflow{false};
+private:
+    uint8_t* buffer;
+    std::size_t capacity;
+};
+
+class Reader
+{
+public:
+    Reader(const uint8_t* data_, std::size_t size_) : data{data_}, size{size_}
+    {
+    }
+    template<typename T> T Get()
+    {
+        T value{};
+        if(offset + sizeof(T) <= size)
+            std::memcpy(&value, data + offset, sizeof(T));
+        offset += Align(sizeof(T));
+        return value;
+    }
+    std::string GetString()
+    {
+        uint32_t length{Get<uint32_t>()};
+        if(offset + length > size)
+            length = offset < size ? static_cast<uint32_t>(size - offset) : 0;
+        std::string string(reinterpret_cast<const char*>(data + offset), length);
+        offset += Align(length);
+        return string;
+    }
+private:
+    const uint8_t* data;
+    std::size_t size;
+    std::size_t offset{0};
+};
+
+template<typename... T> void AppendFormatted(std::string& text, const char* spec, T... values)
+{
+    char buffer[256];
+    int length{snprintf(buffer, sizeof(buffer), spec, values...)};
+    if(length < 0)
+        return;
+    if(static_cast<std::size_t>(length) < sizeof(buffer))
+    {
+        text.append(buffer, static_cast<std::size_t>(length));
+        return;
+    }
+    const std::size_t oldSize{text.size()};
+    text.resize(oldSize + static_cast<std::size_t>(length) + 1);
+    snprintf(&text[oldSize], static_cast<std::size_t>(length) + 1, spec, values...);
+    text.resize(oldSize + static_cast<std::size_t>(length));
+}
+
+template<typename T> void AppendValue(std::string& text, const char* spec, int stars, const int* starValues, T value)
+{
+    if(stars == 0)
+        AppendFormatted(text, spec, value);
+    else if(stars == 1)
+        AppendFormatted(text, spec, starValues[0], value);
+    else
+        AppendFormatted(text, spec, starValues[0], starValues[1], value);
+}
+}
+
+class AsyncLogger::Ring
+{
+public:
+    explicit Ring(std::size_t capacity) : buffer(capacity)
+    {
+    }
+
+    // Only called by the thread owning the ring.
+    bool Push(const uint8_t* record, std::size_t size)
+    {
+        const uint64_t writePosition{head.load(std::memory_order_relaxed)};
+        const std::size_t offset{static_cast<std::size_t>(writePosition % buffer.size())};
+        const std::size_t padding{buffer.size() - offset < size ? buffer.size() - offset : 0};
+        if(writePosition + padding + size - tail.load(std::memory_order_acquire) > buffer.size())
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if(padding > 0)
+        {
+            // Too little space for a header is skipped by the drain thread without one.
+            if(padding >= sizeof(RecordHeader))
+            {
+                RecordHeader header{static_cast<uint32_t>(padding), paddingLevel, 0, nullptr};
+                std::memcpy(buffer.data() + offset, &header, sizeof(header));
+            }
+            std::memcpy(buffer.data(), record, size);
+        }
+        else
+            std::memcpy(buffer.data() + offset, record, size);
+        head.store(writePosition + padding + size, std::memory_order_release);
+        return true;
+    }
+
+    // Only called by the drain thread. Returns nullptr if the ring is empty.
+    const RecordHeader* Peek()
+    {
+        while(true)
+        {
+            const uint64_t readPosition{tail.load(std::memory_order_relaxed)};
+            if(readPosition == head.load(std::memory_order_acquire))
+                return nullptr;
+            const std::size_t offset{static_cast<std::size_t>(readPosition % buffer.size())};
+            if(buffer.size() - offset < sizeof(RecordHeader))
+            {
+                tail.store(readPosition + buffer.size() - offset, std::memory_order_release);
+                continue;
+            }
+            auto header{reinterpret_cast<const RecordHeader*>(buffer.data() + offset)};
+            if(header->level != paddingLevel)
+                return header;
+            tail.store(readPosition + header->size, std::memory_order_release);
+        }
+    }
+
+    void Pop()
+    {
+        const uint64_t readPosition{tail.load(std::memory_order_relaxed)};
+        auto header{reinterpret_cast<const RecordHeader*>(buffer.data() + readPosition % buffer.size())};
+        tail.store(readPosition + header->size, std::memory_order_release);
+    }
+
+    std::atomic<uint32_t> dropped{0};
+    // Set when the owning thread exits. The drain thread then releases the ring once it is empty.
+    std::atomic<bool> orphaned{false};
+
+private:
+    std::vector<uint8_t> buffer;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+};
+
+std::atomic<AsyncLogger*> AsyncLogger::osLogTarget{nullptr};
+std::atomic<int> AsyncLogger::osLogUsers{0};
+
+AsyncLogger::AsyncLogger(LoggerType sink_, std::size_t bufferBytesPerThread)
+    : sink{std::move(sink_)},
+      bufferBytes{Align(std::max(bufferBytesPerThread, minBufferBytes))},
+      id{nextLoggerId.fetch_add(1)}
+{
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    AsyncLogger* self{this};
+    if(osLogTarget.compare_exchange_strong(self, nullptr))
+    {
+        os_log_set_function(nullptr);
+        // Threads which took the target before it was cleared may still be logging to it.
+        while(osLogUsers.load() != 0)
+            std::this_thread::yield();
+    }
+    stop.store(true);
+    if(drainThread.joinable())
+        drainThread.join();
+    while(DrainOnce())
+    {
+    }
+}
+
+bool AsyncLogger::Start()
+{
+    if(drainThread.joinable())
+        return true;
+    drainThread = std::thread(&AsyncLogger::Drain, this);
+    // Formatting and I/O must never compete with the real-time threads, even if started from one of them.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(drainThread.native_handle(), SCHED_OTHER, &parameters);
+    return true;
+}
+
+void AsyncLogger::RouteOsLog()
+{
+    osLogTarget.store(this);
+    os_log_set_function(&AsyncLogger::LogOs);
+}
+
+void AsyncLogger::SetLogLevel(LogLevel logLevel)
+{
+    osLogLevel.store(logLevel, std::memory_order_relaxed);
+}
+
+void AsyncLogger::LogOs(uint8_t type, const char* format, va_list args)
+{
+    // Counted before the target is taken, such that the destructor of the target can wait for the thread.
+    struct UserCount
+    {
+        UserCount()
+        {
+            osLogUsers.fetch_add(1);
+        }
+        ~UserCount()
+        {
+            osLogUsers.fetch_sub(1);
+        }
+    } userCount;
+    AsyncLogger* logger{osLogTarget.load()};
+    if(!logger)
+        return;
+    LogLevel level;
+    switch(LOG_LEVEL_GET(type))
+    {
+    case LOG_LEVEL_DEBUG:
+        level = logDebug;
+        break;
+    case LOG_LEVEL_INFO:
+        level = logInfo;
+        break;
+    case LOG_LEVEL_WARNING:
+        level = logWarning;
+        break;
+    case LOG_LEVEL_ERROR:
+        level = logError;
+        break;
+    default:
+        level = logFatal;
+        break;
+    }
+    if(level <= logger->osLogLevel.load(std::memory_order_relaxed))
+        logger->Log(level, format, args);
+}
+
+AsyncLogger::Ring* AsyncLogger::GetThreadRing()
+{
+    static thread_local struct ThreadRingHolder
+    {
+        ~ThreadRingHolder()
+        {
+            if(ring)
+                ring->orphaned.store(true, std::memory_order_release);
+        }
+        uint64_t owner{0};
+        std::shared_ptr<Ring> ring{};
+    } threadRing;
+
+    if(threadRing.owner != id)
+    {
+        // Only the first message of a thread allocates its ring.
+        tools::AllocationGuardSuspend allocationGuardSuspend;
+        if(threadRing.ring)
+            threadRing.ring->orphaned.store(true, std::memory_order_release);
+        threadRing.ring = std::make_shared<Ring>(bufferBytes);
+        threadRing.owner = id;
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        rings.push_back(threadRing.ring);
+    }
+    return threadRing.ring.get();
+}
+
+void AsyncLogger::Log(LogLevel logLevel, const char* format, va_list args) noexcept
+{
+    if(!format)
+        return;
+    alignas(8) uint8_t record[maxMessageBytes];
+    Writer writer{record, std::min(maxMessageBytes, bufferBytes / 2)};
+    const char* position{format};
+    Spec spec;
+    while(NextSpec(position, spec))
+    {
+        position = spec.end;
+        int precision{spec.precision};
+        for(int star = 0; star < spec.stars; star++)
+        {
+            const int value{va_arg(args, int)};
+            writer.Put<int64_t>(value);
+            if(spec.starPrecision && star == spec.stars - 1)
+                precision = value;
+        }
+        switch(spec.type)
+        {
+        case ArgType::integer:
+            writer.Put<int64_t>(va_arg(args, int));
+            break;
+        case ArgType::longInteger:
+            writer.Put<int64_t>(va_arg(args, long));
+            break;
+        case ArgType::longLongInteger:
+            writer.Put<int64_t>(va_arg(args, long long));
+            break;
+        case ArgType::sizeType:
+            writer.Put<int64_t>(static_cast<int64_t>(va_arg(args, std::size_t)));
+            break;
+        case ArgType::maxInteger:
+            writer.Put<int64_t>(va_arg(args, intmax_t));
+            break;
+        case ArgType::pointerDifference:
+            writer.Put<int64_t>(va_arg(args, std::ptrdiff_t));
+            break;
+        case ArgType::floating:
+            writer.Put<double>(va_arg(args, double));
+            break;
+        case ArgType::longFloating:
+            writer.Put<long double>(va_arg(args, long double));
+            break;
+        case ArgType::string:
+            writer.PutString(va_arg(args, const char*), precision);
+            break;
+        case ArgType::wideString:
+        case ArgType::pointer:
+        case ArgType::count:
+            writer.Put<const void*>(va_arg(args, const void*));
+            break;
+        case ArgType::none:
+        case ArgType::percent:
+            break;
+        }
+    }
+    if(writer.overflow)
+    {
+        // Keep the message, but without its arguments.
+        writer.size = sizeof(RecordHeader);
+        writer.overflow = false;
+        writer.PutString(format);
+        format = "%s (arguments too long, dropped)";
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    RecordHeader header{static_cast<uint32_t>(writer.size), static_cast<uint32_t>(logLevel),
+        static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec), format};
+    std::memcpy(record, &header, sizeof(header));
+    GetThreadRing()->Push(record, writer.size);
+}
+
+void AsyncLogger::Format(const void* record, std::string& text) const
+{
+    const RecordHeader& header{*static_cast<const RecordHeader*>(record)};
+    Reader reader{reinterpret_cast<const uint8_t*>(&header) + sizeof(RecordHeader), header.size - sizeof(RecordHeader)};
+
+    const time_t seconds{static_cast<time_t>(header.timestampNs / 1000000000)};
+    struct tm timestruct;
+    localtime_r(&seconds, &timestruct);
+    char timestamp[32];
+    std::size_t length{strftime(timestamp, sizeof(timestamp), "[%H:%M:%S", &timestruct)};
+    snprintf(timestamp + length, sizeof(timestamp) - length, ".%06u] ",
+        static_cast<unsigned>(header.timestampNs % 1000000000 / 1000));
+    text.assign(timestamp);
+
+    const char* position{header.format};
+    Spec spec;
+    while(NextSpec(position, spec))
+    {
+        text.append(position, spec.begin);
+        position = spec.end;
+        char specBuffer[32];
+        const std::size_t specLength{static_cast<std::size_t>(spec.end - spec.begin)};
+        if(spec.type == ArgType::percent)
+        {
+            text.push_back('%');
+            continue;
+        }
+        if(specLength >= sizeof(specBuffer) || spec.type == ArgType::none)
+        {
+            text.append(spec.begin, spec.end);
+            continue;
+        }
+        std::memcpy(specBuffer, spec.begin, specLength);
+        specBuffer[specLength] = '\0';
+        int starValues[2]{0, 0};
+        for(int star = 0; star < spec.stars; star++)
+            starValues[star] = static_cast<int>(reader.Get<int64_t>());
+        switch(spec.type)
+        {
+        case ArgType::integer:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<int>(reader.Get<int64_t>()));
+            break;
+        case ArgType::longInteger:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<long>(reader.Get<int64_t>()));
+            break;
+        case ArgType::longLongInteger:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<long long>(reader.Get<int64_t>()));
+            break;
+        case ArgType::sizeType:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<std::size_t>(reader.Get<int64_t>()));
+            break;
+        case ArgType::maxInteger:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<intmax_t>(reader.Get<int64_t>()));
+            break;
+        case ArgType::pointerDifference:
+            AppendValue(text, specBuffer, spec.stars, starValues, static_cast<std::ptrdiff_t>(reader.Get<int64_t>()));
+            break;
+        case ArgType::floating:
+            AppendValue(text, specBuffer, spec.stars, starValues, reader.Get<double>());
+            break;
+        case ArgType::longFloating:
+            AppendValue(text, specBuffer, spec.stars, starValues, reader.Get<long double>());
+            break;
+        case ArgType::string:
+            AppendValue(text, specBuffer, spec.stars, starValues, reader.GetString().c_str());
+            break;
+        case ArgType::pointer:
+            AppendValue(text, specBuffer, spec.stars, starValues, reader.Get<const void*>());
+            break;
+        case ArgType::wideString:
+            reader.Get<const void*>();
+            text.append("(wide string)");
+            break;
+        case ArgType::count:
+            reader.Get<const void*>();
+            break;
+        case ArgType::none:
+        case ArgType::percent:
+            break;
+        }
+    }
+    text.append(position);
+    while(!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+        text.pop_back();
+}
+
+bool AsyncLogger::DrainOnce()
+{
+    std::vector<std::shared_ptr<Ring>> currentRings;
+    {
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        currentRings = rings;
+    }
+    std::string text;
+    bool drained{false};
+    while(true)
+    {
+        // Pass the messages of all threads in the order of their timestamps.
+        Ring* oldestRing{nullptr};
+        const RecordHeader* oldest{nullptr};
+        for(auto& ring : currentRings)
+        {
+            const RecordHeader* header{ring->Peek()};
+            if(header && (!oldest || header->timestampNs < oldest->timestampNs))
+            {
+                oldest = header;
+                oldestRing = ring.get();
+            }
+        }
+        if(!oldest)
+            break;
+        Format(oldest, text);
+        const LogLevel level{static_cast<LogLevel>(oldest->level)};
+        oldestRing->Pop();
+        if(sink)
+            sink(level, text);
+        drained = true;
+    }
+    for(auto& ring : currentRings)
+    {
+        uint32_t dropped{ring->dropped.exchange(0, std::memory_order_relaxed)};
+        if(dropped > 0 && sink)
+            sink(logWarning, "Log buffer of a thread was full, dropped " + std::to_string(dropped) + " messages.");
+    }
+    {
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<Ring>& ring)
+            {
+                return ring->orphaned.load(std::memory_order_acquire) && !ring->Peek();
+            }), rings.end());
+    }
+    return drained;
+}
+
+void AsyncLogger::Drain()
+{
+    while(!stop.load(std::memory_order_relaxed))
+    {
+        if(!DrainOnce())
+            std::this_thread::sleep_for(drainInterval);
+    }
+}
+}
@@ -0,0 +1,73 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#pragma once
+
+#include "logging.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Logs without formatting on the calling thread. Log() only stores a timestamp, the pointer to the format
+ * string and the binary arguments in a lock-free ring of the calling thread. A drain thread with normal priority
+ * formats the messages in the order of their timestamps, and passes them to the LoggerType.
+ *
+ * The format strings must be string literals, since they are only read when the message is formatted. Strings
+ * passed for %s are copied. If a ring is full, messages are dropped and the number of dropped messages is logged
+ * later. Messages still in the rings are lost if the process crashes.
+ */
+class AsyncLogger final
+{
+public:
+    AsyncLogger(LoggerType sink, std::size_t bufferBytesPerThread);
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    bool Start();
+
+    void Log(LogLevel logLevel, const char* format, va_list args) noexcept;
+
+    /**
+     * @brief Routes the LOG_* macros of p-net (os_log) into this logger, until it is destroyed.
+     */
+    void RouteOsLog();
+
+    /**
+     * @brief Messages of p-net with a higher level are dropped. The messages passed to Log() are not filtered.
+     */
+    void SetLogLevel(LogLevel logLevel);
+
+private:
+    class Ring;
+
+    Ring* GetThreadRing();
+    void Drain();
+    bool DrainOnce();
+    void Format(const void* record, std::string& text) const;
+    static void LogOs(uint8_t type, const char* format, va_list args);
+
+    LoggerType sink;
+    const std::size_t bufferBytes;
+    const uint64_t id;
+    std::mutex ringsMutex{};
+    std::vector<std::shared_ptr<Ring>> rings{};
+    std::atomic<bool> stop{false};
+    std::atomic<LogLevel> osLogLevel{logDebug};
+    std::thread drainThread{};
+
+    static std::atomic<AsyncLogger*> osLogTarget;
+    // Number of threads in LogOs().
+    static std::atomic<int> osLogUsers;
+};
+}
+#endif
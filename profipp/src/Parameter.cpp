@@ -33,5 +33,13 @@ std::size_t Parameter::GetLengthInBytes() const
 { 
     return lengthInBytes; 
 }
+void Parameter::SetWriteChunkCallback(const WriteChunkCallbackType& writeChunkCallback_)
+{
+    writeChunkCallback = writeChunkCallback_;
+}
+const Parameter::WriteChunkCallbackType& Parameter::GetWriteChunkCallback() const
+{
+    return writeChunkCallback;
+}
 
 }
\ No newline at end of file
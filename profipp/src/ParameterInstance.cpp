@@ -1,7 +1,7 @@
 #include "ParameterInstance.h"
 namespace profinet
 {
-ParameterInstance::ParameterInstance() : unknownParameter{true}, initialized{false}, lengthInBytes{0}, valueBuffer(new uint8_t[0]{})
+ParameterInstance::ParameterInstance() : unknownParameter{true}, initialized{false}, asynchronous{false}, persistent{false}, lengthInBytes{0}, valueBuffer(new uint8_t[0]{})
 {
 }
 
@@ -10,6 +10,8 @@ bool ParameterInstance::Initialize(const Parameter* parameterConfiguration_)
     if(parameterConfiguration_)
     {
         lengthInBytes = parameterConfiguration_->GetLengthInBytes();
+        asynchronous = parameterConfiguration_->properties.asynchronous;
+        persistent = parameterConfiguration_->properties.persistent;
 
         const Parameter::GetCallbackType& getCallbackTmp{parameterConfiguration_->GetGetCallback()};
         const Parameter::SetCallbackType& setCallbackTmp{parameterConfiguration_->GetSetCallback()};
@@ -31,14 +33,19 @@ bool ParameterInstance::Initialize(const Parameter* parameterConfiguration_)
             setCallback = Parameter::emptySetCallback;
         }
 
+        writeChunkCallback = parameterConfiguration_->GetWriteChunkCallback();
+
         unknownParameter = false;
     }
     else
     {
         lengthInBytes = 0;
+        asynchronous = false;
+        persistent = false;
 
         getCallback = Parameter::emptyGetCallback;
         setCallback = Parameter::emptySetCallback;
+        writeChunkCallback = nullptr;
 
         unknownParameter = true;
     }
@@ -55,6 +62,16 @@ ParameterInstance::~ParameterInstance()
     valueBuffer = nullptr;
 }
 
+bool ParameterInstance::IsAsynchronous() const
+{
+    return asynchronous;
+}
+
+bool ParameterInstance::IsPersistent() const
+{
+    return persistent;
+}
+
 bool ParameterInstance::Set(const uint8_t* buffer, std::size_t numBytes)
 {
     if(numBytes < lengthInBytes)
@@ -71,4 +88,14 @@ bool ParameterInstance::Get(uint8_t** buffer, std::size_t* numBytes)
     *numBytes = lengthInBytes;
     return true;
 }
+bool ParameterInstance::SetChunk(std::size_t offset, std::size_t totalLength, const uint8_t* buffer, std::size_t numBytes)
+{
+    if(!writeChunkCallback)
+        return false;
+    return writeChunkCallback(offset, totalLength, buffer, numBytes);
+}
+bool ParameterInstance::HasWriteChunkCallback() const
+{
+    return static_cast<bool>(writeChunkCallback);
+}
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #pragma once
 #include "Parameter.h"
 
+#include <vector>
+
 namespace profinet
 {
 class ParameterInstance final
@@ -20,15 +22,36 @@ public:
 
     bool Set(const uint8_t* buffer, std::size_t numBytes);
     bool Get(uint8_t** buffer, std::size_t* numBytes);
+    /**
+     * @brief Writes a part of a record which the PLC sends in several frames to the write chunk callback of the
+     * parameter.
+     */
+    bool SetChunk(std::size_t offset, std::size_t totalLength, const uint8_t* buffer, std::size_t numBytes);
+    /**
+     * @brief True if records sent in several frames are passed on in parts, see Parameter::SetWriteChunkCallback().
+     */
+    bool HasWriteChunkCallback() const;
 
     bool Initialize(const Parameter* parameterConfiguration_);
 
+    /**
+     * @brief True if the callbacks must run on a record worker thread, see ParameterProperties::asynchronous.
+     */
+    bool IsAsynchronous() const;
+    /**
+     * @brief True if the values written must be stored, see ParameterProperties::persistent.
+     */
+    bool IsPersistent() const;
+
 private:
     bool unknownParameter;
     bool initialized;
+    bool asynchronous;
+    bool persistent;
 
     Parameter::GetCallbackType getCallback;
     Parameter::SetCallbackType setCallback;
+    Parameter::WriteChunkCallbackType writeChunkCallback;
 
     size_t lengthInBytes;
 
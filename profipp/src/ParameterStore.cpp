@@ -0,0 +1,306 @@
+#include "ParameterStore.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+namespace profinet
+{
+bool ParameterStore::Key::operator<(const Key& other) const
+{
+   return std::tie(moduleId, submoduleId, idx) < std::tie(other.moduleId, other.submoduleId, other.idx);
+}
+
+ParameterStore::ParameterStore()
+{
+}
+
+ParameterStore::~ParameterStore()
+{
+   Close();
+}
+
+uint32_t ParameterStore::Crc(uint32_t crc, const void* data, std::size_t numBytes)
+{
+   // CRC-32 as used by Ethernet, reflected polynomial 0xEDB88320.
+   static const auto table{[]()
+   {
+      std::array<uint32_t, 256> entries{};
+      for(uint32_t i = 0; i < entries.size(); i++)
+      {
+         uint32_t value{i};
+         for(int bit = 0; bit < 8; bit++)
+            value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+         entries[i] = value;
+      }
+      return entries;
+   }()};
+   auto bytes{static_cast<const uint8_t*>(data)};
+   crc = ~crc;
+   for(std::size_t i = 0; i < numBytes; i++)
+      crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+   return ~crc;
+}
+
+uint32_t ParameterStore::EntryCrc(const EntryHeader& entry, const uint8_t* value)
+{
+   constexpr std::size_t keyOffset{offsetof(EntryHeader, moduleId)};
+   uint32_t crc{Crc(0, &entry.length, sizeof(entry.length))};
+   crc = Crc(crc, reinterpret_cast<const uint8_t*>(&entry) + keyOffset, sizeof(EntryHeader) - keyOffset);
+   return Crc(crc, value, entry.length);
+}
+
+std::size_t ParameterStore::EntrySize(std::size_t length)
+{
+   return (sizeof(EntryHeader) + length + 7) & ~std::size_t{7};
+}
+
+bool ParameterStore::IsOpen() const
+{
+   // Not the mapping, which the thread of the store replaces when compacting.
+   return thread.joinable();
+}
+
+void ParameterStore::Unmap()
+{
+   // Called on errors, which the caller reports with errno.
+   const int error{errno};
+   if(file)
+      munmap(file, mappedSize);
+   file = nullptr;
+   mappedSize = 0;
+   writePos = 0;
+   if(fd >= 0)
+      close(fd);
+   fd = -1;
+   errno = error;
+}
+
+bool ParameterStore::MapExisting()
+{
+   fd = open(path.c_str(), O_RDWR);
+   if(fd < 0)
+      return false;
+   struct stat status;
+   if(fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(FileHeader))
+   {
+      Unmap();
+      return false;
+   }
+   void* mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(mapping == MAP_FAILED)
+   {
+      Unmap();
+      return false;
+   }
+   file = static_cast<uint8_t*>(mapping);
+   mappedSize = static_cast<std::size_t>(status.st_size);
+   FileHeader header;
+   std::memcpy(&header, file, sizeof(header));
+   if(header.magic != magic || header.version != version || header.headerSize != sizeof(FileHeader))
+   {
+      Unmap();
+      return false;
+   }
+   writePos = ScanJournal(nullptr);
+   // Remove what is left of a torn entry, such that it does not follow the next entry appended.
+   std::memset(file + writePos, 0, mappedSize - writePos);
+   return true;
+}
+
+std::size_t ParameterStore::ScanJournal(std::map<Key, std::vector<uint8_t>>* entries) const
+{
+   std::size_t pos{sizeof(FileHeader)};
+   while(pos + sizeof(EntryHeader) <= mappedSize)
+   {
+      EntryHeader entry;
+      std::memcpy(&entry, file + pos, sizeof(entry));
+      if(entry.length == 0 || EntrySize(entry.length) > mappedSize - pos)
+         break;
+      const uint8_t* value{file + pos + sizeof(EntryHeader)};
+      if(EntryCrc(entry, value) != entry.crc)
+         break;
+      if(entries)
+         (*entries)[Key{entry.moduleId, entry.submoduleId, entry.idx}].assign(value, value + entry.length);
+      pos += EntrySize(entry.length);
+   }
+   return pos;
+}
+
+bool ParameterStore::Create(const std::string& filePath, std::size_t size)
+{
+   fd = open(filePath.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+   if(fd < 0)
+      return false;
+   // Allocate all blocks now. A full disk must not raise SIGBUS when appending later.
+   if(const int error{posix_fallocate(fd, 0, static_cast<off_t>(size))}; error != 0)
+   {
+      errno = error;
+      Unmap();
+      return false;
+   }
+   void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(mapping == MAP_FAILED)
+   {
+      Unmap();
+      return false;
+   }
+   file = static_cast<uint8_t*>(mapping);
+   mappedSize = size;
+   const FileHeader header{magic, version, sizeof(FileHeader), 0};
+   std::memcpy(file, &header, sizeof(header));
+   writePos = sizeof(FileHeader);
+   return true;
+}
+
+bool ParameterStore::Open(const std::string& path_, std::size_t journalBytes_)
+{
+   Close();
+   path = path_;
+   journalBytes = std::max(journalBytes_, sizeof(FileHeader) + EntrySize(0));
+   std::map<Key, std::vector<uint8_t>> entries{};
+   if(MapExisting())
+   {
+      ScanJournal(&entries);
+   }
+   else
+   {
+      struct stat status;
+      if(stat(path.c_str(), &status) == 0)
+         std::rename(path.c_str(), (path + ".prev").c_str());
+      if(!Create(path, journalBytes) || msync(file, mappedSize, MS_SYNC) != 0)
+      {
+         Unmap();
+         return false;
+      }
+   }
+   {
+      std::lock_guard lock{mutex};
+      values = std::move(entries);
+      pending.clear();
+      stop = false;
+   }
+   thread = std::thread{&ParameterStore::Run, this};
+   return true;
+}
+
+void ParameterStore::Close()
+{
+   if(thread.joinable())
+   {
+      {
+         std::lock_guard lock{mutex};
+         stop = true;
+      }
+      condition.notify_one();
+      thread.join();
+   }
+   Unmap();
+}
+
+bool ParameterStore::Load(const Key& key, std::vector<uint8_t>& value) const
+{
+   std::lock_guard lock{mutex};
+   auto it{values.find(key)};
+   if(it == values.end())
+      return false;
+   value = it->second;
+   return true;
+}
+
+void ParameterStore::Store(const Key& key, const uint8_t* data, std::size_t numBytes)
+{
+   if(!IsOpen() || numBytes == 0)
+      return;
+   {
+      std::lock_guard lock{mutex};
+      values[key].assign(data, data + numBytes);
+      pending[key].assign(data, data + numBytes);
+   }
+   condition.notify_one();
+}
+
+bool ParameterStore::Append(const Key& key, const std::vector<uint8_t>& value)
+{
+   if(!file || value.empty() || EntrySize(value.size()) > mappedSize - writePos)
+      return false;
+   EntryHeader entry{static_cast<uint32_t>(value.size()), 0, key.moduleId, key.submoduleId, key.idx, 0, 0};
+   entry.crc = EntryCrc(entry, value.data());
+   std::memcpy(file + writePos + sizeof(EntryHeader), value.data(), value.size());
+   std::memcpy(file + writePos, &entry, sizeof(entry));
+   writePos += EntrySize(value.size());
+   return true;
+}
+
+bool ParameterStore::Compact()
+{
+   std::map<Key, std::vector<uint8_t>> snapshot{};
+   {
+      std::lock_guard lock{mutex};
+      snapshot = values;
+   }
+   std::size_t needed{sizeof(FileHeader)};
+   for(const auto& [key, value] : snapshot)
+      needed += EntrySize(value.size());
+   // Leave room for further writes, such that compacting stays rare.
+   const std::size_t size{std::max(journalBytes, 2 * needed)};
+
+   // The current file stays valid until the new one replaces it.
+   const std::string tempPath{path + ".tmp"};
+   Unmap();
+   bool success{Create(tempPath, size)};
+   for(const auto& [key, value] : snapshot)
+   {
+      if(success && !value.empty())
+         success = Append(key, value);
+   }
+   success = success && msync(file, mappedSize, MS_SYNC) == 0
+      && std::rename(tempPath.c_str(), path.c_str()) == 0;
+   if(!success)
+   {
+      Unmap();
+      std::remove(tempPath.c_str());
+      MapExisting();
+   }
+   return success;
+}
+
+void ParameterStore::Run()
+{
+   std::unique_lock lock{mutex};
+   for(;;)
+   {
+      condition.wait(lock, [this](){return stop || !pending.empty();});
+      if(!stop)
+         condition.wait_for(lock, coalesceTime, [this](){return stop;});
+      auto batch{std::move(pending)};
+      pending.clear();
+      lock.unlock();
+
+      bool compacted{false};
+      for(const auto& [key, value] : batch)
+      {
+         // Compacting writes all values, including the rest of the batch.
+         if(!Append(key, value))
+         {
+            compacted = Compact();
+            break;
+         }
+      }
+      if(!compacted && file && !batch.empty())
+         msync(file, mappedSize, MS_SYNC);
+
+      lock.lock();
+      if(stop && pending.empty())
+         return;
+   }
+}
+}
@@ -0,0 +1,117 @@
+#ifndef PARAMETERSTORE_H
+#define PARAMETERSTORE_H
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Keeps the values of persistent parameters, see ParameterProperties::persistent, in a memory-mapped journal
+ * file. Every value written is appended to the journal as an entry with a CRC-32, and the last valid entry of a
+ * parameter wins when the file is opened. An entry torn by a power loss fails its CRC, and the journal ends before
+ * it. If the journal is full, the current values are written to a new file which replaces the old one by a rename.
+ *
+ * Store() only copies the value. A thread of the store collects the values of a burst of writes, and appends only the
+ * last value of each parameter.
+ */
+class ParameterStore final
+{
+public:
+    /**
+     * @brief Identifies a parameter by the submodule it belongs to, since the set callbacks are the same in all slots.
+     */
+    struct Key
+    {
+        uint32_t moduleId;
+        uint32_t submoduleId;
+        uint16_t idx;
+        bool operator<(const Key& other) const;
+    };
+
+    ParameterStore();
+    ~ParameterStore();
+
+    ParameterStore(const ParameterStore&) = delete;
+    ParameterStore& operator=(const ParameterStore&) = delete;
+
+    /**
+     * @brief Reads the values from the file, creating it if it does not exist, and starts the thread of the store. If
+     * the file is no valid journal, it is kept with the suffix ".prev". journalBytes is the size of a new file.
+     * On failure, errno is that of the call which failed.
+     */
+    bool Open(const std::string& path, std::size_t journalBytes);
+    bool IsOpen() const;
+    /**
+     * @brief Writes the values not written yet, and stops the thread of the store.
+     */
+    void Close();
+
+    bool Load(const Key& key, std::vector<uint8_t>& value) const;
+    void Store(const Key& key, const uint8_t* data, std::size_t numBytes);
+
+private:
+    static constexpr uint32_t magic{0x50505053}; // "PPPS"
+    static constexpr uint32_t version{1};
+    // Time to wait for further writes before appending to the journal.
+    static constexpr std::chrono::milliseconds coalesceTime{100};
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t reserved;
+    };
+    // Followed by length bytes of value, and padding to a multiple of 8 bytes. length 0 ends the journal.
+    struct EntryHeader
+    {
+        uint32_t length;
+        // Of the fields after it, and the value.
+        uint32_t crc;
+        uint32_t moduleId;
+        uint32_t submoduleId;
+        uint16_t idx;
+        uint16_t reserved;
+        uint32_t reserved2;
+    };
+
+    static uint32_t Crc(uint32_t crc, const void* data, std::size_t numBytes);
+    static uint32_t EntryCrc(const EntryHeader& entry, const uint8_t* value);
+    static std::size_t EntrySize(std::size_t length);
+
+    bool MapExisting();
+    std::size_t ScanJournal(std::map<Key, std::vector<uint8_t>>* entries) const;
+    bool Create(const std::string& filePath, std::size_t size);
+    bool Append(const Key& key, const std::vector<uint8_t>& value);
+    bool Compact();
+    void Unmap();
+    void Run();
+
+    std::string path{};
+    std::size_t journalBytes{0};
+    int fd{-1};
+    uint8_t* file{nullptr};
+    std::size_t mappedSize{0};
+    // Position of the end of the journal. Only used by the thread of the store after Open().
+    std::size_t writePos{0};
+
+    mutable std::mutex mutex{};
+    std::condition_variable condition{};
+    // Last value of every parameter, in the journal or pending.
+    std::map<Key, std::vector<uint8_t>> values{};
+    // Values not appended to the journal yet.
+    std::map<Key, std::vector<uint8_t>> pending{};
+    bool stop{false};
+    std::thread thread{};
+};
+}
+#endif
@@ -0,0 +1,116 @@
+#include "ProcessImage.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace profinet
+{
+ProcessImageReader::ProcessImageReader()
+{
+}
+
+ProcessImageReader::~ProcessImageReader()
+{
+   Close();
+}
+
+bool ProcessImageReader::Open(const std::string& name)
+{
+   Close();
+   fd = shm_open(name.c_str(), O_RDONLY, 0);
+   if(fd < 0)
+      return false;
+   struct stat status;
+   if(fstat(fd, &status) != 0 || !Remap(static_cast<std::size_t>(status.st_size)))
+   {
+      Close();
+      return false;
+   }
+   auto header{GetHeader(image)};
+   if(header->magic != processimage::magic || header->version != processimage::version)
+   {
+      Close();
+      return false;
+   }
+   return true;
+}
+
+void ProcessImageReader::Close()
+{
+   if(image)
+      munmap(const_cast<uint8_t*>(image), mappedSize);
+   image = nullptr;
+   mappedSize = 0;
+   if(fd >= 0)
+      close(fd);
+   fd = -1;
+}
+
+bool ProcessImageReader::Remap(std::size_t size)
+{
+   if(size < sizeof(processimage::Header))
+      return false;
+   void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+   if(mapping == MAP_FAILED)
+      return false;
+   if(image)
+      munmap(const_cast<uint8_t*>(image), mappedSize);
+   image = static_cast<const uint8_t*>(mapping);
+   mappedSize = size;
+   return true;
+}
+
+uint32_t ProcessImageReader::BeginRead()
+{
+   // The writer grew the segment since it was mapped.
+   if(GetHeader(image)->imageSize > mappedSize)
+   {
+      struct stat status;
+      if(fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) > mappedSize)
+         Remap(static_cast<std::size_t>(status.st_size));
+   }
+   return GetHeader(image)->sequence.load(std::memory_order_acquire);
+}
+
+bool ProcessImageReader::EndRead(uint32_t sequence) const
+{
+   std::atomic_thread_fence(std::memory_order_acquire);
+   return !(sequence & 1) && GetHeader(image)->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+const uint8_t* ProcessImageReader::GetImage() const
+{
+   return image;
+}
+
+bool ProcessImageReader::Read(std::vector<uint8_t>& snapshot, unsigned int maxRetries)
+{
+   if(!image)
+      return false;
+   for(unsigned int retry = 0; retry < maxRetries; retry++)
+   {
+      uint32_t sequence{BeginRead()};
+      std::size_t size{GetHeader(image)->imageSize};
+      if(size > mappedSize)
+         continue;
+      snapshot.resize(size);
+      std::memcpy(snapshot.data(), image, size);
+      if(EndRead(sequence))
+         return true;
+   }
+   return false;
+}
+
+const processimage::Header* ProcessImageReader::GetHeader(const uint8_t* image)
+{
+   return reinterpret_cast<const processimage::Header*>(image);
+}
+
+const processimage::SubslotEntry* ProcessImageReader::GetSubslots(const uint8_t* image)
+{
+   return reinterpret_cast<const processimage::SubslotEntry*>(image + sizeof(processimage::Header));
+}
+}
@@ -0,0 +1,279 @@
+#include "ProcessImageRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace profinet
+{
+ProcessImageRecorder::ProcessImageRecorder()
+{
+}
+
+ProcessImageRecorder::~ProcessImageRecorder()
+{
+   Unmap();
+}
+
+bool ProcessImageRecorder::Open(const std::string& path_, uint32_t numRecords_, uint32_t cycleTimeUs_,
+   const Device& deviceConfiguration)
+{
+   Unmap();
+   if(path_.empty() || numRecords_ == 0)
+      return false;
+   path = path_;
+   numRecords = numRecords_;
+   cycleTimeUs = cycleTimeUs_;
+
+   // The slots are only known when the PLC connects, so the entries only give the sizes.
+   Layout layout{};
+   for(const auto& moduleWithPlugInfo : deviceConfiguration.modules)
+   {
+      for(const auto& submodule : moduleWithPlugInfo.module.submodules)
+      {
+         recording::SubslotEntry entry;
+         std::memset(&entry, 0, sizeof(entry));
+         entry.api = deviceConfiguration.properties.api;
+         entry.slot = moduleWithPlugInfo.plugInfo.IsFixedSlot() ? moduleWithPlugInfo.plugInfo.fixedSlot : 0;
+         entry.moduleId = moduleWithPlugInfo.module.GetId();
+         entry.submoduleId = submodule.GetId();
+         for(const auto& input : submodule.inputs)
+            entry.inputLength += static_cast<uint32_t>(input.GetLengthInBytes());
+         for(const auto& output : submodule.outputs)
+            entry.outputLength += static_cast<uint32_t>(output.GetLengthInBytes());
+         layout.subslots.push_back(entry);
+      }
+   }
+   Arrange(layout);
+   const std::size_t size{layout.headerSize + layout.recordSize * numRecords};
+
+   if(MapExisting())
+   {
+      if(mappedSize == size && header->magic == recording::magic && header->version == recording::version)
+         return true;
+      bool hasRecords{header->magic == recording::magic && header->nextSequence.load() > 0};
+      Unmap();
+      if(hasRecords)
+         std::rename(path.c_str(), (path + ".prev").c_str());
+   }
+   if(!Create(size))
+      return false;
+   WriteHeader(layout, numRecords);
+   return true;
+}
+
+bool ProcessImageRecorder::IsMapped() const
+{
+   return header != nullptr;
+}
+
+bool ProcessImageRecorder::IsOpen() const
+{
+   return recording;
+}
+
+uint32_t ProcessImageRecorder::GetNumRecords() const
+{
+   return recording ? header->numRecords : 0;
+}
+
+bool ProcessImageRecorder::IsShortened() const
+{
+   return recording && header->numRecords < numRecords;
+}
+
+void ProcessImageRecorder::Arrange(Layout& layout)
+{
+   // Keep the data of each subslot 8-byte aligned.
+   std::size_t offset{(sizeof(recording::RecordHeader) + 2 * layout.subslots.size() + 7) & ~std::size_t{7}};
+   for(auto& entry : layout.subslots)
+   {
+      entry.inputOffset = static_cast<uint32_t>(offset);
+      offset += (entry.inputLength + 7) & ~uint32_t{7};
+      entry.outputOffset = static_cast<uint32_t>(offset);
+      offset += (entry.outputLength + 7) & ~uint32_t{7};
+   }
+   layout.recordSize = offset;
+   // Records start page aligned, such that a record rarely spans more pages than necessary.
+   const std::size_t pageSize{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+   layout.headerSize = (sizeof(recording::FileHeader) + layout.subslots.size() * sizeof(recording::SubslotEntry)
+      + pageSize - 1) / pageSize * pageSize;
+}
+
+void ProcessImageRecorder::WriteHeader(const Layout& layout, uint32_t numRecordsInFile)
+{
+   // Invalidates the records first, as their positions change with the layout.
+   header->nextSequence.store(0, std::memory_order_release);
+   std::memset(file + sizeof(recording::FileHeader), 0, layout.headerSize - sizeof(recording::FileHeader));
+   header->magic = recording::magic;
+   header->version = recording::version;
+   header->headerSize = static_cast<uint32_t>(layout.headerSize);
+   header->recordSize = static_cast<uint32_t>(layout.recordSize);
+   header->numRecords = numRecordsInFile;
+   header->numSubslots = static_cast<uint32_t>(layout.subslots.size());
+   header->cycleTimeUs = cycleTimeUs;
+   std::memcpy(subslots, layout.subslots.data(), layout.subslots.size() * sizeof(recording::SubslotEntry));
+}
+
+void ProcessImageRecorder::Unmap()
+{
+   if(file)
+      munmap(file, mappedSize);
+   file = nullptr;
+   mappedSize = 0;
+   header = nullptr;
+   subslots = nullptr;
+   recording = false;
+   record = nullptr;
+   if(fd >= 0)
+      close(fd);
+   fd = -1;
+}
+
+bool ProcessImageRecorder::MapExisting()
+{
+   fd = open(path.c_str(), O_RDWR);
+   if(fd < 0)
+      return false;
+   struct stat status;
+   if(fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(recording::FileHeader))
+   {
+      Unmap();
+      return false;
+   }
+   void* mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, fd, 0);
+   if(mapping == MAP_FAILED)
+   {
+      Unmap();
+      return false;
+   }
+   file = static_cast<uint8_t*>(mapping);
+   mappedSize = static_cast<std::size_t>(status.st_size);
+   header = reinterpret_cast<recording::FileHeader*>(file);
+   subslots = reinterpret_cast<recording::SubslotEntry*>(file + sizeof(recording::FileHeader));
+   return true;
+}
+
+bool ProcessImageRecorder::Create(std::size_t size)
+{
+   fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+   if(fd < 0)
+      return false;
+   // Allocate all blocks now. A full disk must not raise SIGBUS in the cyclic data exchange later.
+   if(posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0)
+   {
+      Unmap();
+      return false;
+   }
+   void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+   if(mapping == MAP_FAILED)
+   {
+      Unmap();
+      return false;
+   }
+   file = static_cast<uint8_t*>(mapping);
+   mappedSize = size;
+   header = reinterpret_cast<recording::FileHeader*>(file);
+   subslots = reinterpret_cast<recording::SubslotEntry*>(file + sizeof(recording::FileHeader));
+   return true;
+}
+
+bool ProcessImageRecorder::Build(DeviceInstance& device, uint32_t api)
+{
+   recording = false;
+   if(!IsMapped())
+      return false;
+
+   Layout layout{};
+   for(auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for(auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         recording::SubslotEntry entry;
+         std::memset(&entry, 0, sizeof(entry));
+         entry.api = api;
+         entry.slot = itModules->first;
+         entry.subslot = itSubmodules->first;
+         entry.moduleId = itSubmodules->second.GetModuleId();
+         entry.submoduleId = itSubmodules->second.GetSubmoduleId();
+         entry.inputLength = static_cast<uint32_t>(itSubmodules->second.GetInputLengthInBytes());
+         entry.outputLength = static_cast<uint32_t>(itSubmodules->second.GetOutputLengthInBytes());
+         layout.subslots.push_back(entry);
+      }
+   }
+   Arrange(layout);
+   if(layout.headerSize >= mappedSize)
+      return false;
+   const uint32_t numRecordsInFile{static_cast<uint32_t>(
+      std::min<std::size_t>(numRecords, (mappedSize - layout.headerSize) / layout.recordSize))};
+   if(numRecordsInFile == 0)
+      return false;
+
+   if(!(header->magic == recording::magic && header->version == recording::version
+      && header->headerSize == layout.headerSize && header->recordSize == layout.recordSize
+      && header->numRecords == numRecordsInFile && header->numSubslots == layout.subslots.size()
+      && std::memcmp(subslots, layout.subslots.data(), layout.subslots.size() * sizeof(recording::SubslotEntry)) == 0))
+   {
+      WriteHeader(layout, numRecordsInFile);
+   }
+   header->cycleTimeUs = cycleTimeUs;
+   recording = true;
+   return true;
+}
+
+void ProcessImageRecorder::BeginCycle()
+{
+   if(!IsOpen())
+      return;
+   sequence = header->nextSequence.load(std::memory_order_relaxed);
+   record = file + header->headerSize + (sequence % header->numRecords) * header->recordSize;
+   reinterpret_cast<recording::RecordHeader*>(record)->sequence.store(0, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ProcessImageRecorder::SetInput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iops)
+{
+   if(!record || subslotIx >= header->numSubslots)
+      return;
+   const recording::SubslotEntry& entry{subslots[subslotIx]};
+   if(data && length == entry.inputLength)
+      std::memcpy(record + entry.inputOffset, data, length);
+   else
+      std::memset(record + entry.inputOffset, 0, entry.inputLength);
+   record[sizeof(recording::RecordHeader) + 2 * subslotIx] = iops;
+}
+
+void ProcessImageRecorder::SetOutput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iocs)
+{
+   if(!record || subslotIx >= header->numSubslots)
+      return;
+   const recording::SubslotEntry& entry{subslots[subslotIx]};
+   if(!data || length > entry.outputLength)
+      length = 0;
+   if(length > 0)
+      std::memcpy(record + entry.outputOffset, data, length);
+   std::memset(record + entry.outputOffset + length, 0, entry.outputLength - length);
+   record[sizeof(recording::RecordHeader) + 2 * subslotIx + 1] = iocs;
+}
+
+void ProcessImageRecorder::EndCycle(uint16_t ppmCycle, uint16_t cpmCycle)
+{
+   if(!record)
+      return;
+   auto recordHeader{reinterpret_cast<recording::RecordHeader*>(record)};
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME, &now);
+   recordHeader->timestampNs = static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+   recordHeader->ppmCycle = ppmCycle;
+   recordHeader->cpmCycle = cpmCycle;
+   recordHeader->sequence.store(sequence + 1, std::memory_order_release);
+   header->nextSequence.store(sequence + 1, std::memory_order_release);
+   record = nullptr;
+}
+}
@@ -0,0 +1,87 @@
+#ifndef PROCESSIMAGERECORDER_H
+#define PROCESSIMAGERECORDER_H
+
+#pragma once
+
+#include "ProcessImageRecording.h"
+#include "DeviceInstance.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Records the process image of every cycle into a preallocated, memory-mapped ring file, see
+ * recording::FileHeader. Only used by the worker thread. The cyclic functions only copy memory, they neither
+ * allocate, block nor call into the kernel.
+ */
+class ProcessImageRecorder final
+{
+public:
+    ProcessImageRecorder();
+    ~ProcessImageRecorder();
+
+    ProcessImageRecorder(const ProcessImageRecorder&) = delete;
+    ProcessImageRecorder& operator=(const ProcessImageRecorder&) = delete;
+
+    /**
+     * @brief Preallocates and maps the file, sized for the modules of the configuration, each plugged once, and
+     * numRecords cycles. Blocking, so call it before the stack starts. If the file already has this size, e.g. from
+     * before a crash, it is kept, and Build() continues its recording if the layout matches. Otherwise, an old
+     * recording is kept with the suffix ".prev".
+     */
+    bool Open(const std::string& path, uint32_t numRecords, uint32_t cycleTimeUs, const Device& deviceConfiguration);
+    bool IsMapped() const;
+    // True while the cycles are recorded, i.e. after a successful Build().
+    bool IsOpen() const;
+
+    /**
+     * @brief Lays out the records for the submodules currently plugged in the device. Call after PRMEND, before the
+     * cyclic data exchange. Only rewrites the header in the mapped file, and neither resizes the file nor blocks.
+     * If the file holds a recording with the same layout, e.g. from before a reconnect, it is continued, otherwise
+     * the recording restarts. If the records are larger than those of the configuration, fewer cycles fit into the
+     * file, see IsShortened(). Returns false, and records nothing, if not even one fits. The subslot indices of the
+     * cyclic functions are the positions of the submodules when iterating over the device.
+     */
+    bool Build(DeviceInstance& device, uint32_t api);
+    uint32_t GetNumRecords() const;
+    // True if fewer cycles than configured fit into the file with the current layout.
+    bool IsShortened() const;
+
+    void BeginCycle();
+    void SetInput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iops);
+    void SetOutput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iocs);
+    void EndCycle(uint16_t ppmCycle, uint16_t cpmCycle);
+
+private:
+    struct Layout
+    {
+        std::vector<recording::SubslotEntry> subslots{};
+        std::size_t headerSize{0};
+        std::size_t recordSize{0};
+    };
+    static void Arrange(Layout& layout);
+    void WriteHeader(const Layout& layout, uint32_t numRecordsInFile);
+    bool MapExisting();
+    bool Create(std::size_t size);
+    void Unmap();
+
+    std::string path{};
+    // Configured number of records. The file holds header->numRecords.
+    uint32_t numRecords{0};
+    uint32_t cycleTimeUs{0};
+    int fd{-1};
+    uint8_t* file{nullptr};
+    std::size_t mappedSize{0};
+    recording::FileHeader* header{nullptr};
+    recording::SubslotEntry* subslots{nullptr};
+    bool recording{false};
+
+    // Record of the current cycle, null outside of BeginCycle() and EndCycle().
+    uint8_t* record{nullptr};
+    uint64_t sequence{0};
+};
+}
+#endif
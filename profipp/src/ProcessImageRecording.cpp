@@ -0,0 +1,267 @@
+#include "ProcessImageRecording.h"
+#include "standardconversions.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace profinet
+{
+ProcessImageRecording::ProcessImageRecording()
+{
+}
+
+ProcessImageRecording::~ProcessImageRecording()
+{
+   Close();
+}
+
+bool ProcessImageRecording::Open(const std::string& path)
+{
+   Close();
+   fd = open(path.c_str(), O_RDONLY);
+   if(fd < 0)
+      return false;
+   struct stat status;
+   if(fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(recording::FileHeader))
+   {
+      Close();
+      return false;
+   }
+   void* mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+   if(mapping == MAP_FAILED)
+   {
+      Close();
+      return false;
+   }
+   file = static_cast<const uint8_t*>(mapping);
+   mappedSize = static_cast<std::size_t>(status.st_size);
+
+   auto header{GetHeader()};
+   if(header->magic != recording::magic || header->version != recording::version
+      || header->recordSize < sizeof(recording::RecordHeader) + 2 * header->numSubslots
+      || header->headerSize < sizeof(recording::FileHeader) + header->numSubslots * sizeof(recording::SubslotEntry)
+      || header->headerSize + static_cast<std::size_t>(header->numRecords) * header->recordSize > mappedSize)
+   {
+      Close();
+      return false;
+   }
+   for(std::size_t ix = 0; ix < header->numSubslots; ix++)
+   {
+      const recording::SubslotEntry& entry{GetSubslots()[ix]};
+      if(static_cast<std::size_t>(entry.inputOffset) + entry.inputLength > header->recordSize
+         || static_cast<std::size_t>(entry.outputOffset) + entry.outputLength > header->recordSize)
+      {
+         Close();
+         return false;
+      }
+   }
+   return true;
+}
+
+void ProcessImageRecording::Close()
+{
+   if(file)
+      munmap(const_cast<uint8_t*>(file), mappedSize);
+   file = nullptr;
+   mappedSize = 0;
+   if(fd >= 0)
+      close(fd);
+   fd = -1;
+}
+
+const recording::FileHeader* ProcessImageRecording::GetHeader() const
+{
+   return reinterpret_cast<const recording::FileHeader*>(file);
+}
+
+const recording::SubslotEntry* ProcessImageRecording::GetSubslots() const
+{
+   return reinterpret_cast<const recording::SubslotEntry*>(file + sizeof(recording::FileHeader));
+}
+
+std::size_t ProcessImageRecording::ForEachCycle(const CycleCallbackType& callback) const
+{
+   if(!file)
+      return 0;
+   auto header{GetHeader()};
+   const uint64_t next{header->nextSequence.load(std::memory_order_acquire)};
+   const uint64_t first{next > header->numRecords ? next - header->numRecords : 0};
+   std::vector<uint8_t> copy(header->recordSize);
+   std::size_t numCycles{0};
+   for(uint64_t sequence = first; sequence < next; sequence++)
+   {
+      const uint8_t* record{file + header->headerSize + (sequence % header->numRecords) * header->recordSize};
+      auto recordHeader{reinterpret_cast<const recording::RecordHeader*>(record)};
+      // Copy the record first, such that a record overwritten meanwhile by profipp is detected and skipped.
+      if(recordHeader->sequence.load(std::memory_order_acquire) != sequence + 1)
+         continue;
+      std::memcpy(copy.data(), record, copy.size());
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(recordHeader->sequence.load(std::memory_order_relaxed) != sequence + 1)
+         continue;
+      auto copyHeader{reinterpret_cast<const recording::RecordHeader*>(copy.data())};
+      Cycle cycle{sequence, copyHeader->timestampNs, copyHeader->ppmCycle, copyHeader->cpmCycle, copy.data()};
+      callback(cycle);
+      numCycles++;
+   }
+   return numCycles;
+}
+
+const uint8_t* ProcessImageRecording::GetInput(const Cycle& cycle, std::size_t subslotIx) const
+{
+   return cycle.record + GetSubslots()[subslotIx].inputOffset;
+}
+
+const uint8_t* ProcessImageRecording::GetOutput(const Cycle& cycle, std::size_t subslotIx) const
+{
+   return cycle.record + GetSubslots()[subslotIx].outputOffset;
+}
+
+uint8_t ProcessImageRecording::GetInputIops(const Cycle& cycle, std::size_t subslotIx) const
+{
+   return cycle.record[sizeof(recording::RecordHeader) + 2 * subslotIx];
+}
+
+uint8_t ProcessImageRecording::GetOutputIocs(const Cycle& cycle, std::size_t subslotIx) const
+{
+   return cycle.record[sizeof(recording::RecordHeader) + 2 * subslotIx + 1];
+}
+
+namespace
+{
+void PrintHex(std::ostream& stream, const uint8_t* data, std::size_t length)
+{
+   auto flags{stream.flags()};
+   stream << std::hex << std::setfill('0');
+   for(std::size_t ix = 0; ix < length; ix++)
+      stream << std::setw(2) << static_cast<unsigned>(data[ix]);
+   stream.flags(flags);
+}
+
+template<typename T> void PrintNumber(std::ostream& stream, const uint8_t* data, std::size_t length)
+{
+   T value;
+   if(!fromProfinet<T>(data, length, &value))
+      return;
+   if constexpr (std::is_floating_point_v<T>)
+      stream << std::setprecision(std::numeric_limits<T>::max_digits10) << value;
+   else
+      stream << +value;
+}
+
+void PrintValue(std::ostream& stream, const std::string& dataType, const uint8_t* data, std::size_t length)
+{
+   if(dataType == gsdmlName<int8_t>)
+      PrintNumber<int8_t>(stream, data, length);
+   else if(dataType == gsdmlName<int16_t>)
+      PrintNumber<int16_t>(stream, data, length);
+   else if(dataType == gsdmlName<int32_t>)
+      PrintNumber<int32_t>(stream, data, length);
+   else if(dataType == gsdmlName<int64_t>)
+      PrintNumber<int64_t>(stream, data, length);
+   else if(dataType == gsdmlName<uint8_t>)
+      PrintNumber<uint8_t>(stream, data, length);
+   else if(dataType == gsdmlName<uint16_t>)
+      PrintNumber<uint16_t>(stream, data, length);
+   else if(dataType == gsdmlName<uint32_t>)
+      PrintNumber<uint32_t>(stream, data, length);
+   else if(dataType == gsdmlName<uint64_t>)
+      PrintNumber<uint64_t>(stream, data, length);
+   else if(dataType == gsdmlName<float>)
+      PrintNumber<float>(stream, data, length);
+   else if(dataType == gsdmlName<double>)
+      PrintNumber<double>(stream, data, length);
+   else
+      PrintHex(stream, data, length);
+}
+
+/**
+ * @brief Prints the columns of one direction of a subslot: either one column per input/output of the configuration,
+ * or a single hexadecimal column if the configuration does not match the recorded length.
+ * If data is null, the column names are printed instead.
+ */
+template<typename Signals> void PrintSignals(std::ostream& stream, const Signals* signals, const std::string& prefix,
+   const uint8_t* data, std::size_t length)
+{
+   if(signals && signals->GetLengthInBytes() == length)
+   {
+      std::size_t offset{0};
+      std::size_t ix{0};
+      for(const auto& signal : *signals)
+      {
+         stream << ',';
+         if(data)
+            PrintValue(stream, signal.properties.dataType, data + offset, signal.GetLengthInBytes());
+         else
+            stream << prefix << ix << ':' << signal.properties.dataType;
+         offset += signal.GetLengthInBytes();
+         ix++;
+      }
+   }
+   else if(length > 0)
+   {
+      stream << ',';
+      if(data)
+         PrintHex(stream, data, length);
+      else
+         stream << prefix << ":hex";
+   }
+}
+}
+
+bool ProcessImageRecording::Decode(const Device& device, std::ostream& stream) const
+{
+   if(!file)
+      return false;
+   auto header{GetHeader()};
+   std::vector<const Submodule*> configurations(header->numSubslots, nullptr);
+   stream << "sequence,timestamp_ns,ppm_cycle,cpm_cycle";
+   for(std::size_t ix = 0; ix < header->numSubslots; ix++)
+   {
+      const recording::SubslotEntry& entry{GetSubslots()[ix]};
+      auto moduleConfig{device.modules[static_cast<uint16_t>(entry.moduleId)]};
+      if(moduleConfig)
+         configurations[ix] = moduleConfig->module.submodules[static_cast<uint16_t>(entry.submoduleId)];
+      const std::string prefix{std::to_string(entry.slot) + "." + std::to_string(entry.subslot) + "."};
+      const Submodule* config{configurations[ix]};
+      if(entry.inputLength > 0)
+      {
+         stream << ',' << prefix << "iops";
+         PrintSignals(stream, config ? &config->inputs : nullptr, prefix + "in", nullptr, entry.inputLength);
+      }
+      if(entry.outputLength > 0)
+      {
+         stream << ',' << prefix << "iocs";
+         PrintSignals(stream, config ? &config->outputs : nullptr, prefix + "out", nullptr, entry.outputLength);
+      }
+   }
+   stream << '\n';
+
+   ForEachCycle([&](const Cycle& cycle)
+   {
+      stream << cycle.sequence << ',' << cycle.timestampNs << ',' << cycle.ppmCycle << ',' << cycle.cpmCycle;
+      for(std::size_t ix = 0; ix < header->numSubslots; ix++)
+      {
+         const recording::SubslotEntry& entry{GetSubslots()[ix]};
+         const Submodule* config{configurations[ix]};
+         if(entry.inputLength > 0)
+         {
+            stream << ",0x" << std::hex << static_cast<unsigned>(GetInputIops(cycle, ix)) << std::dec;
+            PrintSignals(stream, config ? &config->inputs : nullptr, "", GetInput(cycle, ix), entry.inputLength);
+         }
+         if(entry.outputLength > 0)
+         {
+            stream << ",0x" << std::hex << static_cast<unsigned>(GetOutputIocs(cycle, ix)) << std::dec;
+            PrintSignals(stream, config ? &config->outputs : nullptr, "", GetOutput(cycle, ix), entry.outputLength);
+         }
+      }
+      stream << '\n';
+   });
+   return static_cast<bool>(stream);
+}
+}
@@ -0,0 +1,191 @@
+#include "ProcessImageWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace profinet
+{
+ProcessImageWriter::ProcessImageWriter()
+{
+}
+
+ProcessImageWriter::~ProcessImageWriter()
+{
+   if(image)
+      munmap(image, mappedSize);
+   if(fd >= 0)
+   {
+      close(fd);
+      shm_unlink(name.c_str());
+   }
+}
+
+bool ProcessImageWriter::Open(const std::string& name_)
+{
+   name = name_;
+   fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+   if(fd < 0)
+      return false;
+   // A segment left over by a previous run is reused with its size. Readers may still map it, and take SIGBUS
+   // on pages beyond its end, so it is never truncated.
+   struct stat status;
+   if(fstat(fd, &status) != 0 ||
+      !Grow(std::max(sizeof(processimage::Header), static_cast<std::size_t>(status.st_size))))
+   {
+      close(fd);
+      fd = -1;
+      return false;
+   }
+   // Continue the sequence of a reused segment, such that a reader does not take the new image for the snapshot
+   // it started on the old one. Odd while the header is rewritten.
+   const bool reused{header->magic == processimage::magic};
+   const uint32_t sequence{reused ? header->sequence.load(std::memory_order_relaxed) | 1 : 1};
+   header->sequence.store(sequence, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   header->magic = processimage::magic;
+   header->version = processimage::version;
+   header->connected = 0;
+   header->numSubslots = 0;
+   header->imageSize = sizeof(processimage::Header);
+   header->sequence.store(sequence + 1, std::memory_order_release);
+   return true;
+}
+
+bool ProcessImageWriter::IsOpen() const
+{
+   return header != nullptr;
+}
+
+bool ProcessImageWriter::Grow(std::size_t size)
+{
+   if(size <= mappedSize)
+      return true;
+   if(ftruncate(fd, static_cast<off_t>(size)) != 0)
+      return false;
+   void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(mapping == MAP_FAILED)
+      return false;
+   if(image)
+      munmap(image, mappedSize);
+   image = static_cast<uint8_t*>(mapping);
+   mappedSize = size;
+   header = reinterpret_cast<processimage::Header*>(image);
+   subslots = reinterpret_cast<processimage::SubslotEntry*>(image + sizeof(processimage::Header));
+   return true;
+}
+
+bool ProcessImageWriter::Build(DeviceInstance& device, uint32_t api)
+{
+   if(!IsOpen())
+      return false;
+   std::size_t numSubslots{0};
+   std::size_t dataSize{0};
+   for(auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for(auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         numSubslots++;
+         // Keep the data of each subslot 8-byte aligned.
+         dataSize += (itSubmodules->second.GetInputLengthInBytes() + 7) & ~std::size_t{7};
+         dataSize += (itSubmodules->second.GetOutputLengthInBytes() + 7) & ~std::size_t{7};
+      }
+   }
+   const std::size_t dataOffset{sizeof(processimage::Header) + numSubslots * sizeof(processimage::SubslotEntry)};
+   const std::size_t size{(dataOffset + 7) / 8 * 8 + dataSize};
+
+   BeginUpdate();
+   // Readers remap when imageSize exceeds their mapping, so the segment only grows.
+   if(!Grow(size))
+   {
+      header->numSubslots = 0;
+      EndUpdate();
+      return false;
+   }
+   std::size_t offset{(dataOffset + 7) / 8 * 8};
+   std::size_t ix{0};
+   for(auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for(auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         processimage::SubslotEntry& entry{subslots[ix++]};
+         std::memset(&entry, 0, sizeof(entry));
+         entry.api = api;
+         entry.slot = itModules->first;
+         entry.subslot = itSubmodules->first;
+         entry.inputOffset = static_cast<uint32_t>(offset);
+         entry.inputLength = static_cast<uint32_t>(itSubmodules->second.GetInputLengthInBytes());
+         offset += (entry.inputLength + 7) & ~uint32_t{7};
+         entry.outputOffset = static_cast<uint32_t>(offset);
+         entry.outputLength = static_cast<uint32_t>(itSubmodules->second.GetOutputLengthInBytes());
+         offset += (entry.outputLength + 7) & ~uint32_t{7};
+      }
+   }
+   std::memset(image + dataOffset, 0, size - dataOffset);
+   header->numSubslots = static_cast<uint32_t>(numSubslots);
+   header->imageSize = static_cast<uint32_t>(size);
+   EndUpdate();
+   return true;
+}
+
+void ProcessImageWriter::BeginUpdate()
+{
+   header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ProcessImageWriter::EndUpdate()
+{
+   header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void ProcessImageWriter::BeginCycle()
+{
+   if(IsOpen())
+      BeginUpdate();
+}
+
+void ProcessImageWriter::SetInput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iops)
+{
+   if(!IsOpen() || subslotIx >= header->numSubslots)
+      return;
+   processimage::SubslotEntry& entry{subslots[subslotIx]};
+   if(data && length == entry.inputLength)
+      std::memcpy(image + entry.inputOffset, data, length);
+   entry.inputIops = iops;
+}
+
+void ProcessImageWriter::SetOutput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iocs)
+{
+   if(!IsOpen() || subslotIx >= header->numSubslots)
+      return;
+   processimage::SubslotEntry& entry{subslots[subslotIx]};
+   if(data && length <= entry.outputLength)
+      std::memcpy(image + entry.outputOffset, data, length);
+   entry.outputIocs = iocs;
+}
+
+void ProcessImageWriter::EndCycle()
+{
+   if(!IsOpen())
+      return;
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME, &now);
+   header->timestampNs = static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+   header->cycleCounter++;
+   EndUpdate();
+}
+
+void ProcessImageWriter::SetConnected(bool connected)
+{
+   if(!IsOpen())
+      return;
+   BeginUpdate();
+   header->connected = connected ? 1 : 0;
+   EndUpdate();
+}
+}
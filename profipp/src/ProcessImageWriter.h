@@ -0,0 +1,57 @@
+#ifndef PROCESSIMAGEWRITER_H
+#define PROCESSIMAGEWRITER_H
+
+#pragma once
+
+#include "ProcessImage.h"
+#include "DeviceInstance.h"
+
+#include <cstdint>
+#include <string>
+
+namespace profinet
+{
+/**
+ * @brief Publishes the process image in a POSIX shared-memory segment, see processimage::Header.
+ * Only used by the worker thread. The cyclic functions only copy memory, they neither allocate nor block.
+ */
+class ProcessImageWriter final
+{
+public:
+    ProcessImageWriter();
+    ~ProcessImageWriter();
+
+    ProcessImageWriter(const ProcessImageWriter&) = delete;
+    ProcessImageWriter& operator=(const ProcessImageWriter&) = delete;
+
+    bool Open(const std::string& name);
+    bool IsOpen() const;
+
+    /**
+     * @brief Lays out the image for the submodules currently plugged in the device. Call after PRMEND,
+     * before the cyclic data exchange. The subslot indices of the cyclic functions are the positions
+     * of the submodules when iterating over the device.
+     */
+    bool Build(DeviceInstance& device, uint32_t api);
+
+    void BeginCycle();
+    void SetInput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iops);
+    void SetOutput(std::size_t subslotIx, const uint8_t* data, std::size_t length, uint8_t iocs);
+    void EndCycle();
+
+    void SetConnected(bool connected);
+
+private:
+    bool Grow(std::size_t size);
+    void BeginUpdate();
+    void EndUpdate();
+
+    std::string name{};
+    int fd{-1};
+    uint8_t* image{nullptr};
+    std::size_t mappedSize{0};
+    processimage::Header* header{nullptr};
+    processimage::SubslotEntry* subslots{nullptr};
+};
+}
+#endif
@@ -2,16 +2,24 @@
 #include "ProfinetProperties.h"
 #include "dapModule.h"
 #include "networktools.h"
+#include "AllocationGuard.h"
 
 #include "pnet_api.h"
+#include "osal.h"
 
 #include <memory>
+#include <algorithm>
 #include <functional>
 #include <chrono>
 #include <thread>
 //TODO: Only use when POSIX
 // to set priority of threads to RT.
 #include <pthread.h>
+// to lock memory and prefault stacks in real-time memory mode.
+#include <sys/mman.h>
+#include <malloc.h>
+#include <alloca.h>
+#include <unistd.h>
 #include <filesystem>
 #include <sstream>
 #include <cstdarg>
@@ -20,6 +28,18 @@
 inline constexpr static uint32_t arepNull{UINT32_MAX};
 inline constexpr static bool monitorCycleTimes{false};
 
+/**
+ * Touches the given number of bytes of the stack of the calling thread, such that later accesses
+ * to these do not page-fault.
+ */
+static void PrefaultStack(std::size_t numBytes)
+{
+   volatile uint8_t* stack = static_cast<volatile uint8_t*>(alloca(numBytes));
+   const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+   for(std::size_t i = 0; i < numBytes; i += pageSize)
+      stack[i] = 0;
+}
+
 namespace profinet
 {
 ProfinetInternal::ProfinetInternal() : 
@@ -30,7 +50,8 @@ ProfinetInternal::ProfinetInternal() :
 
 ProfinetInternal::~ProfinetInternal()
 {
-
+   // The record workers signal synchronizationEvents, so stop them first.
+   recordWorker.Stop();
 }
 static inline std::string strPrintf (const char* format, ...)
 {
@@ -44,15 +65,123 @@ static inline std::string strPrintf (const char* format, ...)
 
     return retval;
 }
-void ProfinetInternal::Log(LogLevel logLevel, const char* format, ...) noexcept
+namespace
+{
+// Serializes the worker with the callbacks of the stack, see pnet_lock(). With singleReceiveThread, the callbacks
+// run on the receive thread, and change the state of the stack, the device and arep.
+class StackLock
+{
+public:
+   explicit StackLock(pnet_t* net_) : net{net_}
+   {
+      pnet_lock(net);
+   }
+   ~StackLock()
+   {
+      pnet_unlock(net);
+   }
+   StackLock(const StackLock&) = delete;
+   StackLock& operator=(const StackLock&) = delete;
+private:
+   pnet_t* net;
+};
+
+// Passed to the background worker of the stack, and deleted by the completion callback.
+struct BackgroundJob
+{
+   ProfinetControl::BackgroundJobType job;
+   ProfinetControl::BackgroundJobDoneType done;
+};
+
+int RunBackgroundJob(pnet_t* net, void* arg)
+{
+   return static_cast<BackgroundJob*>(arg)->job() ? 0 : -1;
+}
+
+void BackgroundJobDone(pnet_t* net, void* arg, int result)
+{
+   // Also called for jobs coalesced with a queued one, which did not run.
+   std::unique_ptr<BackgroundJob> backgroundJob{static_cast<BackgroundJob*>(arg)};
+   if(backgroundJob->done)
+      backgroundJob->done(result == 0);
+}
+}
+
+bool ProfinetInternal::SubmitBackgroundJob(JobPriority priority, uint32_t key, const BackgroundJobType& job,
+   const BackgroundJobDoneType& done)
+{
+   if(!initialized || !job)
+      return false;
+   pnet_bg_job_prio_t prio{PNET_BG_JOB_PRIO_NORMAL};
+   switch(priority)
+   {
+   case JobPriority::high:
+      prio = PNET_BG_JOB_PRIO_HIGH;
+      break;
+   case JobPriority::normal:
+      prio = PNET_BG_JOB_PRIO_NORMAL;
+      break;
+   case JobPriority::low:
+      prio = PNET_BG_JOB_PRIO_LOW;
+      break;
+   }
+   auto backgroundJob{new BackgroundJob{job, done}};
+   if(pnet_bg_job_submit(profinetStack, prio, key, &RunBackgroundJob, backgroundJob, &BackgroundJobDone,
+      backgroundJob) != 0)
+   {
+      delete backgroundJob;
+      Log(logWarning, "Could not queue background job with key %u.", key);
+      return false;
+   }
+   return true;
+}
+
+bool ProfinetInternal::GetCyclicTiming(uint16_t iocrIndex, bool reset, CyclicTiming& timing)
+{
+   const uint32_t currentArep{arep.load()};
+   pnet_iocr_timing_t iocrTiming{};
+   if(!initialized || currentArep == arepNull ||
+      pnet_get_iocr_timing(profinetStack, currentArep, iocrIndex, reset, &iocrTiming) != 0)
+      return false;
+   auto convert = [](const pnet_interval_stats_t& stats)
+   {
+      return IntervalStatistics{stats.count, stats.min_ns, stats.max_ns, stats.sum_ns};
+   };
+   timing.frameId = iocrTiming.frame_id;
+   timing.isInput = iocrTiming.is_input;
+   timing.latency = convert(iocrTiming.latency);
+   timing.jitter = convert(iocrTiming.jitter);
+   return true;
+}
+
+void ProfinetInternal::SetLogLevel(LogLevel logLevel)
+{
+   activeLogLevel.store(logLevel, std::memory_order_relaxed);
+   if(asyncLogger)
+      asyncLogger->SetLogLevel(logLevel);
+}
+
+void ProfinetInternal::LogFormat(LogLevel logLevel, const char* format, ...) noexcept
 {
    if(!logFun)
       return;
    va_list args;
+   if(asyncLogger)
+   {
+      va_start (args, format);
+      asyncLogger->Log(logLevel, format, args);
+      va_end (args);
+      return;
+   }
+   // Logging is allowed to allocate, also on the cyclic thread.
+   tools::AllocationGuardSuspend allocationGuardSuspend;
+   va_list argsCopy;
    std::string message;
 
    va_start (args, format);
-   message.resize (vsnprintf (0, 0, format, args));
+   va_copy (argsCopy, args);
+   message.resize (vsnprintf (0, 0, format, argsCopy));
+   va_end (argsCopy);
    vsnprintf (&message[0], message.size () + 1, format, args);
    va_end (args);
    logFun(logLevel, std::move(message));
@@ -62,12 +191,22 @@ bool ProfinetInternal::Initialize(const Profinet& configuration_, LoggerType log
 {
    logFun = logger;
    configuration = configuration_;
+   activeLogLevel.store(configuration.GetProperties().logLevel, std::memory_order_relaxed);
 
    auto& deviceConfiguration{configuration.GetDevice()};
    auto& deviceProperties{deviceConfiguration.properties};
    device.Initialize(deviceConfiguration);
 
    auto& properties = configuration.GetProperties();
+   if(properties.asyncLogging && logFun)
+   {
+      asyncLogger = std::make_unique<AsyncLogger>(logFun, properties.asyncLogBufferBytes);
+      asyncLogger->SetLogLevel(properties.logLevel);
+      asyncLogger->Start();
+      asyncLogger->RouteOsLog();
+   }
+   if(properties.recordWorkerThreads > 0 && !recordWorker.IsRunning())
+      recordWorker.Start(properties.recordWorkerThreads, [this](){synchronizationEvents.SignalRecordDone();});
    pnetCfg = InitializePnetConfig();
 
    // Determine available network interfaces, and determine if configured interfaces are valid and what their IPs etc is.
@@ -161,9 +300,34 @@ bool ProfinetInternal::Initialize(const Profinet& configuration_, LoggerType log
    pnetCfg.pnal_cfg.snmp_thread.prio = properties.snmpThreadPriority;
    pnetCfg.pnal_cfg.snmp_thread.stack_size = properties.snmpThreadStacksize;
    pnetCfg.pnal_cfg.eth_recv_thread.prio = properties.ethThreadPriority;
-   pnetCfg.pnal_cfg.eth_recv_thread.stack_size = properties.ethThreadStacksize;
+   pnetCfg.pnal_cfg.eth_recv_thread.stack_size = properties.singleReceiveThread
+      ? std::max(properties.ethThreadStacksize, ProfinetProperties::minSingleReceiveThreadStacksize)
+      : properties.ethThreadStacksize;
    pnetCfg.pnal_cfg.bg_worker_thread.prio = properties.bgWorkerThreadPriority;
    pnetCfg.pnal_cfg.bg_worker_thread.stack_size = properties.bgWorkerThreadStacksize;
+   pnetCfg.pnal_cfg.link_monitor_thread.prio = properties.linkMonitorThreadPriority;
+   pnetCfg.pnal_cfg.link_monitor_thread.stack_size = properties.linkMonitorThreadStacksize;
+   pnetCfg.pnal_cfg.snmp_thread.cpu_mask = properties.snmpThreadCpuMask;
+   pnetCfg.pnal_cfg.eth_recv_thread.cpu_mask = properties.ethThreadCpuMask;
+   pnetCfg.pnal_cfg.bg_worker_thread.cpu_mask = properties.bgWorkerThreadCpuMask;
+   pnetCfg.pnal_cfg.link_monitor_thread.cpu_mask = properties.linkMonitorThreadCpuMask;
+   pnetCfg.pnal_cfg.eth_recv_thread.busy_poll_us = properties.ethThreadBusyPollUs;
+   pnetCfg.pnal_cfg.eth_recv_thread.busy_spin = properties.ethThreadBusySpin;
+   pnetCfg.pnal_cfg.single_recv_thread = properties.singleReceiveThread;
+   switch(properties.ethTimestamping)
+   {
+   case ProfinetProperties::EthTimestamping::off:
+      pnetCfg.pnal_cfg.eth_timestamping = PNAL_TIMESTAMPING_OFF;
+      break;
+   case ProfinetProperties::EthTimestamping::software:
+      pnetCfg.pnal_cfg.eth_timestamping = PNAL_TIMESTAMPING_SOFTWARE;
+      break;
+   case ProfinetProperties::EthTimestamping::hardware:
+      pnetCfg.pnal_cfg.eth_timestamping = PNAL_TIMESTAMPING_HARDWARE;
+      break;
+   }
+   pnetCfg.pnal_cfg.eth_priority = properties.ethPriority;
+   pnetCfg.pnal_cfg.eth_txtime_delay_us = properties.ethTxtimeDelayUs;
 
    std::filesystem::path filepath;
    if(properties.pathStorageDirectory.empty())
@@ -179,6 +343,29 @@ bool ProfinetInternal::Initialize(const Profinet& configuration_, LoggerType log
    //TODO replace properties.pathStorageDirectory by filepathStr.c_str()
    strcpy (pnetCfg.file_directory, properties.pathStorageDirectory.c_str());
    Log(logInfo, "Persistent file storage directory set to: %s\n", pnetCfg.file_directory);
+   if(!OpenParameterStore(filepathStr))
+      return false;
+
+   if(!properties.processImageShmName.empty())
+   {
+      if(processImage.Open(properties.processImageShmName))
+         Log(logInfo, "Publishing the process image in shared memory %s.", properties.processImageShmName.c_str());
+      else
+         Log(logWarning, "Could not create shared memory %s for the process image: %s", properties.processImageShmName.c_str(), strerror(errno));
+   }
+   if(!properties.processImageRecordFile.empty())
+   {
+      uint32_t numRecords{static_cast<uint32_t>(uint64_t{properties.processImageRecordDurationMs} * 1000 / std::max(properties.cycleTimeUs, uint32_t{1}))};
+      // Preallocated here, as the file is large, and connecting must not wait for it.
+      if(processImageRecorder.Open(properties.processImageRecordFile, std::max(numRecords, uint32_t{1}), properties.cycleTimeUs, deviceConfiguration))
+         Log(logInfo, "Recording the process image of the last %u cycles to %s.", std::max(numRecords, uint32_t{1}), properties.processImageRecordFile.c_str());
+      else
+         Log(logWarning, "Could not preallocate %s to record the process image: %s", properties.processImageRecordFile.c_str(), strerror(errno));
+   }
+
+   // Lock memory before the stack creates its threads, such that their stacks are locked, too.
+   if(properties.realtimeMemory && !LockMemory())
+      return false;
 
    /* Initialise stack */
    alarmAllowed = true;
@@ -282,8 +469,13 @@ static std::string PrintIoxsChange(
 
 void ProfinetInternal::HandleCyclicData ()
 {
-   static std::vector<uint8_t> buffer{};
+   // In real-time memory mode, all buffers are presized at PRMEND, and nothing must be allocated here.
+   tools::CyclicAllocationGuard allocationGuard{configuration.GetProperties().realtimeMemory};
+   auto& buffer{cyclicBuffer};
    auto api{configuration.GetDevice().properties.api};
+   std::size_t subslotIx{0};
+   processImage.BeginCycle();
+   processImageRecorder.BeginCycle();
    for (auto itModules = device.begin(); itModules != device.end(); itModules++)
    {
       uint32_t slot{itModules->first};
@@ -297,8 +489,8 @@ void ProfinetInternal::HandleCyclicData ()
          
          if (inputLength > 0)
          {
-            if(buffer.capacity() < inputLength)
-               buffer.reserve(inputLength);
+            if(buffer.size() < inputLength)
+               buffer.resize(inputLength);
             /* Get data from the PLC */
             bool indata_updated;
             uint8_t indata_iops;
@@ -321,16 +513,24 @@ void ProfinetInternal::HandleCyclicData ()
                   subslot);
                submodule.SetLastInputIops(PNET_IOXS_BAD);
                submodule.SetDefaultInput();
+               processImage.SetInput(subslotIx, nullptr, 0, PNET_IOXS_BAD);
+               processImageRecorder.SetInput(subslotIx, nullptr, 0, PNET_IOXS_BAD);
             }
             else
             {
+               processImage.SetInput(subslotIx, buffer.data(), inputLengthTmp, indata_iops);
+               processImageRecorder.SetInput(subslotIx, buffer.data(), inputLengthTmp, indata_iops);
                if (submodule.GetLastInputIops() != indata_iops)
                {
-                  Log(logDebug, PrintIoxsChange (
-                     slot,
-                     subslot,
-                     "Provider Status (IOPS)",
-                     indata_iops).c_str());
+                  if(IsLogEnabled(logDebug))
+                  {
+                     tools::AllocationGuardSuspend allocationGuardSuspend;
+                     Log(logDebug, "%s", PrintIoxsChange (
+                        slot,
+                        subslot,
+                        "Provider Status (IOPS)",
+                        indata_iops).c_str());
+                  }
                   submodule.SetLastInputIops(indata_iops);
                }
                if (inputLength != inputLengthTmp)
@@ -355,8 +555,8 @@ void ProfinetInternal::HandleCyclicData ()
 
          if (outputLength>0)
          {
-            if(buffer.capacity() < outputLength)
-               buffer.reserve(outputLength);
+            if(buffer.size() < outputLength)
+               buffer.resize(outputLength);
             std::size_t writtenOutputLength{outputLength};
             
             
@@ -378,6 +578,7 @@ void ProfinetInternal::HandleCyclicData ()
                Log(logError, "Failed to get output for submodule in slot %u subslot %u. Sending producer state BAD to controller. Is there something wrong with the application logic?",
                   slot,
                   subslot);
+               writtenOutputLength = 0;
                ret = pnet_input_set_data_and_iops (
                   profinetStack,
                   api,
@@ -400,11 +601,15 @@ void ProfinetInternal::HandleCyclicData ()
             {
                if (submodule.GetLastOutputIocs() != outdata_iocs)
                {
-                  Log(logDebug, PrintIoxsChange(
-                     slot,
-                     subslot,
-                     "Consumer Status (IOCS)",
-                     outdata_iocs).c_str());
+                  if(IsLogEnabled(logDebug))
+                  {
+                     tools::AllocationGuardSuspend allocationGuardSuspend;
+                     Log(logDebug, "%s", PrintIoxsChange(
+                        slot,
+                        subslot,
+                        "Consumer Status (IOCS)",
+                        outdata_iocs).c_str());
+                  }
                   submodule.SetLastOutputIocs(outdata_iocs);
                }
             }
@@ -418,11 +623,52 @@ void ProfinetInternal::HandleCyclicData ()
                   submodule.SetLastOutputIocs(PNET_IOXS_BAD);
                }   
             }
+            processImage.SetOutput(subslotIx, buffer.data(), writtenOutputLength, submodule.GetLastOutputIocs());
+            processImageRecorder.SetOutput(subslotIx, buffer.data(), writtenOutputLength, submodule.GetLastOutputIocs());
          }
+         subslotIx++;
+      }
+   }
+   processImage.EndCycle();
+   if(processImageRecorder.IsOpen())
+   {
+      uint16_t ppmCycle{0};
+      uint16_t cpmCycle{0};
+      pnet_get_cycle_counters(profinetStack, arep, &ppmCycle, &cpmCycle);
+      processImageRecorder.EndCycle(ppmCycle, cpmCycle);
+   }
+}
+void ProfinetInternal::PresizeCyclicBuffers()
+{
+   std::size_t maxLength{0};
+   for (auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for (auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         maxLength = std::max({maxLength, itSubmodules->second.GetInputLengthInBytes(), itSubmodules->second.GetOutputLengthInBytes()});
       }
    }
+   if(cyclicBuffer.size() < maxLength)
+      cyclicBuffer.resize(maxLength);
 }
-inline bool ProfinetInternal::IsConnectedToController()
+
+bool ProfinetInternal::LockMemory()
+{
+   // Do not return freed memory to the operating system, and do not use mmap for large allocations,
+   // such that memory, once locked, stays available to malloc without page faults.
+   mallopt(M_TRIM_THRESHOLD, -1);
+   mallopt(M_MMAP_MAX, 0);
+   if(mlockall(MCL_CURRENT | MCL_FUTURE))
+   {
+      int errsv = errno;
+      Log(logError, "Could not lock memory for real-time mode: %s. Are CAP_IPC_LOCK or RLIMIT_MEMLOCK sufficient?", strerror(errsv));
+      return false;
+   }
+   Log(logInfo, "Memory locked for real-time mode.");
+   return true;
+}
+
+inline bool ProfinetInternal::IsConnectedToController() const
 {
    return arep != arepNull;
 }
@@ -479,24 +725,64 @@ inline bool ProfinetInternal::HandleSendAlarmAck()
    }
 }
 
+std::chrono::steady_clock::time_point ProfinetInternal::GetNextWakeup() const
+{
+   auto& properties{configuration.GetProperties()};
+   auto now{std::chrono::steady_clock::now()};
+   auto wakeup{IsConnectedToController() ? nextCycle : now + std::chrono::microseconds{properties.maxIdleSleepUs}};
+   
+   uint32_t timeoutUs;
+   if(pnet_get_next_timeout_us(profinetStack, &timeoutUs) == 0)
+      wakeup = std::min(wakeup, now + std::chrono::microseconds{timeoutUs});
+   return wakeup;
+}
+
 void ProfinetInternal::loop()
 {
+   if(configuration.GetProperties().realtimeMemory)
+      PrefaultStack(configuration.GetProperties().stackPrefaultBytes);
    arep = arepNull;
 
    SetLed(false);
-   PlugDap(profinetStack, networkInterfaces.size());
+   {
+      StackLock lock{profinetStack};
+      PlugDap(profinetStack, networkInterfaces.size());
+   }
    Log(logInfo, "Waiting for PLC connect request...");
 
+   const bool tickless{configuration.GetProperties().tickless};
+   const auto period{std::chrono::microseconds{configuration.GetProperties().cycleTimeUs}};
+   nextCycle = std::chrono::steady_clock::now();
+
    // Main event loop
    while(true)
    {
-      synchronizationEvents.ReceiveEvents();
+      if(tickless)
+         synchronizationEvents.ReceiveEventsUntil(GetNextWakeup());
+      else
+         synchronizationEvents.ReceiveEvents();
       if(synchronizationEvents.ProcessReadyForData())
       {
+         StackLock lock{profinetStack};
+         if(processImage.IsOpen())
+         {
+            if(!processImage.Build(device, configuration.GetDevice().properties.api))
+               Log(logWarning, "Could not resize the shared memory of the process image.");
+            processImage.SetConnected(true);
+         }
+         if(processImageRecorder.IsMapped())
+         {
+            const auto& recordFile{configuration.GetProperties().processImageRecordFile};
+            if(!processImageRecorder.Build(device, configuration.GetDevice().properties.api))
+               Log(logWarning, "The process image of the plugged modules does not fit into %s. It is not recorded.", recordFile.c_str());
+            else if(processImageRecorder.IsShortened())
+               Log(logWarning, "The plugged modules have more data than configured. %s only keeps the last %u cycles.", recordFile.c_str(), processImageRecorder.GetNumRecords());
+         }
          SendApplicationReady(arepForReady);
       }
       else if(synchronizationEvents.ProcessAlarm())
       {
+         StackLock lock{profinetStack};
          HandleSendAlarmAck();
       }
       else if(synchronizationEvents.ProcessCycle())
@@ -516,9 +802,19 @@ void ProfinetInternal::loop()
             }
             count--;
          }
-         if(IsConnectedToController())
+         if(tickless)
          {
-            HandleCyclicData();
+            // Woken up either by the cycle deadline or by a timeout of the stack.
+            auto now{std::chrono::steady_clock::now()};
+            if(now >= nextCycle)
+               nextCycle = now + period;
+         }
+         {
+            StackLock lock{profinetStack};
+            if(IsConnectedToController())
+            {
+               HandleCyclicData();
+            }
          }
 
          // Run p-net stack 
@@ -527,10 +823,20 @@ void ProfinetInternal::loop()
       else if (synchronizationEvents.ProcessAbort())
       {
          arep = arepNull;
+         processImage.SetConnected(false);
          alarmAllowed = true;
          Log(logInfo, "Connection closed.");
          Log(logInfo, "Waiting for PLC connect request...");
       }
+      else if (synchronizationEvents.ProcessReschedule())
+      {
+         // Nothing to do. Next wakeup time is recalculated when waiting for the next events.
+      }
+      // Not part of the chain above, such that completed records neither delay nor are delayed by the cycle.
+      if(synchronizationEvents.ProcessRecordDone())
+      {
+         HandleRecordsDone();
+      }
    }
 }
 
@@ -543,28 +849,39 @@ bool ProfinetInternal::Start()
    }
    Log(logInfo, "Starting profinet interface...");
 
-  // Create timer, which regularly schedules cyclic data processing
-  // TODO: Ever stop this timer?
-  std::thread timer([this]()
+   // Create timer, which regularly schedules cyclic data processing.
+   // In tickless mode, the main thread itself sleeps until the next deadline, and no timer is needed.
+   // TODO: Ever stop this timer?
+   if(!configuration.GetProperties().tickless)
    {
-      //auto lastTime{std::chrono::steady_clock::now()};
-      const auto period{std::chrono::microseconds{configuration.GetProperties().cycleTimeUs}};
+      std::thread timer([this]()
+      {
+         if(configuration.GetProperties().realtimeMemory)
+            PrefaultStack(configuration.GetProperties().stackPrefaultBytes);
+         //auto lastTime{std::chrono::steady_clock::now()};
+         const auto period{std::chrono::microseconds{configuration.GetProperties().cycleTimeUs}};
 
-      while(true)
+         while(true)
+         {
+            this->synchronizationEvents.SignalCycle();
+            //lastTime += period;
+            //std::this_thread::sleep_until(lastTime);
+            std::this_thread::sleep_for(period);
+         }
+      });
+      sched_param timerScheduleParameters;
+      timerScheduleParameters.sched_priority = configuration.GetProperties().cycleTimerPriority;
+      if(pthread_setschedparam(timer.native_handle(), SCHED_FIFO, &timerScheduleParameters))
       {
-         this->synchronizationEvents.SignalCycle();
-         //lastTime += period;
-         //std::this_thread::sleep_until(lastTime);
-         std::this_thread::sleep_for(period);
+         Log(logWarning, "Could not set scheduling policy and priority for timer thread which schedules cyclic processing of profinet data.");
       }
-   });
-   sched_param timerScheduleParameters;
-   timerScheduleParameters.sched_priority = configuration.GetProperties().cycleTimerPriority;
-   if(pthread_setschedparam(timer.native_handle(), SCHED_FIFO, &timerScheduleParameters))
-   {
-      Log(logWarning, "Could not set scheduling policy and priority for timer thread which schedules cyclic processing of profinet data.");
+      pthread_t timerHandle{timer.native_handle()};
+      if(os_thread_set_affinity(&timerHandle, configuration.GetProperties().cycleTimerCpuMask))
+      {
+         Log(logWarning, "Could not set CPU affinity of timer thread which schedules cyclic processing of profinet data.");
+      }
+      timer.detach();
    }
-   timer.detach();
 
   // Create thread which is responsible for cyclic data processing, alarms etc.
   // TODO: Ever stop this thread?
@@ -575,6 +892,11 @@ bool ProfinetInternal::Start()
    {
       Log(logWarning, "Could not set scheduling policy and priority for main thread which processes profinet cyclic data, alarms etc.");
    }
+   pthread_t mainThreadHandle{mainThread.native_handle()};
+   if(os_thread_set_affinity(&mainThreadHandle, configuration.GetProperties().cycleWorkerCpuMask))
+   {
+      Log(logWarning, "Could not set CPU affinity of main thread which processes profinet cyclic data, alarms etc.");
+   }
    mainThread.detach();
 
    return true;
@@ -597,6 +919,7 @@ pnet_cfg_t ProfinetInternal::InitializePnetConfig()
    auto lowByte = [](const uint16_t value)-> uint8_t{return static_cast<uint8_t>(value & 0xFF);};
 
    pnet_cfg.tick_us = configuration.GetProperties().cycleTimeUs;
+   pnet_cfg.tickless = configuration.GetProperties().tickless;
 
    auto& props{configuration.GetDevice().properties};
    /* Identification & Maintenance */
@@ -696,6 +1019,8 @@ pnet_cfg_t ProfinetInternal::InitializePnetConfig()
    pnet_cfg.ccontrol_cb = wrapFunction<&ProfinetInternal::CallbackCControlCnf>;
    pnet_cfg.read_cb = wrapFunction<&ProfinetInternal::CallbackReadInd>;
    pnet_cfg.write_cb = wrapFunction<&ProfinetInternal::CallbackWriteInd>;
+   pnet_cfg.write_chunk_cb = wrapFunction<&ProfinetInternal::CallbackWriteChunkInd>;
+   pnet_cfg.write_multiple_cb = wrapFunction<&ProfinetInternal::CallbackWriteMultipleInd>;
    pnet_cfg.exp_module_cb = wrapFunction<&ProfinetInternal::CallbackExpModuleInd>;
    pnet_cfg.exp_submodule_cb = wrapFunction<&ProfinetInternal::CallbackExpSubmoduleInd>;
    pnet_cfg.new_data_status_cb = wrapFunction<&ProfinetInternal::CallbackNewDataStatusInd>;
@@ -704,6 +1029,7 @@ pnet_cfg_t ProfinetInternal::InitializePnetConfig()
    pnet_cfg.alarm_ack_cnf_cb = wrapFunction<&ProfinetInternal::CallbackAlarmAckCnf>;
    pnet_cfg.reset_cb = wrapFunction<&ProfinetInternal::CallbackResetInd>;
    pnet_cfg.signal_led_cb = wrapFunction<&ProfinetInternal::CallbackSignalLedInd>;
+   pnet_cfg.next_timeout_cb = wrapFunction<&ProfinetInternal::CallbackNextTimeoutInd>;
 
    pnet_cfg.cb_arg = (void *)this;
 
@@ -718,6 +1044,9 @@ int ProfinetInternal::CallbackConnectInd (
    pnet_result_t * p_result)
 {
    Log(logInfo, "PLC connected to device (AREP: %u). Establishing communication...", arep);
+   // The parameters written until PRMEND are applied as a batch.
+   AbortParameterTransaction();
+   BeginParameterTransaction();
    /*
     * TODO:
     *  Handle the request on an application level.
@@ -780,6 +1109,14 @@ int ProfinetInternal::CallbackDControlInd (
       "The PLC is done with parameter writing (AREP: %u  Command: %s).",
       arep,
       dcontrol_cmd_to_string (control_command));
+   if(control_command == PNET_CONTROL_COMMAND_PRM_END && !EndParameterTransaction(true))
+   {
+      p_result->pnio_status.error_code = PNET_ERROR_CODE_CONTROL;
+      p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIO;
+      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_DCTRL_FAULTY_CONNECT;
+      p_result->pnio_status.error_code_2 = PNET_ERROR_CODE_2_DCTRL_FAULTY_CONNECT_CONTROLCOMMAND;
+      return -1;
+   }
    return 0;
 }
 
@@ -799,84 +1136,116 @@ int ProfinetInternal::CallbackCControlCnf (
    return 0;
 }
 
-int ProfinetInternal::CallbackWriteInd (
-   pnet_t * net,
+ParameterInstance* ProfinetInternal::FindParameter(
    uint32_t arep,
    uint32_t api,
    uint16_t slot,
    uint16_t subslot,
    uint16_t idx,
-   uint16_t sequence_number,
-   uint16_t write_length,
-   const uint8_t * p_write_data,
-   pnet_result_t * p_result)
+   const char* access)
 {
-   Log(logDebug,
-      "PLC writes value of parameter %u in slot %2u, subslot %2u (AREP: %u, API: %u, Sequence: %2u, Length: %u).",
-      (unsigned)idx,
-      slot,
-      subslot,
-      arep,
-      api,
-      sequence_number,
-      write_length);
+   if(!recordIndex.IsValid())
+      recordIndex.Build(device, configuration.GetDevice().properties.api);
+   ParameterInstance* parameterInstance = recordIndex.Find(api, slot, subslot, idx);
+   if(parameterInstance)
+      return parameterInstance;
 
+   // Not found. Only look up what is missing, for the log.
    ModuleInstance* moduleInstance = device.GetModule(slot);
+   SubmoduleInstance* submoduleInstance = moduleInstance ? moduleInstance->GetSubmodule(subslot) : nullptr;
    if(!moduleInstance)
    {
       Log(logWarning,
-         "PLC could not write value of parameter %u in slot %2u, subslot %2u: no module plugged in slot %2u  (AREP: %u, API: %u).",
+         "PLC could not %s value of parameter %u in slot %2u, subslot %2u: no module plugged in slot %2u  (AREP: %u, API: %u).",
+         access,
          (unsigned)idx,
          slot,
          subslot,
          slot,
          arep,
          api);
-      p_result->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
-      p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
-      p_result->pnio_status.error_code_2 = 0; // User specific
-
-      return -1;
-   }           
-   
-   SubmoduleInstance* submoduleInstance = moduleInstance->GetSubmodule(subslot);  
-   if(!submoduleInstance)
+   }
+   else if(!submoduleInstance)
    {
       Log(logWarning,
-         "PLC could not write value of parameter %u in slot %2u, subslot %2u: no submodule plugged in subslot %2u of module (AREP: %u, API: %u).",
+         "PLC could not %s value of parameter %u in slot %2u, subslot %2u: no submodule plugged in subslot %2u of module (AREP: %u, API: %u).",
+         access,
          (unsigned)idx,
          slot,
          subslot,
          subslot,
          arep,
          api);
-      p_result->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
-      p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
-      p_result->pnio_status.error_code_2 = 0; // User specific
-
-      return -1;
-   }           
-   ParameterInstance* parameterInstance = submoduleInstance->GetParameter(idx);
-   if(!submoduleInstance)
+   }
+   else
    {
       Log(logWarning,
-         "PLC could not write value of parameter %u in slot %2u, subslot %2u: submodule does not have parameter with index %u  (AREP: %u, API: %u).",
+         "PLC could not %s value of parameter %u in slot %2u, subslot %2u: submodule does not have parameter with index %u  (AREP: %u, API: %u).",
+         access,
          (unsigned)idx,
          slot,
          subslot,
          (unsigned)idx,
          arep,
          api);
+   }
+   return nullptr;
+}
+
+int ProfinetInternal::CallbackWriteInd (
+   pnet_t * net,
+   uint32_t arep,
+   uint32_t api,
+   uint16_t slot,
+   uint16_t subslot,
+   uint16_t idx,
+   uint16_t sequence_number,
+   uint16_t write_length,
+   const uint8_t * p_write_data,
+   pnet_result_t * p_result)
+{
+   Log(logDebug,
+      "PLC writes value of parameter %u in slot %2u, subslot %2u (AREP: %u, API: %u, Sequence: %2u, Length: %u).",
+      (unsigned)idx,
+      slot,
+      subslot,
+      arep,
+      api,
+      sequence_number,
+      write_length);
+
+   ParameterInstance* parameterInstance = FindParameter(arep, api, slot, subslot, idx, "write");
+   if(!parameterInstance)
+   {
       p_result->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
       p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
       p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
       p_result->pnio_status.error_code_2 = 0; // User specific
 
       return -1;
-   }         
-   bool success = parameterInstance->Set(p_write_data, static_cast<std::size_t>(write_length));
+   }
+   AddToParameterTransaction(slot, subslot);
+   bool success{false};
+   if(parameterInstance->IsAsynchronous() && recordWorker.IsRunning())
+   {
+      RecordWorker::Job job{true, arep, sequence_number, api, slot, subslot, idx, parameterInstance,
+         std::vector<uint8_t>(p_write_data, p_write_data + write_length)};
+      job.persistent = GetParameterStoreKey(parameterInstance, slot, subslot, idx, job.storeKey);
+      job.batch = transactionBatch;
+      job.number = ++lastJobNumber;
+      if(pnet_record_response_deferrable(net))
+      {
+         recordWorker.Submit(std::move(job));
+         return PNET_RECORD_PENDING;
+      }
+      // E.g. part of a write multiple. Still must not run concurrently with the record workers.
+      recordWorker.Run(job);
+      success = job.success;
+   }
+   else
+   {
+      success = parameterInstance->Set(p_write_data, static_cast<std::size_t>(write_length));
+   }
    if (!success)
    {
       Log(logWarning,
@@ -892,10 +1261,16 @@ int ProfinetInternal::CallbackWriteInd (
       p_result->pnio_status.error_code_2 = 0; // User specific 
       return -1;
    }
+   ParameterStore::Key storeKey{};
+   if(GetParameterStoreKey(parameterInstance, slot, subslot, idx, storeKey))
+   {
+      std::lock_guard lock{transactionMutex};
+      PersistParameter(slot, subslot, storeKey, transactionBatch, p_write_data, static_cast<std::size_t>(write_length));
+   }
    return 0;
 }
 
-int ProfinetInternal::CallbackReadInd (
+int ProfinetInternal::CallbackWriteChunkInd (
    pnet_t * net,
    uint32_t arep,
    uint32_t api,
@@ -903,77 +1278,384 @@ int ProfinetInternal::CallbackReadInd (
    uint16_t subslot,
    uint16_t idx,
    uint16_t sequence_number,
-   uint8_t ** pp_read_data,
-   uint16_t * p_read_length,
+   uint32_t offset,
+   uint32_t total_length,
+   uint16_t data_length,
+   const uint8_t * p_data,
    pnet_result_t * p_result)
 {
    Log(logDebug,
-      "PLC reads value of parameter %u in slot %2u, subslot %2u (AREP: %u, API: %u, Sequence: %2u, Max Length: %u).",
+      "PLC writes part of parameter %u in slot %2u, subslot %2u (AREP: %u, API: %u, Sequence: %2u, Offset: %u, Length: %u of %u).",
       (unsigned)idx,
       slot,
       subslot,
       arep,
       api,
       sequence_number,
-      (unsigned)*p_read_length);
+      offset,
+      data_length,
+      total_length);
 
-   ModuleInstance* moduleInstance = device.GetModule(slot);
-   if(!moduleInstance)
+   ParameterInstance* parameterInstance = FindParameter(arep, api, slot, subslot, idx, "write");
+   if(data_length == 0 && !p_data)
    {
-      Log(logWarning,
-         "PLC could not read value of parameter %u in slot %2u, subslot %2u: no module plugged in slot %2u  (AREP: %u, API: %u).",
-         (unsigned)idx,
-         slot,
-         subslot,
-         slot,
-         arep,
-         api);
-      p_result->pnio_status.error_code = PNET_ERROR_CODE_READ;
+      // Asked before the first part. Other records are collected by the stack and written like single frames, such
+      // that asynchronous and persistent parameters are handled as usual.
+      return parameterInstance && parameterInstance->HasWriteChunkCallback() ? 0 : PNET_WRITE_NOT_STREAMED;
+   }
+   bool success{false};
+   if(parameterInstance)
+   {
+      AddToParameterTransaction(slot, subslot);
+      auto setChunk{[&]()
+      {
+         success = parameterInstance->SetChunk(offset, total_length, p_data, static_cast<std::size_t>(data_length));
+      }};
+      if(parameterInstance->IsAsynchronous() && recordWorker.IsRunning())
+         recordWorker.RunExclusive(parameterInstance, setChunk);
+      else
+         setChunk();
+      if(!success)
+      {
+         Log(logWarning,
+            "PLC could not write value of parameter %u in slot %2u, subslot %2u: Write process of the part at offset %u of %u failed. Maybe the data sent from the PLC is invalid or too long, or the parameter is misconfigured (AREP: %u, API: %u).",
+            (unsigned)idx,
+            slot,
+            subslot,
+            offset,
+            total_length,
+            arep,
+            api);
+      }
+   }
+   if(!success)
+   {
+      p_result->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
       p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_READ_ERROR;
+      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
       p_result->pnio_status.error_code_2 = 0; // User specific
-
       return -1;
-   }           
-   
-   SubmoduleInstance* submoduleInstance = moduleInstance->GetSubmodule(subslot);  
-   if(!submoduleInstance)
+   }
+   return 0;
+}
+
+int ProfinetInternal::CallbackWriteMultipleInd (
+   pnet_t * net,
+   uint32_t arep,
+   pnet_write_multiple_event_t event,
+   pnet_result_t * p_result)
+{
+   switch(event)
    {
-        Log(logWarning,
-         "PLC could not read value of parameter %u in slot %2u, subslot %2u: no submodule plugged in subslot %2u of module (AREP: %u, API: %u).",
-         (unsigned)idx,
-         slot,
-         subslot,
-         subslot,
-         arep,
-         api);
-      p_result->pnio_status.error_code = PNET_ERROR_CODE_READ;
-      p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
-      p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_READ_ERROR;
-      p_result->pnio_status.error_code_2 = 0; // User specific
+   case PNET_WRITE_MULTIPLE_BEGIN:
+      BeginParameterTransaction();
+      break;
+   case PNET_WRITE_MULTIPLE_COMMIT:
+      if(!EndParameterTransaction(true))
+      {
+         p_result->pnio_status.error_code = PNET_ERROR_CODE_WRITE;
+         p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+         p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
+         p_result->pnio_status.error_code_2 = 0; // User specific
+         return -1;
+      }
+      break;
+   case PNET_WRITE_MULTIPLE_ABORT:
+      EndParameterTransaction(false);
+      break;
+   }
+   return 0;
+}
 
-      return -1;
-   }           
-   ParameterInstance* parameterInstance = submoduleInstance->GetParameter(idx);
-   if(!submoduleInstance)
+void ProfinetInternal::BeginParameterTransaction()
+{
+   if(transactionDepth++ == 0)
+   {
+      transactionSubmodules.clear();
+      std::lock_guard lock{transactionMutex};
+      transactionValues.clear();
+      transactionBatch = ++lastTransactionBatch;
+   }
+}
+
+void ProfinetInternal::AddToParameterTransaction(uint16_t slot, uint16_t subslot)
+{
+   if(transactionDepth == 0)
+      return;
+   auto it{std::find_if(transactionSubmodules.begin(), transactionSubmodules.end(),
+      [slot, subslot](const TransactionSubmodule& other){return other.slot == slot && other.subslot == subslot;})};
+   if(it != transactionSubmodules.end())
+   {
+      it->depth = std::max(it->depth, transactionDepth);
+      return;
+   }
+   auto module{device.GetModule(slot)};
+   auto submodule{module ? module->GetSubmodule(subslot) : nullptr};
+   if(!submodule)
+      return;
+   transactionSubmodules.push_back(TransactionSubmodule{slot, subslot, transactionDepth});
+   submodule->BeginTransaction();
+}
+
+bool ProfinetInternal::EndParameterTransaction(bool commit)
+{
+   if(transactionDepth == 0)
+      return true;
+   if(transactionDepth > 1)
+   {
+      // A nested batch does not affect the outermost one, as the PLC got its result in the response already. Its
+      // submodules are applied with the outermost batch, or discarded at once if it failed.
+      const unsigned int depth{transactionDepth--};
+      if(commit)
+      {
+         for(auto& transactionSubmodule : transactionSubmodules)
+            transactionSubmodule.depth = std::min(transactionSubmodule.depth, transactionDepth);
+      }
+      else
+      {
+         DiscardParameterTransaction(depth);
+      }
+      return commit;
+   }
+   transactionDepth = 0;
+
+   // The set callbacks of asynchronous parameters must have returned.
+   recordWorker.WaitIdle();
+   std::vector<TransactionValue> values{};
+   {
+      std::lock_guard lock{transactionMutex};
+      StageCompletedJobs();
+      values = std::move(transactionValues);
+      transactionValues.clear();
+      transactionBatch = 0;
+   }
+   bool success{true};
+   for(const auto& transactionSubmodule : transactionSubmodules)
+   {
+      auto module{device.GetModule(transactionSubmodule.slot)};
+      auto submodule{module ? module->GetSubmodule(transactionSubmodule.subslot) : nullptr};
+      if(submodule && !submodule->EndTransaction(commit) && commit)
+      {
+         Log(logWarning,
+            "Application rejected the parameters written by the PLC to slot %2u, subslot %2u.",
+            transactionSubmodule.slot,
+            transactionSubmodule.subslot);
+         success = false;
+      }
+   }
+   transactionSubmodules.clear();
+   if(success && commit)
+   {
+      for(const auto& value : values)
+         parameterStore.Store(value.key, value.data.data(), value.data.size());
+   }
+   return success && commit;
+}
+
+void ProfinetInternal::DiscardParameterTransaction(unsigned int depth)
+{
+   recordWorker.WaitIdle();
+   std::vector<TransactionSubmodule> discarded{};
+   auto it{std::stable_partition(transactionSubmodules.begin(), transactionSubmodules.end(),
+      [depth](const TransactionSubmodule& transactionSubmodule){return transactionSubmodule.depth < depth;})};
+   discarded.assign(it, transactionSubmodules.end());
+   transactionSubmodules.erase(it, transactionSubmodules.end());
+   for(const auto& transactionSubmodule : discarded)
+   {
+      auto module{device.GetModule(transactionSubmodule.slot)};
+      auto submodule{module ? module->GetSubmodule(transactionSubmodule.subslot) : nullptr};
+      if(submodule)
+         submodule->EndTransaction(false);
+   }
+
+   // The application discarded all values of these submodules, also those written before the nested batch.
+   std::lock_guard lock{transactionMutex};
+   StageCompletedJobs();
+   transactionValues.erase(std::remove_if(transactionValues.begin(), transactionValues.end(),
+      [&discarded](const TransactionValue& value)
+      {
+         return std::any_of(discarded.begin(), discarded.end(), [&value](const TransactionSubmodule& other)
+            {
+               return other.slot == value.slot && other.subslot == value.subslot;
+            });
+      }), transactionValues.end());
+}
+
+// Call with transactionMutex locked, and with no job queued or running.
+void ProfinetInternal::StageCompletedJobs()
+{
+   // Successful asynchronous writes of the batch whose responses are not sent yet. The main thread does not stage
+   // them again when it takes them.
+   recordWorker.ForEachCompleted([this](const RecordWorker::Job& job)
+   {
+      if(job.write && job.success && job.persistent && job.batch == transactionBatch && job.number > stagedJobNumber)
+         transactionValues.push_back(TransactionValue{job.slot, job.subslot, job.storeKey, job.data});
+   });
+   stagedJobNumber = lastJobNumber;
+}
+
+void ProfinetInternal::AbortParameterTransaction()
+{
+   if(transactionDepth == 0)
+      return;
+   transactionDepth = 1;
+   EndParameterTransaction(false);
+}
+
+bool ProfinetInternal::OpenParameterStore(const std::string& directory)
+{
+   const Device& deviceConfiguration{configuration.GetDevice()};
+   bool anyPersistent{false};
+   for(const auto& moduleWithPlugInfo : deviceConfiguration.modules)
+   {
+      for(const auto& submodule : moduleWithPlugInfo.module.submodules)
+      {
+         for(const auto& parameter : submodule.parameters)
+            anyPersistent = anyPersistent || parameter.properties.persistent;
+      }
+   }
+   if(!anyPersistent)
+      return true;
+
+   const std::string path{(std::filesystem::path{directory} / "profipp_parameters.bin").string()};
+   if(!parameterStore.Open(path, configuration.GetProperties().parameterStoreBytes))
+   {
+      Log(logError, "Could not open %s to store the values of persistent parameters: %s", path.c_str(), strerror(errno));
+      return false;
+   }
+   // Restore the values before the PLC connects, such that it does not have to send them again. The values of each
+   // submodule are set as a batch, like the parameterization by the PLC.
+   unsigned int numRestored{0};
+   std::vector<uint8_t> value{};
+   for(const auto& moduleWithPlugInfo : deviceConfiguration.modules)
+   {
+      for(const auto& submodule : moduleWithPlugInfo.module.submodules)
+      {
+         bool inTransaction{false};
+         unsigned int numSubmoduleRestored{0};
+         for(const auto& parameter : submodule.parameters)
+         {
+            const ParameterStore::Key key{moduleWithPlugInfo.module.GetId(), submodule.GetId(), parameter.GetIdx()};
+            if(!parameter.properties.persistent || !parameterStore.Load(key, value))
+               continue;
+            if(!inTransaction)
+            {
+               const auto& beginTransactionCallback{submodule.parameters.GetBeginTransactionCallback()};
+               if(beginTransactionCallback)
+                  beginTransactionCallback();
+               inTransaction = true;
+            }
+            const auto& setCallback{parameter.GetSetCallback()};
+            if(value.size() >= parameter.GetLengthInBytes() && setCallback && setCallback(value.data(), value.size()))
+            {
+               numSubmoduleRestored++;
+            }
+            else
+            {
+               Log(logWarning,
+                  "Could not restore stored value of parameter %u of submodule %u in module %u.",
+                  (unsigned)parameter.GetIdx(),
+                  (unsigned)submodule.GetId(),
+                  (unsigned)moduleWithPlugInfo.module.GetId());
+            }
+         }
+         if(!inTransaction)
+            continue;
+         const auto& endTransactionCallback{submodule.parameters.GetEndTransactionCallback()};
+         if(endTransactionCallback && !endTransactionCallback(true))
+         {
+            Log(logWarning,
+               "Application rejected the stored parameters of submodule %u in module %u.",
+               (unsigned)submodule.GetId(),
+               (unsigned)moduleWithPlugInfo.module.GetId());
+            continue;
+         }
+         numRestored += numSubmoduleRestored;
+      }
+   }
+   Log(logInfo, "Restored %u parameter values from %s.", numRestored, path.c_str());
+   return true;
+}
+
+bool ProfinetInternal::GetParameterStoreKey(const ParameterInstance* parameterInstance, uint16_t slot,
+   uint16_t subslot, uint16_t idx, ParameterStore::Key& key)
+{
+   if(!parameterInstance->IsPersistent() || !parameterStore.IsOpen())
+      return false;
+   auto module{device.GetModule(slot)};
+   auto submodule{module ? module->GetSubmodule(subslot) : nullptr};
+   if(!submodule)
+      return false;
+   key = ParameterStore::Key{submodule->GetModuleId(), submodule->GetSubmoduleId(), idx};
+   return true;
+}
+
+// Call with transactionMutex locked.
+void ProfinetInternal::PersistParameter(uint16_t slot, uint16_t subslot, const ParameterStore::Key& key,
+   uint64_t batch, const uint8_t* data, std::size_t numBytes)
+{
+   if(batch == 0)
+      parameterStore.Store(key, data, numBytes);
+   else if(batch == transactionBatch)
+      transactionValues.push_back(TransactionValue{slot, subslot, key, std::vector<uint8_t>(data, data + numBytes)});
+   // Else the batch is over, and took the value if it was committed.
+}
+
+int ProfinetInternal::CallbackReadInd (
+   pnet_t * net,
+   uint32_t arep,
+   uint32_t api,
+   uint16_t slot,
+   uint16_t subslot,
+   uint16_t idx,
+   uint16_t sequence_number,
+   uint8_t ** pp_read_data,
+   uint16_t * p_read_length,
+   pnet_result_t * p_result)
+{
+   Log(logDebug,
+      "PLC reads value of parameter %u in slot %2u, subslot %2u (AREP: %u, API: %u, Sequence: %2u, Max Length: %u).",
+      (unsigned)idx,
+      slot,
+      subslot,
+      arep,
+      api,
+      sequence_number,
+      (unsigned)*p_read_length);
+
+   ParameterInstance* parameterInstance = FindParameter(arep, api, slot, subslot, idx, "read");
+   if(!parameterInstance)
    {
-        Log(logWarning,
-         "PLC could not read value of parameter %u in slot %2u, subslot %2u: submodule does not have parameter with index %u  (AREP: %u, API: %u).",
-         (unsigned)idx,
-         slot,
-         subslot,
-         (unsigned)idx,
-         arep,
-         api);
       p_result->pnio_status.error_code = PNET_ERROR_CODE_READ;
       p_result->pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
       p_result->pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_READ_ERROR;
       p_result->pnio_status.error_code_2 = 0; // User specific
 
       return -1;
-   }         
+   }
    size_t length = static_cast<std::size_t>(*p_read_length);
-   bool success = parameterInstance->Get(pp_read_data, &length);
+   bool success{false};
+   if(parameterInstance->IsAsynchronous() && recordWorker.IsRunning())
+   {
+      RecordWorker::Job job{false, arep, sequence_number, api, slot, subslot, idx, parameterInstance,
+         std::vector<uint8_t>(length)};
+      if(pnet_record_response_deferrable(net))
+      {
+         recordWorker.Submit(std::move(job));
+         return PNET_RECORD_PENDING;
+      }
+      // E.g. an implicit read. The value must stay valid after returning, while the workers reuse the buffer
+      // of the parameter.
+      recordWorker.Run(job);
+      success = job.success;
+      synchronousReadBuffer = std::move(job.data);
+      *pp_read_data = synchronousReadBuffer.data();
+      length = synchronousReadBuffer.size();
+   }
+   else
+   {
+      success = parameterInstance->Get(pp_read_data, &length);
+   }
    if (!success)
    {
       Log(logWarning,
@@ -994,6 +1676,76 @@ int ProfinetInternal::CallbackReadInd (
 }
 
 
+void ProfinetInternal::HandleRecordsDone()
+{
+   RecordWorker::Job job;
+   while(true)
+   {
+      {
+         // Taken and persisted as one step, such that the end of a batch sees the job in one of both places.
+         std::lock_guard lock{transactionMutex};
+         if(!recordWorker.TakeCompleted(job))
+            break;
+         if(job.write && job.success && job.persistent)
+         {
+            if(job.batch == 0 || job.number > stagedJobNumber)
+               PersistParameter(job.slot, job.subslot, job.storeKey, job.batch, job.data.data(), job.data.size());
+         }
+      }
+      pnet_result_t result{};
+      int ret;
+      if(job.write)
+      {
+         if(!job.success)
+         {
+            Log(logWarning,
+               "PLC could not write value of parameter %u in slot %2u, subslot %2u: Write process itself failed. Maybe the data sent from the PLC is invalid, or the parameter is misconfigured (AREP: %u, API: %u).",
+               (unsigned)job.idx,
+               job.slot,
+               job.subslot,
+               job.arep,
+               job.api);
+            result.pnio_status.error_code = PNET_ERROR_CODE_WRITE;
+            result.pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+            result.pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_WRITE_ERROR;
+            result.pnio_status.error_code_2 = 0; // User specific
+         }
+         ret = pnet_write_record_done(profinetStack, job.arep, job.sequenceNumber, job.success ? nullptr : &result);
+      }
+      else
+      {
+         if(!job.success)
+         {
+            Log(logWarning,
+               "PLC could read value of parameter %u in slot %2u, subslot %2u: Read process itself failed. Is there a failure in the application logic, or is the parameter misconfigured (AREP: %u, API: %u).",
+               (unsigned)job.idx,
+               job.slot,
+               job.subslot,
+               job.arep,
+               job.api);
+            result.pnio_status.error_code = PNET_ERROR_CODE_READ;
+            result.pnio_status.error_decode = PNET_ERROR_DECODE_PNIORW;
+            result.pnio_status.error_code_1 = PNET_ERROR_CODE_1_APP_READ_ERROR;
+            result.pnio_status.error_code_2 = 0; // User specific
+         }
+         ret = pnet_read_record_done(profinetStack, job.arep, job.sequenceNumber, job.data.data(),
+            static_cast<uint16_t>(job.data.size()), job.success ? nullptr : &result);
+      }
+      if(ret != 0)
+      {
+         Log(logWarning,
+            "Result of %s parameter %u in slot %2u, subslot %2u is discarded: PLC does not wait for it anymore (AREP: %u, API: %u, Sequence: %2u).",
+            job.write ? "writing" : "reading",
+            (unsigned)job.idx,
+            job.slot,
+            job.subslot,
+            job.arep,
+            job.api,
+            job.sequenceNumber);
+      }
+   }
+}
+
 inline std::string ioxsToString (const pnet_ioxs_values_t& ioxs)
 {
    switch (ioxs)
@@ -1212,6 +1964,8 @@ int ProfinetInternal::CallbackStateInd (
       }
       // Reset all inputs of all submodules. 
       device.SetDefaultInputsAll();
+      // Parameters written by an incomplete parameterization are discarded.
+      AbortParameterTransaction();
 
       // Only abort AR with correct session key
       synchronizationEvents.SignalAbort();
@@ -1222,8 +1976,11 @@ int ProfinetInternal::CallbackStateInd (
       {
          Log(logWarning, "AREP out of sync. Trying to resynchronize connection.");
       }
-      this->arep = arep;
       SetInitialDataAndIoxs();
+      PresizeCyclicBuffers();
+      recordIndex.Build(device, configuration.GetDevice().properties.api);
+      // Published last, as the worker exchanges the cyclic data through cyclicBuffer as soon as it is set.
+      this->arep = arep;
 
       pnet_set_provider_state (net, true);
 
@@ -1260,12 +2017,21 @@ int ProfinetInternal::CallbackSignalLedInd (
    return 0;
 }
 
+void ProfinetInternal::CallbackNextTimeoutInd (
+   pnet_t * net)
+{
+   synchronizationEvents.SignalReschedule();
+}
+
 int ProfinetInternal::CallbackExpModuleInd (
    pnet_t * net,
    uint32_t api,
    uint16_t slot,
    uint32_t moduleId)
 {
+   // Parameters of the plugged submodules change. The record workers must not use them meanwhile.
+   recordIndex.Invalidate();
+   recordWorker.WaitIdle();
    Log(logDebug, "Pulling old module from slot %2u (API: %u)...", slot, api);
    int result = pnet_pull_module (net, api, slot);
    if (result == 0)
@@ -1355,6 +2121,9 @@ int ProfinetInternal::CallbackExpSubmoduleInd (
    uint32_t submoduleId,
    const pnet_data_cfg_t * p_exp_data)
 {
+   // Parameters of the plugged submodules change. The record workers must not use them meanwhile.
+   recordIndex.Invalidate();
+   recordWorker.WaitIdle();
    int ret = -1;
    int result = 0;
    pnet_data_cfg_t data_cfg;
@@ -1493,6 +2262,7 @@ int ProfinetInternal::CallbackExpSubmoduleInd (
    if (ret == 0)
    {
         SubmoduleInstance* submoduleInstance = moduleInstance->CreateInSubslot(subslot);
+        submoduleInstance->SetIdentification(moduleId, submoduleId);
         if(submoduleConfig)
             submoduleInstance->Initialize(*submoduleConfig, subslot);
          else
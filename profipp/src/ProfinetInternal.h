@@ -5,15 +5,30 @@
 
 #include "Profinet.h"
 #include "DeviceInstance.h"
+#include "ProcessImageWriter.h"
+#include "ProcessImageRecorder.h"
+#include "AsyncLogger.h"
+#include "RecordIndex.h"
+#include "RecordWorker.h"
+#include "ParameterStore.h"
 #include "pnet_api.h"
 #include "logging.h"
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+
+#ifndef PROFIPP_MAX_LOG_LEVEL
+#define PROFIPP_MAX_LOG_LEVEL 50
+#endif
 
 namespace profinet
 {
+// Messages above this level are removed at compile time, see PROFIPP_MAX_LOG_LEVEL in CMakeLists.txt.
+inline constexpr LogLevel maxLogLevel{static_cast<LogLevel>(PROFIPP_MAX_LOG_LEVEL)};
+
 class ProfinetInternal final : public ProfinetControl 
 {
 public:
@@ -25,19 +40,37 @@ public:
 
     bool Initialize(const Profinet& configuration, LoggerType logger = logging::CreateConsoleLogger());
     virtual bool Start() override;
-    bool IsConnectedToController();
+    virtual void SetLogLevel(LogLevel logLevel) override;
+    virtual bool SubmitBackgroundJob(JobPriority priority, uint32_t key, const BackgroundJobType& job,
+        const BackgroundJobDoneType& done) override;
+    virtual bool GetCyclicTiming(uint16_t iocrIndex, bool reset, CyclicTiming& timing) override;
+    bool IsConnectedToController() const;
 private:
     DeviceInstance device;
     Profinet configuration;
     LoggerType logFun;
-    void Log(LogLevel logLevel, const char* format, ...) noexcept;    
+    // Formats and passes the messages to logFun on its own thread, if enabled.
+    std::unique_ptr<AsyncLogger> asyncLogger{};
+    std::atomic<LogLevel> activeLogLevel{logInfo};
+    bool IsLogEnabled(LogLevel logLevel) const noexcept
+    {
+        return logLevel <= maxLogLevel && logLevel <= activeLogLevel.load(std::memory_order_relaxed);
+    }
+    // Inline, such that disabled messages cost only the level check, and nothing if removed at compile time.
+    template<typename... Args> void Log(LogLevel logLevel, const char* format, Args... args) noexcept
+    {
+        if(IsLogEnabled(logLevel))
+            LogFormat(logLevel, format, args...);
+    }
+    void LogFormat(LogLevel logLevel, const char* format, ...) noexcept;
     bool alarmAllowed;
     bool initialized;
     pnet_t* profinetStack;
     pnet_cfg_t pnetCfg;
     pnet_alarm_argument_t lastAlarmArguments{};
 
-    uint32_t arep;
+    // Atomic, as GetCyclicTiming() reads it on the thread of the application.
+    std::atomic<uint32_t> arep;
     uint32_t arepForReady;
 
 private:
@@ -48,11 +81,75 @@ private:
     bool HandleSendAlarmAck ();
     bool SetInitialDataAndIoxs();
     void HandleCyclicData();
+    void HandleRecordsDone();
+    void BeginParameterTransaction();
+    void AddToParameterTransaction(uint16_t slot, uint16_t subslot);
+    bool EndParameterTransaction(bool commit);
+    void DiscardParameterTransaction(unsigned int depth);
+    void StageCompletedJobs();
+    void AbortParameterTransaction();
+    bool OpenParameterStore(const std::string& directory);
+    bool GetParameterStoreKey(const ParameterInstance* parameterInstance, uint16_t slot, uint16_t subslot,
+        uint16_t idx, ParameterStore::Key& key);
+    void PersistParameter(uint16_t slot, uint16_t subslot, const ParameterStore::Key& key, uint64_t batch,
+        const uint8_t* data, std::size_t numBytes);
     void SetLed(bool on);
+    bool LockMemory();
+    void PresizeCyclicBuffers();
+    ParameterInstance* FindParameter(uint32_t arep, uint32_t api, uint16_t slot, uint16_t subslot, uint16_t idx, const char* access);
+    std::chrono::steady_clock::time_point GetNextWakeup() const;
 
 private:
     std::string mainNetworkInterface{};
     std::vector<std::string> networkInterfaces{};
+    // Only used in tickless mode: time when the next cyclic data exchange is due.
+    std::chrono::steady_clock::time_point nextCycle{};
+    // Buffer for the cyclic data exchange. Presized at PRMEND, only used by the worker thread.
+    std::vector<uint8_t> cyclicBuffer{};
+    // Process image in shared memory for other processes, if enabled. Only used by the worker thread.
+    ProcessImageWriter processImage{};
+    // Recording of the process image of the last cycles, if enabled. Only used by the worker thread.
+    ProcessImageRecorder processImageRecorder{};
+    // Parameters of the plugged submodules for record reads and writes. Only used by the thread of the stack.
+    RecordIndex recordIndex{};
+    // Runs the callbacks of asynchronous parameters, if any record worker threads are configured.
+    RecordWorker recordWorker{};
+    // Value of the last synchronous read of an asynchronous parameter. Only used by the thread of the stack.
+    std::vector<uint8_t> synchronousReadBuffer{};
+    struct TransactionSubmodule
+    {
+        uint16_t slot;
+        uint16_t subslot;
+        // Innermost batch which wrote to the submodule, 1 for the outermost.
+        unsigned int depth;
+    };
+    struct TransactionValue
+    {
+        uint16_t slot;
+        uint16_t subslot;
+        ParameterStore::Key key;
+        std::vector<uint8_t> data;
+    };
+    // Submodules whose parameters were written in the current batch, see
+    // Submodule::Parameters::SetTransactionCallbacks(). Only used by the thread of the stack.
+    std::vector<TransactionSubmodule> transactionSubmodules{};
+    // Nesting of batches: the parameterization when connecting, and the write multiple requests within.
+    unsigned int transactionDepth{0};
+    // Protects transactionBatch, transactionValues and stagedJobNumber, which the main thread uses for completed
+    // asynchronous writes.
+    std::mutex transactionMutex{};
+    // Identifies the current outermost batch, or 0 if there is none.
+    uint64_t transactionBatch{0};
+    uint64_t lastTransactionBatch{0};
+    // Number of the last asynchronous write submitted, see RecordWorker::Job::number, and of the last one whose
+    // value is staged in transactionValues if it succeeded.
+    uint64_t lastJobNumber{0};
+    uint64_t stagedJobNumber{0};
+    // Values of persistent parameters, see ParameterProperties::persistent, written in the current batch. Only
+    // stored if it is committed.
+    std::vector<TransactionValue> transactionValues{};
+    // Values of persistent parameters, if any. Closed after the record workers are stopped.
+    ParameterStore parameterStore{};
     
     class
     {
@@ -68,6 +165,8 @@ private:
         const unsigned int eventReadyForData{2};
         const unsigned int eventAlarm{4};
         const unsigned int eventAbort{8};
+        const unsigned int eventReschedule{16};
+        const unsigned int eventRecordDone{32};
     public:
         /**
          * Should only be called by worker thread.
@@ -81,6 +180,19 @@ private:
             receivedEvents |= signaledEvents;
             signaledEvents = 0;
         }
+        /**
+         * Should only be called by worker thread.
+         * Worker thread waits until at least one signal is signaled, or until the deadline is reached. 
+         * Reaching the deadline counts as the signal for cyclic data processing.
+         */
+        inline void ReceiveEventsUntil(const std::chrono::steady_clock::time_point& deadline)
+        {
+            std::unique_lock lock{mutex};
+            if(!signaledEvents && condition.wait_until(lock, deadline) == std::cv_status::timeout)
+                signaledEvents |= eventCycle;
+            receivedEvents |= signaledEvents;
+            signaledEvents = 0;
+        }
         /**
          * Signals to the worker thread that it should process cyclic data.
          */
@@ -125,6 +237,28 @@ private:
             }
             condition.notify_one();
         }
+        /**
+         * Signals to the worker thread that it should recalculate when to wake up next.
+         */
+        inline void SignalReschedule()
+        {
+            {
+                std::lock_guard lock{mutex};
+                signaledEvents |= eventReschedule;
+            }
+            condition.notify_one();
+        }
+        /**
+         * Signals to the worker thread that a record worker completed a record read or write.
+         */
+        inline void SignalRecordDone()
+        {
+            {
+                std::lock_guard lock{mutex};
+                signaledEvents |= eventRecordDone;
+            }
+            condition.notify_one();
+        }
         /**
          * Should only be called by worker thread.
          * Checks if it received the signal for cyclic data processing.
@@ -169,6 +303,28 @@ private:
             receivedEvents &= ~eventAbort;
             return temp;
         }
+        /**
+         * Should only be called by worker thread.
+         * Checks if it received the signal to reschedule.
+         * Also, resets this signal.
+         */
+        inline bool ProcessReschedule()
+        {
+            bool temp = (receivedEvents & eventReschedule);
+            receivedEvents &= ~eventReschedule;
+            return temp;
+        }
+        /**
+         * Should only be called by worker thread.
+         * Checks if it received the signal that a record read or write completed.
+         * Also, resets this signal.
+         */
+        inline bool ProcessRecordDone()
+        {
+            bool temp = (receivedEvents & eventRecordDone);
+            receivedEvents &= ~eventRecordDone;
+            return temp;
+        }
     } synchronizationEvents;
 
     
@@ -416,6 +572,58 @@ public:
         const uint8_t * p_write_data,
         pnet_result_t * p_result);
 
+    /**
+     * Indication to the application that a part of a large IODWrite request was
+     * received from the controller, see pnet_write_chunk_ind(). Passed on to
+     * ParameterInstance::SetChunk().
+     *
+     * @param net              InOut: The p-net stack instance
+     * @param arep             In:    The AREP.
+     * @param api              In:    The API identifier.
+     * @param slot             In:    The slot number.
+     * @param subslot          In:    The sub-slot number.
+     * @param idx              In:    The data record index.
+     * @param sequence_number  In:    The sequence number.
+     * @param offset           In:    Position of this part in the record.
+     * @param total_length     In:    The length in bytes of the record.
+     * @param data_length      In:    The length in bytes of this part.
+     * @param p_data           In:    A pointer to this part.
+     * @param p_result         Out:   Detailed error information if returning != 0
+     * @return  0  on success.
+     *          -1 if an error occurred.
+     */
+    int CallbackWriteChunkInd (
+        pnet_t* net,
+        uint32_t arep,
+        uint32_t api,
+        uint16_t slot,
+        uint16_t subslot,
+        uint16_t idx,
+        uint16_t sequence_number,
+        uint32_t offset,
+        uint32_t total_length,
+        uint16_t data_length,
+        const uint8_t * p_data,
+        pnet_result_t * p_result);
+
+    /**
+     * Indication to the application that a Write Multiple request begins or ends, see
+     * pnet_write_multiple_ind(). The records of the request are a batch for the
+     * transaction callbacks of the submodules.
+     *
+     * @param net              InOut: The p-net stack instance
+     * @param arep             In:    The AREP.
+     * @param event            In:    The step of the request.
+     * @param p_result         Out:   Detailed error information if returning != 0
+     * @return  0  on success.
+     *          -1 if the parameters are rejected on PNET_WRITE_MULTIPLE_COMMIT.
+     */
+    int CallbackWriteMultipleInd (
+        pnet_t* net,
+        uint32_t arep,
+        pnet_write_multiple_event_t event,
+        pnet_result_t * p_result);
+
     /**
      * Indication to the application that a module is requested by the controller in
      * a specific slot.
@@ -654,6 +862,17 @@ public:
         pnet_t* net, 
         bool led_state);
 
+    /**
+     * Indication to the application that the earliest timeout of the Profinet stack
+     * moved forward in time. Only used in tickless mode.
+     *
+     * Must not block, since it can be called from any thread of the stack.
+     *
+     * @param net              InOut: The p-net stack instance
+     */
+    void CallbackNextTimeoutInd (
+        pnet_t* net);
+
 
 };
 }
@@ -0,0 +1,83 @@
+#include "RecordIndex.h"
+
+namespace profinet
+{
+RecordIndex::RecordIndex()
+{
+}
+
+RecordIndex::~RecordIndex()
+{
+}
+
+uint64_t RecordIndex::Key(uint16_t slot, uint16_t subslot, uint16_t index)
+{
+   return (uint64_t{slot} << 32) | (uint64_t{subslot} << 16) | index;
+}
+
+std::size_t RecordIndex::Hash(uint64_t key, uint32_t api)
+{
+   // Finalizer of splitmix64, spreads neighbouring slots and indices over the whole table.
+   uint64_t hash{key ^ (uint64_t{api} << 48)};
+   hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+   return static_cast<std::size_t>(hash ^ (hash >> 31));
+}
+
+void RecordIndex::Build(DeviceInstance& device, uint32_t api)
+{
+   std::size_t numParameters{0};
+   for(auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for(auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         numParameters += itSubmodules->second.GetParameters().size();
+      }
+   }
+   // At most half full, such that probe sequences stay short.
+   std::size_t capacity{8};
+   while(capacity < 2 * numParameters)
+      capacity *= 2;
+   entries.assign(capacity, Entry{0, 0, nullptr});
+   mask = capacity - 1;
+
+   for(auto itModules = device.begin(); itModules != device.end(); itModules++)
+   {
+      for(auto itSubmodules = itModules->second.begin(); itSubmodules != itModules->second.end(); itSubmodules++)
+      {
+         for(auto& parameter : itSubmodules->second.GetParameters())
+         {
+            const uint64_t key{Key(itModules->first, itSubmodules->first, parameter.first)};
+            std::size_t position{Hash(key, api) & mask};
+            while(entries[position].parameter)
+               position = (position + 1) & mask;
+            entries[position] = Entry{key, api, &parameter.second};
+         }
+      }
+   }
+   valid = true;
+}
+
+void RecordIndex::Invalidate()
+{
+   valid = false;
+}
+
+bool RecordIndex::IsValid() const
+{
+   return valid;
+}
+
+ParameterInstance* RecordIndex::Find(uint32_t api, uint16_t slot, uint16_t subslot, uint16_t index) const
+{
+   if(!valid)
+      return nullptr;
+   const uint64_t key{Key(slot, subslot, index)};
+   for(std::size_t position = Hash(key, api) & mask; entries[position].parameter; position = (position + 1) & mask)
+   {
+      if(entries[position].key == key && entries[position].api == api)
+         return entries[position].parameter;
+   }
+   return nullptr;
+}
+}
@@ -0,0 +1,50 @@
+#ifndef RECORDINDEX_H
+#define RECORDINDEX_H
+
+#pragma once
+
+#include "DeviceInstance.h"
+#include "ParameterInstance.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Flat hash index of the parameters of all plugged submodules, keyed by (api, slot, subslot, index).
+ * Record reads and writes find their parameter with a single short probe sequence and without allocating,
+ * instead of three map lookups. Only used by the thread of the stack. Must be rebuilt whenever modules or
+ * submodules are plugged or pulled.
+ */
+class RecordIndex final
+{
+public:
+    RecordIndex();
+    ~RecordIndex();
+
+    RecordIndex(const RecordIndex&) = delete;
+    RecordIndex& operator=(const RecordIndex&) = delete;
+
+    void Build(DeviceInstance& device, uint32_t api);
+    void Invalidate();
+    bool IsValid() const;
+
+    ParameterInstance* Find(uint32_t api, uint16_t slot, uint16_t subslot, uint16_t index) const;
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t api;
+        ParameterInstance* parameter;   // nullptr if the entry is empty
+    };
+    static uint64_t Key(uint16_t slot, uint16_t subslot, uint16_t index);
+    static std::size_t Hash(uint64_t key, uint32_t api);
+
+    std::vector<Entry> entries{};
+    std::size_t mask{0};
+    bool valid{false};
+};
+}
+#endif
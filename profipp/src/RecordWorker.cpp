@@ -0,0 +1,173 @@
+#include "RecordWorker.h"
+
+#include <algorithm>
+
+namespace profinet
+{
+RecordWorker::RecordWorker()
+{
+}
+
+RecordWorker::~RecordWorker()
+{
+   Stop();
+}
+
+bool RecordWorker::Start(std::size_t numThreads, NotifyType notify_)
+{
+   if(IsRunning() || numThreads == 0)
+      return false;
+   notify = notify_;
+   stop = false;
+   for(std::size_t i = 0; i < numThreads; i++)
+      threads.emplace_back(&RecordWorker::Loop, this);
+   return true;
+}
+
+void RecordWorker::Stop()
+{
+   {
+      std::lock_guard lock{mutex};
+      stop = true;
+   }
+   changed.notify_all();
+   for(auto& thread : threads)
+      thread.join();
+   threads.clear();
+   queued.clear();
+}
+
+bool RecordWorker::IsRunning() const
+{
+   return !threads.empty();
+}
+
+void RecordWorker::Submit(Job&& job)
+{
+   {
+      std::lock_guard lock{mutex};
+      queued.push_back(std::move(job));
+   }
+   changed.notify_all();
+}
+
+void RecordWorker::Run(Job& job)
+{
+   RunExclusive(job.parameter, [&job](){Execute(job);});
+}
+
+void RecordWorker::RunExclusive(const ParameterInstance* parameter, const std::function<void()>& function)
+{
+   {
+      std::unique_lock lock{mutex};
+      changed.wait(lock, [this, parameter]()
+      {
+         return !IsBusy(parameter) && std::none_of(queued.begin(), queued.end(),
+            [parameter](const Job& other){return other.parameter == parameter;});
+      });
+      busy.push_back(parameter);
+   }
+   function();
+   {
+      std::lock_guard lock{mutex};
+      Release(parameter);
+   }
+   changed.notify_all();
+}
+
+bool RecordWorker::TakeCompleted(Job& job)
+{
+   std::lock_guard lock{mutex};
+   if(completed.empty())
+      return false;
+   job = std::move(completed.front());
+   completed.pop_front();
+   return true;
+}
+
+void RecordWorker::ForEachCompleted(const std::function<void(const Job&)>& function)
+{
+   std::lock_guard lock{mutex};
+   for(const auto& job : completed)
+      function(job);
+}
+
+void RecordWorker::WaitIdle()
+{
+   std::unique_lock lock{mutex};
+   changed.wait(lock, [this](){return queued.empty() && busy.empty();});
+}
+
+void RecordWorker::Loop()
+{
+   std::unique_lock lock{mutex};
+   while(true)
+   {
+      auto next{queued.end()};
+      changed.wait(lock, [this, &next]()
+      {
+         next = FindRunnable();
+         return stop || next != queued.end();
+      });
+      if(stop)
+         return;
+      Job job{std::move(*next)};
+      queued.erase(next);
+      busy.push_back(job.parameter);
+      lock.unlock();
+
+      Execute(job);
+
+      lock.lock();
+      Release(job.parameter);
+      completed.push_back(std::move(job));
+      lock.unlock();
+      changed.notify_all();
+      if(notify)
+         notify();
+      lock.lock();
+   }
+}
+
+std::deque<RecordWorker::Job>::iterator RecordWorker::FindRunnable()
+{
+   // The oldest job of a parameter must run first, so skip all parameters seen before.
+   for(auto it = queued.begin(); it != queued.end(); it++)
+   {
+      if(IsBusy(it->parameter))
+         continue;
+      auto parameter{it->parameter};
+      if(std::none_of(queued.begin(), it, [parameter](const Job& other){return other.parameter == parameter;}))
+         return it;
+   }
+   return queued.end();
+}
+
+bool RecordWorker::IsBusy(const ParameterInstance* parameter) const
+{
+   return std::find(busy.begin(), busy.end(), parameter) != busy.end();
+}
+
+void RecordWorker::Release(const ParameterInstance* parameter)
+{
+   auto it{std::find(busy.begin(), busy.end(), parameter)};
+   if(it != busy.end())
+      busy.erase(it);
+}
+
+void RecordWorker::Execute(Job& job)
+{
+   if(job.write)
+   {
+      job.success = job.parameter->Set(job.data.data(), job.data.size());
+      return;
+   }
+   uint8_t* buffer{nullptr};
+   std::size_t numBytes{job.data.size()};
+   job.success = job.parameter->Get(&buffer, &numBytes);
+   if(job.success)
+      job.data.assign(buffer, buffer + numBytes);
+   else
+      job.data.clear();
+}
+}
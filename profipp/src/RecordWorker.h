@@ -0,0 +1,105 @@
+#ifndef RECORDWORKER_H
+#define RECORDWORKER_H
+
+#pragma once
+
+#include "ParameterInstance.h"
+#include "ParameterStore.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace profinet
+{
+/**
+ * @brief Pool of threads which run the callbacks of asynchronous parameters, see ParameterProperties::asynchronous,
+ * such that the thread of the stack does not wait for them. The thread of the stack submits a job for every record
+ * read or write, and takes the completed jobs to send the responses. Jobs of the same parameter run one after the
+ * other, in the order they were submitted.
+ */
+class RecordWorker final
+{
+public:
+    struct Job
+    {
+        bool write{false};
+        uint32_t arep{0};
+        uint16_t sequenceNumber{0};
+        uint32_t api{0};
+        uint16_t slot{0};
+        uint16_t subslot{0};
+        uint16_t idx{0};
+        ParameterInstance* parameter{nullptr};
+        // Write: the data to write. Read: sized to the maximal length, and the value read afterwards.
+        std::vector<uint8_t> data{};
+        bool success{false};
+        // Write of a persistent parameter: where to store the value. Captured when submitting, as the parameter
+        // may be destroyed before the completed job is taken.
+        bool persistent{false};
+        ParameterStore::Key storeKey{};
+        // Batch of parameter writes the job was submitted in, or 0, and the number of the job in submit order.
+        uint64_t batch{0};
+        uint64_t number{0};
+    };
+    // Called by the pool threads when a job completed.
+    using NotifyType = std::function<void()>;
+
+    RecordWorker();
+    ~RecordWorker();
+
+    RecordWorker(const RecordWorker&) = delete;
+    RecordWorker& operator=(const RecordWorker&) = delete;
+
+    bool Start(std::size_t numThreads, NotifyType notify);
+    void Stop();
+    bool IsRunning() const;
+
+    void Submit(Job&& job);
+    /**
+     * @brief Runs the job on the calling thread, after the submitted jobs of the same parameter. For records which
+     * must be answered synchronously.
+     */
+    void Run(Job& job);
+    /**
+     * @brief Calls the function on the calling thread, after the submitted jobs of the parameter, and while no other
+     * job of the parameter runs.
+     */
+    void RunExclusive(const ParameterInstance* parameter, const std::function<void()>& function);
+    /**
+     * @brief Takes the oldest completed job. Returns false if there is none.
+     */
+    bool TakeCompleted(Job& job);
+    /**
+     * @brief Calls the function for every completed job not taken yet, in the order they completed.
+     */
+    void ForEachCompleted(const std::function<void(const Job&)>& function);
+    /**
+     * @brief Blocks until no job is queued or running. Call before the parameter instances are destroyed, e.g.
+     * when a submodule is pulled. Completed jobs are kept.
+     */
+    void WaitIdle();
+
+private:
+    void Loop();
+    std::deque<Job>::iterator FindRunnable();
+    bool IsBusy(const ParameterInstance* parameter) const;
+    void Release(const ParameterInstance* parameter);
+    static void Execute(Job& job);
+
+    NotifyType notify{};
+    std::mutex mutex{};
+    std::condition_variable changed{};
+    std::deque<Job> queued{};
+    std::deque<Job> completed{};
+    // Parameters of the running jobs.
+    std::vector<const ParameterInstance*> busy{};
+    bool stop{false};
+    std::vector<std::thread> threads{};
+};
+}
+#endif
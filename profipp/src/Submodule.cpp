@@ -17,6 +17,25 @@ Parameter* Submodule::Parameters::Create(uint16_t parameterIdx, const Parameter:
     else
        return nullptr;
 }
+void Submodule::Parameters::SetTransactionCallbacks(const BeginTransactionCallbackType& beginTransactionCallback_,
+    const EndTransactionCallbackType& endTransactionCallback_)
+{
+    beginTransactionCallback = beginTransactionCallback_;
+    endTransactionCallback = endTransactionCallback_;
+}
+void Submodule::Parameters::ClearTransactionCallbacks()
+{
+    beginTransactionCallback = nullptr;
+    endTransactionCallback = nullptr;
+}
+const Submodule::Parameters::BeginTransactionCallbackType& Submodule::Parameters::GetBeginTransactionCallback() const
+{
+    return beginTransactionCallback;
+}
+const Submodule::Parameters::EndTransactionCallbackType& Submodule::Parameters::GetEndTransactionCallback() const
+{
+    return endTransactionCallback;
+}
 Input* Submodule::Inputs::Create(const Input::SetCallbackType& setCallback, std::size_t lengthInBytes)
 {
     return &list.emplace_back(setCallback, lengthInBytes);
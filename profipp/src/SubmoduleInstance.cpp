@@ -9,6 +9,8 @@ SubmoduleInstance::SubmoduleInstance() : unknownModule{true}, inputLengthInBytes
 bool SubmoduleInstance::Initialize(const Submodule& submoduleConfiguration, uint16_t subslot)
 {
     allUpdatedCallback = submoduleConfiguration.inputs.GetAllUpdatedCallback();
+    beginTransactionCallback = submoduleConfiguration.parameters.GetBeginTransactionCallback();
+    endTransactionCallback = submoduleConfiguration.parameters.GetEndTransactionCallback();
     for(const auto& elem : submoduleConfiguration.parameters)
     {
         auto insert = parameters.try_emplace(elem.GetIdx());
@@ -83,6 +85,19 @@ bool SubmoduleInstance::SetDefaultInput()
     }
     return success;
 }
+void SubmoduleInstance::SetIdentification(uint32_t moduleId_, uint32_t submoduleId_)
+{
+    moduleId = moduleId_;
+    submoduleId = submoduleId_;
+}
+uint32_t SubmoduleInstance::GetModuleId() const
+{
+    return moduleId;
+}
+uint32_t SubmoduleInstance::GetSubmoduleId() const
+{
+    return submoduleId;
+}
 std::size_t SubmoduleInstance::GetInputLengthInBytes()
 {
     return inputLengthInBytes;
@@ -104,6 +119,11 @@ ParameterInstance* SubmoduleInstance::GetParameter(uint16_t parameterIdx)
       return nullptr;
 }
 
+std::map<uint16_t, ParameterInstance>& SubmoduleInstance::GetParameters()
+{
+    return parameters;
+}
+
 bool SubmoduleInstance::SetInput(const uint8_t* buffer, std::size_t numBytes)
 {
     if(buffer == nullptr || numBytes < inputLengthInBytes)
@@ -123,6 +143,17 @@ bool SubmoduleInstance::SetInput(const uint8_t* buffer, std::size_t numBytes)
         allUpdatedCallback();
     return true;
 }
+void SubmoduleInstance::BeginTransaction()
+{
+    if(beginTransactionCallback)
+        beginTransactionCallback();
+}
+bool SubmoduleInstance::EndTransaction(bool commit)
+{
+    if(endTransactionCallback)
+        return endTransactionCallback(commit);
+    return true;
+}
 bool SubmoduleInstance::GetOutput(uint8_t* buffer, std::size_t* numBytes)
 {
     if(numBytes == nullptr || buffer == nullptr || *numBytes < outputLengthInBytes)
@@ -26,6 +26,7 @@ public:
     bool InitializeUnknown(uint16_t subslot, std::size_t inputLengthInBytes_, std::size_t outputLengthInBytes_);
 
     ParameterInstance* GetParameter(uint16_t parameterIdx);
+    std::map<uint16_t, ParameterInstance>& GetParameters();
 
     std::size_t GetInputLengthInBytes();
     std::size_t GetOutputLengthInBytes();
@@ -33,6 +34,15 @@ public:
     bool GetOutput(uint8_t* buffer, std::size_t* numBytes);
 
     bool SetDefaultInput();
+
+    // Batch of parameter writes, see Submodule::Parameters::SetTransactionCallbacks().
+    void BeginTransaction();
+    bool EndTransaction(bool commit);
+
+    // Identifiers of the plugged module and submodule, as requested by the controller.
+    void SetIdentification(uint32_t moduleId_, uint32_t submoduleId_);
+    uint32_t GetModuleId() const;
+    uint32_t GetSubmoduleId() const;
 private:
     bool unknownModule;
     bool initialized;
@@ -43,7 +53,12 @@ private:
     std::size_t inputLengthInBytes;
     std::size_t outputLengthInBytes;
 
+    uint32_t moduleId{0};
+    uint32_t submoduleId{0};
+
     Submodule::Inputs::AllUpdatedCallbackType allUpdatedCallback{};
+    Submodule::Parameters::BeginTransactionCallbackType beginTransactionCallback{};
+    Submodule::Parameters::EndTransactionCallbackType endTransactionCallback{};
 
     // initialize to PNET_IOXS_BAD=0x00 (see pnet_ioxs_values in pnet_api.h). They will be
     // (hopefully) switched to PNET_IOXS_GOOD=0x80 during the first